@@ -0,0 +1,75 @@
+# Runs one solver test: cmake -DSOLVER=... -DWORK_DIR=... [options] -P run_test.cmake
+#   SOLVER      The wordle_solver binary.
+#   WORK_DIR    Directory the solver runs in, with --data-dir . --cache-dir . (so it prints bare file names).
+#   DATA_DIR    When set, WORK_DIR is emptied and this fixture directory's files copied into it first.
+#   ARGS        The solver arguments, as one space-separated string.
+#   INPUT       File fed to the solver's stdin.
+#   EXPECTED    File stdout must match, once the timing lines are dropped.
+#   ERROR_REGEX Regular expression stderr must match (the exit code is then not checked).
+#   BY_SESSION  Group stdout's JSON lines by "session" (keeping each session's order) before comparing, since
+#               the server answers different sessions in whatever order its workers finish them.
+#   TEST_NAME   Names the actual_<name>.txt file a mismatching stdout is saved to.
+# Timings and the SIMD kernel name vary between runs and machines, so "Wall time" and "Precomputed" lines
+# are not compared.
+if(NOT SOLVER OR NOT WORK_DIR)
+    message(FATAL_ERROR "run_test.cmake needs SOLVER and WORK_DIR")
+endif()
+
+if(DATA_DIR)
+    file(REMOVE_RECURSE "${WORK_DIR}")
+    file(MAKE_DIRECTORY "${WORK_DIR}")
+    file(GLOB fixtureFiles "${DATA_DIR}/*")
+    file(COPY ${fixtureFiles} DESTINATION "${WORK_DIR}")
+endif()
+
+separate_arguments(solverArgs UNIX_COMMAND "${ARGS}")
+set(inputOption)
+if(INPUT)
+    set(inputOption INPUT_FILE "${INPUT}")
+endif()
+execute_process(
+    COMMAND "${SOLVER}" --offline --data-dir . --cache-dir . ${solverArgs}
+    WORKING_DIRECTORY "${WORK_DIR}"
+    ${inputOption}
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE errors)
+
+if(ERROR_REGEX)
+    if(NOT errors MATCHES "${ERROR_REGEX}")
+        message(FATAL_ERROR "stderr does not match \"${ERROR_REGEX}\":\n${errors}")
+    endif()
+elseif(NOT result EQUAL 0)
+    message(FATAL_ERROR "wordle_solver ${ARGS} exited with ${result}:\n${output}${errors}")
+endif()
+
+if(EXPECTED)
+    string(REGEX REPLACE "^(Wall time|Precomputed)[^\n]*\n" "" output "${output}")
+    string(REGEX REPLACE "\n(Wall time|Precomputed)[^\n]*" "" output "${output}")
+    if(BY_SESSION)
+        string(REPLACE "\n" ";" lines "${output}")
+        set(sessions)
+        set(lines_none)
+        foreach(line IN LISTS lines)
+            if(line MATCHES "\"session\":([0-9]+)")
+                list(APPEND sessions ${CMAKE_MATCH_1})
+                list(APPEND lines_${CMAKE_MATCH_1} "${line}")
+            elseif(NOT line STREQUAL "")
+                list(APPEND lines_none "${line}")
+            endif()
+        endforeach()
+        list(REMOVE_DUPLICATES sessions)
+        list(SORT sessions COMPARE NATURAL)
+        set(output)
+        foreach(session IN ITEMS none ${sessions})
+            foreach(line IN LISTS lines_${session})
+                string(APPEND output "${line}\n")
+            endforeach()
+        endforeach()
+    endif()
+    file(READ "${EXPECTED}" expectedOutput)
+    if(NOT output STREQUAL expectedOutput)
+        file(WRITE "${WORK_DIR}/actual_${TEST_NAME}.txt" "${output}")
+        message(FATAL_ERROR "stdout differs from ${EXPECTED}; it was saved to ${WORK_DIR}/actual_${TEST_NAME}.txt:\n${output}")
+    endif()
+endif()
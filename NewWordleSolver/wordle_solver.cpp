@@ -38,7 +38,7 @@
  *
  * --- External Data Specification ---
  *
- * 1. **Local Dictionary File (Hardcoded Path: "C:\\VS2022.Projects\\StuffForWordle\\WordleWordsCSVs\\AllWords.txt")**
+ * 1. **Local Dictionary File (AllWords.txt in the data directory: --data-dir, WORDLE_DATA_DIR or the build default)**
  * - **Purpose:** Provides a comprehensive list of 5-letter words with associated frequency and linguistic metadata
  * used for filtering and scoring.
  * - **Format:** Each line contains exactly 10 contiguous characters (no delimiter).
@@ -61,36 +61,269 @@
  * for replay in the `g_wordle_replay_words` array.
  */
 
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
 #include <errno.h>
 #include <stdbool.h>
+#ifndef WORDLE_NO_CURL
 #include <curl/curl.h>
+#endif
 #include <math.h>
+#include <float.h>
 #include <stdarg.h>
+#include <stddef.h>
+#include <time.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#include <psapi.h>
+#else
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#endif
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+
+// Portable code path: fopen_s and errno_t are only provided by the Windows runtimes
+#ifndef _WIN32
+typedef int errno_t;
+
+/**
+ * @brief fopen with the fopen_s calling convention (*ppFile is NULL on failure).
+ * @return errno_t 0 on success, otherwise the errno of the failed open.
+ */
+static inline errno_t fopen_s(FILE** ppFile, const char* pszPath, const char* pszMode)
+{
+    *ppFile = fopen(pszPath, pszMode);
+    return (*ppFile != NULL) ? 0 : errno;
+}
+#endif
+
+// Built without cURL (WORDLE_NO_CURL): the used words always come from their cache, as with --offline
+#ifdef WORDLE_NO_CURL
+typedef int CURLcode;
+#define CURLE_OK 0
+#endif
+
+// Vector feedback kernels: AVX2 on x86 (selected at runtime), NEON on ARM64, scalar everywhere
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FEEDBACK_KERNEL_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define FEEDBACK_KERNEL_NEON 1
+#include <arm_neon.h>
+#endif
+
+// GCC/Clang only emit AVX2 code in functions marked for it; MSVC accepts the intrinsics anywhere
+#if defined(FEEDBACK_KERNEL_X86) && (defined(__GNUC__) || defined(__clang__))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
 
-#define LOW_POSSIBLE_ANSWER_COUNT 25
+#define LOW_POSSIBLE_ANSWER_COUNT 25 // Default of --low-count; also the most candidates listed in JSON replies
 #define WORD_SIZE 5
+#define ALPHABET_SIZE 26
 #define MAX_DICTIONARY_WORDS 200000
 #define EPSILON 1e-9
 
  // Macro to check if float 'a' is strictly greater than float 'b', accounting for precision
 #define FLOAT_GREATER(a, b) ((a) > (b) + EPSILON)
 
-// Global definition for the threshold difference in Entropy (H) below which Rank (R) is prioritized.
+// Default threshold difference in Entropy (H) below which Rank (R) is prioritized (--threshold).
 #define ENTROPY_RANK_THRESHOLD 0.50
 
+// Prior-weighted scoring (--weighted): an answer's prior weight is a logistic curve of its rank.
+#define PRIOR_RANK_MIDPOINT 50.0
+#define PRIOR_RANK_SCALE 8.0
+
 // Global debug controls
 #define DEBUG_ON 1
 #define DEBUG_LEVEL 0 // 0 = print all debug, higher number limits debug output to later turns
 #define MAX_TOP_PICKS 40
 
+// Pattern encoding: each feedback result is a base-3 number (B=0, Y=1, G=2; position 0 is the lowest digit).
+#define NUM_PATTERNS 243 // 3^WORD_SIZE
+#define PATTERN_ALL_GREEN (NUM_PATTERNS - 1)
+
+// Incremental histograms: buckets per guess row (NUM_PATTERNS padded) and the largest answer set they count.
+#define PATTERN_HISTOGRAM_ROW_SIZE 256
+#define PATTERN_HISTOGRAM_MAX_COUNT 65535
+
+// Largest dictionary for which the full guess x answer pattern matrix is precomputed (MAX^2 bytes).
+#define MAX_PATTERN_MATRIX_WORDS 20000
+
+// Dictionary store: bits per packed letter index (26 letters fit in 5 bits, a word in 25).
+#define LETTER_BITS 5
+#define LETTER_MASK 0x1Fu
+#define INVALID_WORD_ID 0xFFFFFFFFu
+
+// Word kernels: the word lengths they are compiled for and the largest alphabet (single-byte letters)
+// a dictionary of another length or alphabet may use (see select_word_kernels).
+#define VARIANT_MIN_WORD_SIZE 4
+#define VARIANT_MAX_WORD_SIZE 7
+#define VARIANT_MAX_ALPHABET 64
+#define VARIANT_RECORD_SIZE(wordLength) (2 * (wordLength) + 1) // The word, its NUL, then its letter indices
+
+// Data locations: the dictionary files live in the data directory and the caches in the cache directory.
+// The build defaults below can be set with -DWORDLE_DATA_DIR / -DWORDLE_CACHE_DIR, and are overridden by
+// the WORDLE_DATA_DIR / WORDLE_CACHE_DIR environment variables and then by --data-dir / --cache-dir.
+#ifndef WORDLE_DATA_DIR
+#define WORDLE_DATA_DIR "."
+#endif
+#ifndef WORDLE_CACHE_DIR
+#define WORDLE_CACHE_DIR "."
+#endif
+#ifdef _WIN32
+#define PATH_SEPARATOR '\\'
+#else
+#define PATH_SEPARATOR '/'
+#endif
+#define DATA_PATH_SIZE 1024
+
+// Dictionary files: the 10-char-per-line text source and its compiled, memory-mappable form.
+#define DICTIONARY_TEXT_FILE "AllWords.txt"
+#define DICTIONARY_BINARY_FILE "AllWords.wdict"
+#define BINARY_DICTIONARY_MAGIC "WDIC"
+#define BINARY_DICTIONARY_VERSION 2
+#define BINARY_SECTION_ALIGNMENT 64
+#define BINARY_DICTIONARY_SECTIONS 6
+
+// Used-words cache: past answers with the HTTP validators of the page they came from.
+#define USED_WORDS_URL "https://www.rockpapershotgun.com/wordle-past-answers"
+#define USED_WORDS_CACHE_FILE "wordle_used_words.cache"
+#define USED_WORDS_CACHE_MAGIC "WUWC"
+#define USED_WORDS_CACHE_VERSION 1
+#define USED_WORDS_VALIDATOR_SIZE 128
+#define USED_WORDS_CONNECT_TIMEOUT 10
+#define USED_WORDS_TIMEOUT 30
+#define DOWNLOAD_INITIAL_CAPACITY 65536
+#define PATTERN_VERIFY_SAMPLES 65536
+
+// Packed words are padded to a multiple of the widest kernel's lane count (AVX2: 32 bytes).
+#define FEEDBACK_KERNEL_LANES 32
+
+// Parallel scoring: upper bound on worker threads and the number of items a worker claims at a time.
+#define PARALLEL_MAX_WORKERS 256
+#define METRICS_CHUNK_SIZE 16
+#define PATTERN_MATRIX_CHUNK_SIZE 32
+
+// Scratch arenas: first block size of a thread's arena and the alignment of every allocation.
+#define SCRATCH_ARENA_INITIAL_SIZE (1 << 20)
+#define SCRATCH_ARENA_ALIGNMENT 64
+
+// Turn output: bytes buffered on the stack before the output buffer moves to the heap.
+#define OUTPUT_INLINE_SIZE 8192
+
+// Full-dictionary scoring: how often (in answers) a candidate's entropy upper bound is checked,
+// and the entropy recorded for candidates pruned before their tally finished.
+#define PRUNE_CHECK_INTERVAL 32
+#define PRUNED_ENTROPY (-1.0)
+
+// Sampled scoring (--sample): only answer sets at least SAMPLE_MIN_REDUCTION times the sample are
+// estimated, and a guess is rescored exactly if its bound of SAMPLE_CONFIDENCE_Z standard errors could matter.
+#define SAMPLE_MIN_REDUCTION 2
+#define SAMPLE_CONFIDENCE_Z 3.0
+
+// Accelerator offload (--gpu): the OpenCL runtime, the smallest pass (guesses x answers) worth sending
+// to the device, guesses per histogram launch, work-items per guess, and device bytes per matrix launch.
+#ifdef _WIN32
+#define ACCELERATOR_LIBRARY "OpenCL.dll"
+#define ACCELERATOR_API __stdcall
+#else
+#define ACCELERATOR_LIBRARY "libOpenCL.so.1"
+#define ACCELERATOR_API
+#endif
+#define ACCELERATOR_MAX_PLATFORMS 8
+#define ACCELERATOR_MIN_PAIRS (1L << 22)
+#define ACCELERATOR_HISTOGRAM_BATCH 8192
+#define ACCELERATOR_WORKGROUP_SIZE 64
+#define ACCELERATOR_MATRIX_BATCH_BYTES (1L << 26)
+
+// Opening cache: turn-1 analysis and turn-2 replies, reused until the dictionary or used words change.
+#define OPENING_CACHE_FILE "wordle_opening.cache"
+#define OPENING_CACHE_MAGIC "WOPC"
+#define OPENING_CACHE_VERSION 2
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+// Candidate filter index: 26 letters x WORD_SIZE positions, then 26 letters x WORD_SIZE minimum counts.
+#define FILTER_INDEX_POSITION_SETS (WORD_SIZE * 26)
+#define FILTER_INDEX_MIN_COUNT_SETS (26 * WORD_SIZE)
+#define FILTER_INDEX_NUM_SETS (FILTER_INDEX_POSITION_SETS + FILTER_INDEX_MIN_COUNT_SETS)
+
+// Batch simulation: guesses allowed per game, games a worker claims at a time, failures listed.
+#define MAX_GUESSES 6
+#define SIMULATION_CHUNK_SIZE 4
+#define MAX_LISTED_FAILURES 50
+
+// Parameter sweep (--sweep-threshold / --sweep-count): most grid points, and the percentile reported.
+#define SWEEP_MAX_POINTS 4096
+#define SWEEP_PERCENTILE 0.99
+
+// Lookahead search: candidates per node, largest set searched, node budget per search and the
+// transposition table (shards x slots). Unsearched sets cost LEAF_GUESSES_PER_BIT per bit of log2(n / 2).
+#define LOOKAHEAD_MAX_PLIES 4
+#define LOOKAHEAD_WIDTH 8
+#define LOOKAHEAD_MAX_ANSWERS 1500
+#define LOOKAHEAD_NODE_BUDGET 50000
+#define LOOKAHEAD_TT_SHARDS 64
+#define LOOKAHEAD_TT_SHARD_SLOTS 4096
+#define LOOKAHEAD_LEAF_GUESSES_PER_BIT 0.25
+
+// Result cache (server and simulation): recommendations shared across games, shards x entries per
+// shard, least recently used entry evicted first.
+#define RESULT_CACHE_SHARDS 64
+#define RESULT_CACHE_SHARD_ENTRIES 64
+
+// Benchmarks: guesses timed against every word (feedback) or every answer (entropy), filter scenarios,
+// and best-of repeats for the thread scaling runs.
+#define BENCH_FEEDBACK_GUESSES 64
+#define BENCH_ENTROPY_GUESSES 256
+#define BENCH_FILTER_SCENARIOS 256
+#define BENCH_REPEATS 3
+#define BENCH_VARIANT_WORDS 4096
+
+// Server mode: longest request line, open sessions allowed and the initial session table size (a power of two).
+#define SERVER_MAX_LINE 1024
+#define SERVER_MAX_SESSIONS 100000
+#define SERVER_INITIAL_SESSION_SLOTS 1024
+
+// Batch queries: longest history line, initial trie/line table size, token separators and top rows
+// reported per line.
+#define BATCH_MAX_LINE 256
+#define BATCH_INITIAL_CAPACITY 1024
+#define BATCH_SEPARATORS " \t,:;"
+#define BATCH_TOP_ROWS 5
+
+// Decision tree export (see export_decision_tree)
+#define DECISION_TREE_MAGIC "WDTR"
+#define DECISION_TREE_VERSION 1
+#define DECISION_TREE_MASK_WORDS ((NUM_PATTERNS + 63) / 64)
+#define DECISION_TREE_CHUNK_SIZE 4
+
 // --- Global Variables and Replay List ---
 long numUsedWords = 0;
 long numWordsInDictionary = 0;
+
+// Data file paths, joined from the data and cache directories at startup (see resolve_data_paths)
+char g_szDictionaryTextPath[DATA_PATH_SIZE];
+char g_szDictionaryBinaryPath[DATA_PATH_SIZE];
+char g_szUsedWordsCachePath[DATA_PATH_SIZE];
+char g_szOpeningCachePath[DATA_PATH_SIZE];
 long maxDictionary = MAX_DICTIONARY_WORDS;
 int g_tryIdx = 0; // Tracks the current guess index (1-6)
 
@@ -117,8 +350,40 @@ typedef struct _word_entry
 } WORD_ENTRY, * PWORD_ENTRY;
 
 /**
- * @brief Node for a dynamically allocated linked list, repurposed for pattern counting in Entropy calculation.
- * 'word' holds the 5-char pattern (e.g., "BGYBB"), 'rank' holds the count.
+ * @brief Index of a word in the dictionary store (and row/column of the pattern matrix).
+ */
+typedef unsigned int WORD_ID;
+
+/**
+ * @brief Compact structure-of-arrays view of the loaded dictionary, indexed by WORD_ID.
+ * Letter indices (A = 0) are packed LETTER_BITS per position, position 0 in the low bits.
+ * The WORD_ENTRY table stays the owner of the word text, so word pointers and IDs map 1:1.
+ */
+typedef struct _dictionary_store
+{
+    long numWords;
+    unsigned int* pPackedLetters;
+    short* pRanks;
+    char* pNounTypes;
+    char* pVerbTypes;
+    struct _letter_counts* pLetterCounts; // Always built at load (not part of the compiled file)
+    double* pPriorWeights;                // Prior weight of each word as an answer, from its rank (built at load)
+    PWORD_ENTRY pEntries;
+    bool ownsColumns; // False when the columns point into the compiled dictionary file
+} DICTIONARY_STORE, * PDICTIONARY_STORE;
+
+/**
+ * @brief A letter multiset as bitmasks: bit L (0-25) of atLeast[k] is set if letter L occurs at
+ * least k + 1 times, so atLeast[0] is the letter set and atLeast[1] the repeated letters.
+ * Used for dictionary words and for the required letters (pGood) of a game state.
+ */
+typedef struct _letter_counts
+{
+    unsigned int atLeast[WORD_SIZE];
+} LETTER_COUNTS, * PLETTER_COUNTS;
+
+/**
+ * @brief Node for a dynamically allocated linked list of words (used while parsing the used-word web page).
  */
 typedef struct _word_node
 {
@@ -135,13 +400,84 @@ typedef struct _word_node
 typedef struct _guess_metrics
 {
     const char* word;
-    double entropy;
+    double entropy;       // Rank-weighted with --weighted
+    double remainingMass; // --weighted: expected share of the prior mass still possible after the guess (0 otherwise)
     int rank;
     bool is_risky;
     char nounType;
     char verbType;
 } GUESS_METRICS, * PGUESS_METRICS;
 
+/**
+ * @brief A single feedback result encoded as a base-3 code in the range 0..242.
+ */
+typedef unsigned char PATTERN_CODE;
+
+/**
+ * @brief Precomputed feedback codes for every (guess, answer) pair of dictionary words.
+ * Row = guess index, column = answer index, both indices into the sorted dictionary table.
+ */
+typedef struct _pattern_matrix
+{
+    PATTERN_CODE* pCodes;
+    PWORD_ENTRY pDictionary;
+    long numWords;
+    bool isMapped;       // pCodes points into the compiled dictionary file
+    bool mappedRejected; // The mapped matrix failed verification; build it from the kernels instead
+    bool onDemand;       // A built matrix failed verification too; always compute patterns on demand
+} PATTERN_MATRIX, * PPATTERN_MATRIX;
+
+/**
+ * @brief Words in structure-of-arrays form for the feedback kernels: pLetters[pos][i] is the
+ * letter index (A = 0) of word i at pos. Rows are numPadded long (zero padded).
+ */
+typedef struct _packed_words
+{
+    unsigned char* pLetters[WORD_SIZE];
+    unsigned char* pStorage;
+    long numWords;
+    long numPadded;
+} PACKED_WORDS, * PPACKED_WORDS;
+
+/**
+ * @brief Feedback kernel: codes of one guess (WORD_SIZE letter indices) against packed answers
+ * [begin, end), written to pCodes[0 .. end - begin).
+ */
+typedef void (*FEEDBACK_KERNEL_FN)(const unsigned char* guess, const PACKED_WORDS* pAnswers, long begin, long end, PATTERN_CODE* pCodes);
+
+/**
+ * @brief Bitset index over the dictionary for candidate filtering. Each set holds one bit per
+ * dictionary word (numBlocks 64-bit words): FILTER_INDEX_POSITION_SETS sets "letter L at position P"
+ * followed by FILTER_INDEX_MIN_COUNT_SETS sets "at least K+1 copies of letter L".
+ */
+typedef struct _filter_index
+{
+    unsigned long long* pBits;
+    long numWords;
+    long numBlocks;
+} FILTER_INDEX, * PFILTER_INDEX;
+
+/**
+ * @brief One game's per-guess feedback pattern histograms, kept between turns so a turn only has to
+ * take the eliminated answers out of the buckets (see sync_pattern_histograms).
+ */
+typedef struct _pattern_histograms
+{
+    unsigned short* pCounts;   // numRows x PATTERN_HISTOGRAM_ROW_SIZE bucket counts
+    long* pRowOfWord;          // Per word ID: its row, or -1
+    WORD_ID* pRowWords;        // Per row: the guess it counts
+    long numRows;
+    long rowCapacity;
+    WORD_ID* pAnswerIds;       // The answer set the counts describe
+    long numAnswers;
+    WORD_ID* pRemovedIds;      // Work buffer for the answers eliminated since the last sync
+    unsigned char* pInAnswers; // Per word ID: 1 if in pAnswerIds (scratch values during a sync)
+    long numWords;             // Size of the per-word arrays (0 until first use)
+    bool isValid;
+    long numUpdates;           // Incremental syncs
+    long numRebuilds;          // Full rebuilds
+} PATTERN_HISTOGRAMS, * PPATTERN_HISTOGRAMS;
+
 /**
  * @brief Structure to hold the final two recommended picks for one optimization path (Rank or Entropy).
  */
@@ -149,252 +485,1876 @@ typedef struct _pick_data
 {
     const char* word;
     const char* alternate_word;
+    const GUESS_METRICS* pMetric;          // Metric of word, or NULL for "NONE"
+    const GUESS_METRICS* pAlternateMetric; // Metric of alternate_word, or NULL for "NONE"
 } PICK_DATA, * PPICK_DATA;
 
+/**
+ * @brief The best entries of a metric table under one ordering, as indices into the table:
+ * the top MAX_TOP_PICKS in order and the first two linguistically clean entries of the full order.
+ */
+typedef struct _top_metrics
+{
+    long topIdx[MAX_TOP_PICKS]; // Best first
+    long numTop;
+    long cleanIdx[2];           // Best first
+    long numClean;
+} TOP_METRICS, * PTOP_METRICS;
 
-// --- Function Prototypes ---
-
-// Standard C/Utility Functions
-void trim(char* str);
-void clear_input_buffer();
-int compare(const void* arg1, const void* arg2);
-
-// Data Loading and Parsing
-PWORD_ENTRY get_word_entry_from_word(const char* word, PWORD_ENTRY pDictionary, long numDictionary);
-PWORD_ENTRY get_dictionary_table();
-char* get_used_words_table();
-PWORD_LIST get_used_words_from_webpage_string(char* pszWebPage);
-char* get_used_words_webpage(void);
-size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp);
-
-// Core Solver Logic
-int is_good_fit(char* pMask, char notMask[6][5], char* pGood, char* pBad, char* pWord);
-long filter_possible_answers(const char** pPossibleAnswers, long numCurrentAnswers, char* pMask, char notMask[6][5], char* pGood, char* pBad, long numTries);
-void get_feedback_pattern(const char* guess, const char* answer, char* result_pattern);
-double calculate_entropy_score(const char* guess, const char** possibleAnswers, long numPossibleAnswers);
-bool is_guess_word_risky(const char* guess, char* pGood);
-void get_linguistic_types(const char* word, PWORD_ENTRY pDictionary, long numDictionary, char* nounType, char* verbType, int* rank);
-
-// Recommendation/Refactored Logic
-void update_game_constraints(const char* guess, const char* result_pattern, char* pMask, char notMask[6][5], char* pGood, char* pBad, int tryIdx);
-void calculate_all_metrics(PWORD_ENTRY pDictionary, const char** pPossibleAnswers, long numPossibleAnswers, char* pGood, PGUESS_METRICS pMetricsTable, long numWordsInDictionary);
-bool create_and_sort_metric_buffers(PGUESS_METRICS pMetricsTable, long numPossibleAnswers, PGUESS_METRICS* ppRankSorted, PGUESS_METRICS* ppEntropySorted);
-void find_top_linguistic_picks(PGUESS_METRICS pSortedMetrics, long numMetrics, PICK_DATA* pResult);
-PGUESS_METRICS find_metric_by_word(const char* word, PGUESS_METRICS pArray, long num);
-void print_recommendation_table(PGUESS_METRICS pRankSorted, PGUESS_METRICS pEntropySorted, long numPossibleAnswers, const PICK_DATA* pRankPicks, const PICK_DATA* pE_Picks);
-void determine_final_pick(PGUESS_METRICS pRankSorted, PGUESS_METRICS pEntropySorted, long numPossibleAnswers, const PICK_DATA* rankPicks, const PICK_DATA* entropyPicks);
-void analyze_and_print_recommendations(PWORD_ENTRY pDictionary, const char** pPossibleAnswers, long numPossibleAnswers, char* pGood, PGUESS_METRICS pMetricsTable);
+/**
+ * @brief qsort-style metric ordering (negative if the first argument comes first).
+ */
+typedef int (*METRIC_COMPARE_FN)(const void* arg1, const void* arg2);
 
-// Comparison Functions
-int sortMetricsByEntropyDescending(const void* arg1, const void* arg2);
-int sortMetricsByRankDescending(const void* arg1, const void* arg2);
-void printfDebug(const char* format, ...);
+/**
+ * @brief Everything one turn's recommendation prints: the top table rows, the linguistically
+ * filtered picks of both paths and the final pick. Words point into the dictionary;
+ * missing picks are "NONE" with R=0 and H=0.
+ */
+typedef struct _recommendation
+{
+    long numPossibleAnswers;
+    long numMetrics;     // Guesses scored (> numPossibleAnswers in full-dictionary mode)
+    long numRankRows;    // Valid entries in rankRows
+    long numEntropyRows; // Valid entries in entropyRows
+    GUESS_METRICS rankRows[MAX_TOP_PICKS];
+    GUESS_METRICS entropyRows[MAX_TOP_PICKS];
+    GUESS_METRICS rankPick;
+    GUESS_METRICS rankAlternate;
+    GUESS_METRICS entropyPick;
+    GUESS_METRICS entropyAlternate;
+    GUESS_METRICS finalPick;
+} RECOMMENDATION, * PRECOMMENDATION;
 
+/**
+ * @brief On-disk form of a GUESS_METRICS entry (the word pointer becomes a dictionary index).
+ */
+typedef struct _cached_metric
+{
+    int wordIndex; // Dictionary index, or -1 for "NONE"
+    int rank;
+    double entropy;
+    double remainingMass;
+    char isRisky;
+    char nounType;
+    char verbType;
+    char reserved;
+} CACHED_METRIC;
 
-// --- Function Implementations ---
+/**
+ * @brief On-disk form of a RECOMMENDATION. numPossibleAnswers == 0 marks an empty record.
+ */
+typedef struct _cached_recommendation
+{
+    int numPossibleAnswers;
+    int numMetrics;
+    int numRankRows;
+    int numEntropyRows;
+    CACHED_METRIC rankRows[MAX_TOP_PICKS];
+    CACHED_METRIC entropyRows[MAX_TOP_PICKS];
+    CACHED_METRIC picks[5]; // Rank pick, Rank alternate, Entropy pick, Entropy alternate, Final pick
+} CACHED_RECOMMENDATION;
 
 /**
- * @brief Prints a debug message if global conditions are met.
- * @param format The format string.
- * @param ... The arguments for the format string.
+ * @brief Opening cache file: header, turn-1 recommendation, then one turn-2 reply per feedback
+ * pattern of the turn-1 final pick (the opener), indexed by pattern code.
  */
-void printfDebug(const char* format, ...)
+typedef struct _opening_cache
 {
-    if (DEBUG_ON && (g_tryIdx >= DEBUG_LEVEL))
+    struct
     {
-        va_list args;
-        va_start(args, format);
-        vprintf(format, args);
-        va_end(args);
-    }
-}
+        char magic[4];
+        int version;
+        unsigned long long fingerprint; // See compute_opening_fingerprint
+        int openerIndex;                // Dictionary index of the turn-1 final pick, or -1
+        int numReplies;                 // NUM_PATTERNS
+    } header;
+    CACHED_RECOMMENDATION opening;
+    CACHED_RECOMMENDATION replies[NUM_PATTERNS];
+} OPENING_CACHE, * POPENING_CACHE;
 
 /**
- * @brief Comparison function to sort GUESS_METRICS structures by Entropy (descending),
- * with Rank (descending) as a tie-breaker.
- * @return -1 if p1 is better, 1 if p2 is better, 0 if equal.
+ * @brief Header of the compiled dictionary file. Every section starts on a BINARY_SECTION_ALIGNMENT
+ * boundary and is stored in the solver's in-memory layout, so a mapped file is used as is:
+ * WORD_ENTRY[numWords] sorted by word, then the DICTIONARY_STORE columns, then optionally the
+ * PATTERN_CODE[numWords * numWords] matrix (matrixOffset 0 when absent).
+ * A dictionary of another word length or alphabet (see VARIANT_DICTIONARY) stores its word records
+ * in the entries section (entrySize VARIANT_RECORD_SIZE(wordSize)) and has no packed section and
+ * no matrix.
  */
-int sortMetricsByEntropyDescending(const void* arg1, const void* arg2)
+typedef struct _binary_dictionary_header
 {
-    PGUESS_METRICS p1 = (PGUESS_METRICS)arg1;
-    PGUESS_METRICS p2 = (PGUESS_METRICS)arg2;
+    char magic[4];
+    int version;
+    int wordSize;     // Letters per word the file was compiled for
+    int entrySize;    // sizeof(WORD_ENTRY) of the compiler that wrote it, or VARIANT_RECORD_SIZE(wordSize) for a variant
+    int alphabetSize; // Distinct letters; selects the word kernels with wordSize
+    unsigned char alphabet[VARIANT_MAX_ALPHABET]; // Letter index -> character
+    long long numWords;
+    long long entriesOffset;
+    long long packedOffset;
+    long long ranksOffset;
+    long long nounTypesOffset;
+    long long verbTypesOffset;
+    long long matrixOffset;
+} BINARY_DICTIONARY_HEADER, * PBINARY_DICTIONARY_HEADER;
 
-    // Primary sort: Entropy (Highest H first)
-    if (FLOAT_GREATER(p1->entropy, p2->entropy)) return -1;
-    if (FLOAT_GREATER(p2->entropy, p1->entropy)) return 1;
+/**
+ * @brief The core kernels compiled for one word length and alphabet size. Words are variant word
+ * records (see VARIANT_DICTIONARY) whose letter indices are below alphabetSize; word lists are
+ * arrays of pointers to them, like the answer lists of the standard dictionary.
+ */
+typedef struct _word_kernels
+{
+    int wordLength;
+    int alphabetSize;
+    int numPatterns; // 3^wordLength
+    int (*pfnFeedbackCode)(const char* guess, const char* answer);
+    double (*pfnEntropy)(const char* guess, const char* const* ppAnswers, long numAnswers);
+    long (*pfnFilterByPattern)(const char* guess, int code, const char** ppWords, long numWords);
+} WORD_KERNELS, * PWORD_KERNELS;
 
-    // Tie-breaker: Rank (HIGHER rank number is better/more frequent)
-    return (p2->rank - p1->rank);
-}
+/**
+ * @brief A dictionary the WORD_SIZE-letter A-Z solver cannot play: another word length or an
+ * alphabet beyond A-Z. The game loop and the simulation play it with the kernels its header selects.
+ * Word i is the record pWords + i * VARIANT_RECORD_SIZE(wordLength): the word (sorted,
+ * NUL-terminated) followed by its letter indices, so a word pointer serves as text and as kernel input.
+ */
+typedef struct _variant_dictionary
+{
+    const WORD_KERNELS* pKernels; // NULL unless a variant dictionary was loaded
+    int wordLength;
+    int alphabetSize;
+    unsigned char alphabet[VARIANT_MAX_ALPHABET]; // Letter index -> character
+    long numWords;
+    char* pWords;
+    short* pRanks;
+    char* pNounTypes;
+    char* pVerbTypes;
+    bool isMapped; // The columns point into the compiled dictionary file
+} VARIANT_DICTIONARY, * PVARIANT_DICTIONARY;
 
 /**
- * @brief Comparison function to sort GUESS_METRICS structures by Rank (descending),
- * with Entropy (descending) as a tie-breaker.
- * @return -1 if p1 is better, 1 if p2 is better, 0 if equal.
+ * @brief A read-only file mapping.
  */
-int sortMetricsByRankDescending(const void* arg1, const void* arg2)
+typedef struct _mapped_file
 {
-    PGUESS_METRICS p1 = (PGUESS_METRICS)arg1;
-    PGUESS_METRICS p2 = (PGUESS_METRICS)arg2;
+    void* pBase;
+    size_t size;
+#ifdef _WIN32
+    HANDLE hMapping;
+#endif
+} MAPPED_FILE, * PMAPPED_FILE;
 
-    // Primary sort: Rank (HIGHEST numerical rank first/Descending)
-    if (p2->rank > p1->rank) return 1;
-    if (p1->rank > p2->rank) return -1;
+/**
+ * @brief Header of the used-words cache file, followed by numWords sorted 5-char words.
+ */
+typedef struct _used_words_cache_header
+{
+    char magic[4];
+    int version;
+    int numWords;
+    int reserved;
+    long long fetchedAt;                          // time() of the download (or last 304 check)
+    char etag[USED_WORDS_VALIDATOR_SIZE];         // ETag of that response, "" if none
+    char lastModified[USED_WORDS_VALIDATOR_SIZE]; // Last-Modified of that response, "" if none
+} USED_WORDS_CACHE_HEADER, * PUSED_WORDS_CACHE_HEADER;
 
-    // Tie-breaker: Entropy (highest H is better)
-    if (FLOAT_GREATER(p1->entropy, p2->entropy)) return -1;
-    if (FLOAT_GREATER(p2->entropy, p1->entropy)) return 1;
+/**
+ * @brief A growable download buffer (NUL terminated, size excludes the terminator).
+ */
+typedef struct _download_buffer
+{
+    char* pData;
+    size_t size;
+    size_t capacity;
+} DOWNLOAD_BUFFER, * PDOWNLOAD_BUFFER;
 
-    return 0;
-}
+/**
+ * @brief State of the (background) used-words refresh: the cached copy and its validators,
+ * and what the conditional request returned.
+ */
+typedef struct _used_words_fetch
+{
+    bool online;
+    bool haveCache;
+    USED_WORDS_CACHE_HEADER cacheHeader;
+    char* pCachedTable;
+    std::thread worker;
+    bool workerStarted;
+    std::atomic<bool> finished;                   // Set by the worker once the download is over
+    CURLcode result;
+    long httpStatus;
+    bool succeeded;                               // 200 with a body, or 304
+    DOWNLOAD_BUFFER body;
+    char etag[USED_WORDS_VALIDATOR_SIZE];
+    char lastModified[USED_WORDS_VALIDATOR_SIZE];
+} USED_WORDS_FETCH, * PUSED_WORDS_FETCH;
 
 /**
- * @brief Removes leading and trailing whitespace from a string.
- * @param str The string to trim.
+ * @brief One transposition table slot: the expected guesses of a fully searched answer set.
  */
-void trim(char* str)
+typedef struct _lookahead_entry
 {
-    char* ptrToWhereNullCharShouldGo = str;
-    char* currentPtr = str;
-    while (*currentPtr != '\0')
-    {
-        char ch = *currentPtr++;
-        if (ch != ' ' && ch != '\t' && ch != '\n' && ch != '\r')
-        {
-            ptrToWhereNullCharShouldGo = currentPtr;
-        }
-    }
-    *ptrToWhereNullCharShouldGo = '\0';
-}
+    unsigned long long key; // Hash of the sorted answer IDs (0 = empty)
+    long numAnswers;
+    int plies;
+    double expected;
+    long numNodes;          // Nodes the search took; a hit is charged them again
+} LOOKAHEAD_ENTRY, * PLOOKAHEAD_ENTRY;
 
 /**
- * @brief Clears the standard input buffer (required after using fgets).
+ * @brief A lock-protected part of the transposition table; sets are spread over shards by hash.
  */
-void clear_input_buffer()
+typedef struct _lookahead_shard
 {
-    int c;
-    while ((c = getchar()) != '\n' && c != EOF) {}
-}
+    std::mutex lock;
+    LOOKAHEAD_ENTRY entries[LOOKAHEAD_TT_SHARD_SLOTS];
+} LOOKAHEAD_SHARD, * PLOOKAHEAD_SHARD;
 
 /**
- * @brief Comparison function for qsort/bsearch, comparing 5-letter words alphabetically.
- * @return Standard `memcmp` result.
+ * @brief Node budget of one root bucket's search. Each bucket has its own, and transposition table
+ * hits are charged the nodes they stand for, so which sets get estimated depends only on the
+ * position, never on timing, worker interleaving or earlier searches.
  */
-int compare(const void* arg1, const void* arg2)
+typedef struct _lookahead_search
 {
-    return memcmp(arg1, arg2, WORD_SIZE);
-}
+    long numNodes;
+    long nodeBudget;
+} LOOKAHEAD_SEARCH, * PLOOKAHEAD_SEARCH;
 
 /**
- * @brief Searches the dictionary array for a given word using binary search.
- * @param word The word to search for.
- * @param pDictionary The sorted array of word entries.
- * @param numDictionary The number of entries in the dictionary.
- * @return PWORD_ENTRY Pointer to the found entry, or NULL if not found.
+ * @brief One cached recommendation, linked into its shard's most-recently-used list by slot index.
  */
-PWORD_ENTRY get_word_entry_from_word(const char* word, PWORD_ENTRY pDictionary, long numDictionary)
+typedef struct _result_cache_entry
 {
-    return (PWORD_ENTRY)bsearch(word, pDictionary, numDictionary, sizeof(WORD_ENTRY), compare);
-}
+    RECOMMENDATION recommendation;
+    int prev; // More recently used slot, or -1
+    int next; // Less recently used slot, or -1
+} RESULT_CACHE_ENTRY, * PRESULT_CACHE_ENTRY;
 
 /**
- * @brief cURL callback function to dynamically grow and store downloaded data.
- * @return The size of the data successfully handled.
+ * @brief A lock-protected part of the result cache; answer sets are spread over shards by key.
+ * Slots [0, numUsed) are in use. The keys sit apart from the entries so a lookup scans one small array.
  */
-size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp)
+typedef struct _result_cache_shard
 {
-    size_t realsize = size * nmemb;
-    char** memory = (char**)userp;
+    std::mutex lock;
+    unsigned long long keys[RESULT_CACHE_SHARD_ENTRIES];
+    long numAnswers[RESULT_CACHE_SHARD_ENTRIES];
+    int numUsed;
+    int head; // Most recently used slot, or -1
+    int tail; // Least recently used slot (evicted first), or -1
+    RESULT_CACHE_ENTRY entries[RESULT_CACHE_SHARD_ENTRIES];
+} RESULT_CACHE_SHARD, * PRESULT_CACHE_SHARD;
 
-    if (*memory == NULL)
-    {
-        *memory = (char*)malloc(realsize + 1);
-        if (*memory == NULL) return 0;
-        memcpy(*memory, contents, realsize);
-        (*memory)[realsize] = '\0';
-    }
-    else
-    {
-        size_t current_size = strlen(*memory);
-        char* ptr = (char*)realloc(*memory, current_size + realsize + 1);
-        if (ptr == NULL) return 0;
+/**
+ * @brief Header of a decision tree file, followed by numNodes DECISION_TREE_NODE records in
+ * breadth-first order. Node 0 is the start of the game, where the opener is played.
+ */
+typedef struct _decision_tree_header
+{
+    char magic[4];
+    int version;
+    unsigned long long fingerprint; // compute_opening_fingerprint of the game the tree was built for
+    WORD_ID openerId;
+    unsigned int numNodes;
+} DECISION_TREE_HEADER, * PDECISION_TREE_HEADER;
 
-        *memory = ptr;
-        memcpy(&((*memory)[current_size]), contents, realsize);
-        (*memory)[current_size + realsize] = '\0';
-    }
-    return realsize;
-}
+/**
+ * @brief One game state of the solver's policy: the picks it recommends there and the state each
+ * feedback pattern of the final pick leads to. A node's children are stored together in pattern
+ * order, so the child for pattern c is firstChild plus the number of childMask bits below c.
+ */
+typedef struct _decision_tree_node
+{
+    unsigned long long childMask[DECISION_TREE_MASK_WORDS]; // Bit c: pattern c of the final pick has a child
+    double finalEntropy;
+    double rankPickEntropy;
+    double entropyPickEntropy;
+    unsigned int firstChild;
+    unsigned int numCandidates; // Possible answers at this state (cross-checked against the live game)
+    WORD_ID finalId;            // INVALID_WORD_ID where the filter left no candidates (a lost game)
+    WORD_ID rankPickId;         // INVALID_WORD_ID for "NONE"
+    WORD_ID entropyPickId;      // INVALID_WORD_ID for "NONE"
+    unsigned int reserved;
+} DECISION_TREE_NODE, * PDECISION_TREE_NODE;
 
 /**
- * @brief Downloads the webpage containing the past Wordle answers using cURL.
- * @return A pointer to the downloaded HTML content string, or NULL on failure.
+ * @brief A loaded decision tree; the file is mapped read-only and used in place.
  */
-char* get_used_words_webpage(void)
+typedef struct _decision_tree
 {
-    CURL* curl;
-    CURLcode res;
-    char* hugeBuffer = NULL;
+    MAPPED_FILE map;
+    const DECISION_TREE_HEADER* pHeader;
+    const DECISION_TREE_NODE* pNodes;
+    long numNodes;
+} DECISION_TREE, * PDECISION_TREE;
 
-    curl_global_init(CURL_GLOBAL_DEFAULT);
-    curl = curl_easy_init();
+/**
+ * @brief The OpenCL 1.2 C API types the accelerator uses, declared here so that no OpenCL headers or
+ * import library are needed to build; the runtime is loaded when --gpu asks for it.
+ */
+typedef int cl_int;
+typedef unsigned int cl_uint;
+typedef unsigned long long cl_bitfield;
+typedef struct _cl_platform_id* cl_platform_id;
+typedef struct _cl_device_id* cl_device_id;
+typedef struct _cl_context* cl_context;
+typedef struct _cl_command_queue* cl_command_queue;
+typedef struct _cl_mem* cl_mem;
+typedef struct _cl_program* cl_program;
+typedef struct _cl_kernel* cl_kernel;
+typedef struct _cl_event* cl_event;
 
-    if (curl)
-    {
-        // Set the target URL
-        curl_easy_setopt(curl, CURLOPT_URL, "https://www.rockpapershotgun.com/wordle-past-answers");
-        // Set the callback function to handle downloaded data
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-        // Pass the address of hugeBuffer to the callback
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void*)&hugeBuffer);
-        // Follow redirects
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-        // Identify the client
-        curl_easy_setopt(curl, CURLOPT_USERAGENT, "Chrome");
+/**
+ * @brief An OpenCL device with the solver's kernels built and the packed dictionary uploaded.
+ * The entry points are resolved from the runtime library at startup (see init_accelerator).
+ */
+typedef struct _accelerator
+{
+    void* hLibrary;
+    cl_device_id device;
+    cl_context context;
+    cl_command_queue queue;
+    cl_program program;
+    cl_kernel matrixKernel;    // pattern_matrix_rows
+    cl_kernel histogramKernel; // pattern_histograms
+    cl_mem packedWords;        // The dictionary store's packed letters
+    long numWords;
+    char szDeviceName[128];
+
+    cl_int (ACCELERATOR_API* pfnGetPlatformIDs)(cl_uint numEntries, cl_platform_id* pPlatforms, cl_uint* pNumPlatforms);
+    cl_int (ACCELERATOR_API* pfnGetDeviceIDs)(cl_platform_id platform, cl_bitfield deviceType, cl_uint numEntries, cl_device_id* pDevices, cl_uint* pNumDevices);
+    cl_int (ACCELERATOR_API* pfnGetDeviceInfo)(cl_device_id device, cl_uint paramName, size_t size, void* pValue, size_t* pSizeRet);
+    cl_context (ACCELERATOR_API* pfnCreateContext)(const intptr_t* pProperties, cl_uint numDevices, const cl_device_id* pDevices, void* pfnNotify, void* pUserData, cl_int* pStatus);
+    cl_command_queue (ACCELERATOR_API* pfnCreateCommandQueue)(cl_context context, cl_device_id device, cl_bitfield properties, cl_int* pStatus);
+    cl_program (ACCELERATOR_API* pfnCreateProgramWithSource)(cl_context context, cl_uint count, const char** ppStrings, const size_t* pLengths, cl_int* pStatus);
+    cl_int (ACCELERATOR_API* pfnBuildProgram)(cl_program program, cl_uint numDevices, const cl_device_id* pDevices, const char* pszOptions, void* pfnNotify, void* pUserData);
+    cl_int (ACCELERATOR_API* pfnGetProgramBuildInfo)(cl_program program, cl_device_id device, cl_uint paramName, size_t size, void* pValue, size_t* pSizeRet);
+    cl_kernel (ACCELERATOR_API* pfnCreateKernel)(cl_program program, const char* pszName, cl_int* pStatus);
+    cl_mem (ACCELERATOR_API* pfnCreateBuffer)(cl_context context, cl_bitfield flags, size_t size, void* pHost, cl_int* pStatus);
+    cl_int (ACCELERATOR_API* pfnSetKernelArg)(cl_kernel kernel, cl_uint argIndex, size_t size, const void* pValue);
+    cl_int (ACCELERATOR_API* pfnEnqueueWriteBuffer)(cl_command_queue queue, cl_mem buffer, cl_uint blocking, size_t offset, size_t size, const void* pData, cl_uint numEvents, const cl_event* pWaitList, cl_event* pEvent);
+    cl_int (ACCELERATOR_API* pfnEnqueueReadBuffer)(cl_command_queue queue, cl_mem buffer, cl_uint blocking, size_t offset, size_t size, void* pData, cl_uint numEvents, const cl_event* pWaitList, cl_event* pEvent);
+    cl_int (ACCELERATOR_API* pfnEnqueueNDRangeKernel)(cl_command_queue queue, cl_kernel kernel, cl_uint workDim, const size_t* pOffset, const size_t* pGlobalSize, const size_t* pLocalSize, cl_uint numEvents, const cl_event* pWaitList, cl_event* pEvent);
+    cl_int (ACCELERATOR_API* pfnReleaseMemObject)(cl_mem buffer);
+    cl_int (ACCELERATOR_API* pfnReleaseKernel)(cl_kernel kernel);
+    cl_int (ACCELERATOR_API* pfnReleaseProgram)(cl_program program);
+    cl_int (ACCELERATOR_API* pfnReleaseCommandQueue)(cl_command_queue queue);
+    cl_int (ACCELERATOR_API* pfnReleaseContext)(cl_context context);
+} ACCELERATOR, * PACCELERATOR;
 
-        res = curl_easy_perform(curl);
+/**
+ * @brief How a turn's recommendation is written (see print_recommendation).
+ */
+typedef enum _output_mode
+{
+    OUTPUT_HUMAN,   // The two-column table and the final pick banner
+    OUTPUT_COMPACT, // One JSON line with the picks
+    OUTPUT_SILENT   // Nothing
+} OUTPUT_MODE;
 
-        if (res != CURLE_OK)
-        {
-            fprintf(stderr, "cURL failed: %s\n", curl_easy_strerror(res));
-            if (hugeBuffer) free(hugeBuffer);
-            hugeBuffer = NULL;
-        }
-        curl_easy_cleanup(curl);
-    }
-    curl_global_cleanup();
+/**
+ * @brief The settings of the final-pick trade-off (see determine_final_pick): one grid point of a sweep.
+ */
+typedef struct _pick_policy
+{
+    double entropyRankThreshold; // Entropy lead the Entropy pick needs over the Rank pick in large sets
+    int lowAnswerCount;          // Sets of at most this many answers take the absolute top Rank entry
+} PICK_POLICY, * PPICK_POLICY;
 
-    if (hugeBuffer == NULL)
-    {
-        fprintf(stderr, "Failed to download webpage content.\n");
-    }
-    else
-    {
-        printf("Webpage content downloaded successfully.\n");
-    }
-    return hugeBuffer;
-}
+/**
+ * @brief An inclusive range of sweep values, first to last in steps of step (a single value when step is 0).
+ */
+typedef struct _sweep_range
+{
+    double first;
+    double last;
+    double step;
+} SWEEP_RANGE, * PSWEEP_RANGE;
 
 /**
- * @brief Processes the HTML content to extract the list of past Wordle answers.
- * Words flagged in g_wordle_replay_words are excluded from this list.
- * @param pszWebPage The downloaded HTML content string.
- * @return PWORD_LIST A linked list of used words to be excluded from the answer set.
+ * @brief Runtime options parsed from the command line.
  */
-PWORD_LIST get_used_words_from_webpage_string(char* pszWebPage)
+typedef struct _solver_options
 {
-    PWORD_LIST pTop = NULL;
-    PWORD_NODE* ppNextNew = &pTop;
-    PWORD_NODE pNew;
+    int numThreads; // Worker threads for parallel scoring (0 = one per hardware thread)
+    bool scoreFullDictionary; // Score every dictionary word as a guess, not just the remaining answers
+    bool useOpeningCache;     // Load/save the turn-1 and turn-2 analysis in the opening cache (and share results between games)
+    bool simulate;            // Play every possible answer headlessly instead of the interactive loop
+    bool exactFilter;         // Also narrow candidates to those giving exactly the observed pattern
+    bool disableSimd;         // Use the scalar feedback kernel even if the CPU has a vector one
+    bool offline;             // Use the cached used-word list without touching the network
+    bool compileDictionary;   // Convert AllWords.txt into the binary dictionary and exit
+    bool server;              // Serve many games over JSON lines on stdin/stdout
+    int lookaheadPlies;       // Guesses the expectimax search looks ahead (0 = one-ply entropy/rank pick)
+    bool stats;               // Collect stage timers and counters and print them per turn (to stderr)
+    bool bench;               // Time the core kernels against their reference implementations and exit
+    bool quiet;               // Suppress printfDebug output (set by the batch modes)
+    const char* pszBatchPath; // Answer the game histories in this file ("-" = stdin) and exit, or NULL
+    bool csvOutput;           // Write batch answers as CSV instead of JSON lines
+    OUTPUT_MODE outputMode;   // How interactive turns print their recommendation
+    const char* pszExportTreePath; // Write the policy tree from the opener to this file and exit, or NULL
+    const char* pszOpener;         // First guess of the exported tree (NULL = the turn-1 final pick)
+    const char* pszTreePath;       // Decision tree the server answers on-policy games from, or NULL
+    long sampleSize;               // Answers sampled to estimate entropies of large answer sets (0 = always exact)
+    bool priorWeighted;            // Weight answers by rank and pick from one order by expected remaining mass
+    bool useAccelerator;           // Build the matrix and score large passes on an OpenCL device when one is present
+    PICK_POLICY pickPolicy;        // Final-pick trade-off of every recommendation
+    bool sweep;                    // Simulate every grid point of sweepThresholds x sweepCounts instead of one policy
+    SWEEP_RANGE sweepThresholds;   // Entropy/rank thresholds of the sweep
+    SWEEP_RANGE sweepCounts;       // Low answer counts of the sweep
+    const char* pszDataDir;        // Directory of AllWords.txt / AllWords.wdict (NULL = environment or build default)
+    const char* pszCacheDir;       // Directory of the used-words and opening caches (NULL = environment or build default)
+} SOLVER_OPTIONS, * PSOLVER_OPTIONS;
+
+SOLVER_OPTIONS g_options = { 0, false, true, false, false, false, false, false, false, 0, false, false, false, NULL, false, OUTPUT_HUMAN, NULL, NULL, NULL, 0, false, false,
+    { ENTROPY_RANK_THRESHOLD, LOW_POSSIBLE_ANSWER_COUNT }, false, { ENTROPY_RANK_THRESHOLD, ENTROPY_RANK_THRESHOLD, 0.0 }, { LOW_POSSIBLE_ANSWER_COUNT, LOW_POSSIBLE_ANSWER_COUNT, 0.0 }, NULL, NULL };
 
-    char* pTmp;
-    const char* sectionHeader = "<h2>All Wordle answers</h2>";
-    const char* wordStartTag = "<li>";
-    const char* wordEndTag = "</li>";
-    const char* listEndTag = "</ul>";
-    const char* nonWordChars = " \t\n\r\v";
+/**
+ * @brief Instrumented stages. Each one accumulates wall time and process CPU time (all threads)
+ * while it runs; stages running on several threads at once add up their spans.
+ */
+typedef enum _stat_stage
+{
+    STAT_STAGE_DICTIONARY, // Loading or mapping the dictionary
+    STAT_STAGE_USED_WORDS, // Downloading the past-answer page (background thread)
+    STAT_STAGE_MATRIX,     // Building or mapping the pattern matrix
+    STAT_STAGE_FILTER,     // Narrowing the candidates after a guess
+    STAT_STAGE_METRICS,    // Scoring every guess
+    STAT_STAGE_SELECT,     // Top-K selection, picks and final pick
+    STAT_STAGE_LOOKAHEAD,  // Expected-guesses search
+    STAT_STAGE_PRINT,      // Printing the recommendation
+    STAT_NUM_STAGES
+} STAT_STAGE;
 
-    numUsedWords = 0;
+/**
+ * @brief Instrumented event counters.
+ */
+typedef enum _stat_counter
+{
+    STAT_PATTERN_EVALUATIONS, // Feedback patterns computed or looked up
+    STAT_DISTINCT_PATTERNS,   // Distinct patterns the final pick can produce over the answers
+    STAT_ALLOCATIONS,         // Heap allocations on the per-turn paths
+    STAT_RESULT_CACHE_HITS,   // Recommendations taken from the result cache
+    STAT_RESULT_CACHE_MISSES, // Recommendations computed and added to the result cache
+    STAT_DECISION_TREE_HITS,  // Server turns answered from the decision tree
+    STAT_SAMPLED_GUESSES,     // Guesses whose entropy was estimated from an answer sample
+    STAT_EXACT_RESCORES,      // Sampled guesses rescored exactly because their bound could matter
+    STAT_ACCELERATED_PASSES,  // Scoring passes run on the OpenCL device
+    STAT_NUM_COUNTERS
+} STAT_COUNTER;
+
+/**
+ * @brief Totals since the last report_stats. Updated with relaxed atomics from any thread.
+ */
+typedef struct _solver_stats
+{
+    std::atomic<long long> wallNs[STAT_NUM_STAGES];
+    std::atomic<long long> cpuNs[STAT_NUM_STAGES];
+    std::atomic<long long> counters[STAT_NUM_COUNTERS];
+} SOLVER_STATS;
+
+/**
+ * @brief A running stage measurement (inactive, and free, when --stats is off).
+ */
+typedef struct _stat_timer
+{
+    bool active;
+    std::chrono::steady_clock::time_point wallStart;
+    double cpuStart;
+} STAT_TIMER;
+
+/**
+ * @brief Callback for parallel_for: processes items [begin, end) on the worker identified by workerIdx.
+ * workerIdx is only unique within a single parallel_for call.
+ */
+typedef void (*PARALLEL_RANGE_FN)(long begin, long end, int workerIdx, void* pContext);
+
+/**
+ * @brief One worker's share of a parallel_for loop. Owners and thieves both claim chunks from 'next'.
+ * Aligned to a cache line so workers claiming from their own range do not contend.
+ */
+typedef struct _work_range
+{
+    alignas(64) std::atomic<long> next;
+    long end;
+} WORK_RANGE, * PWORK_RANGE;
+
+/**
+ * @brief The persistent parallel_for worker threads. Pool thread i is worker i + 1 (the caller is
+ * worker 0); threads park on 'wake' between loops and the caller waits on 'done' for the last one.
+ * One loop runs at a time, published under 'lock' with a new generation number.
+ */
+typedef struct _parallel_pool
+{
+    std::mutex submitLock;       // Held by the thread running a loop on the pool
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::thread* pThreads;       // PARALLEL_MAX_WORKERS - 1 slots, allocated with the first thread
+    int numThreads;              // Pool threads started so far
+    unsigned long generation;    // Bumped each time a loop is published
+    int numWorkers;              // Workers of the current loop, the caller included
+    int numActive;               // Pool threads still working on the current loop
+    bool shuttingDown;
+    PWORK_RANGE pRanges;
+    long chunkSize;
+    PARALLEL_RANGE_FN fn;
+    void* pContext;
+} PARALLEL_POOL, * PPARALLEL_POOL;
+
+/**
+ * @brief A heap block holding an arena allocation the arena had no room for. Spills are freed
+ * when the arena is next emptied, and the arena block then grows to the peak demand seen.
+ */
+typedef struct _scratch_spill
+{
+    struct _scratch_spill* pNext;
+} SCRATCH_SPILL, * PSCRATCH_SPILL;
+
+/**
+ * @brief Bump allocator for transient solver data. Allocations are released together, in O(1),
+ * by rolling back to a mark, so once the block has grown to a turn's peak a turn makes no heap calls.
+ * Each thread owns one arena at a time (see get_scratch_arena).
+ */
+typedef struct _scratch_arena
+{
+    unsigned char* pBase;
+    size_t capacity;
+    size_t used;
+    size_t spilled;                   // Bytes currently held in spill blocks
+    size_t peak;                      // Most bytes live at once (block plus spills)
+    PSCRATCH_SPILL pSpills;
+    struct _scratch_arena* pNextFree; // Link in the pool of idle arenas
+} SCRATCH_ARENA, * PSCRATCH_ARENA;
+
+/**
+ * @brief Collects one turn's output so it reaches stdout in a single write. Text goes into the
+ * inline block until it is full, then into a heap block that doubles as needed.
+ */
+typedef struct _output_buffer
+{
+    char* pData;   // inlineData or a heap block
+    size_t length;
+    size_t capacity;
+    char inlineData[OUTPUT_INLINE_SIZE];
+} OUTPUT_BUFFER, * POUTPUT_BUFFER;
+
+// The sorted dictionary that word IDs (pattern matrix rows/columns) refer to.
+DICTIONARY_STORE g_dictionaryStore = { 0, NULL, NULL, NULL, NULL, NULL, NULL, NULL, false };
+
+// The compiled dictionary file, when the dictionary was mapped from it (NULL for the text file).
+MAPPED_FILE g_dictionaryMapping;
+const BINARY_DICTIONARY_HEADER* g_pBinaryDictionary = NULL;
+
+// The dictionary of another word length or alphabet, when one was loaded instead (see VARIANT_DICTIONARY).
+VARIANT_DICTIONARY g_variantDictionary;
+
+// Shared feedback pattern matrix: built once at startup, read-only afterwards.
+PATTERN_MATRIX g_patternMatrix = { NULL, NULL, 0, false, false, false };
+
+// Feedback kernel chosen by select_feedback_kernel.
+FEEDBACK_KERNEL_FN g_pFeedbackKernel = NULL;
+const char* g_pszFeedbackKernelName = "none";
+
+// Candidate filter bitsets: built once at startup, read-only afterwards.
+FILTER_INDEX g_filterIndex = { NULL, 0, 0 };
+
+// Words with 'letter' (0-25) at 'pos'.
+static inline unsigned long long* filter_index_position_set(int pos, int letter)
+{
+    return g_filterIndex.pBits + (size_t)(pos * 26 + letter) * g_filterIndex.numBlocks;
+}
+
+// Words with at least minCountIdx + 1 copies of 'letter' (0-25).
+static inline unsigned long long* filter_index_min_count_set(int letter, int minCountIdx)
+{
+    return g_filterIndex.pBits + (size_t)(FILTER_INDEX_POSITION_SETS + letter * WORD_SIZE + minCountIdx) * g_filterIndex.numBlocks;
+}
+
+// Stage timers and counters for --stats.
+SOLVER_STATS g_stats;
+const char* g_pszStatStageNames[STAT_NUM_STAGES] = { "dictionary", "used_words", "matrix", "filter", "metrics", "select", "lookahead", "print" };
+const char* g_pszStatCounterNames[STAT_NUM_COUNTERS] = { "pattern_evals", "distinct_patterns", "allocations", "result_cache_hits", "result_cache_misses", "tree_hits", "sampled_guesses", "exact_rescores", "accelerated_passes" };
+
+// Lookahead transposition table: allocated at startup with --lookahead, shared by every search.
+PLOOKAHEAD_SHARD g_pLookaheadTable = NULL;
+
+// Result cache: allocated at startup for the server and simulation modes, shared by every game.
+PRESULT_CACHE_SHARD g_pResultCache = NULL;
+
+// Decision tree loaded with --tree; read-only while the server runs.
+DECISION_TREE g_decisionTree;
+
+// OpenCL device (--gpu). The lock serializes device use between games scored in parallel.
+ACCELERATOR g_accelerator;
+std::mutex g_acceleratorLock;
+std::atomic<bool> g_acceleratorReady(false);
+
+// Stream print_recommendation writes to: stdout, or the protocol stream of --output compact/silent.
+FILE* g_fpRecommendations = NULL;
+
+// count * log2(count) lookup for the entropy sum, indexed by bucket count.
+double* g_pCountLog2Table = NULL;
+long g_countLog2TableSize = 0;
+
+// --- Function Prototypes ---
+
+// Standard C/Utility Functions
+void trim(char* str);
+void clear_input_buffer();
+int compare(const void* arg1, const void* arg2);
+
+// Data Loading and Parsing
+PWORD_ENTRY get_word_entry_from_word(const char* word, PWORD_ENTRY pDictionary, long numDictionary);
+bool resolve_data_paths();
+PWORD_ENTRY get_dictionary_table();
+PWORD_ENTRY load_text_dictionary();
+PWORD_ENTRY load_binary_dictionary(const char* pszPath);
+bool write_binary_dictionary(const char* pszPath, PWORD_ENTRY pDictionary, long numDictionary);
+void release_dictionary_table(PWORD_ENTRY pDictionary);
+bool write_variant_binary_dictionary(const char* pszPath);
+void free_variant_dictionary();
+bool map_file_readonly(const char* pszPath, PMAPPED_FILE pMap);
+void unmap_file(PMAPPED_FILE pMap);
+char* get_used_words_table();
+PWORD_LIST get_used_words_from_webpage_string(char* pszWebPage);
+void get_used_words_webpage(PUSED_WORDS_FETCH pFetch);
+size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp);
+size_t header_callback(char* buffer, size_t size, size_t nitems, void* userp);
+char* build_used_words_table(PWORD_LIST pUsedWords);
+bool load_used_words_cache(const char* pszPath, PUSED_WORDS_CACHE_HEADER pHeader, char** ppTable);
+bool save_used_words_cache(const char* pszPath, PUSED_WORDS_CACHE_HEADER pHeader, const char* pTable);
+void start_used_words_fetch(PUSED_WORDS_FETCH pFetch);
+bool is_used_words_fetch_pending(PUSED_WORDS_FETCH pFetch);
+char* finish_used_words_fetch(PUSED_WORDS_FETCH pFetch);
+long build_initial_answers(PWORD_ENTRY pDictionary, long numDictionary, const char* pUsedWordsTable, long numUsed, char** pPossibleAnswers);
+
+// Core Solver Logic
+int is_good_fit(char* pMask, char notMask[6][5], char* pGood, char* pBad, char* pWord);
+long filter_possible_answers(const char** pPossibleAnswers, long numCurrentAnswers, char* pMask, char notMask[6][5], char* pGood, char* pBad, long numTries);
+long filter_possible_answers_by_pattern(const char* guess, PATTERN_CODE code, const char** pPossibleAnswers, long numCurrentAnswers);
+long filter_possible_answers_after_guess(const char* guess, const char* result_pattern, const char** pPossibleAnswers, long numCurrentAnswers, char* pMask, char notMask[6][5], char* pGood, char* pBad, int tryIdx);
+bool build_filter_index(PWORD_ENTRY pDictionary, long numDictionary);
+void free_filter_index();
+void get_feedback_pattern(const char* guess, const char* answer, char* result_pattern);
+PATTERN_CODE get_feedback_pattern_code(const char* guess, const char* answer);
+const WORD_KERNELS* select_word_kernels(int wordLength, int alphabetSize);
+PATTERN_CODE encode_feedback_pattern(const char* result_pattern);
+void decode_feedback_pattern(PATTERN_CODE code, char* result_pattern);
+bool build_dictionary_store(PWORD_ENTRY pDictionary, long numDictionary);
+void free_dictionary_store();
+double get_prior_weight(int rank);
+long get_dictionary_index(const char* word);
+WORD_ID get_word_id(const char* word);
+const char* get_word_text(WORD_ID id);
+PATTERN_CODE get_feedback_pattern_code_packed(unsigned int packedGuess, unsigned int packedAnswer);
+PATTERN_CODE lookup_feedback_pattern_code(const char* guess, const char* answer);
+bool pack_words(PWORD_ENTRY pDictionary, long numDictionary, PPACKED_WORDS pPacked);
+void free_packed_words(PPACKED_WORDS pPacked);
+void select_feedback_kernel();
+
+// Accelerator Offload
+bool init_accelerator();
+void free_accelerator();
+bool accelerator_build_pattern_matrix(PATTERN_CODE* pCodes, long numWords);
+bool accelerator_tally_histograms(const WORD_ID* pGuessIds, long numGuesses, const WORD_ID* pAnswerIds, long numAnswers, unsigned int* pCounts);
+bool build_pattern_matrix(PWORD_ENTRY pDictionary, long numDictionary);
+long verify_pattern_matrix(long numSamples);
+void free_pattern_matrix();
+bool build_count_log2_table(long maxCount);
+void free_count_log2_table();
+double calculate_entropy_score(const char* guess, const char** possibleAnswers, long numPossibleAnswers);
+double calculate_entropy_score_ids(WORD_ID guessId, const WORD_ID* pAnswerIds, long numPossibleAnswers);
+double calculate_weighted_score_ids(WORD_ID guessId, const WORD_ID* pAnswerIds, long numPossibleAnswers, double totalWeight, double* pRemainingMass);
+double calculate_entropy_score_bounded(WORD_ID guessId, const WORD_ID* pAnswerIds, long numPossibleAnswers, double threshold, bool* pPruned);
+void init_pattern_histograms(PPATTERN_HISTOGRAMS pHistograms);
+void free_pattern_histograms(PPATTERN_HISTOGRAMS pHistograms);
+bool sync_pattern_histograms(PPATTERN_HISTOGRAMS pHistograms, const WORD_ID* pAnswerIds, long numAnswers, const WORD_ID* pGuessIds, long numGuesses);
+double get_histogram_entropy(const PATTERN_HISTOGRAMS* pHistograms, WORD_ID guessId);
+double get_histogram_entropy_bounded(const PATTERN_HISTOGRAMS* pHistograms, WORD_ID guessId, double threshold, bool* pPruned);
+void count_letters(const char* pLetters, int numLetters, PLETTER_COUNTS pCounts);
+bool is_guess_word_risky(const char* guess, char* pGood);
+
+// Recommendation/Refactored Logic
+void update_game_constraints(const char* guess, const char* result_pattern, char* pMask, char notMask[6][5], char* pGood, char* pBad, int tryIdx);
+long calculate_all_metrics(const char** pPossibleAnswers, long numPossibleAnswers, char* pGood, PGUESS_METRICS pMetricsTable, long numWordsInDictionary, PPATTERN_HISTOGRAMS pHistograms);
+void select_top_metrics(const GUESS_METRICS* pMetrics, long numMetrics, METRIC_COMPARE_FN compareFn, PTOP_METRICS pTop);
+bool is_linguistically_clean(const GUESS_METRICS* pMetric);
+void find_top_linguistic_picks(const GUESS_METRICS* pMetrics, const TOP_METRICS* pTop, long numMetrics, PICK_DATA* pResult);
+void render_recommendation_table(const RECOMMENDATION* pRec, POUTPUT_BUFFER pOut);
+void determine_final_pick(const GUESS_METRICS* pTopRanked, long numPossibleAnswers, const PICK_DATA* rankPicks, const PICK_DATA* entropyPicks, const PICK_POLICY* pPolicy, PGUESS_METRICS pFinalPick);
+void resolve_final_pick(const RECOMMENDATION* pRec, const PICK_POLICY* pPolicy, PGUESS_METRICS pFinalPick);
+void render_final_pick(const GUESS_METRICS* pFinalPick, POUTPUT_BUFFER pOut);
+void render_compact_recommendation(const RECOMMENDATION* pRec, POUTPUT_BUFFER pOut);
+bool compute_recommendation(const char** pPossibleAnswers, long numPossibleAnswers, char* pGood, PGUESS_METRICS pMetricsTable, PPATTERN_HISTOGRAMS pHistograms, PRECOMMENDATION pRec);
+void print_recommendation(const RECOMMENDATION* pRec);
+long count_distinct_patterns(const char* guess, const char** pPossibleAnswers, long numPossibleAnswers);
+void analyze_and_print_recommendations(const char** pPossibleAnswers, long numPossibleAnswers, char* pGood, PGUESS_METRICS pMetricsTable, PPATTERN_HISTOGRAMS pHistograms);
+void init_game_constraints(char* pMask, char notMask[6][5], char* pGood, char* pBad);
+
+// Lookahead Search
+bool init_lookahead_table();
+void free_lookahead_table();
+void apply_lookahead(const char** pPossibleAnswers, long numPossibleAnswers, PRECOMMENDATION pRec);
+
+// Opening Cache
+unsigned long long fnv1a_hash(unsigned long long hash, const void* pData, size_t size);
+unsigned long long compute_opening_fingerprint(PWORD_ENTRY pDictionary, long numDictionary, const char** pPossibleAnswers, long numPossibleAnswers);
+void pack_cached_recommendation(const RECOMMENDATION* pRec, CACHED_RECOMMENDATION* pCached);
+bool unpack_cached_recommendation(const CACHED_RECOMMENDATION* pCached, PWORD_ENTRY pDictionary, long numDictionary, PRECOMMENDATION pRec);
+bool build_opening_cache(const char** pPossibleAnswers, long numPossibleAnswers, PGUESS_METRICS pMetricsTable, const RECOMMENDATION* pOpening, unsigned long long fingerprint, POPENING_CACHE pCache);
+bool load_opening_cache(const char* pszPath, unsigned long long fingerprint, POPENING_CACHE pCache);
+bool save_opening_cache(const char* pszPath, const OPENING_CACHE* pCache);
+
+// Result Cache
+bool init_result_cache();
+void free_result_cache();
+unsigned long long compute_result_key(const char** pPossibleAnswers, long numPossibleAnswers, const char* pGood);
+bool lookup_result_cache(unsigned long long key, long numPossibleAnswers, PRECOMMENDATION pRec);
+void store_result_cache(unsigned long long key, long numPossibleAnswers, const RECOMMENDATION* pRec);
+bool get_shared_recommendation(const char** pPossibleAnswers, long numPossibleAnswers, char* pGood, PGUESS_METRICS pMetricsTable, PPATTERN_HISTOGRAMS pHistograms, PRECOMMENDATION pRec);
+
+// Batch Simulation
+void ensure_pattern_matrix(PWORD_ENTRY pDictionary, long numDictionary);
+bool get_opening_recommendation(PWORD_ENTRY pDictionary, const char** pPossibleAnswers, long numPossibleAnswers, PGUESS_METRICS pMetricsTable, POPENING_CACHE pOpeningCache, PRECOMMENDATION pRec, bool* pHaveOpeningCache);
+void print_guess_histogram(const long* histogram, long numGames);
+bool run_simulation(PWORD_ENTRY pDictionary, const char** pPossibleAnswers, long numPossibleAnswers, const RECOMMENDATION* pOpening, const OPENING_CACHE* pOpeningCache);
+bool run_parameter_sweep(PWORD_ENTRY pDictionary, const char** pPossibleAnswers, long numPossibleAnswers, const RECOMMENDATION* pOpening, const OPENING_CACHE* pOpeningCache);
+bool run_benchmarks(PWORD_ENTRY pDictionary, const char** pPossibleAnswers, long numPossibleAnswers, const RECOMMENDATION* pOpening, const OPENING_CACHE* pOpeningCache);
+
+// Variant Dictionaries
+bool parse_variant_guess(char* pszGuess);
+int encode_variant_pattern(const char* pszPattern, int wordLength);
+bool compute_variant_recommendation(const char** pPossibleAnswers, long numPossibleAnswers, const char* pGood, PGUESS_METRICS pMetricsTable, PRECOMMENDATION pRec);
+long apply_feedback_code(const WORD_KERNELS* pKernels, const char* guess, int code, const char** pPossibleAnswers, long numPossibleAnswers,
+    char* pMask, char notMask[6][5], char* pGood, char* pBad, int tryIdx);
+bool apply_variant_options();
+
+// Server Mode
+FILE* open_protocol_stream();
+bool get_opener_reply(const OPENING_CACHE* pOpeningCache, PWORD_ENTRY pDictionary, const char* guess, const char* pattern, long numCandidates, PRECOMMENDATION pRec);
+bool run_server(PWORD_ENTRY pDictionary, const char** pPossibleAnswers, long numPossibleAnswers, const RECOMMENDATION* pOpening, const OPENING_CACHE* pOpeningCache, FILE* fpOut);
+
+// Batch Queries
+bool run_batch(PWORD_ENTRY pDictionary, const char** pPossibleAnswers, long numPossibleAnswers, const OPENING_CACHE* pOpeningCache, const char* pszPath, FILE* fpOut);
+
+// Decision Tree
+bool export_decision_tree(PWORD_ENTRY pDictionary, const char** pPossibleAnswers, long numPossibleAnswers, const RECOMMENDATION* pOpening, const OPENING_CACHE* pOpeningCache, const char* pszOpener, const char* pszPath);
+bool save_decision_tree(const char* pszPath, unsigned long long fingerprint, WORD_ID openerId, const DECISION_TREE_NODE* pNodes, long numNodes);
+bool load_decision_tree(const char* pszPath, unsigned long long fingerprint, PDECISION_TREE pTree);
+void free_decision_tree(PDECISION_TREE pTree);
+long find_decision_tree_child(const DECISION_TREE* pTree, long nodeIdx, const char* guess, PATTERN_CODE code, long numCandidates);
+void get_decision_tree_recommendation(const DECISION_TREE_NODE* pNode, PRECOMMENDATION pRec);
+
+// Comparison Functions
+int sortMetricsByEntropyDescending(const void* arg1, const void* arg2);
+int sortMetricsByRankDescending(const void* arg1, const void* arg2);
+int sortMetricsByRemainingMassAscending(const void* arg1, const void* arg2);
+void printfDebug(const char* format, ...);
+
+// Instrumentation
+void stats_start(STAT_TIMER* pTimer);
+void stats_stop(STAT_TIMER* pTimer, STAT_STAGE stage);
+void report_stats(const char* pszEvent, int turn, long numPossibleAnswers);
+
+// Command Line and Parallel Scheduling
+bool parse_command_line(int argc, char* argv[], PSOLVER_OPTIONS pOptions);
+void print_usage(const char* programName);
+int get_worker_thread_count();
+void parallel_for(long count, long chunkSize, PARALLEL_RANGE_FN fn, void* pContext);
+void shutdown_parallel_pool();
+
+// Scratch arenas
+PSCRATCH_ARENA get_scratch_arena();
+size_t scratch_mark(PSCRATCH_ARENA pArena);
+void* scratch_alloc(PSCRATCH_ARENA pArena, size_t size);
+void* scratch_calloc(PSCRATCH_ARENA pArena, size_t count, size_t size);
+void scratch_release(PSCRATCH_ARENA pArena, size_t mark);
+void release_thread_scratch_arena();
+void free_scratch_arenas();
+
+// Buffered Output
+void init_output_buffer(POUTPUT_BUFFER pOut);
+void output_printf(POUTPUT_BUFFER pOut, const char* format, ...);
+void output_pad(POUTPUT_BUFFER pOut, size_t columnStart, int width);
+void flush_output_buffer(POUTPUT_BUFFER pOut, FILE* fp);
+
+
+// --- Function Implementations ---
+
+/**
+ * @brief Prints a debug message if global conditions are met.
+ * @param format The format string.
+ * @param ... The arguments for the format string.
+ */
+void printfDebug(const char* format, ...)
+{
+    if (DEBUG_ON && !g_options.quiet && (g_tryIdx >= DEBUG_LEVEL))
+    {
+        va_list args;
+        va_start(args, format);
+        vprintf(format, args);
+        va_end(args);
+    }
+}
+
+// --- Instrumentation ---
+
+/**
+ * @brief Returns the CPU time used so far by every thread of the process.
+ */
+static double get_process_cpu_seconds()
+{
+#ifdef _WIN32
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) return 0.0;
+    ULARGE_INTEGER kernel, user;
+    kernel.LowPart = kernelTime.dwLowDateTime;
+    kernel.HighPart = kernelTime.dwHighDateTime;
+    user.LowPart = userTime.dwLowDateTime;
+    user.HighPart = userTime.dwHighDateTime;
+    return (double)(kernel.QuadPart + user.QuadPart) * 1e-7; // 100 ns units
+#else
+    struct timespec ts;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0) return 0.0;
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+/**
+ * @brief Returns the peak resident memory of the process in KB (0 if unavailable).
+ */
+static long long get_peak_memory_kb()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return (long long)(counters.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // Bytes on macOS
+#else
+    return usage.ru_maxrss;        // KB on Linux
+#endif
+#endif
+}
+
+/**
+ * @brief Starts timing a stage. Without --stats this is a single flag test.
+ */
+void stats_start(STAT_TIMER* pTimer)
+{
+    pTimer->active = g_options.stats;
+    if (!pTimer->active) return;
+    pTimer->wallStart = std::chrono::steady_clock::now();
+    pTimer->cpuStart = get_process_cpu_seconds();
+}
+
+/**
+ * @brief Adds the time since stats_start to a stage.
+ */
+void stats_stop(STAT_TIMER* pTimer, STAT_STAGE stage)
+{
+    if (!pTimer->active) return;
+    long long wallNs = (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - pTimer->wallStart).count();
+    long long cpuNs = (long long)((get_process_cpu_seconds() - pTimer->cpuStart) * 1e9);
+    g_stats.wallNs[stage].fetch_add(wallNs, std::memory_order_relaxed);
+    g_stats.cpuNs[stage].fetch_add(cpuNs, std::memory_order_relaxed);
+    pTimer->active = false;
+}
+
+/**
+ * @brief Adds to a counter (a flag test when --stats is off).
+ */
+static inline void stats_count(STAT_COUNTER counter, long long amount)
+{
+    if (g_options.stats) g_stats.counters[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Prints the stage times and counters accumulated since the previous report as one JSON line
+ * on stderr, then resets them. Does nothing without --stats.
+ * @param pszEvent What the line covers ("startup", "turn", "simulation", "server" or "batch").
+ * @param turn The turn number (0 when not applicable).
+ * @param numPossibleAnswers The possible answers at the end of the span.
+ */
+void report_stats(const char* pszEvent, int turn, long numPossibleAnswers)
+{
+    if (!g_options.stats) return;
+
+    fprintf(stderr, "{\"stats\":\"%s\",\"turn\":%d,\"answers\":%ld,\"wall_ms\":{", pszEvent, turn, numPossibleAnswers);
+    for (int s = 0; s < STAT_NUM_STAGES; s++)
+    {
+        fprintf(stderr, "%s\"%s\":%.3f", s ? "," : "", g_pszStatStageNames[s], g_stats.wallNs[s].exchange(0) * 1e-6);
+    }
+    fprintf(stderr, "},\"cpu_ms\":{");
+    for (int s = 0; s < STAT_NUM_STAGES; s++)
+    {
+        fprintf(stderr, "%s\"%s\":%.3f", s ? "," : "", g_pszStatStageNames[s], g_stats.cpuNs[s].exchange(0) * 1e-6);
+    }
+    fprintf(stderr, "}");
+    for (int c = 0; c < STAT_NUM_COUNTERS; c++)
+    {
+        fprintf(stderr, ",\"%s\":%lld", g_pszStatCounterNames[c], g_stats.counters[c].exchange(0));
+    }
+    fprintf(stderr, ",\"peak_memory_kb\":%lld}\n", get_peak_memory_kb());
+}
+
+/**
+ * @brief Comparison function to sort GUESS_METRICS structures by Entropy (descending),
+ * with Rank (descending) as a tie-breaker.
+ * @return -1 if p1 is better, 1 if p2 is better, 0 if equal.
+ */
+int sortMetricsByEntropyDescending(const void* arg1, const void* arg2)
+{
+    PGUESS_METRICS p1 = (PGUESS_METRICS)arg1;
+    PGUESS_METRICS p2 = (PGUESS_METRICS)arg2;
+
+    // Primary sort: Entropy (Highest H first)
+    if (FLOAT_GREATER(p1->entropy, p2->entropy)) return -1;
+    if (FLOAT_GREATER(p2->entropy, p1->entropy)) return 1;
+
+    // Tie-breaker: Rank (HIGHER rank number is better/more frequent)
+    return (p2->rank - p1->rank);
+}
+
+/**
+ * @brief Comparison function to sort GUESS_METRICS structures by Rank (descending),
+ * with Entropy (descending) as a tie-breaker.
+ * @return -1 if p1 is better, 1 if p2 is better, 0 if equal.
+ */
+int sortMetricsByRankDescending(const void* arg1, const void* arg2)
+{
+    PGUESS_METRICS p1 = (PGUESS_METRICS)arg1;
+    PGUESS_METRICS p2 = (PGUESS_METRICS)arg2;
+
+    // Primary sort: Rank (HIGHEST numerical rank first/Descending)
+    if (p2->rank > p1->rank) return 1;
+    if (p1->rank > p2->rank) return -1;
+
+    // Tie-breaker: Entropy (highest H is better)
+    if (FLOAT_GREATER(p1->entropy, p2->entropy)) return -1;
+    if (FLOAT_GREATER(p2->entropy, p1->entropy)) return 1;
+
+    return 0;
+}
+
+/**
+ * @brief Comparison function to sort GUESS_METRICS structures by expected remaining mass (ascending,
+ * see --weighted), with Entropy (descending) and then Rank (descending) as tie-breakers.
+ * @return -1 if p1 is better, 1 if p2 is better, 0 if equal.
+ */
+int sortMetricsByRemainingMassAscending(const void* arg1, const void* arg2)
+{
+    PGUESS_METRICS p1 = (PGUESS_METRICS)arg1;
+    PGUESS_METRICS p2 = (PGUESS_METRICS)arg2;
+
+    // Primary sort: Remaining mass (lowest M first)
+    if (FLOAT_GREATER(p2->remainingMass, p1->remainingMass)) return -1;
+    if (FLOAT_GREATER(p1->remainingMass, p2->remainingMass)) return 1;
+
+    // Tie-breakers: Entropy (highest H is better), then Rank
+    if (FLOAT_GREATER(p1->entropy, p2->entropy)) return -1;
+    if (FLOAT_GREATER(p2->entropy, p1->entropy)) return 1;
+
+    return (p2->rank - p1->rank);
+}
+
+/**
+ * @brief Removes leading and trailing whitespace from a string.
+ * @param str The string to trim.
+ */
+void trim(char* str)
+{
+    char* ptrToWhereNullCharShouldGo = str;
+    char* currentPtr = str;
+    while (*currentPtr != '\0')
+    {
+        char ch = *currentPtr++;
+        if (ch != ' ' && ch != '\t' && ch != '\n' && ch != '\r')
+        {
+            ptrToWhereNullCharShouldGo = currentPtr;
+        }
+    }
+    *ptrToWhereNullCharShouldGo = '\0';
+}
+
+/**
+ * @brief Clears the standard input buffer (required after using fgets).
+ */
+void clear_input_buffer()
+{
+    int c;
+    while ((c = getchar()) != '\n' && c != EOF) {}
+}
+
+/**
+ * @brief Comparison function for qsort/bsearch, comparing 5-letter words alphabetically.
+ * @return Standard `memcmp` result.
+ */
+int compare(const void* arg1, const void* arg2)
+{
+    return memcmp(arg1, arg2, WORD_SIZE);
+}
+
+/**
+ * @brief Searches the dictionary array for a given word using binary search.
+ * @param word The word to search for.
+ * @param pDictionary The sorted array of word entries.
+ * @param numDictionary The number of entries in the dictionary.
+ * @return PWORD_ENTRY Pointer to the found entry, or NULL if not found.
+ */
+PWORD_ENTRY get_word_entry_from_word(const char* word, PWORD_ENTRY pDictionary, long numDictionary)
+{
+    return (PWORD_ENTRY)bsearch(word, pDictionary, numDictionary, sizeof(WORD_ENTRY), compare);
+}
+
+/**
+ * @brief Prints the supported command line options.
+ * @param programName argv[0].
+ */
+void print_usage(const char* programName)
+{
+    printf("Usage: %s [options]\n", programName);
+    printf("  -t, --threads N          Worker threads for scoring (default: one per hardware thread)\n");
+    printf("  -f, --full-dictionary    Also score non-answer dictionary words as guesses\n");
+    printf("  -x, --exact-filter       Keep only answers that give exactly the entered pattern\n");
+    printf("      --no-cache           Do not load or save the opening analysis cache or share results between games\n");
+    printf("      --offline            Use the cached past-answer list, do not download it\n");
+    printf("      --data-dir DIR       Directory of AllWords.txt and AllWords.wdict (default: $WORDLE_DATA_DIR or %s)\n", WORDLE_DATA_DIR);
+    printf("      --cache-dir DIR      Directory of the used-words and opening caches (default: $WORDLE_CACHE_DIR or %s)\n", WORDLE_CACHE_DIR);
+    printf("      --no-simd            Use the portable scalar feedback kernel\n");
+    printf("      --simulate           Solve every possible answer headlessly and report the guess distribution\n");
+    printf("      --threshold X        Entropy lead the Entropy pick needs over the Rank pick (default %.2f)\n", ENTROPY_RANK_THRESHOLD);
+    printf("      --low-count N        Guess the top Rank entry once at most N answers remain (default %d)\n", LOW_POSSIBLE_ANSWER_COUNT);
+    printf("      --sweep-threshold R  Simulate every threshold of R (A or A:B:STEP) and report each one's results\n");
+    printf("      --sweep-count R      Simulate every low count of R (combined with --sweep-threshold as a grid)\n");
+    printf("      --lookahead N        Pick the guess minimizing expected guesses, searching N guesses ahead\n");
+    printf("      --sample N           Estimate entropies from N sampled answers while many remain, rescoring contenders exactly\n");
+    printf("      --weighted           Weight answers by rank and pick the guess leaving the least expected prior mass\n");
+    printf("      --gpu                Build the pattern matrix and score large passes on an OpenCL device (CPU if none)\n");
+    printf("      --bench              Time the core kernels and full games per thread count, checking identical output\n");
+    printf("      --stats              Print per-stage timings, counters and peak memory per turn (JSON on stderr)\n");
+    printf("      --server             Serve many games as JSON lines on stdin/stdout\n");
+    printf("      --batch FILE         Recommend the next guess for each history in FILE (\"-\" = stdin), one per line\n");
+    printf("      --csv                Write --batch answers and --sweep results as CSV\n");
+    printf("      --output MODE        Print each turn as a table (human, default), one JSON line (compact) or not at all (silent);\n");
+    printf("                           compact and silent send the prompts and status lines to stderr\n");
+    printf("      --export-tree FILE   Precompute the whole guess policy from the opener into FILE and exit\n");
+    printf("      --opener WORD        First guess of the exported tree (default: the recommended opener)\n");
+    printf("      --tree FILE          Answer --server games that follow the policy from a tree made by --export-tree\n");
+    printf("      --compile-dictionary Convert AllWords.txt (plus pattern matrix) into AllWords.wdict and exit\n");
+    printf("  -h, --help               Show this help\n");
+}
+
+/**
+ * @brief Parses a sweep range argument: "A" (one value) or "A:B:STEP".
+ * @param pszRange The argument.
+ * @param pRange Output range.
+ * @return bool True if the range is valid.
+ */
+static bool parse_sweep_range(const char* pszRange, PSWEEP_RANGE pRange)
+{
+    char trailing;
+    pRange->step = 0.0;
+    if (sscanf(pszRange, "%lf:%lf:%lf%c", &pRange->first, &pRange->last, &pRange->step, &trailing) == 3)
+    {
+        return pRange->first >= 0.0 && pRange->last >= pRange->first && pRange->step > 0.0;
+    }
+    if (sscanf(pszRange, "%lf%c", &pRange->first, &trailing) == 1)
+    {
+        pRange->last = pRange->first;
+        pRange->step = 0.0;
+        return pRange->first >= 0.0;
+    }
+    return false;
+}
+
+/**
+ * @brief Parses the command line into the solver options.
+ * @param argc Argument count from main.
+ * @param argv Argument vector from main.
+ * @param pOptions Output options (left at their defaults for arguments not given).
+ * @return bool True if the solver should run, false on a bad argument or after printing help.
+ */
+bool parse_command_line(int argc, char* argv[], PSOLVER_OPTIONS pOptions)
+{
+    bool haveSweepThresholds = false;
+    bool haveSweepCounts = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+
+        if ((strcmp(arg, "-t") == 0 || strcmp(arg, "--threads") == 0) && i + 1 < argc)
+        {
+            pOptions->numThreads = atoi(argv[++i]);
+            if (pOptions->numThreads < 0)
+            {
+                fprintf(stderr, "Thread count must be 0 (auto) or positive.\n");
+                return false;
+            }
+        }
+        else if (strcmp(arg, "-f") == 0 || strcmp(arg, "--full-dictionary") == 0)
+        {
+            pOptions->scoreFullDictionary = true;
+        }
+        else if (strcmp(arg, "--no-cache") == 0)
+        {
+            pOptions->useOpeningCache = false;
+        }
+        else if (strcmp(arg, "-x") == 0 || strcmp(arg, "--exact-filter") == 0)
+        {
+            pOptions->exactFilter = true;
+        }
+        else if (strcmp(arg, "--compile-dictionary") == 0)
+        {
+            pOptions->compileDictionary = true;
+            pOptions->offline = true; // The past answers are not needed to compile
+        }
+        else if (strcmp(arg, "--data-dir") == 0 && i + 1 < argc)
+        {
+            pOptions->pszDataDir = argv[++i];
+        }
+        else if (strcmp(arg, "--cache-dir") == 0 && i + 1 < argc)
+        {
+            pOptions->pszCacheDir = argv[++i];
+        }
+        else if (strcmp(arg, "--offline") == 0)
+        {
+            pOptions->offline = true;
+        }
+        else if (strcmp(arg, "--no-simd") == 0)
+        {
+            pOptions->disableSimd = true;
+        }
+        else if (strcmp(arg, "--simulate") == 0)
+        {
+            pOptions->simulate = true;
+            pOptions->quiet = true;
+        }
+        else if (strcmp(arg, "--threshold") == 0 && i + 1 < argc)
+        {
+            pOptions->pickPolicy.entropyRankThreshold = atof(argv[++i]);
+            if (pOptions->pickPolicy.entropyRankThreshold < 0.0)
+            {
+                fprintf(stderr, "The entropy/rank threshold cannot be negative.\n");
+                return false;
+            }
+        }
+        else if (strcmp(arg, "--low-count") == 0 && i + 1 < argc)
+        {
+            pOptions->pickPolicy.lowAnswerCount = atoi(argv[++i]);
+            if (pOptions->pickPolicy.lowAnswerCount < 0)
+            {
+                fprintf(stderr, "The low answer count cannot be negative.\n");
+                return false;
+            }
+        }
+        else if ((strcmp(arg, "--sweep-threshold") == 0 || strcmp(arg, "--sweep-count") == 0) && i + 1 < argc)
+        {
+            bool isThreshold = strcmp(arg, "--sweep-threshold") == 0;
+            PSWEEP_RANGE pRange = isThreshold ? &pOptions->sweepThresholds : &pOptions->sweepCounts;
+            if (isThreshold) haveSweepThresholds = true;
+            else haveSweepCounts = true;
+            if (!parse_sweep_range(argv[++i], pRange))
+            {
+                fprintf(stderr, "A sweep range is A or A:B:STEP, with 0 <= A <= B and STEP > 0.\n");
+                return false;
+            }
+            pOptions->sweep = true;
+            pOptions->simulate = true;
+            pOptions->quiet = true;
+        }
+        else if (strcmp(arg, "--lookahead") == 0 && i + 1 < argc)
+        {
+            pOptions->lookaheadPlies = atoi(argv[++i]);
+            if (pOptions->lookaheadPlies < 1 || pOptions->lookaheadPlies > LOOKAHEAD_MAX_PLIES)
+            {
+                fprintf(stderr, "Lookahead must be 1 to %d guesses.\n", LOOKAHEAD_MAX_PLIES);
+                return false;
+            }
+        }
+        else if (strcmp(arg, "--sample") == 0 && i + 1 < argc)
+        {
+            pOptions->sampleSize = atol(argv[++i]);
+            if (pOptions->sampleSize < 2)
+            {
+                fprintf(stderr, "The entropy sample must have at least 2 answers.\n");
+                return false;
+            }
+        }
+        else if (strcmp(arg, "--weighted") == 0)
+        {
+            pOptions->priorWeighted = true;
+        }
+        else if (strcmp(arg, "--gpu") == 0)
+        {
+            pOptions->useAccelerator = true;
+        }
+        else if (strcmp(arg, "--bench") == 0)
+        {
+            pOptions->bench = true;
+            pOptions->quiet = true;
+        }
+        else if (strcmp(arg, "--stats") == 0)
+        {
+            pOptions->stats = true;
+        }
+        else if (strcmp(arg, "--server") == 0)
+        {
+            pOptions->server = true;
+            pOptions->quiet = true;
+        }
+        else if (strcmp(arg, "--batch") == 0 && i + 1 < argc)
+        {
+            pOptions->pszBatchPath = argv[++i];
+            pOptions->quiet = true;
+        }
+        else if (strcmp(arg, "--csv") == 0)
+        {
+            pOptions->csvOutput = true;
+        }
+        else if (strcmp(arg, "--output") == 0 && i + 1 < argc)
+        {
+            const char* pszMode = argv[++i];
+            if (strcmp(pszMode, "human") == 0) pOptions->outputMode = OUTPUT_HUMAN;
+            else if (strcmp(pszMode, "compact") == 0) pOptions->outputMode = OUTPUT_COMPACT;
+            else if (strcmp(pszMode, "silent") == 0) pOptions->outputMode = OUTPUT_SILENT;
+            else
+            {
+                fprintf(stderr, "Output mode must be human, compact or silent.\n");
+                return false;
+            }
+            // Only the human tables are interleaved with the informational lines
+            if (pOptions->outputMode != OUTPUT_HUMAN) pOptions->quiet = true;
+        }
+        else if (strcmp(arg, "--export-tree") == 0 && i + 1 < argc)
+        {
+            pOptions->pszExportTreePath = argv[++i];
+            pOptions->quiet = true;
+        }
+        else if (strcmp(arg, "--opener") == 0 && i + 1 < argc)
+        {
+            pOptions->pszOpener = argv[++i];
+        }
+        else if (strcmp(arg, "--tree") == 0 && i + 1 < argc)
+        {
+            pOptions->pszTreePath = argv[++i];
+        }
+        else if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0)
+        {
+            print_usage(argv[0]);
+            return false;
+        }
+        else
+        {
+            fprintf(stderr, "Unknown or incomplete option '%s'.\n", arg);
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+
+    // A sweep keeps the other setting at its single (given or default) value
+    if (!haveSweepThresholds) pOptions->sweepThresholds = { pOptions->pickPolicy.entropyRankThreshold, pOptions->pickPolicy.entropyRankThreshold, 0.0 };
+    if (!haveSweepCounts) pOptions->sweepCounts = { (double)pOptions->pickPolicy.lowAnswerCount, (double)pOptions->pickPolicy.lowAnswerCount, 0.0 };
+    if (pOptions->sweep && pOptions->lookaheadPlies > 0)
+    {
+        fprintf(stderr, "A sweep cannot be combined with --lookahead (the lookahead replaces the final pick).\n");
+        return false;
+    }
+    return true;
+}
+
+// Set on worker threads (and the calling thread) while a parallel_for is running, so nested loops run inline.
+static thread_local bool t_isParallelWorker = false;
+
+// The worker threads shared by every parallel_for, started on first use and kept until exit.
+PARALLEL_POOL g_parallelPool;
+
+// The calling thread's scratch arena (NULL until first use) and the idle arenas of finished threads.
+static thread_local PSCRATCH_ARENA t_pScratchArena = NULL;
+PSCRATCH_ARENA g_pScratchArenaPool = NULL;
+std::mutex g_scratchArenaPoolLock;
+
+/**
+ * @brief Returns the number of worker threads parallel loops should use.
+ * @return int The configured thread count, or the hardware thread count when set to auto.
+ */
+int get_worker_thread_count()
+{
+    int numThreads = g_options.numThreads;
+    if (numThreads <= 0)
+    {
+        numThreads = (int)std::thread::hardware_concurrency();
+        if (numThreads <= 0) numThreads = 1;
+    }
+    return (numThreads > PARALLEL_MAX_WORKERS) ? PARALLEL_MAX_WORKERS : numThreads;
+}
+
+/**
+ * @brief Worker loop: drains its own range chunk by chunk, then steals chunks from the other workers' ranges.
+ */
+static void run_parallel_worker(PWORK_RANGE pRanges, int numWorkers, int workerIdx, long chunkSize, PARALLEL_RANGE_FN fn, void* pContext)
+{
+    bool wasWorker = t_isParallelWorker;
+    t_isParallelWorker = true;
+
+    // Offset 0 is this worker's own range; the rest are visited in order as steal victims
+    for (int offset = 0; offset < numWorkers; offset++)
+    {
+        PWORK_RANGE pRange = pRanges + (workerIdx + offset) % numWorkers;
+
+        while (true)
+        {
+            long begin = pRange->next.fetch_add(chunkSize, std::memory_order_relaxed);
+            if (begin >= pRange->end) break;
+
+            long end = (begin + chunkSize < pRange->end) ? begin + chunkSize : pRange->end;
+            fn(begin, end, workerIdx, pContext);
+        }
+    }
+
+    t_isParallelWorker = wasWorker;
+}
+
+/**
+ * @brief Entry point of a pool thread: runs its worker loop in every published loop that includes
+ * it, parked on the pool's wake condition in between, until the pool shuts down. It then returns
+ * the thread's scratch arena to the arena pool.
+ * @param workerIdx The thread's worker index (1..PARALLEL_MAX_WORKERS - 1).
+ * @param seenGeneration The pool generation when the thread was started; only later loops are joined.
+ */
+static void run_parallel_thread(int workerIdx, unsigned long seenGeneration)
+{
+    PPARALLEL_POOL pPool = &g_parallelPool;
+    t_isParallelWorker = true;
+
+    std::unique_lock<std::mutex> guard(pPool->lock);
+    while (true)
+    {
+        while (pPool->generation == seenGeneration && !pPool->shuttingDown) pPool->wake.wait(guard);
+        if (pPool->shuttingDown) break;
+
+        // Loops with fewer workers leave this thread parked
+        seenGeneration = pPool->generation;
+        if (workerIdx >= pPool->numWorkers) continue;
+
+        PWORK_RANGE pRanges = pPool->pRanges;
+        int numWorkers = pPool->numWorkers;
+        long chunkSize = pPool->chunkSize;
+        PARALLEL_RANGE_FN fn = pPool->fn;
+        void* pContext = pPool->pContext;
+        guard.unlock();
+
+        run_parallel_worker(pRanges, numWorkers, workerIdx, chunkSize, fn, pContext);
+
+        guard.lock();
+        if (--pPool->numActive == 0) pPool->done.notify_one();
+    }
+    guard.unlock();
+    release_thread_scratch_arena();
+}
+
+/**
+ * @brief Starts pool threads until the pool has numThreads of them (or a thread cannot be started).
+ * Called with the pool's submit lock held, so no loop is published meanwhile.
+ * @return int The number of pool threads available.
+ */
+static int grow_parallel_pool(int numThreads)
+{
+    PPARALLEL_POOL pPool = &g_parallelPool;
+
+    if (pPool->pThreads == NULL)
+    {
+        pPool->pThreads = new (std::nothrow) std::thread[PARALLEL_MAX_WORKERS - 1];
+        if (pPool->pThreads == NULL) return 0;
+    }
+    while (pPool->numThreads < numThreads)
+    {
+        try
+        {
+            pPool->pThreads[pPool->numThreads] = std::thread(run_parallel_thread, pPool->numThreads + 1, pPool->generation);
+        }
+        catch (...)
+        {
+            break;
+        }
+        pPool->numThreads++;
+    }
+    return pPool->numThreads;
+}
+
+/**
+ * @brief Runs fn over the items [0, count) on the worker pool with chunked work stealing.
+ * Each worker starts on a contiguous slice and, once it is drained, claims chunks from slower workers,
+ * which evens out items with uneven cost. Results are deterministic as long as fn only writes
+ * per-item outputs. The pool threads are started on first use and parked between loops, so a loop
+ * costs one wake-up rather than a thread start per worker. Called from inside a worker, with one
+ * thread, or while another thread's loop holds the pool, it runs inline on the caller.
+ * @param count The number of items.
+ * @param chunkSize The number of items claimed per step.
+ * @param fn The range callback.
+ * @param pContext Caller data passed through to fn.
+ */
+void parallel_for(long count, long chunkSize, PARALLEL_RANGE_FN fn, void* pContext)
+{
+    PPARALLEL_POOL pPool = &g_parallelPool;
+
+    if (count <= 0) return;
+    if (chunkSize < 1) chunkSize = 1;
+
+    long numChunks = (count + chunkSize - 1) / chunkSize;
+    int numWorkers = get_worker_thread_count();
+    if (numWorkers > numChunks) numWorkers = (int)numChunks;
+
+    std::unique_lock<std::mutex> submitGuard(pPool->submitLock, std::defer_lock);
+    if (t_isParallelWorker || numWorkers <= 1 || !submitGuard.try_lock())
+    {
+        fn(0, count, 0, pContext);
+        return;
+    }
+
+    // The calling thread acts as worker 0. Workers that cannot be started shrink the loop.
+    int numThreads = grow_parallel_pool(numWorkers - 1);
+    if (numWorkers > numThreads + 1) numWorkers = numThreads + 1;
+    if (numWorkers <= 1)
+    {
+        fn(0, count, 0, pContext);
+        return;
+    }
+
+    // Split the items into one contiguous, chunk-aligned slice per worker
+    WORK_RANGE ranges[PARALLEL_MAX_WORKERS];
+    for (int w = 0; w < numWorkers; w++)
+    {
+        ranges[w].next.store((numChunks * w / numWorkers) * chunkSize, std::memory_order_relaxed);
+        long end = (numChunks * (w + 1) / numWorkers) * chunkSize;
+        ranges[w].end = (end < count) ? end : count;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(pPool->lock);
+        pPool->pRanges = ranges;
+        pPool->numWorkers = numWorkers;
+        pPool->numActive = numWorkers - 1;
+        pPool->chunkSize = chunkSize;
+        pPool->fn = fn;
+        pPool->pContext = pContext;
+        pPool->generation++;
+    }
+    pPool->wake.notify_all();
+
+    run_parallel_worker(ranges, numWorkers, 0, chunkSize, fn, pContext);
+
+    std::unique_lock<std::mutex> guard(pPool->lock);
+    while (pPool->numActive > 0) pPool->done.wait(guard);
+}
+
+/**
+ * @brief Stops and joins the pool threads (at exit, with no loop running).
+ */
+void shutdown_parallel_pool()
+{
+    PPARALLEL_POOL pPool = &g_parallelPool;
+
+    {
+        std::lock_guard<std::mutex> guard(pPool->lock);
+        pPool->shuttingDown = true;
+    }
+    pPool->wake.notify_all();
+
+    for (int i = 0; i < pPool->numThreads; i++) pPool->pThreads[i].join();
+    delete[] pPool->pThreads;
+    pPool->pThreads = NULL;
+    pPool->numThreads = 0;
+}
+
+// --- Scratch Arenas ---
+
+/**
+ * @brief Returns the calling thread's scratch arena, taking an idle one from the pool (or creating
+ * an empty one) on first use.
+ * @return PSCRATCH_ARENA The arena, or NULL on memory allocation failure.
+ */
+PSCRATCH_ARENA get_scratch_arena()
+{
+    if (t_pScratchArena != NULL) return t_pScratchArena;
+
+    {
+        std::lock_guard<std::mutex> guard(g_scratchArenaPoolLock);
+        t_pScratchArena = g_pScratchArenaPool;
+        if (t_pScratchArena != NULL) g_pScratchArenaPool = t_pScratchArena->pNextFree;
+    }
+    if (t_pScratchArena == NULL)
+    {
+        t_pScratchArena = (PSCRATCH_ARENA)calloc(1, sizeof(SCRATCH_ARENA));
+        stats_count(STAT_ALLOCATIONS, 1);
+    }
+    return t_pScratchArena;
+}
+
+/**
+ * @brief Returns a mark to pass to scratch_release (the arena's current fill level).
+ */
+size_t scratch_mark(PSCRATCH_ARENA pArena)
+{
+    return (pArena != NULL) ? pArena->used : 0;
+}
+
+/**
+ * @brief Allocates SCRATCH_ARENA_ALIGNMENT-aligned scratch memory, valid until the arena is
+ * released to a mark taken before this call. Never free the result.
+ * @param pArena The arena (NULL allowed: the call then fails).
+ * @param size The number of bytes.
+ * @return void* The memory, or NULL on memory allocation failure.
+ */
+void* scratch_alloc(PSCRATCH_ARENA pArena, size_t size)
+{
+    if (pArena == NULL) return NULL;
+    size = (size + SCRATCH_ARENA_ALIGNMENT - 1) & ~(size_t)(SCRATCH_ARENA_ALIGNMENT - 1);
+
+    // An empty arena can simply swap its block for a larger one
+    if (pArena->used + size > pArena->capacity && pArena->used == 0 && pArena->pSpills == NULL)
+    {
+        size_t capacity = (pArena->capacity > 0) ? pArena->capacity : SCRATCH_ARENA_INITIAL_SIZE;
+        while (capacity < size) capacity *= 2;
+
+        free(pArena->pBase);
+        pArena->pBase = (unsigned char*)malloc(capacity);
+        pArena->capacity = (pArena->pBase != NULL) ? capacity : 0;
+        stats_count(STAT_ALLOCATIONS, 1);
+    }
+
+    void* pMemory;
+    if (pArena->used + size <= pArena->capacity)
+    {
+        pMemory = pArena->pBase + pArena->used;
+        pArena->used += size;
+    }
+    else
+    {
+        // Spill to the heap; the next time the arena empties its block grows to cover this turn
+        PSCRATCH_SPILL pSpill = (PSCRATCH_SPILL)malloc(SCRATCH_ARENA_ALIGNMENT + size);
+        stats_count(STAT_ALLOCATIONS, 1);
+        if (pSpill == NULL) return NULL;
+        pSpill->pNext = pArena->pSpills;
+        pArena->pSpills = pSpill;
+        pArena->spilled += size;
+        pMemory = (unsigned char*)pSpill + SCRATCH_ARENA_ALIGNMENT;
+    }
+
+    if (pArena->used + pArena->spilled > pArena->peak) pArena->peak = pArena->used + pArena->spilled;
+    return pMemory;
+}
+
+/**
+ * @brief Allocates zeroed scratch memory (see scratch_alloc).
+ */
+void* scratch_calloc(PSCRATCH_ARENA pArena, size_t count, size_t size)
+{
+    void* pMemory = scratch_alloc(pArena, count * size);
+    if (pMemory != NULL) memset(pMemory, 0, count * size);
+    return pMemory;
+}
+
+/**
+ * @brief Releases every allocation made since the mark was taken. Marks nest (release in reverse
+ * order). When the arena becomes empty after spilling, its block is resized to the peak demand.
+ * @param pArena The arena (NULL allowed).
+ * @param mark A value from scratch_mark.
+ */
+void scratch_release(PSCRATCH_ARENA pArena, size_t mark)
+{
+    if (pArena == NULL) return;
+    pArena->used = mark;
+    if (mark != 0 || pArena->pSpills == NULL) return;
+
+    while (pArena->pSpills != NULL)
+    {
+        PSCRATCH_SPILL pNext = pArena->pSpills->pNext;
+        free(pArena->pSpills);
+        pArena->pSpills = pNext;
+    }
+    pArena->spilled = 0;
+
+    free(pArena->pBase);
+    pArena->pBase = (unsigned char*)malloc(pArena->peak);
+    pArena->capacity = (pArena->pBase != NULL) ? pArena->peak : 0;
+    stats_count(STAT_ALLOCATIONS, 1);
+}
+
+/**
+ * @brief Returns the calling thread's arena (which must be empty) to the pool, keeping its block
+ * for the next thread. Called when a worker thread finishes.
+ */
+void release_thread_scratch_arena()
+{
+    PSCRATCH_ARENA pArena = t_pScratchArena;
+    if (pArena == NULL) return;
+
+    scratch_release(pArena, 0);
+    t_pScratchArena = NULL;
+
+    std::lock_guard<std::mutex> guard(g_scratchArenaPoolLock);
+    pArena->pNextFree = g_pScratchArenaPool;
+    g_pScratchArenaPool = pArena;
+}
+
+/**
+ * @brief Frees the calling thread's arena and every pooled arena (at exit, no other threads running).
+ */
+void free_scratch_arenas()
+{
+    release_thread_scratch_arena();
+
+    std::lock_guard<std::mutex> guard(g_scratchArenaPoolLock);
+    while (g_pScratchArenaPool != NULL)
+    {
+        PSCRATCH_ARENA pNext = g_pScratchArenaPool->pNextFree;
+        free(g_pScratchArenaPool->pBase);
+        free(g_pScratchArenaPool);
+        g_pScratchArenaPool = pNext;
+    }
+}
+
+// --- Buffered Output ---
+
+/**
+ * @brief Starts an empty output buffer on its inline block.
+ */
+void init_output_buffer(POUTPUT_BUFFER pOut)
+{
+    pOut->pData = pOut->inlineData;
+    pOut->length = 0;
+    pOut->capacity = OUTPUT_INLINE_SIZE;
+    pOut->inlineData[0] = '\0';
+}
+
+/**
+ * @brief Makes room for at least 'extra' more bytes (plus the terminator).
+ * @return bool False if the buffer could not grow (the text written so far is kept).
+ */
+static bool reserve_output_buffer(POUTPUT_BUFFER pOut, size_t extra)
+{
+    if (pOut->length + extra < pOut->capacity) return true;
+
+    size_t capacity = pOut->capacity * 2;
+    while (pOut->length + extra >= capacity) capacity *= 2;
+
+    char* pData = (char*)malloc(capacity);
+    if (pData == NULL) return false;
+    memcpy(pData, pOut->pData, pOut->length + 1);
+    if (pOut->pData != pOut->inlineData) free(pOut->pData);
+    pOut->pData = pData;
+    pOut->capacity = capacity;
+    stats_count(STAT_ALLOCATIONS, 1);
+    return true;
+}
+
+/**
+ * @brief Appends printf-formatted text.
+ */
+void output_printf(POUTPUT_BUFFER pOut, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int needed = vsnprintf(pOut->pData + pOut->length, pOut->capacity - pOut->length, format, args);
+    va_end(args);
+    if (needed < 0) return;
+
+    if (pOut->length + needed >= pOut->capacity)
+    {
+        // Did not fit: grow and format again
+        if (!reserve_output_buffer(pOut, needed))
+        {
+            pOut->pData[pOut->length] = '\0';
+            return;
+        }
+        va_start(args, format);
+        vsnprintf(pOut->pData + pOut->length, pOut->capacity - pOut->length, format, args);
+        va_end(args);
+    }
+    pOut->length += needed;
+}
+
+/**
+ * @brief Pads the text written since columnStart with spaces up to 'width' characters
+ * (the buffered form of printf's "%-*s").
+ */
+void output_pad(POUTPUT_BUFFER pOut, size_t columnStart, int width)
+{
+    size_t written = pOut->length - columnStart;
+    if (written < (size_t)width) output_printf(pOut, "%*s", (int)(width - written), "");
+}
+
+/**
+ * @brief Writes the buffered text with one fwrite and empties the buffer.
+ */
+void flush_output_buffer(POUTPUT_BUFFER pOut, FILE* fp)
+{
+    if (pOut->length > 0) fwrite(pOut->pData, 1, pOut->length, fp);
+    fflush(fp);
+    if (pOut->pData != pOut->inlineData) free(pOut->pData);
+    init_output_buffer(pOut);
+}
+
+/**
+ * @brief cURL callback function to dynamically grow and store downloaded data.
+ * The buffer grows geometrically and tracks its length, so a page of N bytes costs O(N).
+ * @return The size of the data successfully handled.
+ */
+size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp)
+{
+    size_t realsize = size * nmemb;
+    PDOWNLOAD_BUFFER pBuffer = (PDOWNLOAD_BUFFER)userp;
+
+    if (pBuffer->size + realsize + 1 > pBuffer->capacity)
+    {
+        size_t capacity = (pBuffer->capacity > 0) ? pBuffer->capacity : DOWNLOAD_INITIAL_CAPACITY;
+        while (capacity < pBuffer->size + realsize + 1) capacity *= 2;
+
+        char* ptr = (char*)realloc(pBuffer->pData, capacity);
+        if (ptr == NULL) return 0;
+
+        pBuffer->pData = ptr;
+        pBuffer->capacity = capacity;
+    }
+
+    memcpy(pBuffer->pData + pBuffer->size, contents, realsize);
+    pBuffer->size += realsize;
+    pBuffer->pData[pBuffer->size] = '\0';
+    return realsize;
+}
+
+/**
+ * @brief Copies the value of a "Name: value" response header line into pValue if the name matches.
+ */
+static void copy_header_value(const char* pLine, size_t length, const char* pName, char* pValue, size_t valueSize)
+{
+    size_t nameLength = strlen(pName);
+    if (length <= nameLength + 1 || pLine[nameLength] != ':') return;
+
+    for (size_t i = 0; i < nameLength; i++)
+    {
+        if (tolower((unsigned char)pLine[i]) != tolower((unsigned char)pName[i])) return;
+    }
+
+    const char* pStart = pLine + nameLength + 1;
+    const char* pEnd = pLine + length;
+    while (pStart < pEnd && (*pStart == ' ' || *pStart == '\t')) pStart++;
+    while (pEnd > pStart && (pEnd[-1] == '\r' || pEnd[-1] == '\n' || pEnd[-1] == ' ')) pEnd--;
+
+    size_t valueLength = (size_t)(pEnd - pStart);
+    if (valueLength >= valueSize) return; // Too long to send back, so not worth keeping
+
+    memcpy(pValue, pStart, valueLength);
+    pValue[valueLength] = '\0';
+}
+
+/**
+ * @brief cURL header callback: keeps the ETag and Last-Modified validators of the response.
+ * @return The size of the header line handled.
+ */
+size_t header_callback(char* buffer, size_t size, size_t nitems, void* userp)
+{
+    size_t length = size * nitems;
+    PUSED_WORDS_FETCH pFetch = (PUSED_WORDS_FETCH)userp;
+
+    copy_header_value(buffer, length, "ETag", pFetch->etag, sizeof(pFetch->etag));
+    copy_header_value(buffer, length, "Last-Modified", pFetch->lastModified, sizeof(pFetch->lastModified));
+    return length;
+}
+
+/**
+ * @brief Downloads the webpage containing the past Wordle answers using cURL.
+ * When the cache supplied validators, the request is conditional (If-None-Match /
+ * If-Modified-Since) and an unchanged page comes back as HTTP 304 with no body.
+ * Runs on the background fetch thread, so it only records its outcome and prints nothing.
+ * @param pFetch The fetch state: cached validators in, status, body and new validators out.
+ */
+void get_used_words_webpage(PUSED_WORDS_FETCH pFetch)
+{
+    pFetch->result = CURLE_OK;
+    pFetch->httpStatus = 0;
+    pFetch->succeeded = false;
+
+#ifndef WORDLE_NO_CURL
+    CURL* curl;
+    struct curl_slist* pHeaders = NULL;
+    char headerLine[USED_WORDS_VALIDATOR_SIZE + 32];
+
+    curl = curl_easy_init();
+    if (curl == NULL) return;
+
+    // Set the target URL
+    curl_easy_setopt(curl, CURLOPT_URL, USED_WORDS_URL);
+    // Set the callback function to handle downloaded data
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void*)&pFetch->body);
+    // Collect the validators for the next conditional request
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, (void*)pFetch);
+    // Follow redirects
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    // Identify the client
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "Chrome");
+    // Never hold up startup for long; the cache covers a slow or missing network
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, (long)USED_WORDS_CONNECT_TIMEOUT);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, (long)USED_WORDS_TIMEOUT);
+
+    if (pFetch->cacheHeader.etag[0] != '\0')
+    {
+        snprintf(headerLine, sizeof(headerLine), "If-None-Match: %s", pFetch->cacheHeader.etag);
+        pHeaders = curl_slist_append(pHeaders, headerLine);
+    }
+    if (pFetch->cacheHeader.lastModified[0] != '\0')
+    {
+        snprintf(headerLine, sizeof(headerLine), "If-Modified-Since: %s", pFetch->cacheHeader.lastModified);
+        pHeaders = curl_slist_append(pHeaders, headerLine);
+    }
+    if (pHeaders != NULL) curl_easy_setopt(curl, CURLOPT_HTTPHEADER, pHeaders);
+
+    STAT_TIMER timer;
+    stats_start(&timer);
+    pFetch->result = curl_easy_perform(curl);
+    stats_stop(&timer, STAT_STAGE_USED_WORDS);
+    if (pFetch->result == CURLE_OK)
+    {
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &pFetch->httpStatus);
+        pFetch->succeeded = (pFetch->httpStatus == 304) || (pFetch->httpStatus == 200 && pFetch->body.pData != NULL);
+    }
+
+    curl_slist_free_all(pHeaders);
+    curl_easy_cleanup(curl);
+#endif
+}
+
+/**
+ * @brief Processes the HTML content to extract the list of past Wordle answers.
+ * Words flagged in g_wordle_replay_words are excluded from this list.
+ * @param pszWebPage The downloaded HTML content string.
+ * @return PWORD_LIST A linked list of used words to be excluded from the answer set.
+ */
+PWORD_LIST get_used_words_from_webpage_string(char* pszWebPage)
+{
+    PWORD_LIST pTop = NULL;
+    PWORD_NODE* ppNextNew = &pTop;
+    PWORD_NODE pNew;
+
+    char* pTmp;
+    const char* sectionHeader = "<h2>All Wordle answers</h2>";
+    const char* wordStartTag = "<li>";
+    const char* wordEndTag = "</li>";
+    const char* listEndTag = "</ul>";
+    const char* nonWordChars = " \t\n\r\v";
+
+    numUsedWords = 0;
 
     // Locate the section containing the Wordle answers
     pTmp = strstr(pszWebPage, sectionHeader);
@@ -402,912 +2362,8102 @@ PWORD_LIST get_used_words_from_webpage_string(char* pszWebPage)
     pTmp = strstr(pTmp, wordStartTag);
     if (pTmp == NULL) { return NULL; }
 
-    char* pListEnd = strstr(pTmp, listEndTag);
-    if (pListEnd == NULL) { pListEnd = pTmp + strlen(pTmp); }
+    char* pListEnd = strstr(pTmp, listEndTag);
+    if (pListEnd == NULL) { pListEnd = pTmp + strlen(pTmp); }
+
+    while (pTmp != NULL && pTmp < pListEnd)
+    {
+        pTmp += strlen(wordStartTag);
+        pTmp += strspn(pTmp, nonWordChars);
+
+        char* pWordEndTag = strstr(pTmp, wordEndTag);
+        if (pWordEndTag == NULL || pWordEndTag >= pListEnd) break;
+
+        // Skip potential HTML tags within list items
+        if (*pTmp == '<')
+        {
+            char* pContentStart = strchr(pTmp, '>');
+            if (pContentStart != NULL && pContentStart < pWordEndTag) { pTmp = pContentStart + 1; }
+        }
+
+        pTmp += strspn(pTmp, nonWordChars);
+
+        // Check if the content is a 5-letter word
+        size_t wordLen = 0;
+        while (wordLen < WORD_SIZE && isalpha((unsigned char)*(pTmp + wordLen))) { wordLen++; }
+
+        if (wordLen == WORD_SIZE)
+        {
+            bool skip_word = false;
+
+#ifdef NUM_REPLAY_WORDS
+            // Check against the replay list
+            for (int i = 0; i < NUM_REPLAY_WORDS && skip_word == false; i++)
+            {
+                if (strncmp(pTmp, g_wordle_replay_words[i], WORD_SIZE) == 0)
+                {
+                    skip_word = true;
+                }
+            }
+#endif
+
+            // If the word is NOT in the replay list, add it to the exclusion list (pTop)
+            if (!skip_word)
+            {
+                pNew = (PWORD_NODE)scratch_alloc(get_scratch_arena(), sizeof(WORD_NODE));
+                if (pNew == NULL) { fprintf(stderr, "Out of memory!\n"); return NULL; }
+                memset(pNew, 0, sizeof(WORD_NODE));
+
+                // Copy and uppercase the word
+                memcpy(pNew->word, pTmp, WORD_SIZE);
+                for (int i = 0; i < WORD_SIZE; i++)
+                {
+                    pNew->word[i] = toupper((unsigned char)pNew->word[i]);
+                }
+                pNew->word[WORD_SIZE] = '\0';
+
+                numUsedWords++;
+                *ppNextNew = pNew;
+                ppNextNew = &(pNew->pNxt);
+            }
+        }
+
+        // Move pointer to the start of the next list item
+        char* pNextListItem = strstr(pTmp + 1, wordStartTag);
+        char* pEndList = strstr(pTmp + 1, listEndTag);
+
+        if (pNextListItem != NULL && (pEndList == NULL || pNextListItem < pEndList))
+        {
+            pTmp = pNextListItem;
+        }
+        else if (pEndList != NULL)
+        {
+            pTmp = pEndList;
+        }
+        else
+        {
+            pTmp = NULL;
+        }
+    }
+
+    printf("Found %ld total used words (excluding replay words).\n", numUsedWords);
+    return(pTop);
+}
+
+
+/**
+ * @brief Joins a directory and a file name into pszPath ("." or an empty directory gives the bare name).
+ * @return bool False if the path does not fit in DATA_PATH_SIZE.
+ */
+static bool join_data_path(char* pszPath, const char* pszDir, const char* pszFile)
+{
+    size_t dirLength = strlen(pszDir);
+    int length;
+
+    if (dirLength == 0 || strcmp(pszDir, ".") == 0) length = snprintf(pszPath, DATA_PATH_SIZE, "%s", pszFile);
+    else if (pszDir[dirLength - 1] == PATH_SEPARATOR || pszDir[dirLength - 1] == '/') length = snprintf(pszPath, DATA_PATH_SIZE, "%s%s", pszDir, pszFile);
+    else length = snprintf(pszPath, DATA_PATH_SIZE, "%s%c%s", pszDir, PATH_SEPARATOR, pszFile);
+    return length >= 0 && length < DATA_PATH_SIZE;
+}
+
+/**
+ * @brief Builds the dictionary and cache file paths from the data and cache directories: the
+ * command line options, else the WORDLE_DATA_DIR / WORDLE_CACHE_DIR environment variables, else the
+ * build defaults of the same names.
+ * @return bool True if every path fits.
+ */
+bool resolve_data_paths()
+{
+    const char* pszDataDir = g_options.pszDataDir;
+    const char* pszCacheDir = g_options.pszCacheDir;
+    if (pszDataDir == NULL) pszDataDir = getenv("WORDLE_DATA_DIR");
+    if (pszDataDir == NULL) pszDataDir = WORDLE_DATA_DIR;
+    if (pszCacheDir == NULL) pszCacheDir = getenv("WORDLE_CACHE_DIR");
+    if (pszCacheDir == NULL) pszCacheDir = WORDLE_CACHE_DIR;
+
+    if (!join_data_path(g_szDictionaryTextPath, pszDataDir, DICTIONARY_TEXT_FILE) ||
+        !join_data_path(g_szDictionaryBinaryPath, pszDataDir, DICTIONARY_BINARY_FILE) ||
+        !join_data_path(g_szUsedWordsCachePath, pszCacheDir, USED_WORDS_CACHE_FILE) ||
+        !join_data_path(g_szOpeningCachePath, pszCacheDir, OPENING_CACHE_FILE))
+    {
+        fprintf(stderr, "Data or cache directory path is too long.\n");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Loads the dictionary, from the compiled binary file when there is a current one
+ * (mapped, no parsing) and from the text file otherwise. Release it with release_dictionary_table.
+ * A dictionary of another word length or alphabet goes to g_variantDictionary instead.
+ * @return PWORD_ENTRY Pointer to the sorted dictionary array, or NULL on failure or for a variant.
+ */
+PWORD_ENTRY get_dictionary_table()
+{
+    PWORD_ENTRY pDictionary = NULL;
+    STAT_TIMER timer;
+
+    stats_start(&timer);
+    if (!g_options.compileDictionary)
+    {
+        pDictionary = load_binary_dictionary(g_szDictionaryBinaryPath);
+    }
+    if (pDictionary == NULL && g_variantDictionary.pKernels == NULL) pDictionary = load_text_dictionary();
+    stats_stop(&timer, STAT_STAGE_DICTIONARY);
+    return pDictionary;
+}
+
+/**
+ * @brief Comparison function for qsort over variant dictionary records (NUL-terminated word first).
+ */
+static int compare_variant_records(const void* arg1, const void* arg2)
+{
+    return strcmp((const char*)arg1, (const char*)arg2);
+}
+
+/**
+ * @brief Loads a text dictionary of another word length or alphabet into g_variantDictionary.
+ * Lines are [word][3-digit rank][noun type][verb type] with wordLength-letter words; ASCII letters
+ * are upper-cased and single-byte letters above 0x7F (e.g. Latin-1) are kept as they are. The
+ * alphabet is A-Z unless the words use other letters, then every letter they use in byte order.
+ * Blank lines are skipped; any other line of another length or with a byte that is not a letter
+ * fails the load with its line number.
+ * @param fpIn The open text dictionary, positioned at its start.
+ * @param wordLength Letters per word (set by the first line).
+ * @return bool True if the words were loaded and word kernels are compiled for them.
+ */
+static bool load_variant_text_dictionary(FILE* fpIn, int wordLength)
+{
+    PVARIANT_DICTIONARY pVariant = &g_variantDictionary;
+    char buffer[100];
+    bool isUsed[256] = { false };
+    int letterIndex[256];
+    long numWords = 0;
+    long lineNumber = 0;
+
+    if (select_word_kernels(wordLength, 1) == NULL)
+    {
+        fprintf(stderr, "%s holds %d-letter words; the solver plays %d to %d letters.\n", g_szDictionaryTextPath, wordLength, VARIANT_MIN_WORD_SIZE, VARIANT_MAX_WORD_SIZE);
+        return false;
+    }
+
+    // Records are the word (NUL-terminated) followed by the rank and types as in the file, so they sort by word
+    int recordSize = wordLength + 6;
+    char* pRecords = (char*)malloc((size_t)maxDictionary * recordSize);
+    if (pRecords == NULL)
+    {
+        fprintf(stderr, "Out of memory allocating dictionary!\n");
+        return false;
+    }
+
+    bool ok = true;
+    while (fgets(buffer, 100, fpIn) != NULL && numWords < maxDictionary)
+    {
+        lineNumber++;
+        trim(buffer);
+        if (buffer[0] == '\0') continue;
+        if ((int)strlen(buffer) != wordLength + 5)
+        {
+            fprintf(stderr, "Line %ld of %s is not a %d-letter word followed by its rank and types.\n", lineNumber, g_szDictionaryTextPath, wordLength);
+            ok = false;
+            break;
+        }
+
+        char* pRecord = pRecords + (size_t)numWords * recordSize;
+        for (int i = 0; i < wordLength && ok; i++)
+        {
+            unsigned char c = (unsigned char)buffer[i];
+            if (c < 0x80) c = (unsigned char)toupper(c);
+            if (c < 0x80 && (c < 'A' || c > 'Z'))
+            {
+                fprintf(stderr, "Line %ld of %s: '%c' in the word is not a letter.\n", lineNumber, g_szDictionaryTextPath, buffer[i]);
+                ok = false;
+            }
+            pRecord[i] = (char)c;
+        }
+        if (!ok) break;
+        pRecord[wordLength] = '\0';
+        memcpy(pRecord + wordLength + 1, buffer + wordLength, 5);
+        for (int i = 0; i < wordLength; i++) isUsed[(unsigned char)pRecord[i]] = true;
+        numWords++;
+    }
+
+    bool isAsciiOnly = true;
+    for (int c = 0x80; c < 256; c++)
+    {
+        if (isUsed[c]) isAsciiOnly = false;
+    }
+
+    int alphabetSize = 0;
+    bool isAlphabetFull = false;
+    for (int c = 0; c < 256; c++)
+    {
+        letterIndex[c] = -1;
+        if (isAsciiOnly ? (c < 'A' || c > 'Z') : !isUsed[c]) continue;
+        if (alphabetSize == VARIANT_MAX_ALPHABET) isAlphabetFull = true;
+        else
+        {
+            letterIndex[c] = alphabetSize;
+            pVariant->alphabet[alphabetSize++] = (unsigned char)c;
+        }
+    }
+    if (ok && numWords == 0)
+    {
+        fprintf(stderr, "%s holds no %d-letter words.\n", g_szDictionaryTextPath, wordLength);
+        ok = false;
+    }
+    else if (ok && isAlphabetFull)
+    {
+        fprintf(stderr, "%s uses more than %d distinct letters.\n", g_szDictionaryTextPath, VARIANT_MAX_ALPHABET);
+        ok = false;
+    }
+
+    if (ok)
+    {
+        pVariant->pWords = (char*)malloc((size_t)numWords * VARIANT_RECORD_SIZE(wordLength));
+        pVariant->pRanks = (short*)malloc(numWords * sizeof(short));
+        pVariant->pNounTypes = (char*)malloc(numWords);
+        pVariant->pVerbTypes = (char*)malloc(numWords);
+        ok = (pVariant->pWords && pVariant->pRanks && pVariant->pNounTypes && pVariant->pVerbTypes);
+        if (!ok) fprintf(stderr, "Out of memory allocating dictionary!\n");
+    }
+
+    if (ok)
+    {
+        qsort(pRecords, numWords, recordSize, compare_variant_records);
+        for (long i = 0; i < numWords; i++)
+        {
+            const char* pRecord = pRecords + (size_t)i * recordSize;
+            char* word = pVariant->pWords + (size_t)i * VARIANT_RECORD_SIZE(wordLength);
+            char rankStr[4];
+            memcpy(word, pRecord, wordLength + 1);
+            for (int pos = 0; pos < wordLength; pos++)
+            {
+                word[wordLength + 1 + pos] = (char)letterIndex[(unsigned char)pRecord[pos]];
+            }
+            memcpy(rankStr, pRecord + wordLength + 1, 3);
+            rankStr[3] = '\0';
+            pVariant->pRanks[i] = (short)atoi(rankStr);
+            pVariant->pNounTypes[i] = pRecord[wordLength + 4];
+            pVariant->pVerbTypes[i] = pRecord[wordLength + 5];
+        }
+
+        pVariant->pKernels = select_word_kernels(wordLength, alphabetSize);
+        pVariant->wordLength = wordLength;
+        pVariant->alphabetSize = alphabetSize;
+        pVariant->numWords = numWords;
+        pVariant->isMapped = false;
+        numWordsInDictionary = numWords;
+        printf("Loaded %ld %d-letter words over a %d-letter alphabet from the consolidated dictionary.\n", numWords, wordLength, alphabetSize);
+    }
+    else
+    {
+        free_variant_dictionary();
+    }
+
+    free(pRecords);
+    return ok;
+}
+
+/**
+ * @brief Fetches and loads the local text dictionary file into memory.
+ * The dictionary is loaded into a contiguous array of WORD_ENTRY structures and sorted.
+ * A file of another word length or with letters beyond A-Z is loaded into g_variantDictionary
+ * instead (see load_variant_text_dictionary).
+ * @return PWORD_ENTRY Pointer to the allocated dictionary array, or NULL on failure or for a variant.
+ */
+PWORD_ENTRY load_text_dictionary()
+{
+    FILE* fpIn;
+    errno_t errval;
+    char buffer[100];
+    numWordsInDictionary = 0;
+
+    PWORD_ENTRY pDictionary = (PWORD_ENTRY)malloc(sizeof(WORD_ENTRY) * maxDictionary);
+    if (pDictionary == NULL)
+    {
+        fprintf(stderr, "Out of memory allocating dictionary!\n");
+        return NULL;
+    }
+
+    errval = fopen_s(&fpIn, g_szDictionaryTextPath, "r");
+    if (fpIn == NULL || errval != 0)
+    {
+        fprintf(stderr, "Could not open consolidated dictionary file (%s)! Set --data-dir or WORDLE_DATA_DIR.\n", g_szDictionaryTextPath);
+        free(pDictionary);
+        return NULL;
+    }
+
+    // The first word line sets the word length; another length, or a letter above 0x7F anywhere,
+    // makes it a variant dictionary
+    int wordLength = 0;
+    bool isExtended = false;
+    while (fgets(buffer, 100, fpIn) != NULL)
+    {
+        trim(buffer);
+        int lineLength = (int)strlen(buffer);
+        if (lineLength <= 5 || !(isalpha((unsigned char)buffer[0]) || (unsigned char)buffer[0] >= 0x80)) continue;
+        if (wordLength == 0) wordLength = lineLength - 5;
+        for (int i = 0; i < lineLength - 5; i++)
+        {
+            if ((unsigned char)buffer[i] >= 0x80) isExtended = true;
+        }
+    }
+    rewind(fpIn);
+    if (wordLength != 0 && (wordLength != WORD_SIZE || isExtended))
+    {
+        load_variant_text_dictionary(fpIn, wordLength);
+        fclose(fpIn);
+        free(pDictionary);
+        return NULL;
+    }
+
+    // Read the file line by line, parsing the word, rank, and linguistic types
+    while (fgets(buffer, 100, fpIn) != NULL && numWordsInDictionary < maxDictionary)
+    {
+        trim(buffer);
+
+        // Line format: [5-Letter Word][3-Digit Rank][Noun Type][Verb Type] (min 10 chars)
+        if (strlen(buffer) >= 10)
+        {
+            PWORD_ENTRY pEntry = pDictionary + numWordsInDictionary;
+
+            // 1. Extract and format the word (first 5 characters), skipping lines that are not letters
+            bool isWord = true;
+            memcpy(pEntry->word, buffer, WORD_SIZE);
+            for (int i = 0; i < WORD_SIZE; i++)
+            {
+                pEntry->word[i] = toupper((unsigned char)pEntry->word[i]);
+                if (pEntry->word[i] < 'A' || pEntry->word[i] > 'Z') isWord = false;
+            }
+            pEntry->word[WORD_SIZE] = '\0';
+            if (!isWord) continue;
+
+            // 2. Extract and parse the rank (next 3 characters: 000-100)
+            char rankStr[4];
+            memcpy(rankStr, buffer + 5, 3);
+            rankStr[3] = '\0';
+            pEntry->rank = atoi(rankStr);
+
+            // 3. Extract linguistic types (next 2 characters)
+            pEntry->nounType = buffer[8];
+            pEntry->verbType = buffer[9];
+
+            numWordsInDictionary++;
+        }
+    }
+
+    fclose(fpIn);
+    printf("Loaded %ld words from the new consolidated dictionary.\n", numWordsInDictionary);
+    // Sort the dictionary for efficient O(log N) binary search access
+    qsort(pDictionary, numWordsInDictionary, sizeof(WORD_ENTRY), compare);
+
+    return pDictionary;
+}
+
+// --- Binary Dictionary ---
+
+/**
+ * @brief Maps a whole file read-only into memory.
+ * The file is opened with fopen_s like every other data file, then mapped through its descriptor.
+ * @param pszPath The file path.
+ * @param pMap Output mapping.
+ * @return bool True if the file exists, is not empty and was mapped.
+ */
+bool map_file_readonly(const char* pszPath, PMAPPED_FILE pMap)
+{
+    FILE* fpIn;
+    bool ok = false;
+
+    memset(pMap, 0, sizeof(MAPPED_FILE));
+    if (fopen_s(&fpIn, pszPath, "rb") != 0 || fpIn == NULL) return false;
+
+#ifdef _WIN32
+    HANDLE hFile = (HANDLE)_get_osfhandle(_fileno(fpIn));
+    LARGE_INTEGER fileSize;
+    if (hFile != INVALID_HANDLE_VALUE && GetFileSizeEx(hFile, &fileSize) && fileSize.QuadPart > 0)
+    {
+        pMap->hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (pMap->hMapping != NULL)
+        {
+            pMap->pBase = MapViewOfFile(pMap->hMapping, FILE_MAP_READ, 0, 0, 0);
+            if (pMap->pBase != NULL)
+            {
+                pMap->size = (size_t)fileSize.QuadPart;
+                ok = true;
+            }
+            else
+            {
+                CloseHandle(pMap->hMapping);
+                pMap->hMapping = NULL;
+            }
+        }
+    }
+#else
+    struct stat st;
+    if (fstat(fileno(fpIn), &st) == 0 && st.st_size > 0)
+    {
+        void* pBase = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fileno(fpIn), 0);
+        if (pBase != MAP_FAILED)
+        {
+            pMap->pBase = pBase;
+            pMap->size = (size_t)st.st_size;
+            ok = true;
+        }
+    }
+#endif
+
+    // The mapping stays valid after the file is closed
+    fclose(fpIn);
+    return ok;
+}
+
+/**
+ * @brief Releases a mapping made by map_file_readonly (no-op for an empty mapping).
+ */
+void unmap_file(PMAPPED_FILE pMap)
+{
+    if (pMap->pBase == NULL) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(pMap->pBase);
+    CloseHandle(pMap->hMapping);
+#else
+    munmap(pMap->pBase, pMap->size);
+#endif
+    memset(pMap, 0, sizeof(MAPPED_FILE));
+}
+
+/**
+ * @brief Gets a file's modification time.
+ * @return bool False if the file cannot be opened.
+ */
+static bool get_file_mtime(const char* pszPath, long long* pMtime)
+{
+    FILE* fpIn;
+    if (fopen_s(&fpIn, pszPath, "rb") != 0 || fpIn == NULL) return false;
+
+#ifdef _WIN32
+    struct _stat64 st;
+    bool ok = (_fstat64(_fileno(fpIn), &st) == 0);
+#else
+    struct stat st;
+    bool ok = (fstat(fileno(fpIn), &st) == 0);
+#endif
+    fclose(fpIn);
+
+    if (ok) *pMtime = (long long)st.st_mtime;
+    return ok;
+}
+
+/**
+ * @brief Checks that a section of numBytes at offset lies inside the mapped file and is aligned.
+ */
+static bool is_valid_section(const MAPPED_FILE* pMap, long long offset, long long numBytes)
+{
+    return offset > 0 && numBytes >= 0 && (offset % BINARY_SECTION_ALIGNMENT) == 0 &&
+        (unsigned long long)offset + (unsigned long long)numBytes <= pMap->size;
+}
+
+/**
+ * @brief Checks that every mapped word is WORD_SIZE letters A-Z (NUL-terminated) and that its packed
+ * letters match it. The filter and feedback code index per-letter tables with (letter - 'A'), so a
+ * corrupt or hand-edited file must not get that far.
+ */
+static bool are_valid_binary_words(const WORD_ENTRY* pEntries, const unsigned int* pPacked, long long numWords)
+{
+    for (long long i = 0; i < numWords; i++)
+    {
+        unsigned int packed = 0;
+        for (int pos = 0; pos < WORD_SIZE; pos++)
+        {
+            char c = pEntries[i].word[pos];
+            if (c < 'A' || c > 'Z') return false;
+            packed |= (unsigned int)(c - 'A') << (pos * LETTER_BITS);
+        }
+        if (pEntries[i].word[WORD_SIZE] != '\0' || pPacked[i] != packed) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Returns a section of the mapped binary dictionary.
+ */
+static const void* get_binary_section(long long offset)
+{
+    return (const char*)g_dictionaryMapping.pBase + offset;
+}
+
+/**
+ * @brief True if a header's alphabet is A-Z in order, the alphabet of WORD_ENTRY dictionaries.
+ */
+static bool is_standard_alphabet(const unsigned char* pAlphabet, int alphabetSize)
+{
+    if (alphabetSize != ALPHABET_SIZE) return false;
+    for (int i = 0; i < ALPHABET_SIZE; i++)
+    {
+        if (pAlphabet[i] != 'A' + i) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Checks that every mapped variant word record is wordLength letters of the header's
+ * alphabet (NUL-terminated) and that its letter indices match it. The word kernels index
+ * per-letter tables with those indices.
+ */
+static bool are_valid_variant_words(const BINARY_DICTIONARY_HEADER* pHeader, const char* pWords, long long numWords)
+{
+    int wordLength = pHeader->wordSize;
+    for (long long i = 0; i < numWords; i++)
+    {
+        const char* word = pWords + i * VARIANT_RECORD_SIZE(wordLength);
+        const unsigned char* letters = (const unsigned char*)word + wordLength + 1;
+        for (int pos = 0; pos < wordLength; pos++)
+        {
+            if (letters[pos] >= pHeader->alphabetSize || (unsigned char)word[pos] != pHeader->alphabet[letters[pos]]) return false;
+        }
+        if (word[wordLength] != '\0') return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Maps the compiled dictionary (see BINARY_DICTIONARY_HEADER) if it exists, is valid, holds
+ * only valid words and is not older than the text dictionary. Nothing is parsed: the WORD_ENTRY
+ * section is used in place as the dictionary table. The header's word length and alphabet select
+ * the word kernels: a standard WORD_SIZE-letter A-Z file is the solver's table, any other goes to
+ * g_variantDictionary with its columns in place.
+ * @param pszPath The binary dictionary path.
+ * @return PWORD_ENTRY The mapped dictionary table, or NULL for a variant or to fall back to the text file.
+ */
+PWORD_ENTRY load_binary_dictionary(const char* pszPath)
+{
+    long long binaryMtime = 0;
+    long long textMtime = 0;
+
+    if (!map_file_readonly(pszPath, &g_dictionaryMapping)) return NULL;
+
+    const BINARY_DICTIONARY_HEADER* pHeader = (const BINARY_DICTIONARY_HEADER*)g_dictionaryMapping.pBase;
+    long long numWords = (g_dictionaryMapping.size >= sizeof(BINARY_DICTIONARY_HEADER)) ? pHeader->numWords : -1;
+
+    bool valid = (numWords > 0 && numWords <= MAX_DICTIONARY_WORDS &&
+        memcmp(pHeader->magic, BINARY_DICTIONARY_MAGIC, 4) == 0 &&
+        pHeader->version == BINARY_DICTIONARY_VERSION &&
+        pHeader->alphabetSize >= 1 && pHeader->alphabetSize <= VARIANT_MAX_ALPHABET);
+
+    // Another word length or alphabet is a variant dictionary, played by the kernels the header selects
+    bool isVariant = valid && (pHeader->wordSize != WORD_SIZE || !is_standard_alphabet(pHeader->alphabet, pHeader->alphabetSize));
+    const WORD_KERNELS* pKernels = isVariant ? select_word_kernels(pHeader->wordSize, pHeader->alphabetSize) : NULL;
+    if (isVariant)
+    {
+        long long wordLength = pHeader->wordSize;
+        valid = (pHeader->entrySize == VARIANT_RECORD_SIZE(wordLength) &&
+            is_valid_section(&g_dictionaryMapping, pHeader->entriesOffset, numWords * VARIANT_RECORD_SIZE(wordLength)) &&
+            pHeader->packedOffset == 0 &&
+            is_valid_section(&g_dictionaryMapping, pHeader->ranksOffset, numWords * (long long)sizeof(short)) &&
+            is_valid_section(&g_dictionaryMapping, pHeader->nounTypesOffset, numWords) &&
+            is_valid_section(&g_dictionaryMapping, pHeader->verbTypesOffset, numWords) &&
+            pHeader->matrixOffset == 0);
+    }
+    else if (valid)
+    {
+        valid = (pHeader->entrySize == (int)sizeof(WORD_ENTRY) &&
+            is_valid_section(&g_dictionaryMapping, pHeader->entriesOffset, numWords * (long long)sizeof(WORD_ENTRY)) &&
+            is_valid_section(&g_dictionaryMapping, pHeader->packedOffset, numWords * (long long)sizeof(unsigned int)) &&
+            is_valid_section(&g_dictionaryMapping, pHeader->ranksOffset, numWords * (long long)sizeof(short)) &&
+            is_valid_section(&g_dictionaryMapping, pHeader->nounTypesOffset, numWords) &&
+            is_valid_section(&g_dictionaryMapping, pHeader->verbTypesOffset, numWords) &&
+            (pHeader->matrixOffset == 0 || is_valid_section(&g_dictionaryMapping, pHeader->matrixOffset, numWords * numWords)));
+    }
+
+    if (isVariant && pKernels == NULL)
+    {
+        fprintf(stderr, "%s holds %d-letter words over %d letters; no word kernels are compiled for that.\n", pszPath, pHeader->wordSize, pHeader->alphabetSize);
+        valid = false;
+    }
+    else if (valid && isVariant && !are_valid_variant_words(pHeader, (const char*)get_binary_section(pHeader->entriesOffset), numWords))
+    {
+        fprintf(stderr, "Ignoring corrupt binary dictionary %s (a word is not %d letters of its alphabet).\n", pszPath, pHeader->wordSize);
+        valid = false;
+    }
+    else if (valid && !isVariant && !are_valid_binary_words((const WORD_ENTRY*)((const char*)g_dictionaryMapping.pBase + pHeader->entriesOffset),
+        (const unsigned int*)((const char*)g_dictionaryMapping.pBase + pHeader->packedOffset), numWords))
+    {
+        fprintf(stderr, "Ignoring corrupt binary dictionary %s (a word is not %d letters A-Z).\n", pszPath, WORD_SIZE);
+        valid = false;
+    }
+    else if (!valid)
+    {
+        fprintf(stderr, "Ignoring invalid or incompatible binary dictionary %s.\n", pszPath);
+    }
+
+    // A text dictionary edited after compiling wins; the binary is only a faster copy of it
+    if (valid && get_file_mtime(pszPath, &binaryMtime) && get_file_mtime(g_szDictionaryTextPath, &textMtime) && textMtime > binaryMtime)
+    {
+        fprintf(stderr, "Binary dictionary is older than AllWords.txt; loading the text file (rebuild with --compile-dictionary).\n");
+        valid = false;
+    }
+
+    if (!valid)
+    {
+        unmap_file(&g_dictionaryMapping);
+        return NULL;
+    }
+
+    if (isVariant)
+    {
+        PVARIANT_DICTIONARY pVariant = &g_variantDictionary;
+        pVariant->pKernels = pKernels;
+        pVariant->wordLength = pHeader->wordSize;
+        pVariant->alphabetSize = pHeader->alphabetSize;
+        memcpy(pVariant->alphabet, pHeader->alphabet, VARIANT_MAX_ALPHABET);
+        pVariant->numWords = (long)numWords;
+        pVariant->pWords = (char*)get_binary_section(pHeader->entriesOffset);
+        pVariant->pRanks = (short*)get_binary_section(pHeader->ranksOffset);
+        pVariant->pNounTypes = (char*)get_binary_section(pHeader->nounTypesOffset);
+        pVariant->pVerbTypes = (char*)get_binary_section(pHeader->verbTypesOffset);
+        pVariant->isMapped = true;
+        numWordsInDictionary = (long)numWords;
+        printf("Mapped %ld %d-letter words over a %d-letter alphabet from the compiled dictionary.\n", numWordsInDictionary, pVariant->wordLength, pVariant->alphabetSize);
+        return NULL;
+    }
+
+    g_pBinaryDictionary = pHeader;
+    numWordsInDictionary = (long)numWords;
+    printf("Mapped %ld words from the compiled dictionary%s.\n", numWordsInDictionary, pHeader->matrixOffset ? " (with pattern matrix)" : "");
+    return (PWORD_ENTRY)((const char*)g_dictionaryMapping.pBase + pHeader->entriesOffset);
+}
+
+/**
+ * @brief Releases the dictionary table returned by get_dictionary_table (unmaps or frees it).
+ */
+void release_dictionary_table(PWORD_ENTRY pDictionary)
+{
+    if (g_pBinaryDictionary != NULL)
+    {
+        g_pBinaryDictionary = NULL;
+        unmap_file(&g_dictionaryMapping);
+    }
+    else if (pDictionary)
+    {
+        free(pDictionary);
+    }
+}
+
+/**
+ * @brief Releases g_variantDictionary (unmaps or frees its columns; no-op if none was loaded).
+ */
+void free_variant_dictionary()
+{
+    PVARIANT_DICTIONARY pVariant = &g_variantDictionary;
+    if (pVariant->isMapped)
+    {
+        unmap_file(&g_dictionaryMapping);
+    }
+    else
+    {
+        if (pVariant->pWords) free(pVariant->pWords);
+        if (pVariant->pRanks) free(pVariant->pRanks);
+        if (pVariant->pNounTypes) free(pVariant->pNounTypes);
+        if (pVariant->pVerbTypes) free(pVariant->pVerbTypes);
+    }
+    memset(pVariant, 0, sizeof(VARIANT_DICTIONARY));
+}
+
+/**
+ * @brief Pads the output file with zeros up to the next section boundary.
+ * @return long long The offset of the next section, or -1 on a write error.
+ */
+static long long pad_to_section(FILE* fpOut, long long offset)
+{
+    static const char zeros[BINARY_SECTION_ALIGNMENT] = { 0 };
+    long long padding = (BINARY_SECTION_ALIGNMENT - offset % BINARY_SECTION_ALIGNMENT) % BINARY_SECTION_ALIGNMENT;
+
+    if (padding > 0 && fwrite(zeros, 1, (size_t)padding, fpOut) != (size_t)padding) return -1;
+    return offset + padding;
+}
+
+/**
+ * @brief Writes a compiled dictionary file: the header, then each non-NULL section on a
+ * BINARY_SECTION_ALIGNMENT boundary, recording its offset in the header (absent sections stay 0).
+ * @param pszPath The output path.
+ * @param pHeader The filled-in header; its section offsets are set here.
+ * @param pSections The BINARY_DICTIONARY_SECTIONS sections in header order (entries, packed,
+ * ranks, noun types, verb types, matrix), NULL if absent.
+ * @param pSectionSizes Their sizes in bytes.
+ * @return bool True if the file was written completely.
+ */
+static bool write_binary_sections(const char* pszPath, PBINARY_DICTIONARY_HEADER pHeader, const void* const* pSections, const long long* pSectionSizes)
+{
+    FILE* fpOut;
+    long long* pOffsets[BINARY_DICTIONARY_SECTIONS] = { &pHeader->entriesOffset, &pHeader->packedOffset, &pHeader->ranksOffset,
+        &pHeader->nounTypesOffset, &pHeader->verbTypesOffset, &pHeader->matrixOffset };
+
+    if (fopen_s(&fpOut, pszPath, "wb") != 0 || fpOut == NULL)
+    {
+        fprintf(stderr, "Could not create binary dictionary %s!\n", pszPath);
+        return false;
+    }
+
+    // Lay out the sections first so the header can be written in one go
+    long long offset = sizeof(BINARY_DICTIONARY_HEADER);
+    for (int i = 0; i < BINARY_DICTIONARY_SECTIONS; i++)
+    {
+        if (pSections[i] == NULL) continue;
+        offset += (BINARY_SECTION_ALIGNMENT - offset % BINARY_SECTION_ALIGNMENT) % BINARY_SECTION_ALIGNMENT;
+        *pOffsets[i] = offset;
+        offset += pSectionSizes[i];
+    }
+
+    bool ok = (fwrite(pHeader, sizeof(BINARY_DICTIONARY_HEADER), 1, fpOut) == 1);
+    offset = sizeof(BINARY_DICTIONARY_HEADER);
+    for (int i = 0; ok && i < BINARY_DICTIONARY_SECTIONS; i++)
+    {
+        if (pSections[i] == NULL) continue;
+        offset = pad_to_section(fpOut, offset);
+        ok = (offset == *pOffsets[i] && fwrite(pSections[i], 1, (size_t)pSectionSizes[i], fpOut) == (size_t)pSectionSizes[i]);
+        offset += pSectionSizes[i];
+    }
+    if (fclose(fpOut) != 0) ok = false;
+
+    if (!ok)
+    {
+        fprintf(stderr, "Failed writing binary dictionary %s!\n", pszPath);
+        remove(pszPath);
+    }
+    return ok;
+}
+
+/**
+ * @brief Writes the compiled dictionary: header, the sorted WORD_ENTRY table, the store's packed
+ * letter / rank / noun / verb columns and, if it is built, the pattern matrix.
+ * Requires the dictionary store (and optionally the matrix) built over pDictionary.
+ * @param pszPath The output path.
+ * @param pDictionary The sorted dictionary table.
+ * @param numDictionary The number of entries.
+ * @return bool True if the file was written completely.
+ */
+bool write_binary_dictionary(const char* pszPath, PWORD_ENTRY pDictionary, long numDictionary)
+{
+    BINARY_DICTIONARY_HEADER header;
+    const bool withMatrix = (g_patternMatrix.pCodes != NULL && g_patternMatrix.numWords == numDictionary);
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BINARY_DICTIONARY_MAGIC, 4);
+    header.version = BINARY_DICTIONARY_VERSION;
+    header.wordSize = WORD_SIZE;
+    header.entrySize = (int)sizeof(WORD_ENTRY);
+    header.alphabetSize = ALPHABET_SIZE;
+    for (int i = 0; i < ALPHABET_SIZE; i++) header.alphabet[i] = (unsigned char)('A' + i);
+    header.numWords = numDictionary;
+
+    const void* pSections[BINARY_DICTIONARY_SECTIONS] = { pDictionary, g_dictionaryStore.pPackedLetters, g_dictionaryStore.pRanks,
+        g_dictionaryStore.pNounTypes, g_dictionaryStore.pVerbTypes, withMatrix ? g_patternMatrix.pCodes : NULL };
+    long long sectionSizes[BINARY_DICTIONARY_SECTIONS] = { numDictionary * (long long)sizeof(WORD_ENTRY), numDictionary * (long long)sizeof(unsigned int),
+        numDictionary * (long long)sizeof(short), numDictionary, numDictionary, withMatrix ? (long long)numDictionary * numDictionary : 0 };
+
+    if (!write_binary_sections(pszPath, &header, pSections, sectionSizes)) return false;
+
+    printf("Compiled %ld words%s into %s.\n", numDictionary, withMatrix ? " and the pattern matrix" : "", pszPath);
+    return true;
+}
+
+/**
+ * @brief Writes g_variantDictionary as a compiled dictionary: its word length and alphabet in the
+ * header, then the word records and the rank, noun and verb columns (no packed words or matrix).
+ * @param pszPath The output path.
+ * @return bool True if the file was written completely.
+ */
+bool write_variant_binary_dictionary(const char* pszPath)
+{
+    const VARIANT_DICTIONARY* pVariant = &g_variantDictionary;
+    BINARY_DICTIONARY_HEADER header;
+    long long numWords = pVariant->numWords;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BINARY_DICTIONARY_MAGIC, 4);
+    header.version = BINARY_DICTIONARY_VERSION;
+    header.wordSize = pVariant->wordLength;
+    header.entrySize = VARIANT_RECORD_SIZE(pVariant->wordLength);
+    header.alphabetSize = pVariant->alphabetSize;
+    memcpy(header.alphabet, pVariant->alphabet, VARIANT_MAX_ALPHABET);
+    header.numWords = numWords;
+
+    const void* pSections[BINARY_DICTIONARY_SECTIONS] = { pVariant->pWords, NULL, pVariant->pRanks,
+        pVariant->pNounTypes, pVariant->pVerbTypes, NULL };
+    long long sectionSizes[BINARY_DICTIONARY_SECTIONS] = { numWords * VARIANT_RECORD_SIZE(pVariant->wordLength), 0,
+        numWords * (long long)sizeof(short), numWords, numWords, 0 };
+
+    if (!write_binary_sections(pszPath, &header, pSections, sectionSizes)) return false;
+
+    printf("Compiled %ld %d-letter words into %s.\n", pVariant->numWords, pVariant->wordLength, pszPath);
+    return true;
+}
+
+/**
+ * @brief Copies the parsed used-word list into a sorted contiguous array.
+ * @param pUsedWords The list from get_used_words_from_webpage_string (numUsedWords entries, in the
+ * thread's scratch arena; the caller releases it).
+ * @return char* The sorted table (packed 5-char words), or NULL on failure.
+ */
+char* build_used_words_table(PWORD_LIST pUsedWords)
+{
+    PWORD_NODE pWord = pUsedWords;
+    char* pTable = (pUsedWords != NULL) ? (char*)malloc(WORD_SIZE * numUsedWords) : NULL;
+    long cnt = 0;
+
+    if (pUsedWords != NULL && pTable == NULL) fprintf(stderr, "Out of memory allocating used word table\n");
+
+    // Copy words from linked list to the contiguous array
+    while (pWord != NULL)
+    {
+        if (pTable != NULL) memcpy(pTable + (cnt * WORD_SIZE), pWord->word, WORD_SIZE);
+        pWord = pWord->pNxt;
+        cnt++;
+    }
+
+    // Sort the list of used words for efficient O(log N) exclusion check
+    if (pTable != NULL) qsort(pTable, cnt, WORD_SIZE, compare);
+    return pTable;
+}
+
+/**
+ * @brief Loads the used-words cache (header, then numWords sorted 5-char words).
+ * @param pszPath The cache file path.
+ * @param pHeader Output header (timestamp and HTTP validators of the cached copy).
+ * @param ppTable Output sorted word table (caller frees).
+ * @return bool True if a valid cache was loaded.
+ */
+bool load_used_words_cache(const char* pszPath, PUSED_WORDS_CACHE_HEADER pHeader, char** ppTable)
+{
+    FILE* fpIn;
+    *ppTable = NULL;
+
+    if (fopen_s(&fpIn, pszPath, "rb") != 0 || fpIn == NULL) return false;
+
+    bool valid = (fread(pHeader, sizeof(USED_WORDS_CACHE_HEADER), 1, fpIn) == 1 &&
+        memcmp(pHeader->magic, USED_WORDS_CACHE_MAGIC, 4) == 0 &&
+        pHeader->version == USED_WORDS_CACHE_VERSION &&
+        pHeader->numWords >= 0 && pHeader->numWords <= MAX_DICTIONARY_WORDS);
+
+    if (valid)
+    {
+        pHeader->etag[sizeof(pHeader->etag) - 1] = '\0';
+        pHeader->lastModified[sizeof(pHeader->lastModified) - 1] = '\0';
+
+        *ppTable = (char*)malloc(WORD_SIZE * (size_t)pHeader->numWords + 1);
+        valid = (*ppTable != NULL && fread(*ppTable, WORD_SIZE, pHeader->numWords, fpIn) == (size_t)pHeader->numWords);
+
+        for (long i = 0; valid && i < WORD_SIZE * (long)pHeader->numWords; i++)
+        {
+            if ((*ppTable)[i] < 'A' || (*ppTable)[i] > 'Z') valid = false;
+        }
+        if (valid) qsort(*ppTable, pHeader->numWords, WORD_SIZE, compare);
+    }
+    fclose(fpIn);
+
+    if (!valid)
+    {
+        fprintf(stderr, "Ignoring invalid used-words cache %s.\n", pszPath);
+        if (*ppTable) free(*ppTable);
+        *ppTable = NULL;
+    }
+    return valid;
+}
+
+/**
+ * @brief Writes the used-words cache.
+ * @param pszPath The cache file path.
+ * @param pHeader The header (numWords, timestamp and validators filled in by the caller).
+ * @param pTable The sorted word table.
+ * @return bool True if the file was written completely.
+ */
+bool save_used_words_cache(const char* pszPath, PUSED_WORDS_CACHE_HEADER pHeader, const char* pTable)
+{
+    FILE* fpOut;
+
+    memcpy(pHeader->magic, USED_WORDS_CACHE_MAGIC, 4);
+    pHeader->version = USED_WORDS_CACHE_VERSION;
+
+    if (fopen_s(&fpOut, pszPath, "wb") != 0 || fpOut == NULL)
+    {
+        fprintf(stderr, "Could not write used-words cache %s.\n", pszPath);
+        return false;
+    }
+
+    bool ok = (fwrite(pHeader, sizeof(USED_WORDS_CACHE_HEADER), 1, fpOut) == 1 &&
+        fwrite(pTable, WORD_SIZE, pHeader->numWords, fpOut) == (size_t)pHeader->numWords);
+    if (fclose(fpOut) != 0) ok = false;
+
+    if (!ok)
+    {
+        fprintf(stderr, "Failed writing used-words cache %s.\n", pszPath);
+        remove(pszPath);
+    }
+    return ok;
+}
+
+#ifndef WORDLE_NO_CURL
+/**
+ * @brief Background fetch thread: downloads the page, then flags the fetch as finished.
+ */
+static void run_used_words_fetch(PUSED_WORDS_FETCH pFetch)
+{
+    get_used_words_webpage(pFetch);
+    pFetch->finished.store(true, std::memory_order_release);
+}
+#endif
+
+/**
+ * @brief Loads the used-words cache and, unless offline, starts refreshing it on a background
+ * thread so the download overlaps loading the dictionary. Must be paired with finish_used_words_fetch.
+ * @param pFetch The fetch state to initialize.
+ */
+void start_used_words_fetch(PUSED_WORDS_FETCH pFetch)
+{
+    memset(&pFetch->cacheHeader, 0, sizeof(pFetch->cacheHeader));
+    memset(&pFetch->body, 0, sizeof(pFetch->body));
+    pFetch->etag[0] = '\0';
+    pFetch->lastModified[0] = '\0';
+    pFetch->result = CURLE_OK;
+    pFetch->httpStatus = 0;
+    pFetch->succeeded = false;
+    pFetch->workerStarted = false;
+    pFetch->finished.store(false);
+    pFetch->online = !g_options.offline;
+#ifdef WORDLE_NO_CURL
+    if (pFetch->online) printf("Built without cURL; using the cached used-word list.\n");
+    pFetch->online = false;
+#endif
+
+    pFetch->haveCache = load_used_words_cache(g_szUsedWordsCachePath, &pFetch->cacheHeader, &pFetch->pCachedTable);
+    if (!pFetch->online) return;
+
+#ifndef WORDLE_NO_CURL
+    // curl_global_init is not thread-safe, so it runs here before the worker exists
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    try
+    {
+        pFetch->worker = std::thread(run_used_words_fetch, pFetch);
+        pFetch->workerStarted = true;
+    }
+    catch (...)
+    {
+        get_used_words_webpage(pFetch);
+    }
+#endif
+}
+
+/**
+ * @brief True while the background download is still running, i.e. while finish_used_words_fetch
+ * would block. Startup uses this window for work that does not depend on the used words.
+ */
+bool is_used_words_fetch_pending(PUSED_WORDS_FETCH pFetch)
+{
+    return pFetch->workerStarted && !pFetch->finished.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Waits for the background fetch and builds the used-word table: from a fresh page when
+ * it was downloaded (and then saved to the cache), otherwise from the cache.
+ * Sets numUsedWords.
+ * @param pFetch The fetch state from start_used_words_fetch.
+ * @return char* Pointer to the allocated, sorted array of used words (never NULL).
+ */
+char* finish_used_words_fetch(PUSED_WORDS_FETCH pFetch)
+{
+    char* pTable = NULL;
+    bool notModified = false;
+
+    if (pFetch->workerStarted) pFetch->worker.join();
+    pFetch->workerStarted = false;
+
+#ifndef WORDLE_NO_CURL
+    if (pFetch->online)
+    {
+        if (!pFetch->succeeded)
+        {
+            if (pFetch->result != CURLE_OK) fprintf(stderr, "cURL failed: %s\n", curl_easy_strerror(pFetch->result));
+            else if (pFetch->httpStatus != 0) fprintf(stderr, "Used words page returned HTTP %ld.\n", pFetch->httpStatus);
+            fprintf(stderr, "Failed to download webpage content.\n");
+        }
+        else if (pFetch->httpStatus == 304)
+        {
+            notModified = true;
+            printf("Used words page unchanged since the cached copy.\n");
+        }
+        else
+        {
+            printf("Webpage content downloaded successfully.\n");
+
+            // Parse the HTML content into a linked list of words (scratch nodes), then a sorted table
+            PSCRATCH_ARENA pArena = get_scratch_arena();
+            size_t mark = scratch_mark(pArena);
+            pTable = build_used_words_table(get_used_words_from_webpage_string(pFetch->body.pData));
+            scratch_release(pArena, mark);
+            if (pTable != NULL)
+            {
+                USED_WORDS_CACHE_HEADER header;
+                memset(&header, 0, sizeof(header));
+                header.numWords = (int)numUsedWords;
+                header.fetchedAt = (long long)time(NULL);
+                memcpy(header.etag, pFetch->etag, sizeof(header.etag));
+                memcpy(header.lastModified, pFetch->lastModified, sizeof(header.lastModified));
+                save_used_words_cache(g_szUsedWordsCachePath, &header, pTable);
+            }
+        }
+        curl_global_cleanup();
+    }
+#endif
+
+    if (pFetch->body.pData) free(pFetch->body.pData);
+    memset(&pFetch->body, 0, sizeof(pFetch->body));
+
+    if (pTable == NULL && pFetch->haveCache)
+    {
+        pTable = pFetch->pCachedTable;
+        pFetch->pCachedTable = NULL;
+        numUsedWords = pFetch->cacheHeader.numWords;
+
+        double ageHours = difftime(time(NULL), (time_t)pFetch->cacheHeader.fetchedAt) / 3600.0;
+        printf("Using %ld used words cached in %s (%.1f hours old).\n", numUsedWords, g_szUsedWordsCachePath, notModified ? 0.0 : ageHours);
+
+        // A confirmed-current cache gets a fresh timestamp
+        if (notModified)
+        {
+            pFetch->cacheHeader.fetchedAt = (long long)time(NULL);
+            save_used_words_cache(g_szUsedWordsCachePath, &pFetch->cacheHeader, pTable);
+        }
+    }
+    if (pFetch->pCachedTable) free(pFetch->pCachedTable);
+    pFetch->pCachedTable = NULL;
+
+    // Ensure pTable is not NULL if no words were found
+    if (pTable == NULL)
+    {
+        pTable = (char*)malloc(1);
+        numUsedWords = 0;
+    }
+    return pTable;
+}
+
+/**
+ * @brief Fetches the list of previously used Wordle answers (or reads the cache) and stores them
+ * in a sorted contiguous array for fast lookup. Synchronous form of start/finish_used_words_fetch.
+ * @return char* Pointer to the allocated, sorted array of used words (packed 5-char strings).
+ */
+char* get_used_words_table()
+{
+    USED_WORDS_FETCH fetch;
+
+    start_used_words_fetch(&fetch);
+    return finish_used_words_fetch(&fetch);
+}
+
+/**
+ * @brief Builds the turn-1 possible answers: the dictionary minus the used words. Both lists are
+ * sorted, so one merge pass marks the used word IDs in a bitmask, and a second pass collects the
+ * unmarked words in dictionary order.
+ * @param pDictionary The sorted dictionary table.
+ * @param numDictionary The number of dictionary entries.
+ * @param pUsedWordsTable The sorted used-word table (packed 5-char words).
+ * @param numUsed The number of used words.
+ * @param pPossibleAnswers Output array (numDictionary entries) of pointers into the dictionary.
+ * @return long The number of possible answers, or -1 on memory allocation failure.
+ */
+long build_initial_answers(PWORD_ENTRY pDictionary, long numDictionary, const char* pUsedWordsTable, long numUsed, char** pPossibleAnswers)
+{
+    PSCRATCH_ARENA pArena = get_scratch_arena();
+    size_t mark = scratch_mark(pArena);
+    long numBlocks = (numDictionary + 63) / 64;
+    unsigned long long* pUsedBits = (unsigned long long*)scratch_calloc(pArena, numBlocks, sizeof(unsigned long long));
+    if (pUsedBits == NULL)
+    {
+        scratch_release(pArena, mark);
+        return -1;
+    }
+
+    for (long i = 0, u = 0; i < numDictionary && u < numUsed; )
+    {
+        int order = compare(pDictionary[i].word, pUsedWordsTable + u * WORD_SIZE);
+        if (order == 0) pUsedBits[i / 64] |= 1ULL << (i % 64);
+        if (order <= 0) i++;
+        if (order >= 0) u++;
+    }
+
+    long numAnswers = 0;
+    for (long i = 0; i < numDictionary; i++)
+    {
+        if (((pUsedBits[i / 64] >> (i % 64)) & 1) == 0) pPossibleAnswers[numAnswers++] = pDictionary[i].word;
+    }
+
+    scratch_release(pArena, mark);
+    return numAnswers;
+}
+
+/**
+ * @brief Checks if a given word is a valid remaining answer based on current game constraints.
+ * @param pMask Mask of known green letters (e.g., "*A*S*").
+ * @param notMask Array of letters that cannot be in specific positions (from yellow and black results).
+ * @param pGood String of required letters (min count constraint, from yellow and green results).
+ * @param pBad String of letters that must be completely absent (from black results).
+ * @param pWord The word being checked against the constraints.
+ * @return 1 if the word is a good fit, 0 otherwise.
+ */
+int is_good_fit(char* pMask, char notMask[6][5], char* pGood, char* pBad, char* pWord)
+{
+    // 1. CHECK REQUIRED LETTER COUNTS (YELLOW AND GREEN)
+    int required_counts[26] = { 0 };
+    for (char* p = pGood; *p != '\0'; p++)
+    {
+        required_counts[*p - 'A']++;
+    }
+
+    for (int i = 0; i < 26; i++)
+    {
+        if (required_counts[i] > 0)
+        {
+            char required_char = 'A' + i;
+            int word_count = 0;
+
+            for (int wordIdx = 0; wordIdx < WORD_SIZE; wordIdx++)
+            {
+                if (*(pWord + wordIdx) == required_char)
+                {
+                    word_count++;
+                }
+            }
+
+            // Word must contain at least the minimum required count of the letter
+            if (word_count < required_counts[i])
+            {
+                return 0;
+            }
+        }
+    }
+
+    // 2. CHECK POSITIONAL CONSTRAINTS
+    for (int idx = 0; (idx < WORD_SIZE); idx++)
+    {
+        char theChar = *(pWord + idx);
+
+        // Must not contain any "black-listed" letters (pBad)
+        if (strchr(pBad, theChar) != NULL) return 0;
+
+        // Must match green letter mask (pMask)
+        if (*(pMask + idx) != '*' && *(pMask + idx) != theChar) return 0;
+
+        // Must not have a yellow letter in the known incorrect position (notMask)
+        for (int notIdx = 0; notIdx < 6; notIdx++)
+        {
+            if (notMask[notIdx][idx] == theChar) return 0;
+        }
+    }
+
+    return 1;
+}
+
+// --- Word Kernels ---
+
+/**
+ * @brief Number of feedback patterns for a word length: 3^wordLength (gray, yellow or green per letter).
+ */
+constexpr int pattern_count(int wordLength)
+{
+    return (wordLength <= 0) ? 1 : 3 * pattern_count(wordLength - 1);
+}
+
+static_assert(NUM_PATTERNS == pattern_count(WORD_SIZE), "NUM_PATTERNS must be 3^WORD_SIZE");
+
+/**
+ * @brief Feedback pattern code of a guess/answer pair of L letter indices below A, with the rules of
+ * get_feedback_pattern (greens first, then yellows left to right against the unmatched letters).
+ * The position loops have compile-time bounds and weights, so every instantiation is fully unrolled.
+ * @return int The base-3 code (position 0 is the lowest digit; pattern_count(L) - 1 is all green).
+ */
+template <int L, int A>
+static inline int feedback_code_t(const unsigned char* guess, const unsigned char* answer)
+{
+    unsigned char answerCounts[A] = { 0 };
+    bool isGreen[L];
+    int code = 0;
+
+    for (int i = 0, weight = 1; i < L; i++, weight *= 3)
+    {
+        isGreen[i] = (guess[i] == answer[i]);
+        if (isGreen[i]) code += 2 * weight;
+        else answerCounts[answer[i]]++;
+    }
+
+    for (int i = 0, weight = 1; i < L; i++, weight *= 3)
+    {
+        if (!isGreen[i] && answerCounts[guess[i]] > 0)
+        {
+            code += weight;
+            answerCounts[guess[i]]--;
+        }
+    }
+    return code;
+}
+
+/**
+ * @brief Calculates the Wordle feedback pattern (G, Y, B) for a hypothetical guess/answer pair.
+ * This simulates the core Wordle logic needed for entropy calculation.
+ * @param guess The word being guessed.
+ * @param answer The actual solution word.
+ * @param result_pattern Output buffer for the 5-character result pattern (e.g., "BGYBB").
+ */
+void get_feedback_pattern(const char* guess, const char* answer, char* result_pattern)
+{
+    memset(result_pattern, 'B', WORD_SIZE);
+    result_pattern[WORD_SIZE] = '\0';
+
+    int answer_char_counts[26] = { 0 };
+
+    // 1. Determine Green ('G') matches and tally remaining answer letters
+    for (int i = 0; i < WORD_SIZE; i++)
+    {
+        if (guess[i] == answer[i])
+        {
+            result_pattern[i] = 'G';
+        }
+        else
+        {
+            answer_char_counts[answer[i] - 'A']++;
+        }
+    }
+
+    // 2. Determine Yellow ('Y') matches
+    for (int i = 0; i < WORD_SIZE; i++)
+    {
+        if (result_pattern[i] != 'G')
+        {
+            int letter_index = guess[i] - 'A';
+            if (answer_char_counts[letter_index] > 0)
+            {
+                result_pattern[i] = 'Y';
+                // Decrement count to handle duplicates correctly
+                answer_char_counts[letter_index]--;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Calculates the feedback for a guess/answer pair directly as a base-3 pattern code.
+ * Same Green/Yellow rules as get_feedback_pattern, without building the 5-char string.
+ * @param guess The word being guessed.
+ * @param answer The actual solution word.
+ * @return PATTERN_CODE The encoded result (0..242, PATTERN_ALL_GREEN when guess == answer).
+ */
+PATTERN_CODE get_feedback_pattern_code(const char* guess, const char* answer)
+{
+    unsigned char guessLetters[WORD_SIZE];
+    unsigned char answerLetters[WORD_SIZE];
+
+    for (int i = 0; i < WORD_SIZE; i++)
+    {
+        guessLetters[i] = (unsigned char)(guess[i] - 'A');
+        answerLetters[i] = (unsigned char)(answer[i] - 'A');
+    }
+    return (PATTERN_CODE)feedback_code_t<WORD_SIZE, ALPHABET_SIZE>(guessLetters, answerLetters);
+}
+
+/**
+ * @brief Calculates the feedback code for two words given as packed letter indices (see DICTIONARY_STORE).
+ * Same Green/Yellow rules as get_feedback_pattern_code.
+ * @param packedGuess The packed guess.
+ * @param packedAnswer The packed answer.
+ * @return PATTERN_CODE The encoded result.
+ */
+PATTERN_CODE get_feedback_pattern_code_packed(unsigned int packedGuess, unsigned int packedAnswer)
+{
+    unsigned char guessLetters[WORD_SIZE];
+    unsigned char answerLetters[WORD_SIZE];
+
+    for (int i = 0; i < WORD_SIZE; i++)
+    {
+        guessLetters[i] = (unsigned char)((packedGuess >> (i * LETTER_BITS)) & LETTER_MASK);
+        answerLetters[i] = (unsigned char)((packedAnswer >> (i * LETTER_BITS)) & LETTER_MASK);
+    }
+    return (PATTERN_CODE)feedback_code_t<WORD_SIZE, 1 << LETTER_BITS>(guessLetters, answerLetters);
+}
+
+/**
+ * @brief Converts a 5-character "BGYBB" style pattern into its base-3 code.
+ * @param result_pattern The pattern string (B, G or Y per position).
+ * @return PATTERN_CODE The encoded pattern.
+ */
+PATTERN_CODE encode_feedback_pattern(const char* result_pattern)
+{
+    int code = 0;
+    for (int i = WORD_SIZE - 1; i >= 0; i--)
+    {
+        int digit = (result_pattern[i] == 'G') ? 2 : (result_pattern[i] == 'Y') ? 1 : 0;
+        code = code * 3 + digit;
+    }
+    return (PATTERN_CODE)code;
+}
+
+/**
+ * @brief Converts a base-3 pattern code back into its 5-character "BGYBB" string.
+ * @param code The encoded pattern.
+ * @param result_pattern Output buffer of at least WORD_SIZE + 1 characters.
+ */
+void decode_feedback_pattern(PATTERN_CODE code, char* result_pattern)
+{
+    static const char digit_chars[3] = { 'B', 'Y', 'G' };
+    int value = code;
+    for (int i = 0; i < WORD_SIZE; i++)
+    {
+        result_pattern[i] = digit_chars[value % 3];
+        value /= 3;
+    }
+    result_pattern[WORD_SIZE] = '\0';
+}
+
+// --- Dictionary Store ---
+
+/**
+ * @brief Returns the prior weight of a word as the answer: a logistic curve of its rank, close to 1
+ * for common words and close to 0 for obscure ones.
+ * @param rank The word's rank (higher is more common).
+ * @return double The weight, in (0, 1).
+ */
+double get_prior_weight(int rank)
+{
+    return 1.0 / (1.0 + exp(-(rank - PRIOR_RANK_MIDPOINT) / PRIOR_RANK_SCALE));
+}
+
+/**
+ * @brief Builds the dictionary store (see DICTIONARY_STORE) over the loaded, sorted dictionary.
+ * Word IDs are positions in that table.
+ * @param pDictionary The sorted dictionary table (must stay allocated while the store is in use).
+ * @param numDictionary The number of dictionary entries.
+ * @return bool True on success, false on memory allocation failure.
+ */
+bool build_dictionary_store(PWORD_ENTRY pDictionary, long numDictionary)
+{
+    free_dictionary_store();
+
+    PDICTIONARY_STORE pStore = &g_dictionaryStore;
+
+    // Letter counts are cheap to derive, so they are built here for either source
+    pStore->pLetterCounts = (PLETTER_COUNTS)malloc(numDictionary * sizeof(LETTER_COUNTS));
+    if (pStore->pLetterCounts == NULL)
+    {
+        fprintf(stderr, "Out of memory for the dictionary store!\n");
+        return false;
+    }
+    for (long i = 0; i < numDictionary; i++) count_letters(pDictionary[i].word, WORD_SIZE, pStore->pLetterCounts + i);
+
+    // So are the prior weights (only --weighted scoring reads them)
+    pStore->pPriorWeights = (double*)malloc(numDictionary * sizeof(double));
+    if (pStore->pPriorWeights == NULL)
+    {
+        fprintf(stderr, "Out of memory for the dictionary store!\n");
+        free_dictionary_store();
+        return false;
+    }
+    for (long i = 0; i < numDictionary; i++) pStore->pPriorWeights[i] = get_prior_weight(pDictionary[i].rank);
+
+    // A compiled dictionary already holds the other columns
+    if (g_pBinaryDictionary != NULL && pDictionary == (PWORD_ENTRY)get_binary_section(g_pBinaryDictionary->entriesOffset))
+    {
+        pStore->pPackedLetters = (unsigned int*)get_binary_section(g_pBinaryDictionary->packedOffset);
+        pStore->pRanks = (short*)get_binary_section(g_pBinaryDictionary->ranksOffset);
+        pStore->pNounTypes = (char*)get_binary_section(g_pBinaryDictionary->nounTypesOffset);
+        pStore->pVerbTypes = (char*)get_binary_section(g_pBinaryDictionary->verbTypesOffset);
+        pStore->pEntries = pDictionary;
+        pStore->numWords = numDictionary;
+        pStore->ownsColumns = false;
+        return true;
+    }
+
+    pStore->ownsColumns = true;
+    pStore->pPackedLetters = (unsigned int*)malloc(numDictionary * sizeof(unsigned int));
+    pStore->pRanks = (short*)malloc(numDictionary * sizeof(short));
+    pStore->pNounTypes = (char*)malloc(numDictionary);
+    pStore->pVerbTypes = (char*)malloc(numDictionary);
+
+    if (!pStore->pPackedLetters || !pStore->pRanks || !pStore->pNounTypes || !pStore->pVerbTypes)
+    {
+        fprintf(stderr, "Out of memory for the dictionary store!\n");
+        free_dictionary_store();
+        return false;
+    }
+
+    for (long i = 0; i < numDictionary; i++)
+    {
+        unsigned int packed = 0;
+        for (int pos = 0; pos < WORD_SIZE; pos++)
+        {
+            packed |= ((unsigned int)(pDictionary[i].word[pos] - 'A') & LETTER_MASK) << (pos * LETTER_BITS);
+        }
+        pStore->pPackedLetters[i] = packed;
+        pStore->pRanks[i] = (short)pDictionary[i].rank;
+        pStore->pNounTypes[i] = pDictionary[i].nounType;
+        pStore->pVerbTypes[i] = pDictionary[i].verbType;
+    }
+
+    pStore->pEntries = pDictionary;
+    pStore->numWords = numDictionary;
+    return true;
+}
+
+/**
+ * @brief Releases the dictionary store (the WORD_ENTRY table itself is owned by the caller,
+ * mapped columns by the mapping).
+ */
+void free_dictionary_store()
+{
+    PDICTIONARY_STORE pStore = &g_dictionaryStore;
+    if (pStore->ownsColumns)
+    {
+        if (pStore->pPackedLetters) free(pStore->pPackedLetters);
+        if (pStore->pRanks) free(pStore->pRanks);
+        if (pStore->pNounTypes) free(pStore->pNounTypes);
+        if (pStore->pVerbTypes) free(pStore->pVerbTypes);
+    }
+    free(pStore->pLetterCounts);
+    free(pStore->pPriorWeights);
+    memset(pStore, 0, sizeof(DICTIONARY_STORE));
+}
+
+/**
+ * @brief Maps a word pointer back to its index in the dictionary store.
+ * Only pointers to a WORD_ENTRY's word field inside that table are recognized (not arbitrary strings).
+ * @param word Pointer to the word string.
+ * @return long The dictionary index, or -1 if the word is not a pointer into the store's dictionary.
+ */
+long get_dictionary_index(const char* word)
+{
+    if (g_dictionaryStore.pEntries == NULL) return -1;
+
+    const char* pBase = (const char*)g_dictionaryStore.pEntries;
+    if (word < pBase || word >= pBase + g_dictionaryStore.numWords * sizeof(WORD_ENTRY)) return -1;
+
+    size_t byteOffset = (size_t)(word - pBase);
+    if (byteOffset % sizeof(WORD_ENTRY) != offsetof(WORD_ENTRY, word)) return -1;
+
+    return (long)(byteOffset / sizeof(WORD_ENTRY));
+}
+
+/**
+ * @brief Returns the ID of a word pointer into the store's dictionary (see get_dictionary_index).
+ * @return WORD_ID The ID, or INVALID_WORD_ID.
+ */
+WORD_ID get_word_id(const char* word)
+{
+    long idx = get_dictionary_index(word);
+    return (idx >= 0) ? (WORD_ID)idx : INVALID_WORD_ID;
+}
+
+/**
+ * @brief Returns the text of a word ID (a pointer into the dictionary table).
+ */
+const char* get_word_text(WORD_ID id)
+{
+    return g_dictionaryStore.pEntries[id].word;
+}
+
+/**
+ * @brief Returns the feedback code for a guess/answer pair, using the precomputed matrix when possible.
+ * Falls back to computing the code directly for words outside the indexed dictionary.
+ * @param guess The word being guessed.
+ * @param answer The actual solution word.
+ * @return PATTERN_CODE The encoded result.
+ */
+PATTERN_CODE lookup_feedback_pattern_code(const char* guess, const char* answer)
+{
+    long guessIdx = get_dictionary_index(guess);
+    long answerIdx = get_dictionary_index(answer);
+
+    if (g_patternMatrix.pCodes != NULL && guessIdx >= 0 && answerIdx >= 0)
+    {
+        return g_patternMatrix.pCodes[guessIdx * g_patternMatrix.numWords + answerIdx];
+    }
+    return get_feedback_pattern_code(guess, answer);
+}
+
+// --- Packed Feedback Kernels ---
+
+/**
+ * @brief Packs words into the structure-of-arrays layout the feedback kernels read:
+ * one row of letter indices (A = 0) per position, padded to FEEDBACK_KERNEL_LANES words.
+ * @param pDictionary The dictionary table.
+ * @param numDictionary The number of words to pack.
+ * @param pPacked Output packed words (release with free_packed_words).
+ * @return bool True on success, false if memory ran out.
+ */
+bool pack_words(PWORD_ENTRY pDictionary, long numDictionary, PPACKED_WORDS pPacked)
+{
+    long numPadded = ((numDictionary + FEEDBACK_KERNEL_LANES - 1) / FEEDBACK_KERNEL_LANES) * FEEDBACK_KERNEL_LANES;
+
+    memset(pPacked, 0, sizeof(PACKED_WORDS));
+    pPacked->pStorage = (unsigned char*)calloc((size_t)WORD_SIZE * numPadded, 1);
+    if (pPacked->pStorage == NULL) return false;
+
+    pPacked->numWords = numDictionary;
+    pPacked->numPadded = numPadded;
+    for (int pos = 0; pos < WORD_SIZE; pos++)
+    {
+        pPacked->pLetters[pos] = pPacked->pStorage + (size_t)pos * numPadded;
+        for (long i = 0; i < numDictionary; i++)
+        {
+            pPacked->pLetters[pos][i] = (unsigned char)(pDictionary[i].word[pos] - 'A');
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Releases packed words.
+ */
+void free_packed_words(PPACKED_WORDS pPacked)
+{
+    if (pPacked->pStorage) free(pPacked->pStorage);
+    memset(pPacked, 0, sizeof(PACKED_WORDS));
+}
+
+/**
+ * @brief Portable feedback kernel: codes of one guess against packed answers [begin, end),
+ * with the same letter-count rules as get_feedback_pattern_code.
+ * @param guess The guess as WORD_SIZE letter indices.
+ * @param pAnswers The packed answers.
+ * @param begin First answer index.
+ * @param end One past the last answer index.
+ * @param pCodes Output: pCodes[k] is the code for answer begin + k.
+ */
+static void feedback_codes_scalar(const unsigned char* guess, const PACKED_WORDS* pAnswers, long begin, long end, PATTERN_CODE* pCodes)
+{
+    static const int powers_of_3[WORD_SIZE] = { 1, 3, 9, 27, 81 };
+
+    for (long a = begin; a < end; a++)
+    {
+        int answer_char_counts[26] = { 0 };
+        bool is_green[WORD_SIZE];
+        int code = 0;
+
+        for (int i = 0; i < WORD_SIZE; i++)
+        {
+            unsigned char letter = pAnswers->pLetters[i][a];
+            is_green[i] = (letter == guess[i]);
+            if (is_green[i]) code += 2 * powers_of_3[i];
+            else answer_char_counts[letter]++;
+        }
+
+        for (int i = 0; i < WORD_SIZE; i++)
+        {
+            if (!is_green[i] && answer_char_counts[guess[i]] > 0)
+            {
+                code += powers_of_3[i];
+                answer_char_counts[guess[i]]--;
+            }
+        }
+
+        pCodes[a - begin] = (PATTERN_CODE)code;
+    }
+}
+
+#if defined(FEEDBACK_KERNEL_X86)
+/**
+ * @brief AVX2 feedback kernel: 32 answers per step. Uses the counting form of the Wordle rules:
+ * position i is yellow when it is not green and the answer's non-green copies of guess[i]
+ * outnumber the earlier non-green guess positions holding the same letter.
+ * Only called after cpu_supports_avx2 succeeded.
+ */
+TARGET_AVX2 static void feedback_codes_avx2(const unsigned char* guess, const PACKED_WORDS* pAnswers, long begin, long end, PATTERN_CODE* pCodes)
+{
+    static const int powers_of_3[WORD_SIZE] = { 1, 3, 9, 27, 81 };
+    const __m256i allOnes = _mm256_set1_epi8(-1);
+    long a = begin;
+
+    for (; a + 32 <= end; a += 32)
+    {
+        __m256i answer[WORD_SIZE];
+        __m256i notGreen[WORD_SIZE];
+        __m256i code = _mm256_setzero_si256();
+
+        // Greens (each code digit and the total stay below 256, so byte adds never carry)
+        for (int i = 0; i < WORD_SIZE; i++)
+        {
+            answer[i] = _mm256_loadu_si256((const __m256i*)(pAnswers->pLetters[i] + a));
+            __m256i green = _mm256_cmpeq_epi8(answer[i], _mm256_set1_epi8((char)guess[i]));
+            notGreen[i] = _mm256_xor_si256(green, allOnes);
+            code = _mm256_add_epi8(code, _mm256_and_si256(green, _mm256_set1_epi8((char)(2 * powers_of_3[i]))));
+        }
+
+        // Yellows: compare masks are -1 per matching lane, so subtracting them counts
+        for (int i = 0; i < WORD_SIZE; i++)
+        {
+            __m256i letter = _mm256_set1_epi8((char)guess[i]);
+            __m256i available = _mm256_setzero_si256();
+            __m256i earlier = _mm256_setzero_si256();
+
+            for (int j = 0; j < WORD_SIZE; j++)
+            {
+                available = _mm256_sub_epi8(available, _mm256_and_si256(_mm256_cmpeq_epi8(answer[j], letter), notGreen[j]));
+                if (j < i && guess[j] == guess[i]) earlier = _mm256_sub_epi8(earlier, notGreen[j]);
+            }
+
+            __m256i yellow = _mm256_and_si256(notGreen[i], _mm256_cmpgt_epi8(available, earlier));
+            code = _mm256_add_epi8(code, _mm256_and_si256(yellow, _mm256_set1_epi8((char)powers_of_3[i])));
+        }
+
+        _mm256_storeu_si256((__m256i*)(pCodes + (a - begin)), code);
+    }
+
+    if (a < end) feedback_codes_scalar(guess, pAnswers, a, end, pCodes + (a - begin));
+}
+#endif
+
+#if defined(FEEDBACK_KERNEL_NEON)
+/**
+ * @brief NEON feedback kernel: 16 answers per step (same counting rules as feedback_codes_avx2).
+ */
+static void feedback_codes_neon(const unsigned char* guess, const PACKED_WORDS* pAnswers, long begin, long end, PATTERN_CODE* pCodes)
+{
+    static const int powers_of_3[WORD_SIZE] = { 1, 3, 9, 27, 81 };
+    long a = begin;
+
+    for (; a + 16 <= end; a += 16)
+    {
+        uint8x16_t answer[WORD_SIZE];
+        uint8x16_t notGreen[WORD_SIZE];
+        uint8x16_t code = vdupq_n_u8(0);
+
+        for (int i = 0; i < WORD_SIZE; i++)
+        {
+            answer[i] = vld1q_u8(pAnswers->pLetters[i] + a);
+            uint8x16_t green = vceqq_u8(answer[i], vdupq_n_u8(guess[i]));
+            notGreen[i] = vmvnq_u8(green);
+            code = vaddq_u8(code, vandq_u8(green, vdupq_n_u8((uint8_t)(2 * powers_of_3[i]))));
+        }
+
+        for (int i = 0; i < WORD_SIZE; i++)
+        {
+            uint8x16_t letter = vdupq_n_u8(guess[i]);
+            uint8x16_t available = vdupq_n_u8(0);
+            uint8x16_t earlier = vdupq_n_u8(0);
+
+            for (int j = 0; j < WORD_SIZE; j++)
+            {
+                available = vsubq_u8(available, vandq_u8(vceqq_u8(answer[j], letter), notGreen[j]));
+                if (j < i && guess[j] == guess[i]) earlier = vsubq_u8(earlier, notGreen[j]);
+            }
+
+            uint8x16_t yellow = vandq_u8(notGreen[i], vcgtq_u8(available, earlier));
+            code = vaddq_u8(code, vandq_u8(yellow, vdupq_n_u8((uint8_t)powers_of_3[i])));
+        }
+
+        vst1q_u8(pCodes + (a - begin), code);
+    }
+
+    if (a < end) feedback_codes_scalar(guess, pAnswers, a, end, pCodes + (a - begin));
+}
+#endif
+
+/**
+ * @brief Checks (CPU and OS support) whether AVX2 instructions can be used.
+ */
+static bool cpu_supports_avx2()
+{
+#if defined(FEEDBACK_KERNEL_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+
+    // AVX needs OSXSAVE and the OS saving the YMM state
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+    if ((_xgetbv(0) & 6) != 6) return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(FEEDBACK_KERNEL_X86)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Picks the fastest feedback kernel this CPU supports (the scalar one with --no-simd).
+ * Must be called before any worker threads use g_pFeedbackKernel.
+ */
+void select_feedback_kernel()
+{
+    g_pFeedbackKernel = feedback_codes_scalar;
+    g_pszFeedbackKernelName = "scalar";
+    if (g_options.disableSimd) return;
+
+#if defined(FEEDBACK_KERNEL_X86)
+    if (cpu_supports_avx2())
+    {
+        g_pFeedbackKernel = feedback_codes_avx2;
+        g_pszFeedbackKernelName = "AVX2";
+    }
+#elif defined(FEEDBACK_KERNEL_NEON)
+    g_pFeedbackKernel = feedback_codes_neon;
+    g_pszFeedbackKernelName = "NEON";
+#endif
+}
+
+// --- Accelerator Offload ---
+
+// OpenCL C source of the device kernels (WORD_SIZE, LETTER_BITS and NUM_PATTERNS are build options).
+// feedback_code follows feedback_code_t: greens first, then yellows left to right from the letters left over.
+static const char* g_pszAcceleratorSource =
+    "uint feedback_code(uint guess, uint answer)\n"
+    "{\n"
+    "    uchar answerCounts[1 << LETTER_BITS];\n"
+    "    uint code = 0, weight = 1, greens = 0;\n"
+    "    for (int c = 0; c < (1 << LETTER_BITS); c++) answerCounts[c] = 0;\n"
+    "    for (int i = 0; i < WORD_SIZE; i++, weight *= 3)\n"
+    "    {\n"
+    "        uint g = (guess >> (i * LETTER_BITS)) & ((1u << LETTER_BITS) - 1);\n"
+    "        uint a = (answer >> (i * LETTER_BITS)) & ((1u << LETTER_BITS) - 1);\n"
+    "        if (g == a) { code += 2 * weight; greens |= 1u << i; }\n"
+    "        else answerCounts[a]++;\n"
+    "    }\n"
+    "    weight = 1;\n"
+    "    for (int i = 0; i < WORD_SIZE; i++, weight *= 3)\n"
+    "    {\n"
+    "        uint g = (guess >> (i * LETTER_BITS)) & ((1u << LETTER_BITS) - 1);\n"
+    "        if (!(greens & (1u << i)) && answerCounts[g] > 0) { code += weight; answerCounts[g]--; }\n"
+    "    }\n"
+    "    return code;\n"
+    "}\n"
+    "\n"
+    "__kernel void pattern_matrix_rows(__global const uint* packed, uint numWords, uint firstRow, __global uchar* codes)\n"
+    "{\n"
+    "    size_t answer = get_global_id(0);\n"
+    "    size_t row = get_global_id(1);\n"
+    "    if (answer < numWords) codes[row * numWords + answer] = (uchar)feedback_code(packed[firstRow + row], packed[answer]);\n"
+    "}\n"
+    "\n"
+    "__kernel void pattern_histograms(__global const uint* packed, __global const uint* guessIds, __global const uint* answerIds, uint numAnswers, __global uint* counts)\n"
+    "{\n"
+    "    __local uint histogram[NUM_PATTERNS];\n"
+    "    size_t lid = get_local_id(0);\n"
+    "    size_t size = get_local_size(0);\n"
+    "    size_t group = get_group_id(0);\n"
+    "    for (size_t k = lid; k < NUM_PATTERNS; k += size) histogram[k] = 0;\n"
+    "    barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "    uint guess = packed[guessIds[group]];\n"
+    "    for (size_t i = lid; i < numAnswers; i += size) atomic_inc(&histogram[feedback_code(guess, packed[answerIds[i]])]);\n"
+    "    barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "    for (size_t k = lid; k < NUM_PATTERNS; k += size) counts[group * NUM_PATTERNS + k] = histogram[k];\n"
+    "}\n";
+
+// OpenCL constants used by the accelerator (values from the OpenCL 1.2 headers)
+#define CL_SUCCESS 0
+#define CL_TRUE 1
+#define CL_DEVICE_TYPE_GPU (1 << 2)
+#define CL_DEVICE_TYPE_ACCELERATOR (1 << 3)
+#define CL_MEM_WRITE_ONLY (1 << 1)
+#define CL_MEM_READ_ONLY (1 << 2)
+#define CL_MEM_COPY_HOST_PTR (1 << 5)
+#define CL_DEVICE_NAME 0x102B
+#define CL_PROGRAM_BUILD_LOG 0x1183
+
+/**
+ * @brief Loads the OpenCL runtime and resolves every entry point the accelerator calls.
+ * @return bool True if the library and all of its entry points were found.
+ */
+static bool load_accelerator_library(PACCELERATOR pAccel)
+{
+    struct { const char* pszName; void** ppfn; } entryPoints[] =
+    {
+        { "clGetPlatformIDs", (void**)&pAccel->pfnGetPlatformIDs },
+        { "clGetDeviceIDs", (void**)&pAccel->pfnGetDeviceIDs },
+        { "clGetDeviceInfo", (void**)&pAccel->pfnGetDeviceInfo },
+        { "clCreateContext", (void**)&pAccel->pfnCreateContext },
+        { "clCreateCommandQueue", (void**)&pAccel->pfnCreateCommandQueue },
+        { "clCreateProgramWithSource", (void**)&pAccel->pfnCreateProgramWithSource },
+        { "clBuildProgram", (void**)&pAccel->pfnBuildProgram },
+        { "clGetProgramBuildInfo", (void**)&pAccel->pfnGetProgramBuildInfo },
+        { "clCreateKernel", (void**)&pAccel->pfnCreateKernel },
+        { "clCreateBuffer", (void**)&pAccel->pfnCreateBuffer },
+        { "clSetKernelArg", (void**)&pAccel->pfnSetKernelArg },
+        { "clEnqueueWriteBuffer", (void**)&pAccel->pfnEnqueueWriteBuffer },
+        { "clEnqueueReadBuffer", (void**)&pAccel->pfnEnqueueReadBuffer },
+        { "clEnqueueNDRangeKernel", (void**)&pAccel->pfnEnqueueNDRangeKernel },
+        { "clReleaseMemObject", (void**)&pAccel->pfnReleaseMemObject },
+        { "clReleaseKernel", (void**)&pAccel->pfnReleaseKernel },
+        { "clReleaseProgram", (void**)&pAccel->pfnReleaseProgram },
+        { "clReleaseCommandQueue", (void**)&pAccel->pfnReleaseCommandQueue },
+        { "clReleaseContext", (void**)&pAccel->pfnReleaseContext },
+    };
+
+#ifdef _WIN32
+    pAccel->hLibrary = (void*)LoadLibraryA(ACCELERATOR_LIBRARY);
+#else
+    pAccel->hLibrary = dlopen(ACCELERATOR_LIBRARY, RTLD_NOW | RTLD_LOCAL);
+#endif
+    if (pAccel->hLibrary == NULL) return false;
+
+    for (size_t i = 0; i < sizeof(entryPoints) / sizeof(entryPoints[0]); i++)
+    {
+#ifdef _WIN32
+        *entryPoints[i].ppfn = (void*)GetProcAddress((HMODULE)pAccel->hLibrary, entryPoints[i].pszName);
+#else
+        *entryPoints[i].ppfn = dlsym(pAccel->hLibrary, entryPoints[i].pszName);
+#endif
+        if (*entryPoints[i].ppfn == NULL) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Finds the first GPU or accelerator device, builds the kernels on it and uploads the packed
+ * dictionary (the dictionary store must be built). Without a runtime or a device, or if any step
+ * fails, everything runs on the CPU engine as before.
+ * @return bool True if the device is ready.
+ */
+bool init_accelerator()
+{
+    PACCELERATOR pAccel = &g_accelerator;
+    cl_platform_id platforms[ACCELERATOR_MAX_PLATFORMS];
+    cl_uint numPlatforms = 0;
+
+    memset(pAccel, 0, sizeof(ACCELERATOR));
+    if (!load_accelerator_library(pAccel))
+    {
+        printf("No OpenCL runtime found; using the CPU engine.\n");
+        free_accelerator();
+        return false;
+    }
+
+    if (pAccel->pfnGetPlatformIDs(ACCELERATOR_MAX_PLATFORMS, platforms, &numPlatforms) != CL_SUCCESS) numPlatforms = 0;
+    for (cl_uint p = 0; p < numPlatforms && pAccel->device == NULL; p++)
+    {
+        cl_uint numDevices = 0;
+        if (pAccel->pfnGetDeviceIDs(platforms[p], CL_DEVICE_TYPE_GPU | CL_DEVICE_TYPE_ACCELERATOR, 1, &pAccel->device, &numDevices) != CL_SUCCESS || numDevices == 0)
+        {
+            pAccel->device = NULL;
+        }
+    }
+    if (pAccel->device == NULL)
+    {
+        printf("No OpenCL device found; using the CPU engine.\n");
+        free_accelerator();
+        return false;
+    }
+    pAccel->pfnGetDeviceInfo(pAccel->device, CL_DEVICE_NAME, sizeof(pAccel->szDeviceName) - 1, pAccel->szDeviceName, NULL);
+
+    cl_int status;
+    pAccel->context = pAccel->pfnCreateContext(NULL, 1, &pAccel->device, NULL, NULL, &status);
+    if (status == CL_SUCCESS) pAccel->queue = pAccel->pfnCreateCommandQueue(pAccel->context, pAccel->device, 0, &status);
+    if (status == CL_SUCCESS) pAccel->program = pAccel->pfnCreateProgramWithSource(pAccel->context, 1, &g_pszAcceleratorSource, NULL, &status);
+    if (status == CL_SUCCESS)
+    {
+        char szOptions[128];
+        snprintf(szOptions, sizeof(szOptions), "-D WORD_SIZE=%d -D LETTER_BITS=%d -D NUM_PATTERNS=%d", WORD_SIZE, LETTER_BITS, NUM_PATTERNS);
+        status = pAccel->pfnBuildProgram(pAccel->program, 1, &pAccel->device, szOptions, NULL, NULL);
+        if (status != CL_SUCCESS)
+        {
+            char szLog[2048] = "";
+            pAccel->pfnGetProgramBuildInfo(pAccel->program, pAccel->device, CL_PROGRAM_BUILD_LOG, sizeof(szLog) - 1, szLog, NULL);
+            fprintf(stderr, "OpenCL kernel build failed:\n%s\n", szLog);
+        }
+    }
+    if (status == CL_SUCCESS) pAccel->matrixKernel = pAccel->pfnCreateKernel(pAccel->program, "pattern_matrix_rows", &status);
+    if (status == CL_SUCCESS) pAccel->histogramKernel = pAccel->pfnCreateKernel(pAccel->program, "pattern_histograms", &status);
+    if (status == CL_SUCCESS)
+    {
+        pAccel->packedWords = pAccel->pfnCreateBuffer(pAccel->context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, g_dictionaryStore.numWords * sizeof(unsigned int), g_dictionaryStore.pPackedLetters, &status);
+    }
+    if (status != CL_SUCCESS)
+    {
+        fprintf(stderr, "OpenCL setup failed on %s (error %d); using the CPU engine.\n", pAccel->szDeviceName, status);
+        free_accelerator();
+        return false;
+    }
+
+    pAccel->numWords = g_dictionaryStore.numWords;
+    g_acceleratorReady = true;
+    printf("Using OpenCL device %s for the pattern matrix and large scoring passes.\n", pAccel->szDeviceName);
+    return true;
+}
+
+/**
+ * @brief Releases the device objects and unloads the runtime (no-op if nothing was loaded).
+ */
+void free_accelerator()
+{
+    PACCELERATOR pAccel = &g_accelerator;
+    g_acceleratorReady = false;
+
+    if (pAccel->packedWords) pAccel->pfnReleaseMemObject(pAccel->packedWords);
+    if (pAccel->histogramKernel) pAccel->pfnReleaseKernel(pAccel->histogramKernel);
+    if (pAccel->matrixKernel) pAccel->pfnReleaseKernel(pAccel->matrixKernel);
+    if (pAccel->program) pAccel->pfnReleaseProgram(pAccel->program);
+    if (pAccel->queue) pAccel->pfnReleaseCommandQueue(pAccel->queue);
+    if (pAccel->context) pAccel->pfnReleaseContext(pAccel->context);
+    if (pAccel->hLibrary)
+    {
+#ifdef _WIN32
+        FreeLibrary((HMODULE)pAccel->hLibrary);
+#else
+        dlclose(pAccel->hLibrary);
+#endif
+    }
+    memset(pAccel, 0, sizeof(ACCELERATOR));
+}
+
+/**
+ * @brief Reports a failed device call and sends every later pass to the CPU engine.
+ */
+static void disable_accelerator(const char* pszWhat, cl_int status)
+{
+    fprintf(stderr, "OpenCL %s failed (error %d); using the CPU engine from now on.\n", pszWhat, status);
+    g_acceleratorReady = false;
+}
+
+/**
+ * @brief Fills the pattern matrix on the device, ACCELERATOR_MATRIX_BATCH_BYTES of rows per launch.
+ * @param pCodes The host matrix (numWords x numWords codes).
+ * @param numWords The number of dictionary words (must be the dictionary store's).
+ * @return bool True if every row was computed; false leaves the matrix to the CPU engine.
+ */
+bool accelerator_build_pattern_matrix(PATTERN_CODE* pCodes, long numWords)
+{
+    PACCELERATOR pAccel = &g_accelerator;
+    std::lock_guard<std::mutex> guard(g_acceleratorLock);
+    if (!g_acceleratorReady || numWords != pAccel->numWords) return false;
+
+    long rowsPerLaunch = ACCELERATOR_MATRIX_BATCH_BYTES / numWords;
+    if (rowsPerLaunch < 1) rowsPerLaunch = 1;
+    if (rowsPerLaunch > numWords) rowsPerLaunch = numWords;
+
+    cl_int status;
+    cl_mem codes = pAccel->pfnCreateBuffer(pAccel->context, CL_MEM_WRITE_ONLY, (size_t)rowsPerLaunch * numWords * sizeof(PATTERN_CODE), NULL, &status);
+    cl_uint numWordsArg = (cl_uint)numWords;
+
+    for (long firstRow = 0; status == CL_SUCCESS && firstRow < numWords; firstRow += rowsPerLaunch)
+    {
+        long numRows = (numWords - firstRow < rowsPerLaunch) ? numWords - firstRow : rowsPerLaunch;
+        cl_uint firstRowArg = (cl_uint)firstRow;
+        size_t globalSize[2] = { (size_t)numWords, (size_t)numRows };
+
+        status = pAccel->pfnSetKernelArg(pAccel->matrixKernel, 0, sizeof(cl_mem), &pAccel->packedWords);
+        if (status == CL_SUCCESS) status = pAccel->pfnSetKernelArg(pAccel->matrixKernel, 1, sizeof(cl_uint), &numWordsArg);
+        if (status == CL_SUCCESS) status = pAccel->pfnSetKernelArg(pAccel->matrixKernel, 2, sizeof(cl_uint), &firstRowArg);
+        if (status == CL_SUCCESS) status = pAccel->pfnSetKernelArg(pAccel->matrixKernel, 3, sizeof(cl_mem), &codes);
+        if (status == CL_SUCCESS) status = pAccel->pfnEnqueueNDRangeKernel(pAccel->queue, pAccel->matrixKernel, 2, NULL, globalSize, NULL, 0, NULL, NULL);
+        if (status == CL_SUCCESS)
+        {
+            status = pAccel->pfnEnqueueReadBuffer(pAccel->queue, codes, CL_TRUE, 0, (size_t)numRows * numWords * sizeof(PATTERN_CODE),
+                pCodes + (size_t)firstRow * numWords, 0, NULL, NULL);
+        }
+    }
+    if (codes) pAccel->pfnReleaseMemObject(codes);
+
+    if (status != CL_SUCCESS)
+    {
+        disable_accelerator("pattern matrix build", status);
+        return false;
+    }
+    stats_count(STAT_PATTERN_EVALUATIONS, (long long)numWords * numWords);
+    return true;
+}
+
+/**
+ * @brief Tallies the 243-bucket pattern histogram of each guess over the answers on the device
+ * (one work-group per guess, counting into local memory).
+ * @param pGuessIds The guesses (at most ACCELERATOR_HISTOGRAM_BATCH).
+ * @param numGuesses The number of guesses.
+ * @param pAnswerIds The answers.
+ * @param numAnswers The number of answers.
+ * @param pCounts Output: NUM_PATTERNS counts per guess, in guess order.
+ * @return bool True on success; false means the caller must use the CPU engine.
+ */
+bool accelerator_tally_histograms(const WORD_ID* pGuessIds, long numGuesses, const WORD_ID* pAnswerIds, long numAnswers, unsigned int* pCounts)
+{
+    PACCELERATOR pAccel = &g_accelerator;
+    std::lock_guard<std::mutex> guard(g_acceleratorLock);
+    if (!g_acceleratorReady) return false;
+
+    cl_int status;
+    cl_mem guessIds = pAccel->pfnCreateBuffer(pAccel->context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, numGuesses * sizeof(WORD_ID), (void*)pGuessIds, &status);
+    cl_mem answerIds = NULL;
+    cl_mem counts = NULL;
+    if (status == CL_SUCCESS) answerIds = pAccel->pfnCreateBuffer(pAccel->context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, numAnswers * sizeof(WORD_ID), (void*)pAnswerIds, &status);
+    if (status == CL_SUCCESS) counts = pAccel->pfnCreateBuffer(pAccel->context, CL_MEM_WRITE_ONLY, (size_t)numGuesses * NUM_PATTERNS * sizeof(unsigned int), NULL, &status);
+
+    cl_uint numAnswersArg = (cl_uint)numAnswers;
+    size_t globalSize = (size_t)numGuesses * ACCELERATOR_WORKGROUP_SIZE;
+    size_t localSize = ACCELERATOR_WORKGROUP_SIZE;
+    if (status == CL_SUCCESS) status = pAccel->pfnSetKernelArg(pAccel->histogramKernel, 0, sizeof(cl_mem), &pAccel->packedWords);
+    if (status == CL_SUCCESS) status = pAccel->pfnSetKernelArg(pAccel->histogramKernel, 1, sizeof(cl_mem), &guessIds);
+    if (status == CL_SUCCESS) status = pAccel->pfnSetKernelArg(pAccel->histogramKernel, 2, sizeof(cl_mem), &answerIds);
+    if (status == CL_SUCCESS) status = pAccel->pfnSetKernelArg(pAccel->histogramKernel, 3, sizeof(cl_uint), &numAnswersArg);
+    if (status == CL_SUCCESS) status = pAccel->pfnSetKernelArg(pAccel->histogramKernel, 4, sizeof(cl_mem), &counts);
+    if (status == CL_SUCCESS) status = pAccel->pfnEnqueueNDRangeKernel(pAccel->queue, pAccel->histogramKernel, 1, NULL, &globalSize, &localSize, 0, NULL, NULL);
+    if (status == CL_SUCCESS) status = pAccel->pfnEnqueueReadBuffer(pAccel->queue, counts, CL_TRUE, 0, (size_t)numGuesses * NUM_PATTERNS * sizeof(unsigned int), pCounts, 0, NULL, NULL);
+
+    if (counts) pAccel->pfnReleaseMemObject(counts);
+    if (answerIds) pAccel->pfnReleaseMemObject(answerIds);
+    if (guessIds) pAccel->pfnReleaseMemObject(guessIds);
+
+    if (status != CL_SUCCESS)
+    {
+        disable_accelerator("histogram pass", status);
+        return false;
+    }
+    stats_count(STAT_PATTERN_EVALUATIONS, (long long)numGuesses * numAnswers);
+    return true;
+}
+
+// --- Pattern Matrix ---
+
+/**
+ * @brief Inputs of the parallel pattern matrix build.
+ */
+typedef struct _pattern_matrix_job
+{
+    PATTERN_CODE* pCodes;
+    const PACKED_WORDS* pPacked;
+} PATTERN_MATRIX_JOB, * PPATTERN_MATRIX_JOB;
+
+/**
+ * @brief parallel_for callback: fills the pattern matrix rows for guesses [begin, end).
+ */
+static void build_pattern_matrix_rows(long begin, long end, int, void* pContext)
+{
+    PPATTERN_MATRIX_JOB pJob = (PPATTERN_MATRIX_JOB)pContext;
+    const PACKED_WORDS* pPacked = pJob->pPacked;
+    long numWords = pPacked->numWords;
+
+    for (long guessIdx = begin; guessIdx < end; guessIdx++)
+    {
+        unsigned char guess[WORD_SIZE];
+        for (int pos = 0; pos < WORD_SIZE; pos++) guess[pos] = pPacked->pLetters[pos][guessIdx];
+
+        g_pFeedbackKernel(guess, pPacked, 0, numWords, pJob->pCodes + (size_t)guessIdx * numWords);
+    }
+    stats_count(STAT_PATTERN_EVALUATIONS, (long long)(end - begin) * numWords);
+}
+
+/**
+ * @brief Precomputes the feedback code of every dictionary word against every dictionary word.
+ * This is done once at startup so that every later entropy calculation is a table lookup.
+ * Each row is one feedback kernel call over the packed dictionary.
+ * @param pDictionary The sorted dictionary table (must stay allocated while the matrix is in use).
+ * @param numDictionary The number of entries in the dictionary.
+ * @return bool True if the matrix was built, false if the dictionary is too large or memory ran out.
+ */
+bool build_pattern_matrix(PWORD_ENTRY pDictionary, long numDictionary)
+{
+    PACKED_WORDS packed;
+
+    free_pattern_matrix();
+
+    if (numDictionary <= 0 || numDictionary > MAX_PATTERN_MATRIX_WORDS)
+    {
+        fprintf(stderr, "Dictionary too large for the pattern matrix (%ld words); computing patterns on demand.\n", numDictionary);
+        return false;
+    }
+
+    PATTERN_CODE* pCodes = (PATTERN_CODE*)malloc((size_t)numDictionary * numDictionary * sizeof(PATTERN_CODE));
+    if (pCodes == NULL || !pack_words(pDictionary, numDictionary, &packed))
+    {
+        fprintf(stderr, "Out of memory allocating pattern matrix; computing patterns on demand.\n");
+        if (pCodes) free(pCodes);
+        return false;
+    }
+
+    if (g_pFeedbackKernel == NULL) select_feedback_kernel();
+
+    // The device fills the matrix from the packed dictionary store when it is ready; otherwise
+    // rows are independent, so they are filled in parallel
+    const char* pszKernelName = g_pszFeedbackKernelName;
+    if (pDictionary == g_dictionaryStore.pEntries && accelerator_build_pattern_matrix(pCodes, numDictionary))
+    {
+        pszKernelName = "OpenCL";
+    }
+    else
+    {
+        PATTERN_MATRIX_JOB job = { pCodes, &packed };
+        parallel_for(numDictionary, PATTERN_MATRIX_CHUNK_SIZE, build_pattern_matrix_rows, &job);
+    }
+    free_packed_words(&packed);
+
+    g_patternMatrix.pCodes = pCodes;
+    g_patternMatrix.pDictionary = pDictionary;
+    g_patternMatrix.numWords = numDictionary;
+
+    printf("Precomputed %ld x %ld feedback pattern matrix (%s kernel).\n", numDictionary, numDictionary, pszKernelName);
+    return true;
+}
+
+/**
+ * @brief Cross-checks a deterministic sample of the pattern matrix against get_feedback_pattern,
+ * which remains the reference implementation of the Wordle feedback rules.
+ * @param numSamples The number of (guess, answer) pairs to check.
+ * @return long The number of mismatching pairs (0 when the matrix agrees with the reference).
+ */
+long verify_pattern_matrix(long numSamples)
+{
+    long numWords = g_patternMatrix.numWords;
+    long mismatches = 0;
+    char reference[WORD_SIZE + 1];
+    char decoded[WORD_SIZE + 1];
+
+    if (g_patternMatrix.pCodes == NULL || numWords == 0) return 0;
+
+    // Walk the matrix with a large odd stride so the sample covers many rows and columns
+    unsigned long long totalPairs = (unsigned long long)numWords * numWords;
+    unsigned long long pairIdx = 0;
+    for (long i = 0; i < numSamples; i++)
+    {
+        long guessIdx = (long)(pairIdx / numWords);
+        long answerIdx = (long)(pairIdx % numWords);
+        const char* guess = g_patternMatrix.pDictionary[guessIdx].word;
+        const char* answer = g_patternMatrix.pDictionary[answerIdx].word;
+
+        get_feedback_pattern(guess, answer, reference);
+        decode_feedback_pattern(g_patternMatrix.pCodes[pairIdx], decoded);
+
+        if (strcmp(reference, decoded) != 0)
+        {
+            printfDebug("Pattern matrix mismatch: %s vs %s -> %s (expected %s)\n", guess, answer, decoded, reference);
+            mismatches++;
+        }
+        pairIdx = (pairIdx + 7919ULL * 104729ULL) % totalPairs;
+    }
+
+    return mismatches;
+}
+
+/**
+ * @brief Releases the pattern matrix. Lookups fall back to on-demand computation afterwards.
+ */
+void free_pattern_matrix()
+{
+    if (g_patternMatrix.pCodes && !g_patternMatrix.isMapped) free(g_patternMatrix.pCodes);
+    g_patternMatrix.pCodes = NULL;
+    g_patternMatrix.isMapped = false;
+    g_patternMatrix.pDictionary = NULL;
+    g_patternMatrix.numWords = 0;
+}
+
+/**
+ * @brief Precomputes count * log2(count) for every bucket count from 0 to maxCount.
+ * This turns the per-pattern log() of the entropy sum into a table lookup.
+ * @param maxCount The largest count that can occur (the number of dictionary words).
+ * @return bool True on success, false on memory allocation failure.
+ */
+bool build_count_log2_table(long maxCount)
+{
+    free_count_log2_table();
+
+    g_pCountLog2Table = (double*)malloc((maxCount + 1) * sizeof(double));
+    if (g_pCountLog2Table == NULL)
+    {
+        fprintf(stderr, "Out of memory allocating count*log2(count) table; using log() directly.\n");
+        return false;
+    }
+
+    g_pCountLog2Table[0] = 0.0;
+    for (long count = 1; count <= maxCount; count++)
+    {
+        g_pCountLog2Table[count] = count * log2((double)count);
+    }
+    g_countLog2TableSize = maxCount + 1;
+    return true;
+}
+
+/**
+ * @brief Releases the count * log2(count) table.
+ */
+void free_count_log2_table()
+{
+    if (g_pCountLog2Table) free(g_pCountLog2Table);
+    g_pCountLog2Table = NULL;
+    g_countLog2TableSize = 0;
+}
+
+/**
+ * @brief Returns count * log2(count), from the precomputed table when it covers the count.
+ */
+static inline double count_times_log2(long count)
+{
+    if (count < g_countLog2TableSize) return g_pCountLog2Table[count];
+    return (count > 0) ? count * log2((double)count) : 0.0;
+}
+
+/**
+ * @brief The letter indices of a variant word record of L letters (they follow the word's NUL).
+ */
+template <int L>
+static inline const unsigned char* word_letters_t(const char* word)
+{
+    return (const unsigned char*)word + L + 1;
+}
+
+/**
+ * @brief Feedback pattern code of a guess/answer pair of variant word records (see feedback_code_t).
+ */
+template <int L, int A>
+static int word_feedback_code_t(const char* guess, const char* answer)
+{
+    return feedback_code_t<L, A>(word_letters_t<L>(guess), word_letters_t<L>(answer));
+}
+
+/**
+ * @brief Shannon entropy of a guess over variant word records of L letter indices below A, summed like
+ * calculate_entropy_score_ids. The pattern buckets are a pattern_count(L) array on the stack.
+ */
+template <int L, int A>
+static double entropy_t(const char* guess, const char* const* ppAnswers, long numAnswers)
+{
+    long patternCounts[pattern_count(L)] = { 0 };
+    const unsigned char* guessLetters = word_letters_t<L>(guess);
+
+    if (numAnswers <= 1) return 0.0;
+
+    for (long i = 0; i < numAnswers; i++)
+    {
+        patternCounts[feedback_code_t<L, A>(guessLetters, word_letters_t<L>(ppAnswers[i]))]++;
+    }
+    stats_count(STAT_PATTERN_EVALUATIONS, numAnswers);
+
+    double sumCountLog2 = 0.0;
+    for (int k = 0; k < pattern_count(L); k++)
+    {
+        sumCountLog2 += count_times_log2(patternCounts[k]);
+    }
+    return log2((double)numAnswers) - sumCountLog2 / numAnswers;
+}
+
+/**
+ * @brief Keeps the words (variant records of L letter indices below A) that give exactly the feedback code
+ * for the guess, compacting the pointer array in place with the order preserved.
+ * @return long The number of words kept.
+ */
+template <int L, int A>
+static long filter_by_pattern_t(const char* guess, int code, const char** ppWords, long numWords)
+{
+    const unsigned char* guessLetters = word_letters_t<L>(guess);
+    long numKept = 0;
+    for (long i = 0; i < numWords; i++)
+    {
+        if (feedback_code_t<L, A>(guessLetters, word_letters_t<L>(ppWords[i])) == code) ppWords[numKept++] = ppWords[i];
+    }
+    return numKept;
+}
+
+#define WORD_KERNELS_ENTRY(L, A) { L, A, pattern_count(L), word_feedback_code_t<L, A>, entropy_t<L, A>, filter_by_pattern_t<L, A> }
+
+// Every compiled instantiation, by word length, then alphabet size ascending.
+static const WORD_KERNELS g_wordKernels[] =
+{
+    WORD_KERNELS_ENTRY(4, ALPHABET_SIZE), WORD_KERNELS_ENTRY(4, VARIANT_MAX_ALPHABET),
+    WORD_KERNELS_ENTRY(5, ALPHABET_SIZE), WORD_KERNELS_ENTRY(5, VARIANT_MAX_ALPHABET),
+    WORD_KERNELS_ENTRY(6, ALPHABET_SIZE), WORD_KERNELS_ENTRY(6, VARIANT_MAX_ALPHABET),
+    WORD_KERNELS_ENTRY(7, ALPHABET_SIZE), WORD_KERNELS_ENTRY(7, VARIANT_MAX_ALPHABET),
+};
+
+/**
+ * @brief Picks the kernels compiled for a word length and the smallest compiled alphabet that holds
+ * alphabetSize letters, as read from a dictionary header.
+ * @param wordLength Letters per word (VARIANT_MIN_WORD_SIZE..VARIANT_MAX_WORD_SIZE).
+ * @param alphabetSize Distinct letters (1..VARIANT_MAX_ALPHABET).
+ * @return const WORD_KERNELS* The instantiation, or NULL if none was compiled for it.
+ */
+const WORD_KERNELS* select_word_kernels(int wordLength, int alphabetSize)
+{
+    if (alphabetSize < 1) return NULL;
+    for (size_t i = 0; i < sizeof(g_wordKernels) / sizeof(g_wordKernels[0]); i++)
+    {
+        if (g_wordKernels[i].wordLength == wordLength && alphabetSize <= g_wordKernels[i].alphabetSize) return g_wordKernels + i;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Calculates the Shannon Entropy score for a word against the possible answers.
+ * Pattern counts are tallied in a fixed array of NUM_PATTERNS buckets indexed by pattern code,
+ * so the calculation performs no heap allocations.
+ * @param guess The word to calculate entropy for.
+ * @param possibleAnswers Array of remaining possible answer words.
+ * @param numPossibleAnswers The number of words in the array.
+ * @return double The calculated entropy score (H).
+ */
+double calculate_entropy_score(const char* guess, const char** possibleAnswers, long numPossibleAnswers)
+{
+    long patternCounts[NUM_PATTERNS] = { 0 };
+
+    if (numPossibleAnswers <= 1) return 0.0;
+
+    // 1. Tally the frequency of each possible result pattern (matrix row lookups when precomputed)
+    long guessIdx = get_dictionary_index(guess);
+    const PATTERN_CODE* pRow = (guessIdx >= 0 && g_patternMatrix.pCodes != NULL) ? g_patternMatrix.pCodes + (size_t)guessIdx * g_patternMatrix.numWords : NULL;
+
+    for (long i = 0; i < numPossibleAnswers; i++)
+    {
+        const char* answer = possibleAnswers[i];
+        long answerIdx = (pRow != NULL) ? get_dictionary_index(answer) : -1;
+
+        PATTERN_CODE code = (answerIdx >= 0) ? pRow[answerIdx] : get_feedback_pattern_code(guess, answer);
+        patternCounts[code]++;
+    }
+    stats_count(STAT_PATTERN_EVALUATIONS, numPossibleAnswers);
+
+    // 2. Calculate Shannon Entropy H
+    // H = sum(P_k * log2(N / count_k)) = log2(N) - (1/N) * sum(count_k * log2(count_k))
+    double sumCountLog2 = 0.0;
+    for (int k = 0; k < NUM_PATTERNS; k++)
+    {
+        sumCountLog2 += count_times_log2(patternCounts[k]);
+    }
+
+    return log2((double)numPossibleAnswers) - sumCountLog2 / numPossibleAnswers;
+}
+
+/**
+ * @brief Adds the feedback patterns of one guess against a list of answer IDs to a histogram
+ * (one matrix row read per guess, or the packed kernel when there is no matrix).
+ */
+static inline void tally_pattern_counts_ids(WORD_ID guessId, const WORD_ID* pAnswerIds, long numAnswers, long* pPatternCounts)
+{
+    if (g_patternMatrix.pCodes != NULL)
+    {
+        const PATTERN_CODE* pRow = g_patternMatrix.pCodes + (size_t)guessId * g_patternMatrix.numWords;
+        for (long i = 0; i < numAnswers; i++)
+        {
+            pPatternCounts[pRow[pAnswerIds[i]]]++;
+        }
+    }
+    else
+    {
+        const unsigned int* pPacked = g_dictionaryStore.pPackedLetters;
+        unsigned int packedGuess = pPacked[guessId];
+        for (long i = 0; i < numAnswers; i++)
+        {
+            pPatternCounts[get_feedback_pattern_code_packed(packedGuess, pPacked[pAnswerIds[i]])]++;
+        }
+    }
+    stats_count(STAT_PATTERN_EVALUATIONS, numAnswers);
+}
+
+/**
+ * @brief Calculates the Shannon Entropy score like calculate_entropy_score, for a guess and answers
+ * given as word IDs (one matrix row read per guess, no pointer lookups in the answer loop).
+ * @param guessId The word to calculate entropy for.
+ * @param pAnswerIds IDs of the remaining possible answers.
+ * @param numPossibleAnswers The number of IDs.
+ * @return double The calculated entropy score (H).
+ */
+double calculate_entropy_score_ids(WORD_ID guessId, const WORD_ID* pAnswerIds, long numPossibleAnswers)
+{
+    long patternCounts[NUM_PATTERNS] = { 0 };
+
+    if (numPossibleAnswers <= 1) return 0.0;
+
+    tally_pattern_counts_ids(guessId, pAnswerIds, numPossibleAnswers, patternCounts);
+
+    double sumCountLog2 = 0.0;
+    for (int k = 0; k < NUM_PATTERNS; k++)
+    {
+        sumCountLog2 += count_times_log2(patternCounts[k]);
+    }
+
+    return log2((double)numPossibleAnswers) - sumCountLog2 / numPossibleAnswers;
+}
+
+/**
+ * @brief Calculates the Shannon Entropy score like calculate_entropy_score, but gives up as soon as
+ * the guess provably cannot reach the threshold.
+ * While tallying, two upper bounds on the final entropy are tracked:
+ * - log2(N) - S/N, where S = sum(count_k * log2(count_k)) so far (S only grows as answers are added), and
+ * - log2 of the most distinct patterns still reachable (seen so far plus answers left, at most NUM_PATTERNS).
+ * @param guessId The word to calculate entropy for.
+ * @param pAnswerIds IDs of the remaining possible answers.
+ * @param numPossibleAnswers The number of IDs.
+ * @param threshold The entropy the guess must reach to be of interest.
+ * @param pPruned Output: true if the tally stopped early (the returned H is then only an upper bound).
+ * @return double The exact entropy score (H), or an upper bound below the threshold if pruned.
+ */
+double calculate_entropy_score_bounded(WORD_ID guessId, const WORD_ID* pAnswerIds, long numPossibleAnswers, double threshold, bool* pPruned)
+{
+    long patternCounts[NUM_PATTERNS] = { 0 };
+    double sumCountLog2 = 0.0;
+    long numDistinct = 0;
+
+    *pPruned = false;
+    if (numPossibleAnswers <= 1) return 0.0;
+
+    const double log2N = log2((double)numPossibleAnswers);
+    const PATTERN_CODE* pRow = (g_patternMatrix.pCodes != NULL) ? g_patternMatrix.pCodes + (size_t)guessId * g_patternMatrix.numWords : NULL;
+    const unsigned int* pPacked = g_dictionaryStore.pPackedLetters;
+
+    for (long i = 0; i < numPossibleAnswers; i++)
+    {
+        WORD_ID answerId = pAnswerIds[i];
+        PATTERN_CODE code = (pRow != NULL) ? pRow[answerId] : get_feedback_pattern_code_packed(pPacked[guessId], pPacked[answerId]);
+        long count = patternCounts[code]++;
+        if (count == 0) numDistinct++;
+        sumCountLog2 += count_times_log2(count + 1) - count_times_log2(count);
+
+        if ((i % PRUNE_CHECK_INTERVAL) == PRUNE_CHECK_INTERVAL - 1)
+        {
+            long maxDistinct = numDistinct + (numPossibleAnswers - i - 1);
+            if (maxDistinct > NUM_PATTERNS) maxDistinct = NUM_PATTERNS;
+
+            double bound = log2N - sumCountLog2 / numPossibleAnswers;
+            double distinctBound = log2((double)maxDistinct);
+            if (distinctBound < bound) bound = distinctBound;
+
+            if (bound < threshold - EPSILON)
+            {
+                stats_count(STAT_PATTERN_EVALUATIONS, i + 1);
+                *pPruned = true;
+                return bound;
+            }
+        }
+    }
+    stats_count(STAT_PATTERN_EVALUATIONS, numPossibleAnswers);
+
+    // Recompute the sum from the buckets so the result is bit-identical to calculate_entropy_score_ids
+    sumCountLog2 = 0.0;
+    for (int k = 0; k < NUM_PATTERNS; k++)
+    {
+        sumCountLog2 += count_times_log2(patternCounts[k]);
+    }
+
+    return log2N - sumCountLog2 / numPossibleAnswers;
+}
+
+// --- Incremental Pattern Histograms ---
+
+/**
+ * @brief Creates an empty histogram set for one game (no memory is allocated until first use).
+ */
+void init_pattern_histograms(PPATTERN_HISTOGRAMS pHistograms)
+{
+    memset(pHistograms, 0, sizeof(PATTERN_HISTOGRAMS));
+}
+
+/**
+ * @brief Releases a histogram set.
+ */
+void free_pattern_histograms(PPATTERN_HISTOGRAMS pHistograms)
+{
+    free(pHistograms->pCounts);
+    free(pHistograms->pRowOfWord);
+    free(pHistograms->pRowWords);
+    free(pHistograms->pAnswerIds);
+    free(pHistograms->pRemovedIds);
+    free(pHistograms->pInAnswers);
+    init_pattern_histograms(pHistograms);
+}
+
+/**
+ * @brief Allocates the per-word arrays the first time a histogram set is used.
+ */
+static bool allocate_pattern_histograms(PPATTERN_HISTOGRAMS pHistograms, long numWords)
+{
+    if (pHistograms->numWords == numWords) return true;
+
+    free_pattern_histograms(pHistograms);
+    pHistograms->pRowOfWord = (long*)malloc(numWords * sizeof(long));
+    pHistograms->pRowWords = (WORD_ID*)malloc(numWords * sizeof(WORD_ID));
+    pHistograms->pAnswerIds = (WORD_ID*)malloc(numWords * sizeof(WORD_ID));
+    pHistograms->pRemovedIds = (WORD_ID*)malloc(numWords * sizeof(WORD_ID));
+    pHistograms->pInAnswers = (unsigned char*)calloc(numWords, 1);
+
+    if (!pHistograms->pRowOfWord || !pHistograms->pRowWords || !pHistograms->pAnswerIds || !pHistograms->pRemovedIds || !pHistograms->pInAnswers)
+    {
+        free_pattern_histograms(pHistograms);
+        return false;
+    }
+    for (long i = 0; i < numWords; i++) pHistograms->pRowOfWord[i] = -1;
+    pHistograms->numWords = numWords;
+    return true;
+}
+
+/**
+ * @brief Returns the feedback pattern of a guess/answer pair by word ID (matrix or packed kernel).
+ */
+static inline PATTERN_CODE get_feedback_pattern_code_ids(WORD_ID guessId, WORD_ID answerId)
+{
+    if (g_patternMatrix.pCodes != NULL) return g_patternMatrix.pCodes[(size_t)guessId * g_patternMatrix.numWords + answerId];
+    return get_feedback_pattern_code_packed(g_dictionaryStore.pPackedLetters[guessId], g_dictionaryStore.pPackedLetters[answerId]);
+}
+
+/**
+ * @brief Inputs of one histogram update pass: rows [begin, end) of pRowWords are either rebuilt from
+ * pIds (bRebuild) or have the answers in pIds taken out of their buckets.
+ */
+typedef struct _histogram_job
+{
+    PPATTERN_HISTOGRAMS pHistograms;
+    const WORD_ID* pIds;
+    long numIds;
+    bool bRebuild;
+} HISTOGRAM_JOB, * PHISTOGRAM_JOB;
+
+/**
+ * @brief parallel_for callback: updates histogram rows [begin, end). Each row belongs to one guess,
+ * so workers never write the same buckets.
+ */
+static void update_histogram_rows(long begin, long end, int, void* pContext)
+{
+    PHISTOGRAM_JOB pJob = (PHISTOGRAM_JOB)pContext;
+    PPATTERN_HISTOGRAMS pHistograms = pJob->pHistograms;
+
+    for (long r = begin; r < end; r++)
+    {
+        WORD_ID guessId = pHistograms->pRowWords[r];
+        unsigned short* pRow = pHistograms->pCounts + (size_t)r * PATTERN_HISTOGRAM_ROW_SIZE;
+
+        if (pJob->bRebuild)
+        {
+            memset(pRow, 0, PATTERN_HISTOGRAM_ROW_SIZE * sizeof(unsigned short));
+            for (long i = 0; i < pJob->numIds; i++) pRow[get_feedback_pattern_code_ids(guessId, pJob->pIds[i])]++;
+        }
+        else
+        {
+            for (long i = 0; i < pJob->numIds; i++) pRow[get_feedback_pattern_code_ids(guessId, pJob->pIds[i])]--;
+        }
+    }
+    stats_count(STAT_PATTERN_EVALUATIONS, (long long)(end - begin) * pJob->numIds);
+}
+
+/**
+ * @brief Brings a game's histograms up to date with its current answer set.
+ * If the answers are a subset of the set the histograms describe and every guess already has a row,
+ * only the removed answers are taken out of the buckets. Otherwise, or when more answers were removed
+ * than remain (rebuilding is then cheaper), the rows are rebuilt for exactly pGuessIds.
+ * @param pHistograms The game's histograms.
+ * @param pAnswerIds The current possible answers (no duplicates).
+ * @param numAnswers The number of answers (at most PATTERN_HISTOGRAM_MAX_COUNT).
+ * @param pGuessIds The guesses that will be scored.
+ * @param numGuesses The number of guesses.
+ * @return bool True if the histograms are usable, false on memory allocation failure.
+ */
+bool sync_pattern_histograms(PPATTERN_HISTOGRAMS pHistograms, const WORD_ID* pAnswerIds, long numAnswers, const WORD_ID* pGuessIds, long numGuesses)
+{
+    if (numAnswers > PATTERN_HISTOGRAM_MAX_COUNT) return false;
+    if (!allocate_pattern_histograms(pHistograms, g_dictionaryStore.numWords)) return false;
+
+    // Incremental only if the new answers are all tracked and every guess has a row
+    bool canUpdate = pHistograms->isValid;
+    for (long i = 0; canUpdate && i < numGuesses; i++)
+    {
+        if (pHistograms->pRowOfWord[pGuessIds[i]] < 0) canUpdate = false;
+    }
+    for (long i = 0; canUpdate && i < numAnswers; i++)
+    {
+        if (pHistograms->pInAnswers[pAnswerIds[i]] != 1) canUpdate = false;
+        else pHistograms->pInAnswers[pAnswerIds[i]] = 2; // Still an answer
+    }
+
+    long numRemoved = 0;
+    for (long i = 0; i < pHistograms->numAnswers; i++)
+    {
+        WORD_ID id = pHistograms->pAnswerIds[i];
+        if (pHistograms->pInAnswers[id] != 2) pHistograms->pRemovedIds[numRemoved++] = id;
+        pHistograms->pInAnswers[id] = 0;
+    }
+    for (long i = 0; i < numAnswers; i++) pHistograms->pInAnswers[pAnswerIds[i]] = 0;
+    if (numRemoved > numAnswers) canUpdate = false;
+
+    HISTOGRAM_JOB job;
+    job.pHistograms = pHistograms;
+
+    if (canUpdate)
+    {
+        job.pIds = pHistograms->pRemovedIds;
+        job.numIds = numRemoved;
+        job.bRebuild = false;
+        pHistograms->numUpdates++;
+    }
+    else
+    {
+        if (numGuesses > pHistograms->rowCapacity)
+        {
+            unsigned short* pCounts = (unsigned short*)realloc(pHistograms->pCounts, (size_t)numGuesses * PATTERN_HISTOGRAM_ROW_SIZE * sizeof(unsigned short));
+            stats_count(STAT_ALLOCATIONS, 1);
+            if (pCounts == NULL)
+            {
+                pHistograms->isValid = false;
+                return false;
+            }
+            pHistograms->pCounts = pCounts;
+            pHistograms->rowCapacity = numGuesses;
+        }
+
+        for (long r = 0; r < pHistograms->numRows; r++) pHistograms->pRowOfWord[pHistograms->pRowWords[r]] = -1;
+        for (long r = 0; r < numGuesses; r++)
+        {
+            pHistograms->pRowWords[r] = pGuessIds[r];
+            pHistograms->pRowOfWord[pGuessIds[r]] = r;
+        }
+        pHistograms->numRows = numGuesses;
+
+        job.pIds = pAnswerIds;
+        job.numIds = numAnswers;
+        job.bRebuild = true;
+        pHistograms->numRebuilds++;
+    }
+
+    parallel_for(pHistograms->numRows, METRICS_CHUNK_SIZE, update_histogram_rows, &job);
+
+    memcpy(pHistograms->pAnswerIds, pAnswerIds, numAnswers * sizeof(WORD_ID));
+    pHistograms->numAnswers = numAnswers;
+    for (long i = 0; i < numAnswers; i++) pHistograms->pInAnswers[pAnswerIds[i]] = 1;
+    pHistograms->isValid = true;
+    return true;
+}
+
+/**
+ * @brief Calculates a guess's entropy from its histogram row. The buckets are summed in pattern order,
+ * so the result is bit-identical to calculate_entropy_score_ids.
+ * @param pHistograms Histograms synced to the current answers; guessId must have a row.
+ * @param guessId The guess.
+ * @return double The entropy score (H).
+ */
+double get_histogram_entropy(const PATTERN_HISTOGRAMS* pHistograms, WORD_ID guessId)
+{
+    long numAnswers = pHistograms->numAnswers;
+    if (numAnswers <= 1) return 0.0;
+
+    const unsigned short* pRow = pHistograms->pCounts + (size_t)pHistograms->pRowOfWord[guessId] * PATTERN_HISTOGRAM_ROW_SIZE;
+    double sumCountLog2 = 0.0;
+    for (int k = 0; k < NUM_PATTERNS; k++)
+    {
+        sumCountLog2 += count_times_log2(pRow[k]);
+    }
+
+    return log2((double)numAnswers) - sumCountLog2 / numAnswers;
+}
+
+/**
+ * @brief Calculates a guess's entropy from its histogram row like get_histogram_entropy, but gives up
+ * as soon as the guess provably cannot reach the threshold. The bounds are those of
+ * calculate_entropy_score_bounded, taken over the buckets scanned so far instead of the answers tallied.
+ * @param pHistograms Histograms synced to the current answers; guessId must have a row.
+ * @param guessId The guess.
+ * @param threshold The entropy the guess must reach to be of interest.
+ * @param pPruned Output: true if the scan stopped early (the returned H is then only an upper bound).
+ * @return double The exact entropy score (H), or an upper bound below the threshold if pruned.
+ */
+double get_histogram_entropy_bounded(const PATTERN_HISTOGRAMS* pHistograms, WORD_ID guessId, double threshold, bool* pPruned)
+{
+    long numAnswers = pHistograms->numAnswers;
+
+    *pPruned = false;
+    if (numAnswers <= 1) return 0.0;
+
+    const double log2N = log2((double)numAnswers);
+    const unsigned short* pRow = pHistograms->pCounts + (size_t)pHistograms->pRowOfWord[guessId] * PATTERN_HISTOGRAM_ROW_SIZE;
+    double sumCountLog2 = 0.0;
+    long numSeen = 0;
+    long numDistinct = 0;
+    for (int k = 0; k < NUM_PATTERNS; k++)
+    {
+        if (pRow[k] != 0)
+        {
+            numSeen += pRow[k];
+            numDistinct++;
+        }
+        sumCountLog2 += count_times_log2(pRow[k]);
+
+        if ((k % PRUNE_CHECK_INTERVAL) == PRUNE_CHECK_INTERVAL - 1)
+        {
+            long maxDistinct = numDistinct + (numAnswers - numSeen);
+            if (maxDistinct > numDistinct + (NUM_PATTERNS - k - 1)) maxDistinct = numDistinct + (NUM_PATTERNS - k - 1);
+
+            double bound = log2N - sumCountLog2 / numAnswers;
+            double distinctBound = (maxDistinct > 0) ? log2((double)maxDistinct) : 0.0;
+            if (distinctBound < bound) bound = distinctBound;
+
+            if (bound < threshold - EPSILON)
+            {
+                *pPruned = true;
+                return bound;
+            }
+        }
+    }
+
+    return log2N - sumCountLog2 / numAnswers;
+}
+
+/**
+ * @brief Builds the letter-count masks of a word or of a required-letter string.
+ * @param pLetters Upper-case letters (at most WORD_SIZE are counted per letter).
+ * @param numLetters The number of letters.
+ * @param pCounts Output masks.
+ */
+void count_letters(const char* pLetters, int numLetters, PLETTER_COUNTS pCounts)
+{
+    memset(pCounts, 0, sizeof(LETTER_COUNTS));
+    for (int i = 0; i < numLetters; i++)
+    {
+        unsigned int bit = 1u << (pLetters[i] - 'A');
+        int k = 0;
+        while (k < WORD_SIZE && (pCounts->atLeast[k] & bit) != 0) k++;
+        if (k < WORD_SIZE) pCounts->atLeast[k] |= bit;
+    }
+}
+
+/**
+ * @brief The repeat-risk rule on letter-count masks: a guess is risky if it repeats a letter more
+ * times than the board requires. A letter with c > 1 copies is safe only if at least c are
+ * required, so the guess is risky exactly when atLeast[k] (k >= 1) has a letter the requirement lacks.
+ */
+static inline bool has_unconfirmed_repeat(const LETTER_COUNTS* pGuess, const LETTER_COUNTS* pRequired)
+{
+    unsigned int unconfirmed = 0;
+    for (int k = 1; k < WORD_SIZE; k++) unconfirmed |= pGuess->atLeast[k] & ~pRequired->atLeast[k];
+    return unconfirmed != 0;
+}
+
+/**
+ * @brief Checks if a guess word contains a repeated letter that is NOT guaranteed by current constraints.
+ * This guards against "risky" guesses (e.g., guessing 'DADDY' when D isn't confirmed as a double).
+ * @param guess The word to check.
+ * @param pGood The string of required letters (yellow or green).
+ * @return true if the word has unconfirmed repeat letters, false otherwise.
+ */
+bool is_guess_word_risky(const char* guess, char* pGood)
+{
+    LETTER_COUNTS guessCounts;
+    LETTER_COUNTS requiredCounts;
+    count_letters(guess, WORD_SIZE, &guessCounts);
+    count_letters(pGood, (int)strlen(pGood), &requiredCounts);
+    return has_unconfirmed_repeat(&guessCounts, &requiredCounts);
+}
+
+
+// --- Refactored Functions Start Here ---
+
+/**
+ * @brief Performs the constraint update logic for a single guess.
+ * Calculates confirmed counts and updates the mask, required letters (pGood),
+ * excluded letters (pBad), and positional exclusions (notMask).
+ * @param guess The 5-letter word guessed by the user.
+ * @param result_pattern The 5-char feedback (B, G, Y) from Wordle.
+ * @param pMask The green letter mask.
+ * @param notMask Positional exclusions array.
+ * @param pGood String of required letters (min count constraint).
+ * @param pBad String of letters that must be absent.
+ * @param tryIdx The current turn number.
+ */
+void update_game_constraints(const char* guess, const char* result_pattern, char* pMask, char notMask[6][5], char* pGood, char* pBad, int tryIdx)
+{
+    // 1. Calculate confirmed minimum counts for required letters (Yellow/Green)
+    int confirmed_counts[26] = { 0 };
+    for (int idx = 0; idx < WORD_SIZE; idx++)
+    {
+        char current_char = toupper((unsigned char)guess[idx]);
+        if (result_pattern[idx] == 'G' || result_pattern[idx] == 'Y')
+        {
+            confirmed_counts[current_char - 'A']++;
+        }
+    }
+
+    // 2. Apply updates based on result pattern position by position
+    for (int idx = 0; idx < WORD_SIZE; idx++)
+    {
+        char current_char = toupper((unsigned char)guess[idx]);
+
+        // Find how many of this char are already marked as required
+        int current_required_count = 0;
+        for (size_t k = 0; k < strlen(pGood); k++)
+        {
+            if (pGood[k] == current_char) current_required_count++;
+        }
+
+        size_t len_good = strlen(pGood);
+        size_t len_bad = strlen(pBad);
+
+        if (result_pattern[idx] == 'G')
+        {
+            pMask[idx] = current_char;
+            // Update required letters (pGood) if we found a new, necessary instance
+            if (current_required_count < confirmed_counts[current_char - 'A'])
+            {
+                pGood[len_good] = current_char;
+                pGood[len_good + 1] = '\0';
+            }
+        }
+        else if (result_pattern[idx] == 'Y')
+        {
+            notMask[tryIdx - 1][idx] = current_char;
+            // Update required letters (pGood)
+            if (current_required_count < confirmed_counts[current_char - 'A'])
+            {
+                pGood[len_good] = current_char;
+                pGood[len_good + 1] = '\0';
+            }
+        }
+        else if (result_pattern[idx] == 'B')
+        {
+            notMask[tryIdx - 1][idx] = current_char;
+
+            // Only blacklist the letter (pBad) if it is NOT a required letter (count is 0)
+            if (current_required_count == 0)
+            {
+                if (strchr(pBad, current_char) == NULL)
+                {
+                    pBad[len_bad] = current_char;
+                    pBad[len_bad + 1] = '\0';
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Shared, read-only inputs of one calculate_all_metrics call, handed to each worker.
+ * pGuessIds/pMetricsTable are the guesses being scored in this pass (the possible answers, or the
+ * extra dictionary words in full-dictionary mode); pAnswerIds is always the answer set.
+ */
+typedef struct _metrics_job
+{
+    const WORD_ID* pAnswerIds;
+    long numPossibleAnswers;
+    const WORD_ID* pGuessIds;
+    LETTER_COUNTS requiredCounts; // pGood as letter counts, for the repeat-risk check
+    PGUESS_METRICS pMetricsTable;
+    long numWordsInDictionary;
+    struct _prune_threshold* pThresholds; // Per-worker pruning state (full-dictionary pass only)
+    const PATTERN_HISTOGRAMS* pHistograms; // Synced histograms to read entropies from, or NULL to tally
+    double totalWeight;                    // Prior mass of the answers (--weighted only)
+} METRICS_JOB, * PMETRICS_JOB;
+
+/**
+ * @brief Per-worker pruning state for the full-dictionary pass: the best exact entropies seen so far.
+ * A guess that cannot beat both the K-th best overall (K = MAX_TOP_PICKS, the table size) and the
+ * second best linguistically clean word (the picks) can never be displayed or picked.
+ * Each worker's view is a subset of all scores, so its threshold never exceeds the true one.
+ */
+typedef struct _prune_threshold
+{
+    double topEntropies[MAX_TOP_PICKS]; // Ascending: [0] is the K-th best seen
+    long numTop;
+    double cleanEntropies[2];           // Descending: [1] is the second best clean word seen
+    long numClean;
+} PRUNE_THRESHOLD, * PPRUNE_THRESHOLD;
+
+/**
+ * @brief Records an exact score in a pruning state.
+ */
+static void update_prune_threshold(PPRUNE_THRESHOLD pThreshold, const GUESS_METRICS* pMetric)
+{
+    double entropy = pMetric->entropy;
+
+    if (pThreshold->numTop < MAX_TOP_PICKS || entropy > pThreshold->topEntropies[0])
+    {
+        // Insert into the ascending array, dropping the old K-th best once the array is full
+        long pos;
+        if (pThreshold->numTop < MAX_TOP_PICKS)
+        {
+            pos = pThreshold->numTop++;
+        }
+        else
+        {
+            pos = 0;
+            while (pos + 1 < MAX_TOP_PICKS && pThreshold->topEntropies[pos + 1] < entropy)
+            {
+                pThreshold->topEntropies[pos] = pThreshold->topEntropies[pos + 1];
+                pos++;
+            }
+        }
+        while (pos > 0 && pThreshold->topEntropies[pos - 1] > entropy)
+        {
+            pThreshold->topEntropies[pos] = pThreshold->topEntropies[pos - 1];
+            pos--;
+        }
+        pThreshold->topEntropies[pos] = entropy;
+    }
+
+    if (is_linguistically_clean(pMetric))
+    {
+        if (pThreshold->numClean < 2) pThreshold->numClean++;
+        if (pThreshold->numClean == 1 || entropy > pThreshold->cleanEntropies[0])
+        {
+            pThreshold->cleanEntropies[1] = pThreshold->cleanEntropies[0];
+            pThreshold->cleanEntropies[0] = entropy;
+        }
+        else if (entropy > pThreshold->cleanEntropies[1])
+        {
+            pThreshold->cleanEntropies[1] = entropy;
+        }
+    }
+}
+
+/**
+ * @brief Returns the entropy a guess must reach to matter, or -1 (prune nothing) while the state is not full.
+ */
+static double get_prune_threshold(const PRUNE_THRESHOLD* pThreshold)
+{
+    if (pThreshold->numTop < MAX_TOP_PICKS || pThreshold->numClean < 2) return -1.0;
+
+    double threshold = pThreshold->topEntropies[0];
+    if (pThreshold->cleanEntropies[1] < threshold) threshold = pThreshold->cleanEntropies[1];
+    return threshold;
+}
+
+/**
+ * @brief Fills the static (R, linguistic) and risk fields of a metric.
+ */
+static void fill_word_metrics(PMETRICS_JOB pJob, WORD_ID wordId, PGUESS_METRICS pMetric)
+{
+    const char* pWord = get_word_text(wordId);
+
+    pMetric->word = pWord;
+    pMetric->remainingMass = 0.0;
+
+    // Static metrics come straight from the store's arrays
+    pMetric->rank = g_dictionaryStore.pRanks[wordId];
+    pMetric->nounType = g_dictionaryStore.pNounTypes[wordId];
+    pMetric->verbType = g_dictionaryStore.pVerbTypes[wordId];
+
+    // Dynamic risk against the game state's required letters
+    pMetric->is_risky = has_unconfirmed_repeat(g_dictionaryStore.pLetterCounts + wordId, &pJob->requiredCounts);
+}
+
+/**
+ * @brief parallel_for callback: scores the candidates [begin, end) of a metrics job.
+ * Every call of calculate_entropy_score_ids tallies into its own stack histogram, so workers share no
+ * mutable state and each writes only its own metric slots.
+ */
+static void calculate_metrics_range(long begin, long end, int, void* pContext)
+{
+    PMETRICS_JOB pJob = (PMETRICS_JOB)pContext;
+
+    for (long i = begin; i < end; i++)
+    {
+        WORD_ID guessId = pJob->pGuessIds[i];
+        PGUESS_METRICS pMetric = pJob->pMetricsTable + i;
+
+        fill_word_metrics(pJob, guessId, pMetric);
+
+        // Calculate the core information metric
+        if (pJob->pHistograms != NULL) pMetric->entropy = get_histogram_entropy(pJob->pHistograms, guessId);
+        else pMetric->entropy = calculate_entropy_score_ids(guessId, pJob->pAnswerIds, pJob->numPossibleAnswers);
+    }
+}
+
+/**
+ * @brief parallel_for callback: scores extra (non-answer) dictionary guesses [begin, end), abandoning
+ * each one as soon as its entropy upper bound falls below the worker's current threshold.
+ * With synced histograms the bound is taken over the guess's histogram row instead of a fresh tally.
+ */
+static void calculate_pruned_metrics_range(long begin, long end, int workerIdx, void* pContext)
+{
+    PMETRICS_JOB pJob = (PMETRICS_JOB)pContext;
+    PPRUNE_THRESHOLD pThreshold = pJob->pThresholds + workerIdx;
+
+    for (long i = begin; i < end; i++)
+    {
+        WORD_ID guessId = pJob->pGuessIds[i];
+        PGUESS_METRICS pMetric = pJob->pMetricsTable + i;
+        bool pruned;
+
+        fill_word_metrics(pJob, guessId, pMetric);
+
+        double threshold = get_prune_threshold(pThreshold);
+        if (pJob->pHistograms != NULL) pMetric->entropy = get_histogram_entropy_bounded(pJob->pHistograms, guessId, threshold, &pruned);
+        else pMetric->entropy = calculate_entropy_score_bounded(guessId, pJob->pAnswerIds, pJob->numPossibleAnswers, threshold, &pruned);
+        if (pruned)
+        {
+            pMetric->entropy = PRUNED_ENTROPY;
+        }
+        else
+        {
+            update_prune_threshold(pThreshold, pMetric);
+        }
+    }
+}
+
+/**
+ * @brief Scores every dictionary word that is not a possible answer (full-dictionary mode).
+ * The possible answers in pMetricsTable[0, numPossibleAnswers) must already be scored; they seed
+ * the pruning threshold. Pruned guesses get PRUNED_ENTROPY and always sort below exact ones.
+ * @return long The number of extra guesses written after the answers, or -1 on allocation failure.
+ */
+static long calculate_extra_guess_metrics(PMETRICS_JOB pJob)
+{
+    long numDictionary = pJob->numWordsInDictionary;
+    long numExtra = 0;
+    long numPruned = 0;
+    int numWorkers = get_worker_thread_count();
+
+    PSCRATCH_ARENA pArena = get_scratch_arena();
+    size_t mark = scratch_mark(pArena);
+    bool* pIsAnswer = (bool*)scratch_calloc(pArena, numDictionary, sizeof(bool));
+    WORD_ID* pExtraIds = (WORD_ID*)scratch_alloc(pArena, numDictionary * sizeof(WORD_ID));
+    PPRUNE_THRESHOLD pThresholds = (PPRUNE_THRESHOLD)scratch_alloc(pArena, numWorkers * sizeof(PRUNE_THRESHOLD));
+
+    if (pIsAnswer == NULL || pExtraIds == NULL || pThresholds == NULL)
+    {
+        fprintf(stderr, "Out of memory for full dictionary scoring!\n");
+        scratch_release(pArena, mark);
+        return -1;
+    }
+
+    // Collect the dictionary words that are not already scored as possible answers
+    for (long i = 0; i < pJob->numPossibleAnswers; i++)
+    {
+        pIsAnswer[pJob->pAnswerIds[i]] = true;
+    }
+    for (long idx = 0; idx < numDictionary; idx++)
+    {
+        if (!pIsAnswer[idx]) pExtraIds[numExtra++] = (WORD_ID)idx;
+    }
+
+    // Seed every worker's threshold with the exact scores of the possible answers
+    PRUNE_THRESHOLD seed;
+    memset(&seed, 0, sizeof(seed));
+    for (long i = 0; i < pJob->numPossibleAnswers; i++)
+    {
+        update_prune_threshold(&seed, pJob->pMetricsTable + i);
+    }
+    for (int w = 0; w < numWorkers; w++)
+    {
+        pThresholds[w] = seed;
+    }
+
+    METRICS_JOB extraJob = *pJob;
+    extraJob.pGuessIds = pExtraIds;
+    extraJob.pMetricsTable = pJob->pMetricsTable + pJob->numPossibleAnswers;
+    extraJob.pThresholds = pThresholds;
+
+    parallel_for(numExtra, METRICS_CHUNK_SIZE, calculate_pruned_metrics_range, &extraJob);
+
+    for (long i = 0; i < numExtra; i++)
+    {
+        if (extraJob.pMetricsTable[i].entropy == PRUNED_ENTROPY) numPruned++;
+    }
+    printfDebug("Full dictionary scoring: %ld extra guesses, %ld pruned early.\n", numExtra, numPruned);
+
+    scratch_release(pArena, mark);
+    return numExtra;
+}
+
+/**
+ * @brief Lists the guesses of a metrics job in table order: the answers first, then (scoreExtra) the
+ * other dictionary words in dictionary order, as exact scoring lays them out.
+ * @param pJob The metrics job.
+ * @param scoreExtra True to include the dictionary words that are not possible answers.
+ * @param pIsAnswer Zeroed scratch flags, one per dictionary word.
+ * @param pGuessIds Output: room for one ID per dictionary word.
+ * @return long The number of guesses listed.
+ */
+static long collect_scored_guess_ids(const METRICS_JOB* pJob, bool scoreExtra, bool* pIsAnswer, WORD_ID* pGuessIds)
+{
+    memcpy(pGuessIds, pJob->pAnswerIds, pJob->numPossibleAnswers * sizeof(WORD_ID));
+    long numGuesses = pJob->numPossibleAnswers;
+    if (scoreExtra)
+    {
+        for (long i = 0; i < pJob->numPossibleAnswers; i++) pIsAnswer[pJob->pAnswerIds[i]] = true;
+        for (long idx = 0; idx < pJob->numWordsInDictionary; idx++)
+        {
+            if (!pIsAnswer[idx]) pGuessIds[numGuesses++] = (WORD_ID)idx;
+        }
+    }
+    return numGuesses;
+}
+
+/**
+ * @brief Inputs of a sampled scoring pass: the metrics job plus the answer sample, each guess's
+ * confidence margin and, for the exact pass, the table slots to rescore and their estimate errors.
+ */
+typedef struct _sample_job
+{
+    METRICS_JOB metrics;
+    const WORD_ID* pSampleIds;
+    long numSamples;
+    double* pMargins;          // Per table slot: half-width of the estimate's confidence interval
+    const long* pRescoreIdx;   // Table slots rescored exactly
+    double* pErrors;           // Per rescored slot: exact minus estimated entropy
+} SAMPLE_JOB, * PSAMPLE_JOB;
+
+/**
+ * @brief Estimates a guess's entropy over all answers from its patterns over a sample of them.
+ * The plug-in entropy of the sample is biased low; the Miller-Madow term (observed buckets - 1) / 2n ln 2,
+ * scaled by the finite population correction, is added back. The margin is SAMPLE_CONFIDENCE_Z standard
+ * errors of the mean surprisal (also corrected for sampling without replacement) plus that bias term.
+ * @param guessId The guess.
+ * @param pSampleIds The sampled answers.
+ * @param numSamples The sample size (at least 2).
+ * @param numAnswers The number of answers the sample was drawn from (more than numSamples).
+ * @param pMargin Output: the half-width of the confidence interval around the estimate.
+ * @return double The estimated entropy score (H).
+ */
+static double estimate_entropy_score_ids(WORD_ID guessId, const WORD_ID* pSampleIds, long numSamples, long numAnswers, double* pMargin)
+{
+    long patternCounts[NUM_PATTERNS] = { 0 };
+    tally_pattern_counts_ids(guessId, pSampleIds, numSamples, patternCounts);
+
+    // A bucket of c answers has surprisal log2(n) - log2(c), with log2(c) taken from the c * log2(c) table
+    double log2Samples = log2((double)numSamples);
+    double sumSurprisal = 0.0;
+    double sumSurprisalSq = 0.0;
+    long numBuckets = 0;
+    for (int k = 0; k < NUM_PATTERNS; k++)
+    {
+        if (patternCounts[k] == 0) continue;
+        double surprisal = log2Samples - count_times_log2(patternCounts[k]) / patternCounts[k];
+        sumSurprisal += patternCounts[k] * surprisal;
+        sumSurprisalSq += patternCounts[k] * surprisal * surprisal;
+        numBuckets++;
+    }
+
+    double plugIn = sumSurprisal / numSamples;
+    double variance = sumSurprisalSq / numSamples - plugIn * plugIn;
+    if (variance < 0.0) variance = 0.0;
+    double populationCorrection = (double)(numAnswers - numSamples) / (numAnswers - 1);
+    double bias = (numBuckets - 1) / (2.0 * numSamples * log(2.0)) * populationCorrection;
+
+    *pMargin = SAMPLE_CONFIDENCE_Z * sqrt(variance * populationCorrection / numSamples) + bias;
+    return plugIn + bias;
+}
+
+/**
+ * @brief parallel_for callback: estimates the guesses [begin, end) of a sampled scoring pass.
+ */
+static void estimate_metrics_range(long begin, long end, int, void* pContext)
+{
+    PSAMPLE_JOB pJob = (PSAMPLE_JOB)pContext;
+
+    for (long i = begin; i < end; i++)
+    {
+        PGUESS_METRICS pMetric = pJob->metrics.pMetricsTable + i;
+        WORD_ID guessId = pJob->metrics.pGuessIds[i];
+
+        fill_word_metrics(&pJob->metrics, guessId, pMetric);
+        pMetric->entropy = estimate_entropy_score_ids(guessId, pJob->pSampleIds, pJob->numSamples, pJob->metrics.numPossibleAnswers, pJob->pMargins + i);
+    }
+}
+
+/**
+ * @brief parallel_for callback: replaces the estimates of the rescored slots [begin, end) with exact entropies.
+ */
+static void rescore_metrics_range(long begin, long end, int, void* pContext)
+{
+    PSAMPLE_JOB pJob = (PSAMPLE_JOB)pContext;
+
+    for (long r = begin; r < end; r++)
+    {
+        long i = pJob->pRescoreIdx[r];
+        PGUESS_METRICS pMetric = pJob->metrics.pMetricsTable + i;
+        double exact = calculate_entropy_score_ids(pJob->metrics.pGuessIds[i], pJob->metrics.pAnswerIds, pJob->metrics.numPossibleAnswers);
+
+        pJob->pErrors[r] = exact - pMetric->entropy;
+        pMetric->entropy = exact;
+    }
+}
+
+/**
+ * @brief Scores the guesses from a deterministic sample of the answers, then rescores exactly every guess
+ * that could still be displayed or picked (see calculate_all_metrics for the table layout).
+ * The sample is stratified over the answers in dictionary order: one answer from the middle of each of
+ * numSamples equal slices. A guess is rescored if its upper bound reaches the pruning threshold (see
+ * get_prune_threshold) of the lower bounds, or if it is an answer ranked at least as high as the last
+ * entry of the rank table (that table shows entropies and breaks rank ties with them). Every other
+ * guess keeps an estimate below the exact entropy of each displayed entry.
+ * @param pJob The metrics job (pGuessIds is ignored: the answers, then any extra guesses, are scored).
+ * @param scoreExtra True to also score the dictionary words that are not possible answers.
+ * @param numSamples The sample size (less than the number of answers).
+ * @return long The number of metrics written, or 0 on allocation failure.
+ */
+static long calculate_sampled_metrics(PMETRICS_JOB pJob, bool scoreExtra, long numSamples)
+{
+    long numAnswers = pJob->numPossibleAnswers;
+    long numDictionary = pJob->numWordsInDictionary;
+    long numGuesses = scoreExtra ? numDictionary : numAnswers;
+
+    PSCRATCH_ARENA pArena = get_scratch_arena();
+    size_t mark = scratch_mark(pArena);
+    WORD_ID* pGuessIds = (WORD_ID*)scratch_alloc(pArena, numGuesses * sizeof(WORD_ID));
+    bool* pIsAnswer = (bool*)scratch_calloc(pArena, numDictionary, sizeof(bool));
+    WORD_ID* pSampleIds = (WORD_ID*)scratch_alloc(pArena, numSamples * sizeof(WORD_ID));
+    double* pMargins = (double*)scratch_alloc(pArena, numGuesses * sizeof(double));
+    long* pRescoreIdx = (long*)scratch_alloc(pArena, numGuesses * sizeof(long));
+    double* pErrors = (double*)scratch_alloc(pArena, numGuesses * sizeof(double));
+
+    if (pGuessIds == NULL || pIsAnswer == NULL || pSampleIds == NULL || pMargins == NULL || pRescoreIdx == NULL || pErrors == NULL)
+    {
+        fprintf(stderr, "Out of memory for sampled scoring!\n");
+        scratch_release(pArena, mark);
+        return 0;
+    }
+
+    long numScored = collect_scored_guess_ids(pJob, scoreExtra, pIsAnswer, pGuessIds);
+    for (long s = 0; s < numSamples; s++)
+    {
+        pSampleIds[s] = pJob->pAnswerIds[(long)(((2 * s + 1) * (long long)numAnswers) / (2 * numSamples))];
+    }
+
+    SAMPLE_JOB job = { *pJob, pSampleIds, numSamples, pMargins, pRescoreIdx, pErrors };
+    job.metrics.pGuessIds = pGuessIds;
+    parallel_for(numScored, METRICS_CHUNK_SIZE, estimate_metrics_range, &job);
+
+    // The entropy a guess must be able to reach, judged on the lower bounds of the estimates
+    PRUNE_THRESHOLD lowerBounds;
+    memset(&lowerBounds, 0, sizeof(lowerBounds));
+    for (long i = 0; i < numScored; i++)
+    {
+        GUESS_METRICS bound = pJob->pMetricsTable[i];
+        bound.entropy -= pMargins[i];
+        update_prune_threshold(&lowerBounds, &bound);
+    }
+    double threshold = get_prune_threshold(&lowerBounds);
+
+    TOP_METRICS rankTop;
+    select_top_metrics(pJob->pMetricsTable, numAnswers, sortMetricsByRankDescending, &rankTop);
+    int rankCutoff = pJob->pMetricsTable[rankTop.topIdx[rankTop.numTop - 1]].rank;
+
+    long numRescored = 0;
+    for (long i = 0; i < numScored; i++)
+    {
+        const GUESS_METRICS* pMetric = pJob->pMetricsTable + i;
+        if (pMetric->entropy + pMargins[i] >= threshold || (i < numAnswers && pMetric->rank >= rankCutoff))
+        {
+            pRescoreIdx[numRescored++] = i;
+        }
+    }
+    parallel_for(numRescored, METRICS_CHUNK_SIZE, rescore_metrics_range, &job);
+
+    // How good the estimates of the rescored guesses were
+    double sumError = 0.0;
+    double maxError = 0.0;
+    long numWithin = 0;
+    for (long r = 0; r < numRescored; r++)
+    {
+        double error = fabs(pErrors[r]);
+        sumError += error;
+        if (error > maxError) maxError = error;
+        if (error <= pMargins[pRescoreIdx[r]]) numWithin++;
+    }
+    printfDebug("Sampled scoring: %ld of %ld answers sampled, %ld of %ld guesses rescored exactly (estimate error mean %.4f, max %.4f bits, %.1f%% within bounds).\n",
+        numSamples, numAnswers, numRescored, numScored, (numRescored > 0) ? sumError / numRescored : 0.0, maxError, (numRescored > 0) ? 100.0 * numWithin / numRescored : 100.0);
+    stats_count(STAT_SAMPLED_GUESSES, numScored);
+    stats_count(STAT_EXACT_RESCORES, numRescored);
+
+    scratch_release(pArena, mark);
+    return numScored;
+}
+
+/**
+ * @brief Calculates the rank-weighted entropy of a guess and the prior mass it is expected to leave,
+ * both from one pass that adds each answer's prior weight to its pattern bucket.
+ * With bucket masses m_k summing to W, the entropy is log2(W) - sum(m_k * log2(m_k)) / W and the
+ * remaining mass is sum(m_k^2) / W^2 over every bucket but all green (the guess then wins, leaving nothing).
+ * @param guessId The guess.
+ * @param pAnswerIds IDs of the remaining possible answers.
+ * @param numPossibleAnswers The number of IDs.
+ * @param totalWeight The prior mass W of the answers.
+ * @param pRemainingMass Output: the expected share of W still possible after the guess.
+ * @return double The rank-weighted entropy score (H).
+ */
+double calculate_weighted_score_ids(WORD_ID guessId, const WORD_ID* pAnswerIds, long numPossibleAnswers, double totalWeight, double* pRemainingMass)
+{
+    double patternMass[NUM_PATTERNS] = { 0.0 };
+    const double* pWeights = g_dictionaryStore.pPriorWeights;
+
+    if (g_patternMatrix.pCodes != NULL)
+    {
+        const PATTERN_CODE* pRow = g_patternMatrix.pCodes + (size_t)guessId * g_patternMatrix.numWords;
+        for (long i = 0; i < numPossibleAnswers; i++)
+        {
+            patternMass[pRow[pAnswerIds[i]]] += pWeights[pAnswerIds[i]];
+        }
+    }
+    else
+    {
+        const unsigned int* pPacked = g_dictionaryStore.pPackedLetters;
+        unsigned int packedGuess = pPacked[guessId];
+        for (long i = 0; i < numPossibleAnswers; i++)
+        {
+            patternMass[get_feedback_pattern_code_packed(packedGuess, pPacked[pAnswerIds[i]])] += pWeights[pAnswerIds[i]];
+        }
+    }
+    stats_count(STAT_PATTERN_EVALUATIONS, numPossibleAnswers);
+
+    double sumMassLog2 = 0.0;
+    double sumMassSq = 0.0;
+    for (int k = 0; k < NUM_PATTERNS; k++)
+    {
+        double mass = patternMass[k];
+        if (mass <= 0.0) continue;
+        sumMassLog2 += mass * log2(mass);
+        if (k != PATTERN_ALL_GREEN) sumMassSq += mass * mass;
+    }
+
+    *pRemainingMass = sumMassSq / (totalWeight * totalWeight);
+    return log2(totalWeight) - sumMassLog2 / totalWeight;
+}
+
+/**
+ * @brief parallel_for callback: scores the guesses [begin, end) of a --weighted metrics job.
+ */
+static void calculate_weighted_metrics_range(long begin, long end, int, void* pContext)
+{
+    PMETRICS_JOB pJob = (PMETRICS_JOB)pContext;
+
+    for (long i = begin; i < end; i++)
+    {
+        WORD_ID guessId = pJob->pGuessIds[i];
+        PGUESS_METRICS pMetric = pJob->pMetricsTable + i;
+
+        fill_word_metrics(pJob, guessId, pMetric);
+        pMetric->entropy = calculate_weighted_score_ids(guessId, pJob->pAnswerIds, pJob->numPossibleAnswers, pJob->totalWeight, &pMetric->remainingMass);
+    }
+}
+
+/**
+ * @brief Scores every guess by rank-weighted entropy and expected remaining mass (--weighted).
+ * The bucket masses are not counts, so neither histograms, sampling nor entropy pruning apply;
+ * every guess is tallied in full (see calculate_all_metrics for the table layout).
+ * @param pJob The metrics job (pGuessIds is ignored: the answers, then any extra guesses, are scored).
+ * @param scoreExtra True to also score the dictionary words that are not possible answers.
+ * @return long The number of metrics written, or 0 on allocation failure.
+ */
+static long calculate_weighted_metrics(PMETRICS_JOB pJob, bool scoreExtra)
+{
+    PSCRATCH_ARENA pArena = get_scratch_arena();
+    size_t mark = scratch_mark(pArena);
+    WORD_ID* pGuessIds = (WORD_ID*)scratch_alloc(pArena, pJob->numWordsInDictionary * sizeof(WORD_ID));
+    bool* pIsAnswer = (bool*)scratch_calloc(pArena, pJob->numWordsInDictionary, sizeof(bool));
+
+    if (pGuessIds == NULL || pIsAnswer == NULL)
+    {
+        fprintf(stderr, "Out of memory for weighted scoring!\n");
+        scratch_release(pArena, mark);
+        return 0;
+    }
+
+    METRICS_JOB job = *pJob;
+    job.pGuessIds = pGuessIds;
+    job.totalWeight = 0.0;
+    for (long i = 0; i < pJob->numPossibleAnswers; i++) job.totalWeight += g_dictionaryStore.pPriorWeights[pJob->pAnswerIds[i]];
+
+    long numScored = collect_scored_guess_ids(pJob, scoreExtra, pIsAnswer, pGuessIds);
+    parallel_for(numScored, METRICS_CHUNK_SIZE, calculate_weighted_metrics_range, &job);
+
+    scratch_release(pArena, mark);
+    return numScored;
+}
+
+/**
+ * @brief Inputs of one accelerated scoring batch: the batch's guesses and their device histograms.
+ */
+typedef struct _accelerated_job
+{
+    METRICS_JOB metrics;
+    const unsigned int* pCounts; // NUM_PATTERNS counts per guess of the batch
+} ACCELERATED_JOB, * PACCELERATED_JOB;
+
+/**
+ * @brief parallel_for callback: fills the metrics of batch guesses [begin, end) from their device
+ * histograms. The buckets are summed in pattern order, so each entropy is bit-identical to
+ * calculate_entropy_score_ids.
+ */
+static void accelerated_metrics_range(long begin, long end, int, void* pContext)
+{
+    PACCELERATED_JOB pJob = (PACCELERATED_JOB)pContext;
+    long numAnswers = pJob->metrics.numPossibleAnswers;
+
+    for (long i = begin; i < end; i++)
+    {
+        PGUESS_METRICS pMetric = pJob->metrics.pMetricsTable + i;
+        const unsigned int* pRow = pJob->pCounts + (size_t)i * NUM_PATTERNS;
+
+        fill_word_metrics(&pJob->metrics, pJob->metrics.pGuessIds[i], pMetric);
+
+        double sumCountLog2 = 0.0;
+        for (int k = 0; k < NUM_PATTERNS; k++)
+        {
+            sumCountLog2 += count_times_log2(pRow[k]);
+        }
+        pMetric->entropy = (numAnswers <= 1) ? 0.0 : log2((double)numAnswers) - sumCountLog2 / numAnswers;
+    }
+}
+
+/**
+ * @brief Scores every guess exactly with the pattern histograms tallied on the device (--gpu), in
+ * batches of ACCELERATOR_HISTOGRAM_BATCH guesses. Extra guesses are scored in full rather than pruned.
+ * @param pJob The metrics job (pGuessIds is ignored: the answers, then any extra guesses, are scored).
+ * @param scoreExtra True to also score the dictionary words that are not possible answers.
+ * @return long The number of metrics written, or 0 if the device failed (the CPU engine then scores the turn).
+ */
+static long calculate_accelerated_metrics(PMETRICS_JOB pJob, bool scoreExtra)
+{
+    PSCRATCH_ARENA pArena = get_scratch_arena();
+    size_t mark = scratch_mark(pArena);
+    WORD_ID* pGuessIds = (WORD_ID*)scratch_alloc(pArena, pJob->numWordsInDictionary * sizeof(WORD_ID));
+    bool* pIsAnswer = (bool*)scratch_calloc(pArena, pJob->numWordsInDictionary, sizeof(bool));
+    unsigned int* pCounts = (unsigned int*)scratch_alloc(pArena, (size_t)ACCELERATOR_HISTOGRAM_BATCH * NUM_PATTERNS * sizeof(unsigned int));
+
+    if (pGuessIds == NULL || pIsAnswer == NULL || pCounts == NULL)
+    {
+        scratch_release(pArena, mark);
+        return 0;
+    }
+
+    long numScored = collect_scored_guess_ids(pJob, scoreExtra, pIsAnswer, pGuessIds);
+    for (long first = 0; first < numScored; first += ACCELERATOR_HISTOGRAM_BATCH)
+    {
+        long numBatch = (numScored - first < ACCELERATOR_HISTOGRAM_BATCH) ? numScored - first : ACCELERATOR_HISTOGRAM_BATCH;
+        if (!accelerator_tally_histograms(pGuessIds + first, numBatch, pJob->pAnswerIds, pJob->numPossibleAnswers, pCounts))
+        {
+            scratch_release(pArena, mark);
+            return 0;
+        }
+
+        ACCELERATED_JOB job = { *pJob, pCounts };
+        job.metrics.pGuessIds = pGuessIds + first;
+        job.metrics.pMetricsTable = pJob->pMetricsTable + first;
+        parallel_for(numBatch, METRICS_CHUNK_SIZE, accelerated_metrics_range, &job);
+    }
+    stats_count(STAT_ACCELERATED_PASSES, 1);
+
+    scratch_release(pArena, mark);
+    return numScored;
+}
+
+/**
+ * @brief Calculates all required metrics (H, R, Linguistic, Risk) for every possible answer.
+ * Candidates are scored in parallel (see parallel_for); the table is identical to a serial run.
+ * In full-dictionary mode the remaining dictionary words are scored too and appended after the
+ * answers, with pruning (see calculate_extra_guess_metrics).
+ * The answers are converted to word IDs once, so the scoring loops only touch the store and matrix.
+ * With pHistograms the game's pattern histograms are synced to the answers first (often just by
+ * removing the answers eliminated since the previous turn) and every entropy is read from them.
+ * With --sample, answer sets much larger than the sample are scored by calculate_sampled_metrics instead,
+ * and with --weighted every set is scored by calculate_weighted_metrics.
+ * With --gpu, passes of at least ACCELERATOR_MIN_PAIRS guess/answer pairs are tallied on the device
+ * (see calculate_accelerated_metrics), falling back to the CPU engine if it fails.
+ * @param pPossibleAnswers Array of pointers to remaining possible answers (words of the dictionary store).
+ * @param numPossibleAnswers The number of words remaining.
+ * @param pGood The string of required letters (for repeat risk check).
+ * @param pMetricsTable The pre-allocated array to store the results (numWordsInDictionary entries).
+ * @param numWordsInDictionary Total size of the dictionary (for lookup).
+ * @param pHistograms The game's histograms, or NULL to tally every entropy from scratch.
+ * @return long The number of metrics written: the answers first, then any extra guesses (0 on failure).
+ */
+long calculate_all_metrics(const char** pPossibleAnswers, long numPossibleAnswers, char* pGood, PGUESS_METRICS pMetricsTable, long numWordsInDictionary, PPATTERN_HISTOGRAMS pHistograms)
+{
+    PSCRATCH_ARENA pArena = get_scratch_arena();
+    size_t mark = scratch_mark(pArena);
+    WORD_ID* pAnswerIds = (WORD_ID*)scratch_alloc(pArena, numPossibleAnswers * sizeof(WORD_ID));
+    if (pAnswerIds == NULL)
+    {
+        fprintf(stderr, "Out of memory for the answer ID list!\n");
+        scratch_release(pArena, mark);
+        return 0;
+    }
+
+    for (long i = 0; i < numPossibleAnswers; i++)
+    {
+        pAnswerIds[i] = get_word_id(pPossibleAnswers[i]);
+        if (pAnswerIds[i] == INVALID_WORD_ID)
+        {
+            fprintf(stderr, "Possible answer %.5s is not a dictionary word!\n", pPossibleAnswers[i]);
+            scratch_release(pArena, mark);
+            return 0;
+        }
+    }
+
+    STAT_TIMER timer;
+    stats_start(&timer);
+
+    // Every dictionary word is a guess in full-dictionary mode, otherwise only the answers are
+    bool scoreExtra = g_options.scoreFullDictionary && numPossibleAnswers > 1;
+    bool weighted = g_options.priorWeighted;
+    bool sample = !weighted && g_options.sampleSize > 0 && numPossibleAnswers >= SAMPLE_MIN_REDUCTION * g_options.sampleSize;
+    long numGuesses = scoreExtra ? numWordsInDictionary : numPossibleAnswers;
+    bool offload = !weighted && !sample && g_acceleratorReady && (long long)numGuesses * numPossibleAnswers >= ACCELERATOR_MIN_PAIRS;
+    const PATTERN_HISTOGRAMS* pSynced = NULL;
+    if (pHistograms != NULL && !sample && !weighted && !offload)
+    {
+        WORD_ID* pGuessIds = pAnswerIds;
+        if (scoreExtra && (pGuessIds = (WORD_ID*)scratch_alloc(pArena, numWordsInDictionary * sizeof(WORD_ID))) != NULL)
+        {
+            for (long idx = 0; idx < numWordsInDictionary; idx++) pGuessIds[idx] = (WORD_ID)idx;
+        }
+        if (pGuessIds != NULL &&
+            sync_pattern_histograms(pHistograms, pAnswerIds, numPossibleAnswers, pGuessIds, numGuesses))
+        {
+            pSynced = pHistograms;
+        }
+    }
+
+    LETTER_COUNTS requiredCounts;
+    count_letters(pGood, (int)strlen(pGood), &requiredCounts);
+    METRICS_JOB job = { pAnswerIds, numPossibleAnswers, pAnswerIds, requiredCounts, pMetricsTable, numWordsInDictionary, NULL, pSynced, 0.0 };
+
+    long numMetrics = 0;
+    if (weighted)
+    {
+        numMetrics = calculate_weighted_metrics(&job, scoreExtra);
+    }
+    else if (sample)
+    {
+        numMetrics = calculate_sampled_metrics(&job, scoreExtra, g_options.sampleSize);
+    }
+    else if (offload)
+    {
+        numMetrics = calculate_accelerated_metrics(&job, scoreExtra);
+    }
+
+    if (numMetrics == 0 && !weighted && !sample)
+    {
+        parallel_for(numPossibleAnswers, METRICS_CHUNK_SIZE, calculate_metrics_range, &job);
+
+        numMetrics = numPossibleAnswers;
+        if (scoreExtra)
+        {
+            long numExtra = calculate_extra_guess_metrics(&job);
+            if (numExtra > 0) numMetrics += numExtra;
+        }
+    }
+
+    stats_stop(&timer, STAT_STAGE_METRICS);
+    scratch_release(pArena, mark);
+    return numMetrics;
+}
+
+/**
+ * @brief True if metric a comes before metric b: by compareFn, then by table index, so the order is
+ * total and independent of the sort algorithm (ties keep table order, as a stable sort would).
+ */
+static inline bool is_metric_before(const GUESS_METRICS* pMetrics, long a, long b, METRIC_COMPARE_FN compareFn)
+{
+    int order = compareFn(pMetrics + a, pMetrics + b);
+    return (order != 0) ? order < 0 : a < b;
+}
+
+/**
+ * @brief Selects the best MAX_TOP_PICKS metrics and the best two linguistically clean ones in a
+ * single pass, without copying or sorting the table: a bounded heap of indices whose root is the
+ * worst entry kept, so most entries are rejected with one comparison (O(N log K) overall).
+ * @param pMetrics The metric table (unsorted).
+ * @param numMetrics The number of entries to consider.
+ * @param compareFn The ordering (sortMetricsByRankDescending or sortMetricsByEntropyDescending).
+ * @param pTop Output: the selected indices, best first.
+ */
+void select_top_metrics(const GUESS_METRICS* pMetrics, long numMetrics, METRIC_COMPARE_FN compareFn, PTOP_METRICS pTop)
+{
+    long* pHeap = pTop->topIdx;
+    long numHeap = 0;
+
+    pTop->numClean = 0;
+
+    for (long i = 0; i < numMetrics; i++)
+    {
+        // The first two clean entries of the full order
+        if (is_linguistically_clean(pMetrics + i))
+        {
+            if (pTop->numClean == 0 || is_metric_before(pMetrics, i, pTop->cleanIdx[0], compareFn))
+            {
+                pTop->cleanIdx[1] = pTop->cleanIdx[0];
+                pTop->cleanIdx[0] = i;
+                if (pTop->numClean < 2) pTop->numClean++;
+            }
+            else if (pTop->numClean == 1 || is_metric_before(pMetrics, i, pTop->cleanIdx[1], compareFn))
+            {
+                pTop->cleanIdx[1] = i;
+                pTop->numClean = 2;
+            }
+        }
+
+        long pos;
+        if (numHeap < MAX_TOP_PICKS)
+        {
+            // Sift up: parents come after their children
+            pos = numHeap++;
+            while (pos > 0 && is_metric_before(pMetrics, pHeap[(pos - 1) / 2], i, compareFn))
+            {
+                pHeap[pos] = pHeap[(pos - 1) / 2];
+                pos = (pos - 1) / 2;
+            }
+            pHeap[pos] = i;
+        }
+        else if (is_metric_before(pMetrics, i, pHeap[0], compareFn))
+        {
+            // Replace the worst entry kept and sift down
+            pos = 0;
+            while (true)
+            {
+                long child = 2 * pos + 1;
+                if (child >= numHeap) break;
+                if (child + 1 < numHeap && is_metric_before(pMetrics, pHeap[child], pHeap[child + 1], compareFn)) child++;
+                if (!is_metric_before(pMetrics, i, pHeap[child], compareFn)) break;
+                pHeap[pos] = pHeap[child];
+                pos = child;
+            }
+            pHeap[pos] = i;
+        }
+    }
+
+    // Order the kept entries best first (at most MAX_TOP_PICKS, so insertion sort)
+    for (long k = 1; k < numHeap; k++)
+    {
+        long idx = pHeap[k];
+        long pos = k;
+        while (pos > 0 && is_metric_before(pMetrics, idx, pHeap[pos - 1], compareFn))
+        {
+            pHeap[pos] = pHeap[pos - 1];
+            pos--;
+        }
+        pHeap[pos] = idx;
+    }
+    pTop->numTop = numHeap;
+}
+
+/**
+ * @brief Checks the strict linguistic/risk preference used for the top picks.
+ * Excludes Plural Nouns ('P'), Past Tense Verbs ('T'), Third-Person Singular Verbs ('S'),
+ * and words with unconfirmed repeat letters.
+ * @param pMetric The metric to check.
+ * @return true if the word may be used as a top pick.
+ */
+bool is_linguistically_clean(const GUESS_METRICS* pMetric)
+{
+    return (pMetric->nounType != 'P' && pMetric->verbType != 'T' &&
+        pMetric->verbType != 'S' && pMetric->is_risky == false);
+}
+
+/**
+ * @brief Finds the top pick and alternate based on strict linguistic/risk preferences.
+ * This filters out undesirable word forms (plurals, past tense, etc.) from the top of the order.
+ * @param pMetrics The metric table the selection indexes.
+ * @param pTop The selection for the primary metric (Rank or Entropy), see select_top_metrics.
+ * @param numMetrics Number of entries the selection was made from.
+ * @param pResult Output structure to store the top pick and alternate.
+ */
+void find_top_linguistic_picks(const GUESS_METRICS* pMetrics, const TOP_METRICS* pTop, long numMetrics, PICK_DATA* pResult)
+{
+    pResult->word = "NONE";
+    pResult->alternate_word = "NONE";
+    pResult->pMetric = NULL;
+    pResult->pAlternateMetric = NULL;
+
+    // The top two words that are linguistically sound and not risky (found during selection)
+    int found_count = (int)pTop->numClean;
+    if (found_count > 0)
+    {
+        pResult->pMetric = pMetrics + pTop->cleanIdx[0];
+        pResult->word = pResult->pMetric->word;
+    }
+    if (found_count > 1)
+    {
+        pResult->pAlternateMetric = pMetrics + pTop->cleanIdx[1];
+        pResult->alternate_word = pResult->pAlternateMetric->word;
+    }
+
+    // Fallback: If not enough linguistically clean words were found, use the absolute top words
+    if (found_count < 2 && numMetrics > 0)
+    {
+        // If 0 clean words found, use absolute top word as the Top Pick
+        if (found_count == 0)
+        {
+            pResult->pMetric = pMetrics + pTop->topIdx[0];
+            pResult->word = pResult->pMetric->word;
+            found_count = 1;
+        }
+
+        // If less than 2 clean words found, use absolute second best as Alternate (if available)
+        if (found_count == 1 && numMetrics > 1)
+        {
+            const GUESS_METRICS* pSecond = pMetrics + pTop->topIdx[1];
+            if (strcmp(pSecond->word, pResult->word) != 0)
+            {
+                pResult->pAlternateMetric = pSecond;
+                pResult->alternate_word = pSecond->word;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Builds a pick metric for a word chosen by find_top_linguistic_picks.
+ * Words without a metric entry (e.g. "NONE") are reported with R=0 and H=0.
+ * @param word The picked word (or "NONE").
+ * @param pFound Its metric entry, or NULL.
+ * @param pResult Output pick metric.
+ */
+static void make_pick_metric(const char* word, const GUESS_METRICS* pFound, PGUESS_METRICS pResult)
+{
+    if (pFound != NULL)
+    {
+        *pResult = *pFound;
+        return;
+    }
+    memset(pResult, 0, sizeof(GUESS_METRICS));
+    pResult->word = word;
+    pResult->nounType = 'N';
+    pResult->verbType = 'N';
+}
+
+/**
+ * @brief Appends one table cell: "Word (R, H) N=x V=x R=Y/N", padded to the column width.
+ */
+static void render_metric_cell(POUTPUT_BUFFER pOut, int row, const GUESS_METRICS* pMetric, int width)
+{
+    size_t start = pOut->length;
+    if (pMetric != NULL)
+    {
+        output_printf(pOut, "%3d. %-5s (R=%03d, H=%.4f) N=%c V=%c R=%c",
+            row, pMetric->word, pMetric->rank, pMetric->entropy, pMetric->nounType, pMetric->verbType,
+            (pMetric->is_risky ? 'Y' : 'N'));
+    }
+    output_pad(pOut, start, width);
+}
+
+/**
+ * @brief Appends one pick line ("Top Pick" or "Alternate"), padded to the column width.
+ */
+static void render_pick_cell(POUTPUT_BUFFER pOut, const char* pszLabel, const GUESS_METRICS* pPick, int width)
+{
+    size_t start = pOut->length;
+    output_printf(pOut, "     %-10s: %-5s (R=%03d, H=%.4f)", pszLabel, pPick->word, pPick->rank, pPick->entropy);
+    output_pad(pOut, start, width);
+}
+
+/**
+ * @brief Renders the one-column --weighted table: the top N choices by expected remaining mass,
+ * then the linguistically filtered Top Pick and Alternate.
+ * @param pRec The recommendation (see select_weighted_recommendation) to render.
+ * @param pOut The turn's output buffer.
+ */
+static void render_weighted_table(const RECOMMENDATION* pRec, POUTPUT_BUFFER pOut)
+{
+    const char* pszRule = "---------------------------------------------------------------------------------------\n";
+
+    if (pRec->numMetrics > pRec->numPossibleAnswers)
+    {
+        output_printf(pOut, "\n%*s--- Top %d Choices (Possible Answers: %ld, Guesses Scored: %ld) ---\n", 12, "", MAX_TOP_PICKS, pRec->numPossibleAnswers, pRec->numMetrics);
+    }
+    else
+    {
+        output_printf(pOut, "\n%*s--- Top %d Choices (Possible Answers: %ld) ---\n", 22, "", MAX_TOP_PICKS, pRec->numPossibleAnswers);
+    }
+    output_printf(pOut, "(R=Rank, H=Weighted Entropy, M=Remaining Mass, N=Plurality, V=Preterite, R=Repeat Risk)\n");
+    output_printf(pOut, "%s", pszRule);
+    output_printf(pOut, "     Prior-Weighted (Lower M = Less of the likely answers left after the guess)\n");
+    output_printf(pOut, "%s", pszRule);
+
+    for (int i = 0; i < pRec->numEntropyRows; i++)
+    {
+        const GUESS_METRICS* pMetric = pRec->entropyRows + i;
+        output_printf(pOut, "%3d. %-5s (R=%03d, H=%.4f, M=%.4f) N=%c V=%c R=%c\n",
+            i + 1, pMetric->word, pMetric->rank, pMetric->entropy, pMetric->remainingMass, pMetric->nounType, pMetric->verbType,
+            (pMetric->is_risky ? 'Y' : 'N'));
+    }
+
+    output_printf(pOut, "%s", pszRule);
+    output_printf(pOut, "     %-10s: %-5s (R=%03d, H=%.4f, M=%.4f)\n", "Top Pick", pRec->entropyPick.word, pRec->entropyPick.rank, pRec->entropyPick.entropy, pRec->entropyPick.remainingMass);
+    output_printf(pOut, "     %-10s: %-5s (R=%03d, H=%.4f, M=%.4f)\n", "Alternate", pRec->entropyAlternate.word, pRec->entropyAlternate.rank, pRec->entropyAlternate.entropy, pRec->entropyAlternate.remainingMass);
+    output_printf(pOut, "%s", pszRule);
+}
+
+/**
+ * @brief Renders the two-column table showing the top N choices for both Rank and Entropy.
+ * @param pRec The recommendation (top rows and linguistically filtered picks) to render.
+ * @param pOut The turn's output buffer.
+ */
+void render_recommendation_table(const RECOMMENDATION* pRec, POUTPUT_BUFFER pOut)
+{
+    if (g_options.priorWeighted)
+    {
+        render_weighted_table(pRec, pOut);
+        return;
+    }
+
+    const int COL_WIDTH = 43;
+    const int MAX_ROWS = MAX_TOP_PICKS;
+    const char* pszRule = "-------------------------------------------+-------------------------------------------\n";
+
+    if (pRec->numMetrics > pRec->numPossibleAnswers)
+    {
+        output_printf(pOut, "\n%*s--- Top %d Choices (Possible Answers: %ld, Guesses Scored: %ld) ---\n", 12, "", MAX_ROWS, pRec->numPossibleAnswers, pRec->numMetrics);
+    }
+    else
+    {
+        output_printf(pOut, "\n%*s--- Top %d Choices (Possible Answers: %ld) ---\n", 22, "", MAX_ROWS, pRec->numPossibleAnswers);
+    }
+    output_printf(pOut, "%*s(R=Rank, H=Entropy, N=Plurality, V=Preterite, R=Repeat Risk)\n", 16, "");
+    output_printf(pOut, "%s", pszRule);
+    output_printf(pOut, "     Rank-Optimized                        |     Entropy-Optimized                     \n");
+    output_printf(pOut, "   (Higher Rank = More Common)             |   (Higher H = Reduces solution set)       \n");
+    output_printf(pOut, "%s", pszRule);
+
+    // The top N rows side-by-side (the Rank column can be shorter in full-dictionary mode)
+    for (int i = 0; i < pRec->numEntropyRows; i++)
+    {
+        render_metric_cell(pOut, i + 1, (i < pRec->numRankRows) ? pRec->rankRows + i : NULL, COL_WIDTH);
+        output_printf(pOut, "|");
+        render_metric_cell(pOut, i + 1, pRec->entropyRows + i, COL_WIDTH);
+        output_printf(pOut, "\n");
+    }
+
+    output_printf(pOut, "%s", pszRule);
+
+    // Top Pick and Alternate of both paths
+    render_pick_cell(pOut, "Top Pick", &pRec->rankPick, COL_WIDTH);
+    output_printf(pOut, "|");
+    render_pick_cell(pOut, "Top Pick", &pRec->entropyPick, COL_WIDTH);
+    output_printf(pOut, "\n");
+    render_pick_cell(pOut, "Alternate", &pRec->rankAlternate, COL_WIDTH);
+    output_printf(pOut, "|");
+    render_pick_cell(pOut, "Alternate", &pRec->entropyAlternate, COL_WIDTH);
+    output_printf(pOut, "\n");
+
+    output_printf(pOut, "%s", pszRule);
+}
+
+/**
+ * @brief Applies the dynamic H/R trade-off logic to select the single best final recommendation.
+ * @param pTopRanked The highest ranked possible answer (absolute top pick in small sets).
+ * @param numPossibleAnswers The number of words remaining.
+ * @param rankPicks The top picks from the Rank path.
+ * @param entropyPicks The top picks from the Entropy path.
+ * @param pPolicy The entropy/rank threshold and low answer count to apply.
+ * @param pFinalPick Output: the metrics of the chosen word.
+ */
+void determine_final_pick(const GUESS_METRICS* pTopRanked, long numPossibleAnswers, const PICK_DATA* rankPicks, const PICK_DATA* entropyPicks, const PICK_POLICY* pPolicy, PGUESS_METRICS pFinalPick)
+{
+    // Metrics of the linguistically filtered top picks
+    const GUESS_METRICS* pR_Pick = rankPicks->pMetric;
+    const GUESS_METRICS* pE_Pick = entropyPicks->pMetric;
+
+    // Default to the Rank pick (most common)
+    make_pick_metric(rankPicks->word, pR_Pick, pFinalPick);
+
+    if (pR_Pick && pE_Pick)
+    {
+        double entropy_diff = fabs(pE_Pick->entropy - pR_Pick->entropy);
+
+        if (numPossibleAnswers > pPolicy->lowAnswerCount)
+        {
+            // Large set (N > 25 by default): Prioritize H unless the difference is negligible.
+            if (entropy_diff > pPolicy->entropyRankThreshold)
+            {
+                // Difference is significant: choose Entropy pick for max information gain
+                *pFinalPick = *pE_Pick;
+            }
+            // Otherwise, Rank-Pick (default) is used for its higher probability.
+        }
+        else // Small set (N <= 25 by default): Prioritize Rank.
+        {
+            // Choose the absolute highest ranked word (first in the Rank order)
+            *pFinalPick = *pTopRanked;
+        }
+    }
+    else if (numPossibleAnswers > 0)
+    {
+        // Fallback: If filtering removed one of the key picks, use the absolute highest Rank word.
+        *pFinalPick = *pTopRanked;
+    }
+}
+
+/**
+ * @brief Renders the final top pick in a centered banner format.
+ * @param pFinalPick The metrics of the chosen word.
+ * @param pOut The turn's output buffer.
+ */
+void render_final_pick(const GUESS_METRICS* pFinalPick, POUTPUT_BUFFER pOut)
+{
+    // Center the banner text in the table width
+    int final_string_length = snprintf(NULL, 0, "Final Top Pick: %s (R=%03d, H=%.4f)", pFinalPick->word, pFinalPick->rank, pFinalPick->entropy);
+    int total_width = 89;
+    int padding = (total_width - final_string_length) / 2;
+
+    output_printf(pOut, "%*sFinal Top Pick: %s (R=%03d, H=%.4f)%*s\n", padding, "", pFinalPick->word, pFinalPick->rank, pFinalPick->entropy, padding, "");
+    output_printf(pOut, "---------------------------------------------------------------------------------------\n");
+}
+
+/**
+ * @brief Renders a recommendation as one JSON line: the answer count, the final pick and the
+ * picks of both paths.
+ * @param pRec The recommendation to render.
+ * @param pOut The turn's output buffer.
+ */
+void render_compact_recommendation(const RECOMMENDATION* pRec, POUTPUT_BUFFER pOut)
+{
+    output_printf(pOut, "{\"remaining\":%ld,\"scored\":%ld,\"pick\":\"%s\",\"rank\":%d,\"entropy\":%.4f,"
+        "\"rank_pick\":\"%s\",\"rank_alternate\":\"%s\",\"entropy_pick\":\"%s\",\"entropy_alternate\":\"%s\"}\n",
+        pRec->numPossibleAnswers, pRec->numMetrics, pRec->finalPick.word, pRec->finalPick.rank, pRec->finalPick.entropy,
+        pRec->rankPick.word, pRec->rankAlternate.word, pRec->entropyPick.word, pRec->entropyAlternate.word);
+}
+
+/**
+ * @brief Fills a recommendation from the single --weighted order (lowest expected remaining mass
+ * first): its top rows, its linguistically filtered picks and the final pick. There is no Rank path;
+ * its rows are empty and its picks "NONE". Like determine_final_pick, large sets take the filtered
+ * pick and small sets (N <= the low answer count) the absolute best entry.
+ * @param pMetricsTable The scored table (see calculate_all_metrics).
+ * @param numPossibleAnswers The number of words remaining.
+ * @param numMetrics The number of guesses scored.
+ * @param pRec Output: the top rows, picks and final pick.
+ */
+static void select_weighted_recommendation(const GUESS_METRICS* pMetricsTable, long numPossibleAnswers, long numMetrics, PRECOMMENDATION pRec)
+{
+    TOP_METRICS top;
+    PICK_DATA picks;
+
+    select_top_metrics(pMetricsTable, numMetrics, sortMetricsByRemainingMassAscending, &top);
+    find_top_linguistic_picks(pMetricsTable, &top, numMetrics, &picks);
+
+    pRec->numPossibleAnswers = numPossibleAnswers;
+    pRec->numMetrics = numMetrics;
+    pRec->numRankRows = 0;
+    pRec->numEntropyRows = top.numTop;
+    for (long i = 0; i < top.numTop; i++) pRec->entropyRows[i] = pMetricsTable[top.topIdx[i]];
+
+    make_pick_metric("NONE", NULL, &pRec->rankPick);
+    make_pick_metric("NONE", NULL, &pRec->rankAlternate);
+    make_pick_metric(picks.word, picks.pMetric, &pRec->entropyPick);
+    make_pick_metric(picks.alternate_word, picks.pAlternateMetric, &pRec->entropyAlternate);
+
+    if (numPossibleAnswers > g_options.pickPolicy.lowAnswerCount) pRec->finalPick = pRec->entropyPick;
+    else pRec->finalPick = pMetricsTable[top.topIdx[0]];
+}
+
+/**
+ * @brief Re-derives the final pick of a recommendation under another pick policy, from the picks and
+ * top rows it keeps (the scores do not depend on the policy). With the policy the recommendation was
+ * computed with, this reproduces its final pick (unless --lookahead replaced it).
+ * @param pRec The recommendation (computed or from a cache).
+ * @param pPolicy The policy to apply.
+ * @param pFinalPick Output: the metrics of the chosen word.
+ */
+void resolve_final_pick(const RECOMMENDATION* pRec, const PICK_POLICY* pPolicy, PGUESS_METRICS pFinalPick)
+{
+    if (g_options.priorWeighted)
+    {
+        *pFinalPick = (pRec->numPossibleAnswers > pPolicy->lowAnswerCount) ? pRec->entropyPick : pRec->entropyRows[0];
+        return;
+    }
+
+    bool haveRankPick = strcmp(pRec->rankPick.word, "NONE") != 0;
+    bool haveEntropyPick = strcmp(pRec->entropyPick.word, "NONE") != 0;
+    PICK_DATA rankPicks = { pRec->rankPick.word, pRec->rankAlternate.word, haveRankPick ? &pRec->rankPick : NULL, NULL };
+    PICK_DATA entropyPicks = { pRec->entropyPick.word, pRec->entropyAlternate.word, haveEntropyPick ? &pRec->entropyPick : NULL, NULL };
+    determine_final_pick(pRec->rankRows, pRec->numPossibleAnswers, &rankPicks, &entropyPicks, pPolicy, pFinalPick);
+}
+
+/**
+ * @brief Selects a recommendation from a scored metric table: the top rows and clean picks of both
+ * orders and the final pick by the H/R trade-off.
+ * @param pMetricsTable The scored table; its first numPossibleAnswers entries are the answers.
+ * @param numPossibleAnswers The number of possible answers (must be > 0).
+ * @param numMetrics The number of scored entries.
+ * @param pRec Output: the top rows, picks and final pick.
+ */
+static void select_recommendation(const GUESS_METRICS* pMetricsTable, long numPossibleAnswers, long numMetrics, PRECOMMENDATION pRec)
+{
+    TOP_METRICS rankTop;
+    TOP_METRICS entropyTop;
+    PICK_DATA rankPicks;
+    PICK_DATA entropyPicks;
+
+    // 1. Select the top rows and clean picks of both orders (Rank over the answers, Entropy over every guess)
+    select_top_metrics(pMetricsTable, numPossibleAnswers, sortMetricsByRankDescending, &rankTop);
+    select_top_metrics(pMetricsTable, numMetrics, sortMetricsByEntropyDescending, &entropyTop);
+
+    // 2. Find Top Pick and Alternate for each path, applying linguistic/risk filters
+    find_top_linguistic_picks(pMetricsTable, &rankTop, numPossibleAnswers, &rankPicks);
+    find_top_linguistic_picks(pMetricsTable, &entropyTop, numMetrics, &entropyPicks);
+
+    // 3. Keep the rows the table shows and the metrics of the picks
+    pRec->numPossibleAnswers = numPossibleAnswers;
+    pRec->numMetrics = numMetrics;
+    pRec->numRankRows = rankTop.numTop;
+    pRec->numEntropyRows = entropyTop.numTop;
+    for (long i = 0; i < rankTop.numTop; i++) pRec->rankRows[i] = pMetricsTable[rankTop.topIdx[i]];
+    for (long i = 0; i < entropyTop.numTop; i++) pRec->entropyRows[i] = pMetricsTable[entropyTop.topIdx[i]];
+
+    make_pick_metric(rankPicks.word, rankPicks.pMetric, &pRec->rankPick);
+    make_pick_metric(rankPicks.alternate_word, rankPicks.pAlternateMetric, &pRec->rankAlternate);
+    make_pick_metric(entropyPicks.word, entropyPicks.pMetric, &pRec->entropyPick);
+    make_pick_metric(entropyPicks.alternate_word, entropyPicks.pAlternateMetric, &pRec->entropyAlternate);
+
+    // 4. Determine the final top pick based on the dynamic H/R trade-off
+    determine_final_pick(pMetricsTable + rankTop.topIdx[0], numPossibleAnswers, &rankPicks, &entropyPicks, &g_options.pickPolicy, &pRec->finalPick);
+}
+
+/**
+ * @brief Runs the metric calculation, top-K selection, linguistic filtering and final pick for a single turn,
+ * without printing anything.
+ * @param pPossibleAnswers Array of pointers to remaining possible answers.
+ * @param numPossibleAnswers The number of words remaining (must be > 0).
+ * @param pGood The string of required letters (for repeat risk check).
+ * @param pMetricsTable The pre-allocated array for metric storage.
+ * @param pHistograms The game's pattern histograms, or NULL (see calculate_all_metrics).
+ * @param pRec Output: the top rows, picks and final pick.
+ * @return bool True on success, false if there are no answers or memory ran out.
+ */
+bool compute_recommendation(const char** pPossibleAnswers, long numPossibleAnswers, char* pGood, PGUESS_METRICS pMetricsTable, PPATTERN_HISTOGRAMS pHistograms, PRECOMMENDATION pRec)
+{
+    if (numPossibleAnswers == 0) return false;
+
+    // A variant dictionary is scored by the word kernels its header selected
+    if (g_variantDictionary.pKernels != NULL) return compute_variant_recommendation(pPossibleAnswers, numPossibleAnswers, pGood, pMetricsTable, pRec);
+
+    // 1. Calculate all metrics (H, R, Linguistic, Risk) for the current possible answers
+    //    (plus every other dictionary word in full-dictionary mode)
+    long numMetrics = calculate_all_metrics(pPossibleAnswers, numPossibleAnswers, pGood, pMetricsTable, numWordsInDictionary, pHistograms);
+    if (numMetrics == 0) return false;
+
+    STAT_TIMER timer;
+    stats_start(&timer);
+
+    if (g_options.priorWeighted)
+    {
+        select_weighted_recommendation(pMetricsTable, numPossibleAnswers, numMetrics, pRec);
+        stats_stop(&timer, STAT_STAGE_SELECT);
+        if (g_options.stats) stats_count(STAT_DISTINCT_PATTERNS, count_distinct_patterns(pRec->finalPick.word, pPossibleAnswers, numPossibleAnswers));
+        apply_lookahead(pPossibleAnswers, numPossibleAnswers, pRec);
+        return true;
+    }
+
+    // 2. Select the top rows, the picks of both paths and the final pick
+    select_recommendation(pMetricsTable, numPossibleAnswers, numMetrics, pRec);
+    stats_stop(&timer, STAT_STAGE_SELECT);
+    if (g_options.stats) stats_count(STAT_DISTINCT_PATTERNS, count_distinct_patterns(pRec->finalPick.word, pPossibleAnswers, numPossibleAnswers));
+
+    // 3. Optionally reconsider the final pick by expected guesses to solve
+    apply_lookahead(pPossibleAnswers, numPossibleAnswers, pRec);
+    return true;
+}
+
+/**
+ * @brief Prints a recommendation in the --output mode: the two-column table followed by the final
+ * pick banner, one compact JSON line, or nothing. The text is rendered into one buffer and written
+ * in a single write to g_fpRecommendations (stdout if not set).
+ * @param pRec The recommendation to print.
+ */
+void print_recommendation(const RECOMMENDATION* pRec)
+{
+    if (g_options.outputMode == OUTPUT_SILENT) return;
+
+    STAT_TIMER timer;
+    stats_start(&timer);
+    OUTPUT_BUFFER output;
+    init_output_buffer(&output);
+    if (g_options.outputMode == OUTPUT_COMPACT)
+    {
+        render_compact_recommendation(pRec, &output);
+    }
+    else
+    {
+        render_recommendation_table(pRec, &output);
+        render_final_pick(&pRec->finalPick, &output);
+    }
+    flush_output_buffer(&output, (g_fpRecommendations != NULL) ? g_fpRecommendations : stdout);
+    stats_stop(&timer, STAT_STAGE_PRINT);
+}
+
+/**
+ * @brief Counts the distinct feedback patterns a guess produces over the possible answers.
+ * @return long The number of distinct patterns (0 if the guess is not a dictionary word).
+ */
+long count_distinct_patterns(const char* guess, const char** pPossibleAnswers, long numPossibleAnswers)
+{
+    bool seen[NUM_PATTERNS] = { false };
+    long numDistinct = 0;
+
+    WORD_ID guessId = get_word_id(guess);
+    if (guessId == INVALID_WORD_ID) return 0;
+
+    for (long i = 0; i < numPossibleAnswers; i++)
+    {
+        WORD_ID answerId = get_word_id(pPossibleAnswers[i]);
+        if (answerId == INVALID_WORD_ID) continue;
+        PATTERN_CODE code = get_feedback_pattern_code_ids(guessId, answerId);
+        if (!seen[code])
+        {
+            seen[code] = true;
+            numDistinct++;
+        }
+    }
+    return numDistinct;
+}
+
+/**
+ * @brief Coordinates the metric calculation, sorting, filtering, and printing for a single turn.
+ * @param pPossibleAnswers Array of pointers to remaining possible answers.
+ * @param numPossibleAnswers The number of words remaining.
+ * @param pGood The string of required letters (for repeat risk check).
+ * @param pMetricsTable The pre-allocated array for metric storage.
+ * @param pHistograms The game's pattern histograms, or NULL (see calculate_all_metrics).
+ */
+void analyze_and_print_recommendations(const char** pPossibleAnswers, long numPossibleAnswers, char* pGood, PGUESS_METRICS pMetricsTable, PPATTERN_HISTOGRAMS pHistograms)
+{
+    RECOMMENDATION rec;
+
+    if (compute_recommendation(pPossibleAnswers, numPossibleAnswers, pGood, pMetricsTable, pHistograms, &rec))
+    {
+        print_recommendation(&rec);
+    }
+}
+
+
+// --- Lookahead Search ---
+
+/**
+ * @brief Allocates the shared transposition table used by every lookahead search.
+ * @return bool True on success.
+ */
+bool init_lookahead_table()
+{
+    if (g_pLookaheadTable != NULL) return true;
+    try
+    {
+        g_pLookaheadTable = new LOOKAHEAD_SHARD[LOOKAHEAD_TT_SHARDS]();
+    }
+    catch (...)
+    {
+        fprintf(stderr, "Out of memory for the lookahead table!\n");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Releases the transposition table.
+ */
+void free_lookahead_table()
+{
+    delete[] g_pLookaheadTable;
+    g_pLookaheadTable = NULL;
+}
+
+/**
+ * @brief Estimated guesses to solve an unsearched set of n answers (including the solving guess):
+ * exact for one or two answers, otherwise 2 - 1/n (guessing an answer) plus a cost per remaining bit.
+ */
+static double estimate_expected_guesses(long n)
+{
+    if (n <= 1) return 1.0;
+    if (n == 2) return 1.5;
+    return 2.0 - 1.0 / n + LOOKAHEAD_LEAF_GUESSES_PER_BIT * log2(n / 2.0);
+}
+
+/**
+ * @brief Looks up a searched set. The key is a hash of the sorted answer IDs; the size and depth
+ * are compared as well so a hash collision between different-sized sets cannot match.
+ */
+static bool lookup_lookahead_entry(unsigned long long key, long numAnswers, int plies, double* pExpected, long* pNumNodes)
+{
+    PLOOKAHEAD_SHARD pShard = g_pLookaheadTable + (key % LOOKAHEAD_TT_SHARDS);
+    const LOOKAHEAD_ENTRY* pEntry = pShard->entries + ((key / LOOKAHEAD_TT_SHARDS) % LOOKAHEAD_TT_SHARD_SLOTS);
+
+    std::lock_guard<std::mutex> guard(pShard->lock);
+    if (pEntry->key != key || pEntry->numAnswers != numAnswers || pEntry->plies != plies) return false;
+    *pExpected = pEntry->expected;
+    *pNumNodes = pEntry->numNodes;
+    return true;
+}
+
+/**
+ * @brief Stores a fully searched set (always replacing whatever held the slot).
+ */
+static void store_lookahead_entry(unsigned long long key, long numAnswers, int plies, double expected, long numNodes)
+{
+    PLOOKAHEAD_SHARD pShard = g_pLookaheadTable + (key % LOOKAHEAD_TT_SHARDS);
+    PLOOKAHEAD_ENTRY pEntry = pShard->entries + ((key / LOOKAHEAD_TT_SHARDS) % LOOKAHEAD_TT_SHARD_SLOTS);
+
+    std::lock_guard<std::mutex> guard(pShard->lock);
+    pEntry->key = key;
+    pEntry->numAnswers = numAnswers;
+    pEntry->plies = plies;
+    pEntry->expected = expected;
+    pEntry->numNodes = numNodes;
+}
+
+/**
+ * @brief Splits sorted answer IDs by the pattern a guess gives (stable, so every bucket stays sorted).
+ * @param pStarts Output: bucket k is pOut[pStarts[k], pStarts[k + 1]) (NUM_PATTERNS + 1 entries).
+ */
+static void partition_by_pattern(WORD_ID guessId, const WORD_ID* pIds, long n, WORD_ID* pOut, long* pStarts)
+{
+    long counts[NUM_PATTERNS] = { 0 };
+    long next[NUM_PATTERNS];
+
+    for (long i = 0; i < n; i++) counts[get_feedback_pattern_code_ids(guessId, pIds[i])]++;
+
+    pStarts[0] = 0;
+    for (int k = 0; k < NUM_PATTERNS; k++)
+    {
+        next[k] = pStarts[k];
+        pStarts[k + 1] = pStarts[k] + counts[k];
+    }
+    for (long i = 0; i < n; i++) pOut[next[get_feedback_pattern_code_ids(guessId, pIds[i])]++] = pIds[i];
+    stats_count(STAT_PATTERN_EVALUATIONS, 2 * n);
+}
+
+/**
+ * @brief Picks the (up to) LOOKAHEAD_WIDTH answers with the highest entropy against the set,
+ * lower word ID first on ties.
+ * @return long The number of candidates written.
+ */
+static long select_lookahead_candidates(const WORD_ID* pIds, long n, WORD_ID* pCandidates)
+{
+    double entropies[LOOKAHEAD_WIDTH];
+    long numCandidates = 0;
+
+    for (long i = 0; i < n; i++)
+    {
+        double entropy = calculate_entropy_score_ids(pIds[i], pIds, n);
+        if (numCandidates == LOOKAHEAD_WIDTH && !(entropy > entropies[numCandidates - 1])) continue;
+
+        long pos = (numCandidates < LOOKAHEAD_WIDTH) ? numCandidates++ : numCandidates - 1;
+        while (pos > 0 && entropy > entropies[pos - 1])
+        {
+            entropies[pos] = entropies[pos - 1];
+            pCandidates[pos] = pCandidates[pos - 1];
+            pos--;
+        }
+        entropies[pos] = entropy;
+        pCandidates[pos] = pIds[i];
+    }
+    return numCandidates;
+}
+
+/**
+ * @brief Expectimax over a set of possible answers: the expected number of guesses (including the
+ * solving one) when each turn plays the best of the set's top-entropy answers.
+ * E(S) = min over g of 1 + sum over patterns p != all green of |S_p| / |S| * E(S_p).
+ * At depth 0, or once the node budget is used up, the set is estimated instead of searched.
+ * @param pSearch The search state.
+ * @param pIds The answer IDs, sorted.
+ * @param n The number of answers.
+ * @param plies Guesses left to search.
+ * @param pExact In/out: cleared if any part of the value came from an exhausted budget.
+ * @return double The expected number of guesses.
+ */
+static double search_expected_guesses(PLOOKAHEAD_SEARCH pSearch, const WORD_ID* pIds, long n, int plies, bool* pExact)
+{
+    if (n <= 2 || plies == 0) return estimate_expected_guesses(n);
+    if (pSearch->numNodes >= pSearch->nodeBudget)
+    {
+        *pExact = false;
+        return estimate_expected_guesses(n);
+    }
+
+    // A stored set is used only if searching it again would have fit the budget, and is charged its nodes
+    unsigned long long key = fnv1a_hash(FNV_OFFSET_BASIS, pIds, n * sizeof(WORD_ID));
+    double best;
+    long numNodes;
+    if (lookup_lookahead_entry(key, n, plies, &best, &numNodes) && pSearch->numNodes + numNodes <= pSearch->nodeBudget)
+    {
+        pSearch->numNodes += numNodes;
+        return best;
+    }
+
+    long firstNode = pSearch->numNodes++;
+
+    WORD_ID candidates[LOOKAHEAD_WIDTH];
+    long starts[NUM_PATTERNS + 1];
+    PSCRATCH_ARENA pArena = get_scratch_arena();
+    size_t mark = scratch_mark(pArena);
+    WORD_ID* pPartition = (WORD_ID*)scratch_alloc(pArena, n * sizeof(WORD_ID));
+    if (pPartition == NULL)
+    {
+        *pExact = false;
+        scratch_release(pArena, mark);
+        return estimate_expected_guesses(n);
+    }
+
+    long numCandidates = select_lookahead_candidates(pIds, n, candidates);
+    bool exact = true;
+    best = DBL_MAX;
+
+    for (long c = 0; c < numCandidates; c++)
+    {
+        partition_by_pattern(candidates[c], pIds, n, pPartition, starts);
+
+        double cost = 1.0;
+        for (int k = 0; k < PATTERN_ALL_GREEN && cost < best; k++)
+        {
+            long size = starts[k + 1] - starts[k];
+            if (size > 0) cost += (double)size / n * search_expected_guesses(pSearch, pPartition + starts[k], size, plies - 1, &exact);
+        }
+        if (cost < best) best = cost;
+    }
+
+    scratch_release(pArena, mark);
+    if (exact) store_lookahead_entry(key, n, plies, best, pSearch->numNodes - firstNode);
+    else *pExact = false;
+    return best;
+}
+
+/**
+ * @brief Shared inputs of one root candidate's bucket evaluations, handed to each worker.
+ */
+typedef struct _lookahead_bucket_job
+{
+    const WORD_ID* pPartition;
+    const long* pStarts;
+    const int* pBuckets;  // Non-empty, non-green pattern codes
+    double* pExpected;    // Output per bucket
+    bool* pExact;         // Output per bucket
+    long* pNumNodes;      // Output per bucket
+    long numAnswers;      // Answers over all buckets
+    long nodeBudget;      // Nodes for the candidate, shared out by bucket size
+    int plies;
+} LOOKAHEAD_BUCKET_JOB, * PLOOKAHEAD_BUCKET_JOB;
+
+/**
+ * @brief parallel_for callback: searches the buckets [begin, end) of a root candidate, each with
+ * its share of the candidate's node budget.
+ */
+static void search_lookahead_buckets(long begin, long end, int, void* pContext)
+{
+    PLOOKAHEAD_BUCKET_JOB pJob = (PLOOKAHEAD_BUCKET_JOB)pContext;
+
+    for (long b = begin; b < end; b++)
+    {
+        int k = pJob->pBuckets[b];
+        long size = pJob->pStarts[k + 1] - pJob->pStarts[k];
+        LOOKAHEAD_SEARCH search = { 0, (long)((double)pJob->nodeBudget * size / pJob->numAnswers) + 1 };
+        pJob->pExact[b] = true;
+        pJob->pExpected[b] = search_expected_guesses(&search, pJob->pPartition + pJob->pStarts[k], size, pJob->plies, pJob->pExact + b);
+        pJob->pNumNodes[b] = search.numNodes;
+    }
+}
+
+/**
+ * @brief Replaces the final pick with the candidate that minimizes the expected number of guesses,
+ * searching g_options.lookaheadPlies guesses ahead over the final pick and the top entropy rows.
+ * Each candidate gets an equal share of LOOKAHEAD_NODE_BUDGET and its pattern buckets are searched
+ * in parallel, so the pick is the same on any machine and load. Sets above LOOKAHEAD_MAX_ANSWERS
+ * keep the one-ply pick; ties keep the earlier candidate, so the one-ply pick wins unless beaten.
+ * @param pPossibleAnswers The current possible answers.
+ * @param numPossibleAnswers The number of possible answers.
+ * @param pRec In/out: the recommendation whose final pick is reconsidered.
+ */
+void apply_lookahead(const char** pPossibleAnswers, long numPossibleAnswers, PRECOMMENDATION pRec)
+{
+    if (g_options.lookaheadPlies <= 0 || numPossibleAnswers <= 2 || numPossibleAnswers > LOOKAHEAD_MAX_ANSWERS) return;
+    if (g_pLookaheadTable == NULL) return;
+
+    const GUESS_METRICS* candidates[LOOKAHEAD_WIDTH];
+    long numCandidates = 0;
+
+    candidates[numCandidates++] = &pRec->finalPick;
+    for (long i = 0; i < pRec->numEntropyRows && numCandidates < LOOKAHEAD_WIDTH; i++)
+    {
+        const GUESS_METRICS* pRow = pRec->entropyRows + i;
+        if (pRow->entropy != PRUNED_ENTROPY && strncmp(pRow->word, pRec->finalPick.word, WORD_SIZE) != 0) candidates[numCandidates++] = pRow;
+    }
+
+    STAT_TIMER timer;
+    stats_start(&timer);
+
+    PSCRATCH_ARENA pArena = get_scratch_arena();
+    size_t mark = scratch_mark(pArena);
+    WORD_ID* pIds = (WORD_ID*)scratch_alloc(pArena, numPossibleAnswers * sizeof(WORD_ID));
+    WORD_ID* pPartition = (WORD_ID*)scratch_alloc(pArena, numPossibleAnswers * sizeof(WORD_ID));
+    if (pIds == NULL || pPartition == NULL)
+    {
+        scratch_release(pArena, mark);
+        stats_stop(&timer, STAT_STAGE_LOOKAHEAD);
+        return;
+    }
+
+    // Canonical (sorted) ID order, so equal sets hash alike whatever order filtering left them in
+    bool* pIsAnswer = (bool*)scratch_calloc(pArena, numWordsInDictionary, sizeof(bool));
+    long n = 0;
+    if (pIsAnswer != NULL)
+    {
+        for (long i = 0; i < numPossibleAnswers; i++)
+        {
+            WORD_ID id = get_word_id(pPossibleAnswers[i]);
+            if (id != INVALID_WORD_ID) pIsAnswer[id] = true;
+        }
+        for (long idx = 0; idx < numWordsInDictionary; idx++)
+        {
+            if (pIsAnswer[idx]) pIds[n++] = (WORD_ID)idx;
+        }
+    }
+
+    long starts[NUM_PATTERNS + 1];
+    int buckets[NUM_PATTERNS];
+    double expected[NUM_PATTERNS];
+    bool exact[NUM_PATTERNS];
+    long nodes[NUM_PATTERNS];
+    double bestCost = DBL_MAX;
+    long bestIdx = -1;
+    long numNodes = 0;
+    bool budgetReached = false;
+
+    for (long c = 0; c < numCandidates && n == numPossibleAnswers; c++)
+    {
+        WORD_ID guessId = get_word_id(candidates[c]->word);
+        if (guessId == INVALID_WORD_ID) continue;
+
+        partition_by_pattern(guessId, pIds, n, pPartition, starts);
+        long numBuckets = 0;
+        for (int k = 0; k < PATTERN_ALL_GREEN; k++)
+        {
+            if (starts[k + 1] > starts[k]) buckets[numBuckets++] = k;
+        }
+
+        LOOKAHEAD_BUCKET_JOB job = { pPartition, starts, buckets, expected, exact, nodes, n, LOOKAHEAD_NODE_BUDGET / numCandidates, g_options.lookaheadPlies - 1 };
+        parallel_for(numBuckets, 1, search_lookahead_buckets, &job);
+
+        // Summed in bucket order so the cost does not depend on which worker finished first
+        double cost = 1.0;
+        for (long b = 0; b < numBuckets; b++)
+        {
+            cost += (double)(starts[buckets[b] + 1] - starts[buckets[b]]) / n * expected[b];
+            numNodes += nodes[b];
+            if (!exact[b]) budgetReached = true;
+        }
+
+        if (cost < bestCost - EPSILON)
+        {
+            bestCost = cost;
+            bestIdx = c;
+        }
+    }
+
+    if (bestIdx > 0) pRec->finalPick = *candidates[bestIdx];
+    if (bestIdx >= 0)
+    {
+        printfDebug("Lookahead (%d plies, %ld nodes%s): %.5s, %.4f expected guesses.\n", g_options.lookaheadPlies, numNodes,
+            budgetReached ? ", budget reached" : "", pRec->finalPick.word, bestCost);
+    }
+
+    scratch_release(pArena, mark);
+    stats_stop(&timer, STAT_STAGE_LOOKAHEAD);
+}
+
+/**
+ * @brief Builds the candidate filter index over the dictionary (see FILTER_INDEX).
+ * Word indices are the same as get_dictionary_index's.
+ * @param pDictionary The sorted dictionary table.
+ * @param numDictionary The number of dictionary entries.
+ * @return bool True on success; on failure filtering falls back to is_good_fit.
+ */
+bool build_filter_index(PWORD_ENTRY pDictionary, long numDictionary)
+{
+    free_filter_index();
+
+    long numBlocks = (numDictionary + 63) / 64;
+    unsigned long long* pBits = (unsigned long long*)calloc((size_t)FILTER_INDEX_NUM_SETS * numBlocks, sizeof(unsigned long long));
+    if (pBits == NULL)
+    {
+        fprintf(stderr, "Out of memory for the candidate filter index; filtering word by word.\n");
+        return false;
+    }
+
+    g_filterIndex.pBits = pBits;
+    g_filterIndex.numWords = numDictionary;
+    g_filterIndex.numBlocks = numBlocks;
+
+    for (long i = 0; i < numDictionary; i++)
+    {
+        unsigned long long bit = 1ULL << (i % 64);
+        long block = i / 64;
+        int letterCounts[26] = { 0 };
+
+        for (int pos = 0; pos < WORD_SIZE; pos++)
+        {
+            char c = pDictionary[i].word[pos];
+            if (c < 'A' || c > 'Z') continue;
+
+            filter_index_position_set(pos, c - 'A')[block] |= bit;
+            filter_index_min_count_set(c - 'A', letterCounts[c - 'A']++)[block] |= bit;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Releases the candidate filter index.
+ */
+void free_filter_index()
+{
+    if (g_filterIndex.pBits) free(g_filterIndex.pBits);
+    g_filterIndex.pBits = NULL;
+    g_filterIndex.numWords = 0;
+    g_filterIndex.numBlocks = 0;
+}
+
+/**
+ * @brief Computes the set of dictionary words that satisfy the game constraints, with exactly
+ * the rules of is_good_fit, as a bitset of g_filterIndex.numBlocks words.
+ * @param pMask Green letters mask.
+ * @param notMask Positional exclusions (Yellow/Black).
+ * @param pGood Required letters (Min Count).
+ * @param pBad Letters that must be absent.
+ * @param pAllowed Output bitset, bit i set if dictionary word i fits.
+ * @return bool False if a constraint holds a character the index does not cover (not A-Z).
+ */
+static bool build_allowed_bitset(const char* pMask, char notMask[6][5], const char* pGood, const char* pBad, unsigned long long* pAllowed)
+{
+    long numBlocks = g_filterIndex.numBlocks;
+    int requiredCounts[26] = { 0 };
+
+    for (long b = 0; b < numBlocks; b++) pAllowed[b] = ~0ULL;
+
+    // Required letter counts (Yellow and Green): at least N copies of the letter
+    for (const char* p = pGood; *p != '\0'; p++)
+    {
+        if (*p < 'A' || *p > 'Z') return false;
+        requiredCounts[*p - 'A']++;
+    }
+    for (int letter = 0; letter < 26; letter++)
+    {
+        if (requiredCounts[letter] == 0) continue;
+        if (requiredCounts[letter] > WORD_SIZE) { memset(pAllowed, 0, numBlocks * sizeof(unsigned long long)); return true; }
+
+        const unsigned long long* pSet = filter_index_min_count_set(letter, requiredCounts[letter] - 1);
+        for (long b = 0; b < numBlocks; b++) pAllowed[b] &= pSet[b];
+    }
+
+    // Excluded letters (Black): no copy anywhere
+    for (const char* p = pBad; *p != '\0'; p++)
+    {
+        if (*p < 'A' || *p > 'Z') return false;
+
+        const unsigned long long* pSet = filter_index_min_count_set(*p - 'A', 0);
+        for (long b = 0; b < numBlocks; b++) pAllowed[b] &= ~pSet[b];
+    }
+
+    // Positional constraints: the green letter, and none of the letters seen in the wrong spot
+    for (int pos = 0; pos < WORD_SIZE; pos++)
+    {
+        if (pMask[pos] != '*')
+        {
+            if (pMask[pos] < 'A' || pMask[pos] > 'Z') return false;
+
+            const unsigned long long* pSet = filter_index_position_set(pos, pMask[pos] - 'A');
+            for (long b = 0; b < numBlocks; b++) pAllowed[b] &= pSet[b];
+        }
+
+        for (int notIdx = 0; notIdx < 6; notIdx++)
+        {
+            char c = notMask[notIdx][pos];
+            if (c == '*') continue;
+            if (c < 'A' || c > 'Z') return false;
+
+            const unsigned long long* pSet = filter_index_position_set(pos, c - 'A');
+            for (long b = 0; b < numBlocks; b++) pAllowed[b] &= ~pSet[b];
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Filters the list of possible answers based on the latest game constraints.
+ * This function updates the array of possible answers in place by moving valid pointers
+ * to the beginning of the array (their order is preserved).
+ * Dictionary words are tested against a bitset built from the filter index; any other word
+ * (or a constraint the index cannot express) falls back to is_good_fit.
+ * @param pPossibleAnswers Array of pointers to remaining possible answers.
+ * @param numCurrentAnswers The current count of answers.
+ * @param pMask Green letters mask.
+ * @param notMask Positional exclusions (Yellow/Black).
+ * @param pGood Required letters (Min Count).
+ * @param pBad Letters that must be absent.
+ * The last parameter, the attempt number, is unused and kept for the callers.
+ * @return long The new count of possible answers.
+ */
+long filter_possible_answers(const char** pPossibleAnswers, long numCurrentAnswers, char* pMask, char notMask[6][5], char* pGood, char* pBad, long)
+{
+    long numNewAnswers = 0;
+    unsigned long long* pAllowed = NULL;
+    PSCRATCH_ARENA pArena = get_scratch_arena();
+    size_t mark = scratch_mark(pArena);
+
+    // The index only covers the dictionary that word indices refer to
+    if (g_filterIndex.pBits != NULL && g_filterIndex.numWords == numWordsInDictionary)
+    {
+        pAllowed = (unsigned long long*)scratch_alloc(pArena, g_filterIndex.numBlocks * sizeof(unsigned long long));
+        if (pAllowed != NULL && !build_allowed_bitset(pMask, notMask, pGood, pBad, pAllowed)) pAllowed = NULL;
+    }
+
+    for (long i = 0; i < numCurrentAnswers; i++)
+    {
+        char* pWord = (char*)pPossibleAnswers[i];
+        long wordIdx = (pAllowed != NULL) ? get_dictionary_index(pWord) : -1;
+        bool fits = (wordIdx >= 0) ? ((pAllowed[wordIdx / 64] >> (wordIdx % 64)) & 1) != 0
+                                   : (is_good_fit(pMask, notMask, pGood, pBad, pWord) != 0);
+        if (fits)
+        {
+            // Keep the pointer by moving it to the front of the array
+            pPossibleAnswers[numNewAnswers++] = pWord;
+        }
+    }
+
+    scratch_release(pArena, mark);
+    return numNewAnswers;
+}
+
+/**
+ * @brief Narrows the possible answers to those that would give exactly the observed feedback
+ * for the guess, using the pattern matrix row when available. This is stricter than the
+ * constraint filter, which cannot express e.g. "exactly one E" after a gray duplicate.
+ * The array is compacted in place, order preserved.
+ * @param guess The word that was guessed.
+ * @param code The observed feedback pattern.
+ * @param pPossibleAnswers Array of pointers to remaining possible answers.
+ * @param numCurrentAnswers The current count of answers.
+ * @return long The new count of possible answers.
+ */
+long filter_possible_answers_by_pattern(const char* guess, PATTERN_CODE code, const char** pPossibleAnswers, long numCurrentAnswers)
+{
+    long numNewAnswers = 0;
+    char upperGuess[WORD_SIZE + 1];
+
+    // Typed guesses may be lower case; dictionary words are upper case
+    for (int i = 0; i < WORD_SIZE; i++) upperGuess[i] = toupper((unsigned char)guess[i]);
+    upperGuess[WORD_SIZE] = '\0';
+
+    long guessIdx = get_dictionary_index(guess);
+    const PATTERN_CODE* pRow = (g_patternMatrix.pCodes != NULL && guessIdx >= 0) ? g_patternMatrix.pCodes + guessIdx * g_patternMatrix.numWords : NULL;
+
+    for (long i = 0; i < numCurrentAnswers; i++)
+    {
+        const char* pWord = pPossibleAnswers[i];
+        long answerIdx = (pRow != NULL) ? get_dictionary_index(pWord) : -1;
+        PATTERN_CODE answerCode = (answerIdx >= 0) ? pRow[answerIdx] : get_feedback_pattern_code(upperGuess, pWord);
+
+        if (answerCode == code) pPossibleAnswers[numNewAnswers++] = pWord;
+    }
+
+    return numNewAnswers;
+}
+
+/**
+ * @brief Filters the possible answers after a guess whose feedback is already applied to the
+ * game constraints, additionally narrowing them by exact pattern when g_options.exactFilter is set.
+ * @param guess The word that was guessed.
+ * @param result_pattern The 5-char feedback (B, G, Y).
+ * @param pPossibleAnswers Array of pointers to remaining possible answers (compacted in place).
+ * @param numCurrentAnswers The current count of answers.
+ * @param pMask Green letters mask.
+ * @param notMask Positional exclusions (Yellow/Black).
+ * @param pGood Required letters (Min Count).
+ * @param pBad Letters that must be absent.
+ * @param tryIdx The current turn number.
+ * @return long The new count of possible answers.
+ */
+long filter_possible_answers_after_guess(const char* guess, const char* result_pattern, const char** pPossibleAnswers, long numCurrentAnswers, char* pMask, char notMask[6][5], char* pGood, char* pBad, int tryIdx)
+{
+    STAT_TIMER timer;
+    stats_start(&timer);
+
+    long numNewAnswers = filter_possible_answers(pPossibleAnswers, numCurrentAnswers, pMask, notMask, pGood, pBad, tryIdx);
+
+    if (g_options.exactFilter)
+    {
+        numNewAnswers = filter_possible_answers_by_pattern(guess, encode_feedback_pattern(result_pattern), pPossibleAnswers, numNewAnswers);
+    }
+    stats_stop(&timer, STAT_STAGE_FILTER);
+    return numNewAnswers;
+}
+
+/**
+ * @brief Resets the game constraint buffers to the start-of-game state (nothing known).
+ * @param pMask Green letter mask (WORD_SIZE + 1 chars), set to "*****".
+ * @param notMask Positional exclusions, every row set to "*****".
+ * @param pGood Required letters (WORD_SIZE + 1 chars), emptied.
+ * @param pBad Excluded letters (26 chars), emptied.
+ */
+void init_game_constraints(char* pMask, char notMask[6][5], char* pGood, char* pBad)
+{
+    memset(pMask, '*', WORD_SIZE);
+    pMask[WORD_SIZE] = '\0'; // Green mask initialized to *****
+    memset(pGood, 0, WORD_SIZE + 1); // Required letters initialized empty
+    memset(pBad, 0, 26); // Excluded letters initialized empty
+    for (int idx = 0; idx < 6; idx++)
+    {
+        memcpy(notMask[idx], pMask, WORD_SIZE); // Positional exclusions initialized to *
+    }
+}
+
+// --- Opening Cache ---
+
+/**
+ * @brief Folds a block of bytes into a 64-bit FNV-1a hash.
+ * @param hash The running hash (start with FNV_OFFSET_BASIS).
+ * @param pData The bytes to add.
+ * @param size The number of bytes.
+ * @return unsigned long long The updated hash.
+ */
+unsigned long long fnv1a_hash(unsigned long long hash, const void* pData, size_t size)
+{
+    const unsigned char* pBytes = (const unsigned char*)pData;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= pBytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @brief Computes the key of the opening cache: a hash of the dictionary contents, the set of
+ * possible answers (i.e. the effect of the used-word list) and every setting that changes the analysis.
+ * @param pDictionary The sorted dictionary table.
+ * @param numDictionary The number of dictionary entries.
+ * @param pPossibleAnswers The turn-1 possible answers.
+ * @param numPossibleAnswers The number of possible answers.
+ * @return unsigned long long The fingerprint.
+ */
+unsigned long long compute_opening_fingerprint(PWORD_ENTRY pDictionary, long numDictionary, const char** pPossibleAnswers, long numPossibleAnswers)
+{
+    unsigned long long hash = FNV_OFFSET_BASIS;
+    int version = OPENING_CACHE_VERSION;
+    int wordSize = WORD_SIZE;
+
+    hash = fnv1a_hash(hash, &version, sizeof(version));
+    hash = fnv1a_hash(hash, &wordSize, sizeof(wordSize));
+
+    // Dictionary: words and the static metrics the analysis uses
+    for (long i = 0; i < numDictionary; i++)
+    {
+        hash = fnv1a_hash(hash, pDictionary[i].word, WORD_SIZE);
+        hash = fnv1a_hash(hash, &pDictionary[i].rank, sizeof(pDictionary[i].rank));
+        hash = fnv1a_hash(hash, &pDictionary[i].nounType, 1);
+        hash = fnv1a_hash(hash, &pDictionary[i].verbType, 1);
+    }
+
+    // Answer set: dictionary minus the used words
+    hash = fnv1a_hash(hash, &numPossibleAnswers, sizeof(numPossibleAnswers));
+    for (long i = 0; i < numPossibleAnswers; i++)
+    {
+        int idx = (int)get_dictionary_index(pPossibleAnswers[i]);
+        hash = fnv1a_hash(hash, &idx, sizeof(idx));
+    }
+
+    // Settings that change the metrics or the final pick
+    int fullDictionary = g_options.scoreFullDictionary ? 1 : 0;
+    int lowAnswerCount = g_options.pickPolicy.lowAnswerCount;
+    int maxTopPicks = MAX_TOP_PICKS;
+    double entropyRankThreshold = g_options.pickPolicy.entropyRankThreshold;
+    int exactFilter = g_options.exactFilter ? 1 : 0;
+    hash = fnv1a_hash(hash, &fullDictionary, sizeof(fullDictionary));
+    hash = fnv1a_hash(hash, &exactFilter, sizeof(exactFilter));
+    hash = fnv1a_hash(hash, &lowAnswerCount, sizeof(lowAnswerCount));
+    hash = fnv1a_hash(hash, &maxTopPicks, sizeof(maxTopPicks));
+    hash = fnv1a_hash(hash, &entropyRankThreshold, sizeof(entropyRankThreshold));
+
+    int lookahead[3] = { g_options.lookaheadPlies, LOOKAHEAD_WIDTH, LOOKAHEAD_NODE_BUDGET };
+    hash = fnv1a_hash(hash, lookahead, sizeof(lookahead));
+
+    long long sampleSize = g_options.sampleSize;
+    hash = fnv1a_hash(hash, &sampleSize, sizeof(sampleSize));
+
+    double prior[3] = { g_options.priorWeighted ? 1.0 : 0.0, PRIOR_RANK_MIDPOINT, PRIOR_RANK_SCALE };
+    hash = fnv1a_hash(hash, prior, sizeof(prior));
+
+    return hash;
+}
+
+/**
+ * @brief Converts a metric into its on-disk form (word pointer replaced by its dictionary index).
+ */
+static void pack_cached_metric(const GUESS_METRICS* pMetric, CACHED_METRIC* pCached)
+{
+    memset(pCached, 0, sizeof(CACHED_METRIC));
+    pCached->wordIndex = (int)get_dictionary_index(pMetric->word);
+    pCached->rank = pMetric->rank;
+    pCached->entropy = pMetric->entropy;
+    pCached->remainingMass = pMetric->remainingMass;
+    pCached->isRisky = pMetric->is_risky ? 1 : 0;
+    pCached->nounType = pMetric->nounType;
+    pCached->verbType = pMetric->verbType;
+}
+
+/**
+ * @brief Converts an on-disk metric back into a metric pointing into the dictionary.
+ * @return bool False if the word index is out of range.
+ */
+static bool unpack_cached_metric(const CACHED_METRIC* pCached, PWORD_ENTRY pDictionary, long numDictionary, PGUESS_METRICS pMetric)
+{
+    if (pCached->wordIndex >= numDictionary || pCached->wordIndex < -1) return false;
+
+    pMetric->word = (pCached->wordIndex >= 0) ? pDictionary[pCached->wordIndex].word : "NONE";
+    pMetric->rank = pCached->rank;
+    pMetric->entropy = pCached->entropy;
+    pMetric->remainingMass = pCached->remainingMass;
+    pMetric->is_risky = (pCached->isRisky != 0);
+    pMetric->nounType = pCached->nounType;
+    pMetric->verbType = pCached->verbType;
+    return true;
+}
+
+/**
+ * @brief Converts a recommendation into its on-disk form.
+ * @param pRec The recommendation.
+ * @param pCached Output record.
+ */
+void pack_cached_recommendation(const RECOMMENDATION* pRec, CACHED_RECOMMENDATION* pCached)
+{
+    memset(pCached, 0, sizeof(CACHED_RECOMMENDATION));
+    pCached->numPossibleAnswers = (int)pRec->numPossibleAnswers;
+    pCached->numMetrics = (int)pRec->numMetrics;
+    pCached->numRankRows = (int)pRec->numRankRows;
+    pCached->numEntropyRows = (int)pRec->numEntropyRows;
+
+    for (long i = 0; i < pRec->numRankRows; i++) pack_cached_metric(pRec->rankRows + i, pCached->rankRows + i);
+    for (long i = 0; i < pRec->numEntropyRows; i++) pack_cached_metric(pRec->entropyRows + i, pCached->entropyRows + i);
+
+    pack_cached_metric(&pRec->rankPick, pCached->picks + 0);
+    pack_cached_metric(&pRec->rankAlternate, pCached->picks + 1);
+    pack_cached_metric(&pRec->entropyPick, pCached->picks + 2);
+    pack_cached_metric(&pRec->entropyAlternate, pCached->picks + 3);
+    pack_cached_metric(&pRec->finalPick, pCached->picks + 4);
+}
+
+/**
+ * @brief Converts an on-disk record back into a printable recommendation.
+ * @param pCached The record.
+ * @param pDictionary The dictionary the record's word indices refer to.
+ * @param numDictionary The number of dictionary entries.
+ * @param pRec Output recommendation.
+ * @return bool False if the record is empty or inconsistent.
+ */
+bool unpack_cached_recommendation(const CACHED_RECOMMENDATION* pCached, PWORD_ENTRY pDictionary, long numDictionary, PRECOMMENDATION pRec)
+{
+    if (pCached->numPossibleAnswers <= 0 ||
+        pCached->numRankRows < 0 || pCached->numRankRows > MAX_TOP_PICKS ||
+        pCached->numEntropyRows < 0 || pCached->numEntropyRows > MAX_TOP_PICKS) return false;
+
+    pRec->numPossibleAnswers = pCached->numPossibleAnswers;
+    pRec->numMetrics = pCached->numMetrics;
+    pRec->numRankRows = pCached->numRankRows;
+    pRec->numEntropyRows = pCached->numEntropyRows;
+
+    bool ok = true;
+    for (long i = 0; i < pRec->numRankRows; i++) ok = ok && unpack_cached_metric(pCached->rankRows + i, pDictionary, numDictionary, pRec->rankRows + i);
+    for (long i = 0; i < pRec->numEntropyRows; i++) ok = ok && unpack_cached_metric(pCached->entropyRows + i, pDictionary, numDictionary, pRec->entropyRows + i);
+
+    ok = ok && unpack_cached_metric(pCached->picks + 0, pDictionary, numDictionary, &pRec->rankPick);
+    ok = ok && unpack_cached_metric(pCached->picks + 1, pDictionary, numDictionary, &pRec->rankAlternate);
+    ok = ok && unpack_cached_metric(pCached->picks + 2, pDictionary, numDictionary, &pRec->entropyPick);
+    ok = ok && unpack_cached_metric(pCached->picks + 3, pDictionary, numDictionary, &pRec->entropyAlternate);
+    ok = ok && unpack_cached_metric(pCached->picks + 4, pDictionary, numDictionary, &pRec->finalPick);
+    return ok;
+}
+
+/**
+ * @brief Fills an opening cache: the turn-1 recommendation plus the turn-2 recommendation for
+ * every feedback pattern the turn-1 final pick can produce. Each reply is computed exactly the way
+ * the interactive loop would (constraint update, filter, full analysis).
+ * @param pPossibleAnswers The turn-1 possible answers (left unchanged).
+ * @param numPossibleAnswers The number of possible answers.
+ * @param pMetricsTable Metric work buffer (numWordsInDictionary entries; contents are overwritten).
+ * @param pOpening The turn-1 recommendation.
+ * @param fingerprint The cache key (see compute_opening_fingerprint).
+ * @param pCache Output cache.
+ * @return bool True on success, false on memory allocation failure.
+ */
+bool build_opening_cache(const char** pPossibleAnswers, long numPossibleAnswers, PGUESS_METRICS pMetricsTable, const RECOMMENDATION* pOpening, unsigned long long fingerprint, POPENING_CACHE pCache)
+{
+    memset(pCache, 0, sizeof(OPENING_CACHE));
+    memcpy(pCache->header.magic, OPENING_CACHE_MAGIC, sizeof(pCache->header.magic));
+    pCache->header.version = OPENING_CACHE_VERSION;
+    pCache->header.fingerprint = fingerprint;
+    pCache->header.numReplies = NUM_PATTERNS;
+    pCache->header.openerIndex = (int)get_dictionary_index(pOpening->finalPick.word);
+    pack_cached_recommendation(pOpening, &pCache->opening);
+
+    if (pCache->header.openerIndex < 0) return true; // No opener, so no replies
+
+    PSCRATCH_ARENA pArena = get_scratch_arena();
+    size_t mark = scratch_mark(pArena);
+    const char** pReplyAnswers = (const char**)scratch_alloc(pArena, numPossibleAnswers * sizeof(char*));
+    if (pReplyAnswers == NULL)
+    {
+        fprintf(stderr, "Out of memory building opening cache!\n");
+        scratch_release(pArena, mark);
+        return false;
+    }
+
+    const char* opener = pOpening->finalPick.word;
+    for (int code = 0; code < NUM_PATTERNS; code++)
+    {
+        char pattern[WORD_SIZE + 1];
+        char mask[WORD_SIZE + 1];
+        char good[WORD_SIZE + 1];
+        char bad[26];
+        char notMask[6][WORD_SIZE];
+        RECOMMENDATION reply;
+
+        // A solved game needs no reply
+        if (code == PATTERN_ALL_GREEN) continue;
+
+        decode_feedback_pattern((PATTERN_CODE)code, pattern);
+        init_game_constraints(mask, notMask, good, bad);
+        update_game_constraints(opener, pattern, mask, notMask, good, bad, 1);
+
+        memcpy((void*)pReplyAnswers, pPossibleAnswers, numPossibleAnswers * sizeof(char*));
+        long numReplyAnswers = filter_possible_answers_after_guess(opener, pattern, pReplyAnswers, numPossibleAnswers, mask, notMask, good, bad, 1);
+
+        if (numReplyAnswers > 0 && compute_recommendation(pReplyAnswers, numReplyAnswers, good, pMetricsTable, NULL, &reply))
+        {
+            pack_cached_recommendation(&reply, pCache->replies + code);
+        }
+    }
+
+    scratch_release(pArena, mark);
+    return true;
+}
+
+/**
+ * @brief Loads an opening cache file if it exists and matches the current inputs.
+ * @param pszPath The cache file path.
+ * @param fingerprint The expected key (see compute_opening_fingerprint).
+ * @param pCache Output cache.
+ * @return bool True if a valid cache for this fingerprint was loaded.
+ */
+bool load_opening_cache(const char* pszPath, unsigned long long fingerprint, POPENING_CACHE pCache)
+{
+    FILE* fpIn;
+    errno_t errval = fopen_s(&fpIn, pszPath, "rb");
+    if (fpIn == NULL || errval != 0) return false;
+
+    size_t numRead = fread(pCache, sizeof(OPENING_CACHE), 1, fpIn);
+    bool atEnd = (fgetc(fpIn) == EOF);
+    fclose(fpIn);
+
+    return (numRead == 1 && atEnd &&
+        memcmp(pCache->header.magic, OPENING_CACHE_MAGIC, sizeof(pCache->header.magic)) == 0 &&
+        pCache->header.version == OPENING_CACHE_VERSION &&
+        pCache->header.numReplies == NUM_PATTERNS &&
+        pCache->header.fingerprint == fingerprint);
+}
+
+/**
+ * @brief Writes an opening cache file.
+ * @param pszPath The cache file path.
+ * @param pCache The cache to write.
+ * @return bool True on success.
+ */
+bool save_opening_cache(const char* pszPath, const OPENING_CACHE* pCache)
+{
+    FILE* fpOut;
+    errno_t errval = fopen_s(&fpOut, pszPath, "wb");
+    if (fpOut == NULL || errval != 0)
+    {
+        fprintf(stderr, "Could not write opening cache (%s).\n", pszPath);
+        return false;
+    }
+
+    bool ok = (fwrite(pCache, sizeof(OPENING_CACHE), 1, fpOut) == 1);
+    ok = (fclose(fpOut) == 0) && ok;
+    if (!ok) fprintf(stderr, "Could not write opening cache (%s).\n", pszPath);
+    return ok;
+}
+
+/**
+ * @brief Case-insensitively compares a typed guess with a dictionary word.
+ */
+static bool is_same_word(const char* typed, const char* word)
+{
+    for (int i = 0; i < WORD_SIZE; i++)
+    {
+        if (toupper((unsigned char)typed[i]) != word[i]) return false;
+    }
+    return true;
+}
+
+// --- Result Cache ---
+
+/**
+ * @brief Allocates the result cache shared by every game of a server or simulation run.
+ * @return bool True on success.
+ */
+bool init_result_cache()
+{
+    if (g_pResultCache != NULL) return true;
+    try
+    {
+        g_pResultCache = new RESULT_CACHE_SHARD[RESULT_CACHE_SHARDS]();
+    }
+    catch (...)
+    {
+        fprintf(stderr, "Out of memory for the result cache!\n");
+        return false;
+    }
+    for (int s = 0; s < RESULT_CACHE_SHARDS; s++)
+    {
+        g_pResultCache[s].head = -1;
+        g_pResultCache[s].tail = -1;
+    }
+    return true;
+}
+
+/**
+ * @brief Releases the result cache.
+ */
+void free_result_cache()
+{
+    delete[] g_pResultCache;
+    g_pResultCache = NULL;
+}
+
+/**
+ * @brief Fingerprints everything a recommendation depends on: the answer IDs (candidate lists are
+ * kept in dictionary order, so the sequence is the sorted set), the required letter counts of pGood
+ * (its order does not affect the repeat-risk check) and the scoring mode.
+ * @return unsigned long long The cache key.
+ */
+unsigned long long compute_result_key(const char** pPossibleAnswers, long numPossibleAnswers, const char* pGood)
+{
+    unsigned long long hash = FNV_OFFSET_BASIS;
+    for (long i = 0; i < numPossibleAnswers; i++)
+    {
+        WORD_ID id = get_word_id(pPossibleAnswers[i]);
+        hash = fnv1a_hash(hash, &id, sizeof(id));
+    }
+
+    unsigned char requiredCounts[26] = { 0 };
+    for (const char* p = pGood; *p != '\0'; p++) requiredCounts[*p - 'A']++;
+    hash = fnv1a_hash(hash, requiredCounts, sizeof(requiredCounts));
+
+    char mode[4] = { (char)g_options.scoreFullDictionary, (char)g_options.exactFilter, (char)g_options.lookaheadPlies, (char)g_options.priorWeighted };
+    hash = fnv1a_hash(hash, mode, sizeof(mode));
+    return fnv1a_hash(hash, &g_options.sampleSize, sizeof(g_options.sampleSize));
+}
+
+/**
+ * @brief Returns the slot holding a key in a shard, or -1. The answer count is compared as well so
+ * a hash collision between different-sized sets cannot match.
+ */
+static int find_result_slot(const RESULT_CACHE_SHARD* pShard, unsigned long long key, long numPossibleAnswers)
+{
+    for (int s = 0; s < pShard->numUsed; s++)
+    {
+        if (pShard->keys[s] == key && pShard->numAnswers[s] == numPossibleAnswers) return s;
+    }
+    return -1;
+}
+
+/**
+ * @brief Takes a slot out of its shard's most-recently-used list.
+ */
+static void unlink_result_slot(PRESULT_CACHE_SHARD pShard, int slot)
+{
+    PRESULT_CACHE_ENTRY pEntry = pShard->entries + slot;
+    if (pEntry->prev >= 0) pShard->entries[pEntry->prev].next = pEntry->next;
+    else pShard->head = pEntry->next;
+    if (pEntry->next >= 0) pShard->entries[pEntry->next].prev = pEntry->prev;
+    else pShard->tail = pEntry->prev;
+}
+
+/**
+ * @brief Puts an unlinked slot at the front (most recently used) of its shard's list.
+ */
+static void push_result_slot(PRESULT_CACHE_SHARD pShard, int slot)
+{
+    PRESULT_CACHE_ENTRY pEntry = pShard->entries + slot;
+    pEntry->prev = -1;
+    pEntry->next = pShard->head;
+    if (pShard->head >= 0) pShard->entries[pShard->head].prev = slot;
+    else pShard->tail = slot;
+    pShard->head = slot;
+}
+
+/**
+ * @brief Copies out the cached recommendation for an answer set and marks it most recently used.
+ * @return bool True on a hit.
+ */
+bool lookup_result_cache(unsigned long long key, long numPossibleAnswers, PRECOMMENDATION pRec)
+{
+    PRESULT_CACHE_SHARD pShard = g_pResultCache + (key % RESULT_CACHE_SHARDS);
+
+    std::lock_guard<std::mutex> guard(pShard->lock);
+    int slot = find_result_slot(pShard, key, numPossibleAnswers);
+    if (slot < 0) return false;
+
+    *pRec = pShard->entries[slot].recommendation;
+    if (slot != pShard->head)
+    {
+        unlink_result_slot(pShard, slot);
+        push_result_slot(pShard, slot);
+    }
+    return true;
+}
+
+/**
+ * @brief Adds (or refreshes) the recommendation for an answer set, evicting the shard's least
+ * recently used entry when the shard is full.
+ */
+void store_result_cache(unsigned long long key, long numPossibleAnswers, const RECOMMENDATION* pRec)
+{
+    PRESULT_CACHE_SHARD pShard = g_pResultCache + (key % RESULT_CACHE_SHARDS);
+
+    std::lock_guard<std::mutex> guard(pShard->lock);
+    int slot = find_result_slot(pShard, key, numPossibleAnswers);
+    if (slot >= 0)
+    {
+        unlink_result_slot(pShard, slot);
+    }
+    else if (pShard->numUsed < RESULT_CACHE_SHARD_ENTRIES)
+    {
+        slot = pShard->numUsed++;
+    }
+    else
+    {
+        slot = pShard->tail;
+        unlink_result_slot(pShard, slot);
+    }
+
+    pShard->keys[slot] = key;
+    pShard->numAnswers[slot] = numPossibleAnswers;
+    pShard->entries[slot].recommendation = *pRec;
+    push_result_slot(pShard, slot);
+}
+
+/**
+ * @brief compute_recommendation behind the result cache: games that reach the same answer set
+ * (with the same required letters) share one computation. Without a cache it just computes.
+ * Same parameters and return value as compute_recommendation.
+ */
+bool get_shared_recommendation(const char** pPossibleAnswers, long numPossibleAnswers, char* pGood, PGUESS_METRICS pMetricsTable, PPATTERN_HISTOGRAMS pHistograms, PRECOMMENDATION pRec)
+{
+    if (g_pResultCache == NULL || numPossibleAnswers == 0)
+    {
+        return compute_recommendation(pPossibleAnswers, numPossibleAnswers, pGood, pMetricsTable, pHistograms, pRec);
+    }
+
+    unsigned long long key = compute_result_key(pPossibleAnswers, numPossibleAnswers, pGood);
+    if (lookup_result_cache(key, numPossibleAnswers, pRec))
+    {
+        stats_count(STAT_RESULT_CACHE_HITS, 1);
+        return true;
+    }
+
+    stats_count(STAT_RESULT_CACHE_MISSES, 1);
+    if (!compute_recommendation(pPossibleAnswers, numPossibleAnswers, pGood, pMetricsTable, pHistograms, pRec)) return false;
+    store_result_cache(key, numPossibleAnswers, pRec);
+    return true;
+}
+
+// --- Batch Simulation ---
+
+/**
+ * @brief Builds or maps from the compiled dictionary (and, with DEBUG_ON, verifies) the pattern
+ * matrix if it is not available yet. A failed verification is remembered: a rejected mapped matrix
+ * is rebuilt from the kernels (now and on later calls), and a rejected built one leaves patterns
+ * computed on demand for good.
+ * @param pDictionary The sorted dictionary table.
+ * @param numDictionary The number of dictionary entries.
+ */
+void ensure_pattern_matrix(PWORD_ENTRY pDictionary, long numDictionary)
+{
+    if (g_patternMatrix.pCodes != NULL || g_patternMatrix.onDemand) return;
+
+    bool ready = false;
+    STAT_TIMER timer;
+    stats_start(&timer);
+    if (g_pBinaryDictionary != NULL && g_pBinaryDictionary->matrixOffset != 0 && pDictionary == g_dictionaryStore.pEntries &&
+        !g_patternMatrix.mappedRejected)
+    {
+        // The compiled dictionary carries the matrix; pages are read in as rows are used
+        g_patternMatrix.pCodes = (PATTERN_CODE*)get_binary_section(g_pBinaryDictionary->matrixOffset);
+        g_patternMatrix.pDictionary = pDictionary;
+        g_patternMatrix.numWords = numDictionary;
+        g_patternMatrix.isMapped = true;
+        ready = true;
+
+        long mismatches = DEBUG_ON ? verify_pattern_matrix(PATTERN_VERIFY_SAMPLES) : 0;
+        if (mismatches != 0)
+        {
+            fprintf(stderr, "Mapped pattern matrix failed verification (%ld mismatches); rebuilding it.\n", mismatches);
+            free_pattern_matrix();
+            g_patternMatrix.mappedRejected = true;
+            ready = false;
+        }
+    }
+
+    if (!ready)
+    {
+        // Precompute every feedback pattern once so later turns are pure table lookups
+        ready = build_pattern_matrix(pDictionary, numDictionary);
+
+        long mismatches = (ready && DEBUG_ON) ? verify_pattern_matrix(PATTERN_VERIFY_SAMPLES) : 0;
+        if (mismatches != 0)
+        {
+            fprintf(stderr, "Pattern matrix failed verification (%ld mismatches); computing patterns on demand.\n", mismatches);
+            free_pattern_matrix();
+            g_patternMatrix.onDemand = true;
+        }
+    }
+    stats_stop(&timer, STAT_STAGE_MATRIX);
+}
+
+/**
+ * @brief Loads the turn-1 recommendation from the opening cache, or computes it (building the
+ * pattern matrix first) and saves a fresh cache.
+ * @param pDictionary The entire word dictionary.
+ * @param pPossibleAnswers The turn-1 possible answers.
+ * @param numPossibleAnswers The number of possible answers.
+ * @param pMetricsTable Metric work buffer (numWordsInDictionary entries).
+ * @param pOpeningCache Cache buffer, or NULL when caching is disabled.
+ * @param pRec Output: the turn-1 recommendation.
+ * @param pHaveOpeningCache Output: true if pOpeningCache holds valid turn-2 replies.
+ * @return bool True if a recommendation is available.
+ */
+bool get_opening_recommendation(PWORD_ENTRY pDictionary, const char** pPossibleAnswers, long numPossibleAnswers, PGUESS_METRICS pMetricsTable, POPENING_CACHE pOpeningCache, PRECOMMENDATION pRec, bool* pHaveOpeningCache)
+{
+    char mask[WORD_SIZE + 1];
+    char good[WORD_SIZE + 1];
+    char bad[26];
+    char notMask[6][WORD_SIZE];
+
+    *pHaveOpeningCache = false;
+
+    // Turn 1 (and each turn-2 reply to its final pick) only changes with the dictionary or used words
+    unsigned long long fingerprint = compute_opening_fingerprint(pDictionary, numWordsInDictionary, pPossibleAnswers, numPossibleAnswers);
+
+    if (pOpeningCache != NULL && load_opening_cache(g_szOpeningCachePath, fingerprint, pOpeningCache) &&
+        unpack_cached_recommendation(&pOpeningCache->opening, pDictionary, numWordsInDictionary, pRec))
+    {
+        printf("Loaded opening analysis from %s.\n", g_szOpeningCachePath);
+        *pHaveOpeningCache = true;
+        return true;
+    }
+
+    ensure_pattern_matrix(pDictionary, numWordsInDictionary);
+
+    init_game_constraints(mask, notMask, good, bad);
+    if (!compute_recommendation(pPossibleAnswers, numPossibleAnswers, good, pMetricsTable, NULL, pRec)) return false;
+
+    if (pOpeningCache != NULL &&
+        build_opening_cache(pPossibleAnswers, numPossibleAnswers, pMetricsTable, pRec, fingerprint, pOpeningCache))
+    {
+        *pHaveOpeningCache = true;
+        if (save_opening_cache(g_szOpeningCachePath, pOpeningCache)) printf("Saved opening analysis to %s.\n", g_szOpeningCachePath);
+    }
+    return true;
+}
+
+/**
+ * @brief Shared, read-only inputs of a simulation run, handed to each worker.
+ */
+typedef struct _simulation_job
+{
+    PWORD_ENTRY pDictionary;
+    const WORD_KERNELS* pKernels;       // A variant dictionary's word kernels (see apply_feedback_code), or NULL
+    const char** pPossibleAnswers;
+    long numPossibleAnswers;
+    const RECOMMENDATION* pOpening;
+    const OPENING_CACHE* pOpeningCache; // Turn-2 replies to the opener, or NULL
+    int* pGuessCounts;                  // Output per answer: guesses used (1..MAX_GUESSES), 0 = failed
+    const PICK_POLICY* pPolicies;       // Sweep grid (every answer is played under each), or NULL for the computed picks
+    long numPolicies;                   // Entries in pPolicies; pGuessCounts then holds numPolicies rows of answers
+} SIMULATION_JOB, * PSIMULATION_JOB;
+
+/**
+ * @brief Plays one headless game against a known answer, always guessing the solver's final pick
+ * and scoring it with get_feedback_pattern's rules (or the job's word kernels).
+ * @param pJob The simulation inputs.
+ * @param answer The hidden answer.
+ * @param pCandidates Work buffer (numPossibleAnswers entries).
+ * @param pMetricsTable Work buffer (numWordsInDictionary entries).
+ * @param pHistograms The worker's histograms (resynced from scratch when a new game starts).
+ * @param pPolicy The policy every final pick is re-derived with (see resolve_final_pick), or NULL to
+ * guess the final picks as computed.
+ * @return int The number of guesses needed (1..MAX_GUESSES), or 0 if the game was not solved.
+ */
+static int play_simulated_game(PSIMULATION_JOB pJob, const char* answer, const char** pCandidates, PGUESS_METRICS pMetricsTable, PPATTERN_HISTOGRAMS pHistograms, const PICK_POLICY* pPolicy)
+{
+    char mask[WORD_SIZE + 1];
+    char good[VARIANT_MAX_WORD_SIZE + 1];
+    char bad[26];
+    char notMask[6][WORD_SIZE];
+    RECOMMENDATION rec;
+    GUESS_METRICS pick;
+    int numPatterns = (pJob->pKernels != NULL) ? pJob->pKernels->numPatterns : NUM_PATTERNS;
+
+    init_game_constraints(mask, notMask, good, bad);
+    memcpy((void*)pCandidates, pJob->pPossibleAnswers, pJob->numPossibleAnswers * sizeof(char*));
+    long numCandidates = pJob->numPossibleAnswers;
+
+    const char* guess = pJob->pOpening->finalPick.word;
+    if (pPolicy != NULL)
+    {
+        resolve_final_pick(pJob->pOpening, pPolicy, &pick);
+        guess = pick.word;
+    }
+
+    // The cached turn-2 replies are to the computed opener only
+    bool isCachedOpener = memcmp(guess, pJob->pOpening->finalPick.word, WORD_SIZE) == 0;
+    for (int tryIdx = 1; tryIdx <= MAX_GUESSES; tryIdx++)
+    {
+        int code = (pJob->pKernels != NULL) ? pJob->pKernels->pfnFeedbackCode(guess, answer) : lookup_feedback_pattern_code(guess, answer);
+        if (code == numPatterns - 1) return tryIdx;
+        if (tryIdx == MAX_GUESSES) break;
+
+        numCandidates = apply_feedback_code(pJob->pKernels, guess, code, pCandidates, numCandidates, mask, notMask, good, bad, tryIdx);
+        if (numCandidates == 0) break;
+
+        // Turn 2 after the opener comes from the opening cache when it is available
+        const CACHED_RECOMMENDATION* pReply = (tryIdx == 1 && isCachedOpener && pJob->pOpeningCache != NULL) ? pJob->pOpeningCache->replies + code : NULL;
+        if (!(pReply != NULL && pReply->numPossibleAnswers == numCandidates &&
+              unpack_cached_recommendation(pReply, pJob->pDictionary, numWordsInDictionary, &rec)) &&
+            !get_shared_recommendation(pCandidates, numCandidates, good, pMetricsTable, pHistograms, &rec))
+        {
+            break;
+        }
+
+        guess = rec.finalPick.word;
+        if (pPolicy != NULL)
+        {
+            resolve_final_pick(&rec, pPolicy, &pick);
+            guess = pick.word;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief parallel_for callback: plays the games for answers [begin, end), under every sweep policy
+ * in turn. The games run on different workers, so each one scores its turns on the calling thread.
+ * An answer's games under neighbouring policies mostly reach the same answer sets, so playing them
+ * back to back keeps those sets in the result cache.
+ */
+static void simulate_games_range(long begin, long end, int, void* pContext)
+{
+    PSIMULATION_JOB pJob = (PSIMULATION_JOB)pContext;
+
+    PSCRATCH_ARENA pArena = get_scratch_arena();
+    size_t mark = scratch_mark(pArena);
+    const char** pCandidates = (const char**)scratch_alloc(pArena, pJob->numPossibleAnswers * sizeof(char*));
+    PGUESS_METRICS pMetricsTable = (PGUESS_METRICS)scratch_alloc(pArena, numWordsInDictionary * sizeof(GUESS_METRICS));
+    PATTERN_HISTOGRAMS histograms;
+    init_pattern_histograms(&histograms);
+
+    long numPolicies = (pJob->pPolicies != NULL) ? pJob->numPolicies : 1;
+    for (long i = begin; i < end; i++)
+    {
+        for (long p = 0; p < numPolicies; p++)
+        {
+            const PICK_POLICY* pPolicy = (pJob->pPolicies != NULL) ? pJob->pPolicies + p : NULL;
+            pJob->pGuessCounts[p * pJob->numPossibleAnswers + i] = (pCandidates && pMetricsTable) ?
+                play_simulated_game(pJob, pJob->pPossibleAnswers[i], pCandidates, pMetricsTable, &histograms, pPolicy) : 0;
+        }
+    }
+
+    scratch_release(pArena, mark);
+    free_pattern_histograms(&histograms);
+}
+
+/**
+ * @brief Prints how many games were solved, their average number of guesses and the guess histogram.
+ * @param histogram Games per number of guesses; [0] counts the failed games.
+ * @param numGames The number of games.
+ */
+void print_guess_histogram(const long* histogram, long numGames)
+{
+    long numSolved = numGames - histogram[0];
+    long totalGuesses = 0;
+    for (int g = 1; g <= MAX_GUESSES; g++) totalGuesses += g * histogram[g];
+
+    printf("Solved          : %ld / %ld (%.2f%%)\n", numSolved, numGames, numGames ? 100.0 * numSolved / numGames : 0.0);
+    printf("Average guesses : %.4f (solved games)\n", numSolved ? (double)totalGuesses / numSolved : 0.0);
+    printf("Guess histogram :\n");
+    for (int g = 1; g <= MAX_GUESSES; g++)
+    {
+        printf("  %d: %6ld\n", g, histogram[g]);
+    }
+    printf("  X: %6ld (failed, > %d guesses)\n", histogram[0], MAX_GUESSES);
+}
+
+/**
+ * @brief Plays the solver against every possible answer and prints the guess distribution,
+ * the average number of guesses, the failures (not solved within MAX_GUESSES) and the wall time.
+ * @param pDictionary The entire word dictionary (NULL for g_variantDictionary, played by its word kernels).
+ * @param pPossibleAnswers The turn-1 possible answers (each one is played as the hidden answer).
+ * @param numPossibleAnswers The number of possible answers.
+ * @param pOpening The turn-1 recommendation (its final pick is every game's first guess).
+ * @param pOpeningCache The turn-2 replies to the opener, or NULL.
+ * @return bool True on success, false on memory allocation failure.
+ */
+bool run_simulation(PWORD_ENTRY pDictionary, const char** pPossibleAnswers, long numPossibleAnswers, const RECOMMENDATION* pOpening, const OPENING_CACHE* pOpeningCache)
+{
+    long histogram[MAX_GUESSES + 1] = { 0 }; // [0] = failed
+
+    int* pGuessCounts = (int*)malloc(numPossibleAnswers * sizeof(int));
+    if (pGuessCounts == NULL)
+    {
+        fprintf(stderr, "Out of memory for simulation results!\n");
+        return false;
+    }
+
+    printf("\n--- Simulating %ld games (opener %s, %d threads) ---\n", numPossibleAnswers, pOpening->finalPick.word, get_worker_thread_count());
+
+    SIMULATION_JOB job = { pDictionary, g_variantDictionary.pKernels, pPossibleAnswers, numPossibleAnswers, pOpening, pOpeningCache, pGuessCounts, NULL, 0 };
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    parallel_for(numPossibleAnswers, SIMULATION_CHUNK_SIZE, simulate_games_range, &job);
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    for (long i = 0; i < numPossibleAnswers; i++) histogram[pGuessCounts[i]]++;
+    print_guess_histogram(histogram, numPossibleAnswers);
+
+    if (histogram[0] > 0)
+    {
+        printf("Failed answers  :");
+        long numListed = 0;
+        for (long i = 0; i < numPossibleAnswers && numListed < MAX_LISTED_FAILURES; i++)
+        {
+            if (pGuessCounts[i] == 0)
+            {
+                printf(" %s", pPossibleAnswers[i]);
+                numListed++;
+            }
+        }
+        printf("%s\n", (histogram[0] > numListed) ? " ..." : "");
+    }
+    printf("Wall time       : %.3f s (%.1f games/s)\n", wallSeconds, wallSeconds > 0 ? numPossibleAnswers / wallSeconds : 0.0);
+
+    free(pGuessCounts);
+    return true;
+}
+
+/**
+ * @brief Lists the values of a sweep range: first, first + step, ... up to last (within EPSILON).
+ * @param pRange The range.
+ * @param pValues Output: room for maxValues values.
+ * @param maxValues The most values to list.
+ * @return long The number of values, or 0 if the range has more than maxValues.
+ */
+static long list_sweep_values(const SWEEP_RANGE* pRange, double* pValues, long maxValues)
+{
+    if (pRange->step <= 0.0)
+    {
+        pValues[0] = pRange->first;
+        return 1;
+    }
+
+    long numValues = 0;
+    for (long k = 0; pRange->first + k * pRange->step <= pRange->last + EPSILON; k++)
+    {
+        if (numValues == maxValues) return 0;
+        pValues[numValues++] = pRange->first + k * pRange->step;
+    }
+    return numValues;
+}
+
+/**
+ * @brief Simulates every possible answer under each point of the --sweep-threshold x --sweep-count
+ * grid and prints, per point, the average guesses of solved games, the failure rate and the
+ * SWEEP_PERCENTILE guess count (failures count as MAX_GUESSES + 1), then the best point.
+ * Scoring does not depend on the policy, so every point shares the pattern matrix, the opening
+ * cache and the result cache; each point only re-derives the final picks (see resolve_final_pick).
+ * @param pDictionary The entire word dictionary.
+ * @param pPossibleAnswers The turn-1 possible answers (each one is played as the hidden answer).
+ * @param numPossibleAnswers The number of possible answers.
+ * @param pOpening The turn-1 recommendation.
+ * @param pOpeningCache The turn-2 replies to its final pick, or NULL.
+ * @return bool True on success, false on a bad grid or memory allocation failure.
+ */
+bool run_parameter_sweep(PWORD_ENTRY pDictionary, const char** pPossibleAnswers, long numPossibleAnswers, const RECOMMENDATION* pOpening, const OPENING_CACHE* pOpeningCache)
+{
+    double thresholds[SWEEP_MAX_POINTS];
+    double counts[SWEEP_MAX_POINTS];
+    long numThresholds = list_sweep_values(&g_options.sweepThresholds, thresholds, SWEEP_MAX_POINTS);
+    long numCounts = list_sweep_values(&g_options.sweepCounts, counts, SWEEP_MAX_POINTS);
+    long numPolicies = numThresholds * numCounts;
+
+    if (numPolicies == 0 || numPolicies > SWEEP_MAX_POINTS)
+    {
+        fprintf(stderr, "The sweep grid must have 1 to %d points.\n", SWEEP_MAX_POINTS);
+        return false;
+    }
+
+    PPICK_POLICY pPolicies = (PPICK_POLICY)malloc(numPolicies * sizeof(PICK_POLICY));
+    int* pGuessCounts = (int*)malloc((size_t)numPolicies * numPossibleAnswers * sizeof(int));
+    if (pPolicies == NULL || pGuessCounts == NULL)
+    {
+        fprintf(stderr, "Out of memory for the sweep results!\n");
+        free(pPolicies);
+        free(pGuessCounts);
+        return false;
+    }
+    for (long t = 0; t < numThresholds; t++)
+    {
+        for (long c = 0; c < numCounts; c++)
+        {
+            pPolicies[t * numCounts + c].entropyRankThreshold = thresholds[t];
+            pPolicies[t * numCounts + c].lowAnswerCount = (int)(counts[c] + 0.5);
+        }
+    }
+
+    printf("\n--- Sweeping %ld settings (%ld thresholds x %ld low answer counts) over %ld games each, %d threads ---\n",
+        numPolicies, numThresholds, numCounts, numPossibleAnswers, get_worker_thread_count());
+
+    SIMULATION_JOB job = { pDictionary, NULL, pPossibleAnswers, numPossibleAnswers, pOpening, pOpeningCache, pGuessCounts, pPolicies, numPolicies };
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    parallel_for(numPossibleAnswers, SIMULATION_CHUNK_SIZE, simulate_games_range, &job);
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    if (g_options.csvOutput) printf("threshold,low_count,average_guesses,failure_rate,p99_guesses\n");
+    else printf("Threshold  Low count  Avg guesses  Failed   P99\n");
+
+    long bestIdx = 0;
+    double bestAverage = 0.0;
+    long bestFailed = 0;
+    for (long p = 0; p < numPolicies; p++)
+    {
+        long histogram[MAX_GUESSES + 1] = { 0 }; // [0] = failed
+        const int* pCounts = pGuessCounts + (size_t)p * numPossibleAnswers;
+        for (long i = 0; i < numPossibleAnswers; i++) histogram[pCounts[i]]++;
+
+        long numSolved = numPossibleAnswers - histogram[0];
+        long totalGuesses = 0;
+        for (int g = 1; g <= MAX_GUESSES; g++) totalGuesses += g * histogram[g];
+        double average = numSolved ? (double)totalGuesses / numSolved : 0.0;
+        double failureRate = numPossibleAnswers ? (double)histogram[0] / numPossibleAnswers : 0.0;
+
+        // Smallest guess count that at least SWEEP_PERCENTILE of the games need at most
+        int percentile = MAX_GUESSES + 1;
+        long numCovered = 0;
+        for (int g = 1; g <= MAX_GUESSES; g++)
+        {
+            numCovered += histogram[g];
+            if (numCovered >= SWEEP_PERCENTILE * numPossibleAnswers)
+            {
+                percentile = g;
+                break;
+            }
+        }
+
+        char szPercentile[8];
+        if (percentile <= MAX_GUESSES) snprintf(szPercentile, sizeof(szPercentile), "%d", percentile);
+        else snprintf(szPercentile, sizeof(szPercentile), "X");
+
+        if (g_options.csvOutput) printf("%.4f,%d,%.4f,%.4f,%s\n", pPolicies[p].entropyRankThreshold, pPolicies[p].lowAnswerCount, average, failureRate, szPercentile);
+        else printf("%9.4f  %9d  %11.4f  %6.2f%%  %4s\n", pPolicies[p].entropyRankThreshold, pPolicies[p].lowAnswerCount, average, 100.0 * failureRate, szPercentile);
+
+        // Best: fewest failures, then the lowest average
+        if (p == 0 || histogram[0] < bestFailed || (histogram[0] == bestFailed && average < bestAverage - EPSILON))
+        {
+            bestIdx = p;
+            bestAverage = average;
+            bestFailed = histogram[0];
+        }
+    }
+
+    if (!g_options.csvOutput)
+    {
+        printf("Best            : --threshold %.4f --low-count %d (%.4f guesses, %ld failed)\n",
+            pPolicies[bestIdx].entropyRankThreshold, pPolicies[bestIdx].lowAnswerCount, bestAverage, bestFailed);
+        printf("Wall time       : %.3f s (%.1f games/s)\n", wallSeconds, wallSeconds > 0 ? (double)numPolicies * numPossibleAnswers / wallSeconds : 0.0);
+    }
+
+    free(pPolicies);
+    free(pGuessCounts);
+    return true;
+}
+
+// --- Variant Dictionaries ---
+
+/**
+ * @brief Shared, read-only inputs of a variant scoring pass, handed to each worker.
+ */
+typedef struct _variant_metrics_job
+{
+    const char* const* ppCandidates; // The remaining answers; each one is scored as a guess
+    long numCandidates;
+    const char* pGood;               // The required letters (for the repeat risk check)
+    PGUESS_METRICS pMetricsTable;    // Output, one entry per candidate
+} VARIANT_METRICS_JOB, * PVARIANT_METRICS_JOB;
+
+/**
+ * @brief Counts the copies of a letter in a string of letters.
+ */
+static int count_letter_copies(const char* pLetters, int numLetters, char letter)
+{
+    int count = 0;
+    for (int i = 0; i < numLetters && pLetters[i] != '\0'; i++)
+    {
+        if (pLetters[i] == letter) count++;
+    }
+    return count;
+}
+
+/**
+ * @brief The repeat-risk rule of is_guess_word_risky for variant words: a guess is risky if it
+ * repeats a letter more times than the required letters hold it.
+ */
+static bool has_unconfirmed_variant_repeat(const char* word, const char* pGood, int wordLength)
+{
+    for (int i = 0; i < wordLength; i++)
+    {
+        int count = count_letter_copies(word, wordLength, word[i]);
+        if (count > 1 && count > count_letter_copies(pGood, VARIANT_MAX_WORD_SIZE, word[i])) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Adds one guess's feedback to the required letters of a variant game: a letter marked
+ * green or yellow n times is in the answer at least n times, so pGood holds it n times.
+ * @param pGood The required letters (room for VARIANT_MAX_WORD_SIZE letters and the NUL).
+ */
+static void add_variant_required_letters(const char* guess, int code, int wordLength, char* pGood)
+{
+    char marked[VARIANT_MAX_WORD_SIZE];
+    int numMarked = 0;
+
+    for (int i = 0; i < wordLength; i++, code /= 3)
+    {
+        if (code % 3 != 0) marked[numMarked++] = guess[i];
+    }
+    for (int i = 0; i < numMarked; i++)
+    {
+        int length = (int)strlen(pGood);
+        if (length < wordLength && count_letter_copies(marked, numMarked, marked[i]) > count_letter_copies(pGood, length, marked[i]))
+        {
+            pGood[length] = marked[i];
+            pGood[length + 1] = '\0';
+        }
+    }
+}
+
+/**
+ * @brief Checks an entered guess against g_variantDictionary's alphabet and makes it a word record
+ * the kernels can score: upper-cases its ASCII letters and stores its letter indices after the NUL.
+ * @param pszGuess The trimmed guess, with room for VARIANT_RECORD_SIZE(wordLength) bytes.
+ * @return bool True if the guess is wordLength letters of the alphabet.
+ */
+bool parse_variant_guess(char* pszGuess)
+{
+    const VARIANT_DICTIONARY* pVariant = &g_variantDictionary;
+    int wordLength = pVariant->wordLength;
+
+    if ((int)strlen(pszGuess) != wordLength) return false;
+    for (int i = 0; i < wordLength; i++)
+    {
+        unsigned char c = (unsigned char)pszGuess[i];
+        if (c < 0x80) c = (unsigned char)toupper(c);
+        const unsigned char* pLetter = (const unsigned char*)memchr(pVariant->alphabet, c, pVariant->alphabetSize);
+        if (pLetter == NULL) return false;
+        pszGuess[i] = (char)c;
+        pszGuess[wordLength + 1 + i] = (char)(pLetter - pVariant->alphabet);
+    }
+    return true;
+}
+
+/**
+ * @brief Encodes a validated B/Y/G result of wordLength characters as a word kernel pattern code.
+ * @return int The code (position 0 is the lowest digit; all green is 3^wordLength - 1).
+ */
+int encode_variant_pattern(const char* pszPattern, int wordLength)
+{
+    int code = 0;
+    for (int i = wordLength - 1; i >= 0; i--)
+    {
+        code = code * 3 + ((pszPattern[i] == 'G') ? 2 : (pszPattern[i] == 'Y') ? 1 : 0);
+    }
+    return code;
+}
+
+/**
+ * @brief parallel_for callback: scores the candidates [begin, end) of a variant metrics job with
+ * the dispatched entropy kernel. Each worker writes only its own metric slots.
+ */
+static void calculate_variant_metrics_range(long begin, long end, int, void* pContext)
+{
+    PVARIANT_METRICS_JOB pJob = (PVARIANT_METRICS_JOB)pContext;
+    const VARIANT_DICTIONARY* pVariant = &g_variantDictionary;
+
+    for (long i = begin; i < end; i++)
+    {
+        const char* guess = pJob->ppCandidates[i];
+        long wordIdx = (long)((guess - pVariant->pWords) / VARIANT_RECORD_SIZE(pVariant->wordLength));
+        PGUESS_METRICS pMetric = pJob->pMetricsTable + i;
+
+        pMetric->word = guess;
+        pMetric->rank = pVariant->pRanks[wordIdx];
+        pMetric->nounType = pVariant->pNounTypes[wordIdx];
+        pMetric->verbType = pVariant->pVerbTypes[wordIdx];
+        pMetric->remainingMass = 0.0;
+        pMetric->is_risky = has_unconfirmed_variant_repeat(guess, pJob->pGood, pVariant->wordLength);
+        pMetric->entropy = pVariant->pKernels->pfnEntropy(guess, pJob->ppCandidates, pJob->numCandidates);
+    }
+}
 
-    while (pTmp != NULL && pTmp < pListEnd)
+/**
+ * @brief compute_recommendation for g_variantDictionary: scores every remaining answer as a guess
+ * exactly with the word kernels' entropy and selects the recommendation the same way.
+ * @param pPossibleAnswers The remaining answers (variant word records).
+ * @param numPossibleAnswers Their number (must be > 0).
+ * @param pGood The required letters (for the repeat risk check).
+ * @param pMetricsTable Work buffer (numPossibleAnswers entries).
+ * @param pRec Output: the top rows, picks and final pick.
+ * @return bool True on success.
+ */
+bool compute_variant_recommendation(const char** pPossibleAnswers, long numPossibleAnswers, const char* pGood, PGUESS_METRICS pMetricsTable, PRECOMMENDATION pRec)
+{
+    STAT_TIMER timer;
+
+    stats_start(&timer);
+    VARIANT_METRICS_JOB job = { pPossibleAnswers, numPossibleAnswers, pGood, pMetricsTable };
+    parallel_for(numPossibleAnswers, METRICS_CHUNK_SIZE, calculate_variant_metrics_range, &job);
+    stats_stop(&timer, STAT_STAGE_METRICS);
+
+    stats_start(&timer);
+    select_recommendation(pMetricsTable, numPossibleAnswers, numPossibleAnswers, pRec);
+    stats_stop(&timer, STAT_STAGE_SELECT);
+    return true;
+}
+
+/**
+ * @brief Applies one guess's feedback code to a game: updates its constraints and keeps the
+ * answers consistent with them. With a variant dictionary's word kernels the answers kept are
+ * exactly those giving the code, and only the required letters (pGood) are tracked.
+ * @param pKernels The variant dictionary's word kernels, or NULL for the WORD_SIZE-letter A-Z rules.
+ * @param guess The guess (a variant word record with pKernels).
+ * @param code Its feedback code (a PATTERN_CODE without pKernels).
+ * @param pPossibleAnswers The remaining answers, compacted in place.
+ * @param numPossibleAnswers Their number.
+ * @return long The number of answers kept.
+ */
+long apply_feedback_code(const WORD_KERNELS* pKernels, const char* guess, int code, const char** pPossibleAnswers, long numPossibleAnswers,
+    char* pMask, char notMask[6][5], char* pGood, char* pBad, int tryIdx)
+{
+    if (pKernels == NULL)
     {
-        pTmp += strlen(wordStartTag);
-        pTmp += strspn(pTmp, nonWordChars);
+        char pattern[WORD_SIZE + 1];
+        decode_feedback_pattern((PATTERN_CODE)code, pattern);
+        update_game_constraints(guess, pattern, pMask, notMask, pGood, pBad, tryIdx);
+        return filter_possible_answers_after_guess(guess, pattern, pPossibleAnswers, numPossibleAnswers, pMask, notMask, pGood, pBad, tryIdx);
+    }
 
-        char* pWordEndTag = strstr(pTmp, wordEndTag);
-        if (pWordEndTag == NULL || pWordEndTag >= pListEnd) break;
+    STAT_TIMER timer;
+    add_variant_required_letters(guess, code, pKernels->wordLength, pGood);
+    stats_start(&timer);
+    long numKept = pKernels->pfnFilterByPattern(guess, code, pPossibleAnswers, numPossibleAnswers);
+    stats_stop(&timer, STAT_STAGE_FILTER);
+    return numKept;
+}
+
+/**
+ * @brief Fits the options to g_variantDictionary, whose every remaining answer is scored exactly
+ * by entropy. The modes tied to the WORD_SIZE-letter A-Z tables are refused and the alternative
+ * scorings are switched off.
+ * @return bool True if the requested mode runs on a variant dictionary (the interactive game,
+ * --simulate or --compile-dictionary).
+ */
+bool apply_variant_options()
+{
+    const VARIANT_DICTIONARY* pVariant = &g_variantDictionary;
+
+    if (g_options.server || g_options.pszBatchPath != NULL || g_options.pszExportTreePath != NULL || g_options.bench || g_options.sweep)
+    {
+        fprintf(stderr, "%d-letter dictionaries over a %d-letter alphabet support the interactive game, --simulate and --compile-dictionary only.\n",
+            pVariant->wordLength, pVariant->alphabetSize);
+        return false;
+    }
+
+    if (g_options.scoreFullDictionary || g_options.lookaheadPlies > 0 || g_options.sampleSize > 0 || g_options.priorWeighted || g_options.useAccelerator)
+    {
+        fprintf(stderr, "Ignoring -f, --lookahead, --sample, --weighted and --gpu: they need the %d-letter A-Z dictionary.\n", WORD_SIZE);
+        g_options.scoreFullDictionary = false;
+        g_options.lookaheadPlies = 0;
+        g_options.sampleSize = 0;
+        g_options.priorWeighted = false;
+        g_options.useAccelerator = false;
+    }
+    return true;
+}
+
+// --- Benchmarks ---
+
+/**
+ * @brief Returns the nanoseconds elapsed since startTime.
+ */
+static double bench_elapsed_ns(std::chrono::steady_clock::time_point startTime)
+{
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+/**
+ * @brief Prints one benchmark result line: time per operation, throughput and whether the output
+ * matched the reference implementation.
+ * @param pszName What was timed.
+ * @param totalNs The total time of the run.
+ * @param numOps The operations (pairs, words, games) the run performed.
+ * @param pszUnit The name of one operation.
+ * @param identical True if the output matched the reference.
+ */
+static void print_bench_result(const char* pszName, double totalNs, double numOps, const char* pszUnit, bool identical)
+{
+    double nsPerOp = (numOps > 0) ? totalNs / numOps : 0.0;
+    double opsPerSecond = (totalNs > 0) ? numOps * 1e9 / totalNs : 0.0;
+    printf("  %-36s %10.2f ns/%-6s %12.0f %s/s  %s\n", pszName, nsPerOp, pszUnit, opsPerSecond, pszUnit, identical ? "identical" : "MISMATCH");
+}
+
+/**
+ * @brief Times the feedback pattern kernels over BENCH_FEEDBACK_GUESSES guesses against every
+ * dictionary word. get_feedback_pattern (string result, then encoded) is the reference.
+ * @return bool True if every kernel reproduced the reference codes.
+ */
+static bool bench_feedback_kernels(PWORD_ENTRY pDictionary, long numDictionary)
+{
+    long numGuesses = (numDictionary < BENCH_FEEDBACK_GUESSES) ? numDictionary : BENCH_FEEDBACK_GUESSES;
+    long numPairs = numGuesses * numDictionary;
+    PACKED_WORDS packed;
+
+    PATTERN_CODE* pReference = (PATTERN_CODE*)malloc(numPairs * sizeof(PATTERN_CODE));
+    PATTERN_CODE* pCodes = (PATTERN_CODE*)malloc(numPairs * sizeof(PATTERN_CODE));
+    if (pReference == NULL || pCodes == NULL || !pack_words(pDictionary, numDictionary, &packed))
+    {
+        fprintf(stderr, "Out of memory for the feedback benchmark!\n");
+        free(pReference);
+        free(pCodes);
+        return false;
+    }
+
+    printf("\nFeedback patterns (%ld guesses x %ld words):\n", numGuesses, numDictionary);
+    bool allIdentical = true;
+
+    // Reference: the original string-building implementation
+    char pattern[WORD_SIZE + 1];
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    for (long g = 0; g < numGuesses; g++)
+    {
+        const char* guess = pDictionary[g * (numDictionary / numGuesses)].word;
+        for (long a = 0; a < numDictionary; a++)
+        {
+            get_feedback_pattern(guess, pDictionary[a].word, pattern);
+            pReference[g * numDictionary + a] = encode_feedback_pattern(pattern);
+        }
+    }
+    print_bench_result("get_feedback_pattern (reference)", bench_elapsed_ns(startTime), (double)numPairs, "pair", true);
+
+    startTime = std::chrono::steady_clock::now();
+    for (long g = 0; g < numGuesses; g++)
+    {
+        const char* guess = pDictionary[g * (numDictionary / numGuesses)].word;
+        for (long a = 0; a < numDictionary; a++) pCodes[g * numDictionary + a] = get_feedback_pattern_code(guess, pDictionary[a].word);
+    }
+    bool identical = memcmp(pCodes, pReference, numPairs) == 0;
+    print_bench_result("get_feedback_pattern_code", bench_elapsed_ns(startTime), (double)numPairs, "pair", identical);
+    allIdentical = allIdentical && identical;
+
+    const unsigned int* pPackedLetters = g_dictionaryStore.pPackedLetters;
+    if (pPackedLetters != NULL && g_dictionaryStore.pEntries == pDictionary)
+    {
+        startTime = std::chrono::steady_clock::now();
+        for (long g = 0; g < numGuesses; g++)
+        {
+            unsigned int packedGuess = pPackedLetters[g * (numDictionary / numGuesses)];
+            for (long a = 0; a < numDictionary; a++) pCodes[g * numDictionary + a] = get_feedback_pattern_code_packed(packedGuess, pPackedLetters[a]);
+        }
+        identical = memcmp(pCodes, pReference, numPairs) == 0;
+        print_bench_result("get_feedback_pattern_code_packed", bench_elapsed_ns(startTime), (double)numPairs, "pair", identical);
+        allIdentical = allIdentical && identical;
+    }
+
+    // Row kernels: the portable one and the one selected for this CPU
+    FEEDBACK_KERNEL_FN kernels[2] = { feedback_codes_scalar, g_pFeedbackKernel };
+    const char* pszKernelNames[2] = { "row kernel (scalar)", "row kernel (selected)" };
+    for (int k = 0; k < 2; k++)
+    {
+        if (kernels[k] == NULL || (k == 1 && kernels[1] == kernels[0])) continue;
+
+        startTime = std::chrono::steady_clock::now();
+        for (long g = 0; g < numGuesses; g++)
+        {
+            long guessIdx = g * (numDictionary / numGuesses);
+            unsigned char guess[WORD_SIZE];
+            for (int pos = 0; pos < WORD_SIZE; pos++) guess[pos] = packed.pLetters[pos][guessIdx];
+            kernels[k](guess, &packed, 0, numDictionary, pCodes + g * numDictionary);
+        }
+        identical = memcmp(pCodes, pReference, numPairs) == 0;
+        print_bench_result(pszKernelNames[k], bench_elapsed_ns(startTime), (double)numPairs, "pair", identical);
+        allIdentical = allIdentical && identical;
+    }
+
+    if (g_patternMatrix.pCodes != NULL && g_patternMatrix.numWords == numDictionary)
+    {
+        startTime = std::chrono::steady_clock::now();
+        for (long g = 0; g < numGuesses; g++)
+        {
+            const PATTERN_CODE* pRow = g_patternMatrix.pCodes + (size_t)(g * (numDictionary / numGuesses)) * numDictionary;
+            for (long a = 0; a < numDictionary; a++) pCodes[g * numDictionary + a] = pRow[a];
+        }
+        identical = memcmp(pCodes, pReference, numPairs) == 0;
+        print_bench_result("pattern matrix lookup", bench_elapsed_ns(startTime), (double)numPairs, "pair", identical);
+        allIdentical = allIdentical && identical;
+    }
+
+    free_packed_words(&packed);
+    free(pReference);
+    free(pCodes);
+    return allIdentical;
+}
+
+/**
+ * @brief Times the entropy calculations over BENCH_ENTROPY_GUESSES answers against every answer.
+ * calculate_entropy_score with the pattern matrix switched off (string feedback per pair) is the
+ * reference; every variant must return bit-identical scores.
+ * @return bool True if every variant reproduced the reference scores.
+ */
+static bool bench_entropy(const char** pPossibleAnswers, long numPossibleAnswers)
+{
+    long numGuesses = (numPossibleAnswers < BENCH_ENTROPY_GUESSES) ? numPossibleAnswers : BENCH_ENTROPY_GUESSES;
+    double numPairs = (double)numGuesses * numPossibleAnswers;
+
+    double* pReference = (double*)malloc(numGuesses * sizeof(double));
+    double* pScores = (double*)malloc(numGuesses * sizeof(double));
+    WORD_ID* pAnswerIds = (WORD_ID*)malloc(numPossibleAnswers * sizeof(WORD_ID));
+    if (pReference == NULL || pScores == NULL || pAnswerIds == NULL)
+    {
+        fprintf(stderr, "Out of memory for the entropy benchmark!\n");
+        free(pReference);
+        free(pScores);
+        free(pAnswerIds);
+        return false;
+    }
+    for (long i = 0; i < numPossibleAnswers; i++) pAnswerIds[i] = get_word_id(pPossibleAnswers[i]);
+
+    printf("\nEntropy scores (%ld guesses x %ld answers):\n", numGuesses, numPossibleAnswers);
+    bool allIdentical = true;
+    bool identical;
+    long stride = numPossibleAnswers / numGuesses;
+
+    // The matrix is hidden for the on-demand runs and put back afterwards
+    PATTERN_CODE* pMatrixCodes = g_patternMatrix.pCodes;
+    for (int useMatrix = 0; useMatrix <= 1; useMatrix++)
+    {
+        if (useMatrix && pMatrixCodes == NULL) break;
+        g_patternMatrix.pCodes = useMatrix ? pMatrixCodes : NULL;
+
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        for (long g = 0; g < numGuesses; g++) pScores[g] = calculate_entropy_score(pPossibleAnswers[g * stride], pPossibleAnswers, numPossibleAnswers);
+        double elapsedNs = bench_elapsed_ns(startTime);
+        if (!useMatrix) memcpy(pReference, pScores, numGuesses * sizeof(double));
+        identical = memcmp(pScores, pReference, numGuesses * sizeof(double)) == 0;
+        print_bench_result(useMatrix ? "calculate_entropy_score (matrix)" : "calculate_entropy_score (reference)", elapsedNs, numPairs, "pair", identical);
+        allIdentical = allIdentical && identical;
+
+        startTime = std::chrono::steady_clock::now();
+        for (long g = 0; g < numGuesses; g++) pScores[g] = calculate_entropy_score_ids(pAnswerIds[g * stride], pAnswerIds, numPossibleAnswers);
+        elapsedNs = bench_elapsed_ns(startTime);
+        identical = memcmp(pScores, pReference, numGuesses * sizeof(double)) == 0;
+        print_bench_result(useMatrix ? "calculate_entropy_score_ids (matrix)" : "calculate_entropy_score_ids (packed)", elapsedNs, numPairs, "pair", identical);
+        allIdentical = allIdentical && identical;
+    }
+    g_patternMatrix.pCodes = pMatrixCodes;
+
+    free(pReference);
+    free(pScores);
+    free(pAnswerIds);
+    return allIdentical;
+}
+
+/**
+ * @brief Times the candidate filter over BENCH_FILTER_SCENARIOS two-guess game states (the opener,
+ * then another answer, played against a spread of hidden answers). A plain is_good_fit loop is the
+ * reference for filter_possible_answers.
+ * @return bool True if the filter kept exactly the reference answers for every scenario.
+ */
+static bool bench_filter(const char** pPossibleAnswers, long numPossibleAnswers, const RECOMMENDATION* pOpening)
+{
+    long numScenarios = (numPossibleAnswers < BENCH_FILTER_SCENARIOS) ? numPossibleAnswers : BENCH_FILTER_SCENARIOS;
+    double numWordsTested = (double)numScenarios * numPossibleAnswers;
+    double referenceNs = 0.0;
+    double filterNs = 0.0;
+    bool identical = true;
+
+    const char** pReference = (const char**)malloc(numPossibleAnswers * sizeof(char*));
+    const char** pFiltered = (const char**)malloc(numPossibleAnswers * sizeof(char*));
+    if (pReference == NULL || pFiltered == NULL)
+    {
+        fprintf(stderr, "Out of memory for the filter benchmark!\n");
+        free((void*)pReference);
+        free((void*)pFiltered);
+        return false;
+    }
+
+    for (long s = 0; s < numScenarios; s++)
+    {
+        char mask[WORD_SIZE + 1];
+        char good[WORD_SIZE + 1];
+        char bad[26];
+        char notMask[6][WORD_SIZE];
+        char pattern[WORD_SIZE + 1];
+
+        const char* answer = pPossibleAnswers[s * (numPossibleAnswers / numScenarios)];
+        const char* guesses[2] = { pOpening->finalPick.word, pPossibleAnswers[(s * 7919 + 1) % numPossibleAnswers] };
+        init_game_constraints(mask, notMask, good, bad);
+        for (int tryIdx = 1; tryIdx <= 2; tryIdx++)
+        {
+            get_feedback_pattern(guesses[tryIdx - 1], answer, pattern);
+            update_game_constraints(guesses[tryIdx - 1], pattern, mask, notMask, good, bad, tryIdx);
+        }
+
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        long numReference = 0;
+        for (long i = 0; i < numPossibleAnswers; i++)
+        {
+            if (is_good_fit(mask, notMask, good, bad, (char*)pPossibleAnswers[i])) pReference[numReference++] = pPossibleAnswers[i];
+        }
+        referenceNs += bench_elapsed_ns(startTime);
+
+        memcpy((void*)pFiltered, pPossibleAnswers, numPossibleAnswers * sizeof(char*));
+        startTime = std::chrono::steady_clock::now();
+        long numFiltered = filter_possible_answers(pFiltered, numPossibleAnswers, mask, notMask, good, bad, 2);
+        filterNs += bench_elapsed_ns(startTime);
+
+        if (numFiltered != numReference || memcmp(pFiltered, pReference, numFiltered * sizeof(char*)) != 0) identical = false;
+    }
+
+    printf("\nCandidate filter (%ld two-guess states x %ld answers):\n", numScenarios, numPossibleAnswers);
+    print_bench_result("is_good_fit loop (reference)", referenceNs, numWordsTested, "word", true);
+    print_bench_result("filter_possible_answers", filterNs, numWordsTested, "word", identical);
+
+    free((void*)pReference);
+    free((void*)pFiltered);
+    return identical;
+}
+
+/**
+ * @brief Word-length-agnostic feedback code (runtime length, no unrolling): the reference the
+ * compiled word kernels are checked against.
+ */
+static int reference_feedback_code(const unsigned char* guess, const unsigned char* answer, int wordLength)
+{
+    int answerCounts[VARIANT_MAX_ALPHABET] = { 0 };
+    bool isGreen[VARIANT_MAX_WORD_SIZE];
+    int code = 0;
+    int weight = 1;
+
+    for (int i = 0; i < wordLength; i++)
+    {
+        isGreen[i] = (guess[i] == answer[i]);
+        if (!isGreen[i]) answerCounts[answer[i]]++;
+    }
+    for (int i = 0; i < wordLength; i++, weight *= 3)
+    {
+        if (isGreen[i]) code += 2 * weight;
+        else if (answerCounts[guess[i]] > 0)
+        {
+            code += weight;
+            answerCounts[guess[i]]--;
+        }
+    }
+    return code;
+}
+
+/**
+ * @brief Times every compiled word-length/alphabet instantiation on BENCH_VARIANT_WORDS generated
+ * words (a fixed-seed generator, so runs are repeatable) against reference_feedback_code, and
+ * checks their filters keep exactly the words the reference codes select.
+ * @return bool True if every instantiation reproduced the reference.
+ */
+static bool bench_word_kernels()
+{
+    long numGuesses = BENCH_FEEDBACK_GUESSES;
+    long numWords = BENCH_VARIANT_WORDS;
+    double numPairs = (double)numGuesses * numWords;
+    bool allIdentical = true;
+    char szName[64];
+
+    char* pWords = (char*)malloc(numWords * VARIANT_RECORD_SIZE(VARIANT_MAX_WORD_SIZE));
+    int* pReference = (int*)malloc(numGuesses * numWords * sizeof(int));
+    const char** ppWords = (const char**)malloc(numWords * sizeof(char*));
+    if (pWords == NULL || pReference == NULL || ppWords == NULL)
+    {
+        fprintf(stderr, "Out of memory for the word kernel benchmark!\n");
+        free(pWords);
+        free(pReference);
+        free((void*)ppWords);
+        return false;
+    }
+
+    printf("\nWord-length kernels (%ld guesses x %ld generated words):\n", numGuesses, numWords);
+    for (size_t k = 0; k < sizeof(g_wordKernels) / sizeof(g_wordKernels[0]); k++)
+    {
+        const WORD_KERNELS* pKernels = g_wordKernels + k;
+        int wordLength = pKernels->wordLength;
+        int recordSize = VARIANT_RECORD_SIZE(wordLength);
+
+        // Word records with small effective alphabets, so repeated letters (the tricky yellow cases)
+        // are common; the kernels read only the letter indices after the word's NUL
+        unsigned int seed = 12345u + (unsigned int)k;
+        int numLetters = (pKernels->alphabetSize < 12) ? pKernels->alphabetSize : 12;
+        for (long i = 0; i < numWords; i++)
+        {
+            char* word = pWords + i * recordSize;
+            for (int pos = 0; pos < wordLength; pos++)
+            {
+                seed = seed * 1103515245u + 12345u;
+                int letter = (int)((seed >> 16) % numLetters) * (pKernels->alphabetSize / numLetters);
+                word[pos] = (char)('A' + letter % ALPHABET_SIZE);
+                word[wordLength + 1 + pos] = (char)letter;
+            }
+            word[wordLength] = '\0';
+        }
+
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        for (long g = 0; g < numGuesses; g++)
+        {
+            const unsigned char* guess = (const unsigned char*)pWords + g * recordSize + wordLength + 1;
+            for (long a = 0; a < numWords; a++)
+            {
+                pReference[g * numWords + a] = reference_feedback_code(guess, (const unsigned char*)pWords + a * recordSize + wordLength + 1, wordLength);
+            }
+        }
+        double referenceNs = bench_elapsed_ns(startTime);
+
+        bool identical = true;
+        long long checksum = 0;
+        startTime = std::chrono::steady_clock::now();
+        for (long g = 0; g < numGuesses; g++)
+        {
+            for (long a = 0; a < numWords; a++)
+            {
+                int code = pKernels->pfnFeedbackCode(pWords + g * recordSize, pWords + a * recordSize);
+                checksum += code;
+                if (code != pReference[g * numWords + a]) identical = false;
+            }
+        }
+        double kernelNs = bench_elapsed_ns(startTime);
+
+        // The filter must keep exactly the words whose reference code matches
+        for (long g = 0; g < numGuesses && identical; g++)
+        {
+            int code = pReference[g * numWords + (g * 31) % numWords];
+            for (long a = 0; a < numWords; a++) ppWords[a] = pWords + a * recordSize;
+            long numKept = pKernels->pfnFilterByPattern(pWords + g * recordSize, code, ppWords, numWords);
+
+            long numExpected = 0;
+            for (long a = 0; a < numWords && identical; a++)
+            {
+                if (pReference[g * numWords + a] == code && (numExpected >= numKept || ppWords[numExpected++] != pWords + a * recordSize)) identical = false;
+            }
+            if (numExpected != numKept) identical = false;
+        }
+
+        for (long a = 0; a < numWords; a++) ppWords[a] = pWords + a * recordSize;
+        startTime = std::chrono::steady_clock::now();
+        double entropy = pKernels->pfnEntropy(pWords, ppWords, numWords);
+        double entropyNs = bench_elapsed_ns(startTime);
+
+        snprintf(szName, sizeof(szName), "%d letters, %d-letter alphabet (ref)", wordLength, pKernels->alphabetSize);
+        print_bench_result(szName, referenceNs, numPairs, "pair", true);
+        snprintf(szName, sizeof(szName), "%d letters, %d-letter alphabet", wordLength, pKernels->alphabetSize);
+        print_bench_result(szName, kernelNs, numPairs, "pair", identical);
+        printfDebug("Word kernels %d/%d: checksum %lld, entropy %.4f in %.0f ns.\n", wordLength, pKernels->alphabetSize, checksum, entropy, entropyNs);
+        allIdentical = allIdentical && identical;
+    }
+
+    free(pWords);
+    free(pReference);
+    free((void*)ppWords);
+    return allIdentical;
+}
+
+/**
+ * @brief True if two metric tables agree on every exactly scored guess. Which guesses are pruned in
+ * full-dictionary mode depends on how the work was split, so pruned entries are not compared.
+ */
+static bool are_metric_tables_identical(const GUESS_METRICS* pA, const GUESS_METRICS* pB, long numMetrics)
+{
+    for (long i = 0; i < numMetrics; i++)
+    {
+        if (pA[i].entropy == PRUNED_ENTROPY || pB[i].entropy == PRUNED_ENTROPY) continue;
+        if (pA[i].word != pB[i].word || pA[i].entropy != pB[i].entropy || pA[i].rank != pB[i].rank || pA[i].is_risky != pB[i].is_risky) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Runs the thread scaling benchmarks: calculate_all_metrics over the turn-1 answers and a
+ * full-game sweep over every answer, at 1, 2, 4, ... threads up to the configured count.
+ * The single-thread run is the reference for the others.
+ * @return bool True if every thread count reproduced the single-thread results.
+ */
+static bool bench_thread_scaling(PWORD_ENTRY pDictionary, const char** pPossibleAnswers, long numPossibleAnswers, const RECOMMENDATION* pOpening, const OPENING_CACHE* pOpeningCache)
+{
+    char mask[WORD_SIZE + 1];
+    char good[WORD_SIZE + 1];
+    char bad[26];
+    char notMask[6][WORD_SIZE];
+    bool allIdentical = true;
+    char szName[64];
+
+    int maxThreads = get_worker_thread_count();
+    int savedThreads = g_options.numThreads;
+
+    PGUESS_METRICS pReferenceTable = (PGUESS_METRICS)malloc(numWordsInDictionary * sizeof(GUESS_METRICS));
+    PGUESS_METRICS pMetricsTable = (PGUESS_METRICS)malloc(numWordsInDictionary * sizeof(GUESS_METRICS));
+    int* pReferenceCounts = (int*)malloc(numPossibleAnswers * sizeof(int));
+    int* pGuessCounts = (int*)malloc(numPossibleAnswers * sizeof(int));
+    if (pReferenceTable == NULL || pMetricsTable == NULL || pReferenceCounts == NULL || pGuessCounts == NULL)
+    {
+        fprintf(stderr, "Out of memory for the scaling benchmark!\n");
+        free(pReferenceTable);
+        free(pMetricsTable);
+        free(pReferenceCounts);
+        free(pGuessCounts);
+        return false;
+    }
+
+    init_game_constraints(mask, notMask, good, bad);
+    long numGuesses = g_options.scoreFullDictionary ? numWordsInDictionary : numPossibleAnswers;
+    long numReferenceMetrics = 0;
+    double referenceNs = 0.0;
+
+    printf("\ncalculate_all_metrics (%ld guesses x %ld answers, best of %d):\n", numGuesses, numPossibleAnswers, BENCH_REPEATS);
+    for (int numThreads = 1; numThreads <= maxThreads; numThreads = (numThreads * 2 > maxThreads && numThreads < maxThreads) ? maxThreads : numThreads * 2)
+    {
+        g_options.numThreads = numThreads;
+        double bestNs = 0.0;
+        long numMetrics = 0;
+        for (int r = 0; r < BENCH_REPEATS; r++)
+        {
+            std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+            numMetrics = calculate_all_metrics(pPossibleAnswers, numPossibleAnswers, good, (numThreads == 1) ? pReferenceTable : pMetricsTable, numWordsInDictionary, NULL);
+            double elapsedNs = bench_elapsed_ns(startTime);
+            if (r == 0 || elapsedNs < bestNs) bestNs = elapsedNs;
+        }
+
+        bool identical = true;
+        if (numThreads == 1)
+        {
+            numReferenceMetrics = numMetrics;
+            referenceNs = bestNs;
+        }
+        else
+        {
+            identical = numMetrics == numReferenceMetrics && are_metric_tables_identical(pReferenceTable, pMetricsTable, numMetrics);
+        }
+        snprintf(szName, sizeof(szName), "%d thread%s (%.2fx)", numThreads, (numThreads == 1) ? "" : "s", bestNs > 0 ? referenceNs / bestNs : 0.0);
+        print_bench_result(szName, bestNs, (double)numGuesses * numPossibleAnswers, "pair", identical);
+        allIdentical = allIdentical && identical;
+    }
+
+    printf("\nFull-game sweep (%ld games, opener %s):\n", numPossibleAnswers, pOpening->finalPick.word);
+    for (int numThreads = 1; numThreads <= maxThreads; numThreads = (numThreads * 2 > maxThreads && numThreads < maxThreads) ? maxThreads : numThreads * 2)
+    {
+        g_options.numThreads = numThreads;
+        SIMULATION_JOB job = { pDictionary, NULL, pPossibleAnswers, numPossibleAnswers, pOpening, pOpeningCache, (numThreads == 1) ? pReferenceCounts : pGuessCounts, NULL, 0 };
+
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        parallel_for(numPossibleAnswers, SIMULATION_CHUNK_SIZE, simulate_games_range, &job);
+        double elapsedNs = bench_elapsed_ns(startTime);
+
+        bool identical = true;
+        if (numThreads == 1) referenceNs = elapsedNs;
+        else identical = memcmp(pGuessCounts, pReferenceCounts, numPossibleAnswers * sizeof(int)) == 0;
+
+        snprintf(szName, sizeof(szName), "%d thread%s (%.2fx)", numThreads, (numThreads == 1) ? "" : "s", elapsedNs > 0 ? referenceNs / elapsedNs : 0.0);
+        print_bench_result(szName, elapsedNs, (double)numPossibleAnswers, "game", identical);
+        allIdentical = allIdentical && identical;
+    }
+
+    g_options.numThreads = savedThreads;
+    free(pReferenceTable);
+    free(pMetricsTable);
+    free(pReferenceCounts);
+    free(pGuessCounts);
+    return allIdentical;
+}
+
+/**
+ * @brief Benchmarks the solver's core kernels and a full-game sweep on the loaded dictionary.
+ * Each optimized path is timed next to the reference implementation it replaces and its output is
+ * checked against it, so a speedup that changes results shows up as a MISMATCH.
+ * @param pDictionary The entire word dictionary.
+ * @param pPossibleAnswers The turn-1 possible answers.
+ * @param numPossibleAnswers The number of possible answers.
+ * @param pOpening The turn-1 recommendation (its final pick opens every game).
+ * @param pOpeningCache The turn-2 replies to the opener, or NULL.
+ * @return bool True if every run matched its reference.
+ */
+bool run_benchmarks(PWORD_ENTRY pDictionary, const char** pPossibleAnswers, long numPossibleAnswers, const RECOMMENDATION* pOpening, const OPENING_CACHE* pOpeningCache)
+{
+    printf("\n--- Benchmarks (%ld dictionary words, %ld answers, up to %d threads) ---\n", numWordsInDictionary, numPossibleAnswers, get_worker_thread_count());
+
+    bool allIdentical = bench_feedback_kernels(pDictionary, numWordsInDictionary);
+    allIdentical = bench_entropy(pPossibleAnswers, numPossibleAnswers) && allIdentical;
+    allIdentical = bench_word_kernels() && allIdentical;
+    allIdentical = bench_filter(pPossibleAnswers, numPossibleAnswers, pOpening) && allIdentical;
+    allIdentical = bench_thread_scaling(pDictionary, pPossibleAnswers, numPossibleAnswers, pOpening, pOpeningCache) && allIdentical;
+
+    printf("\n%s\n", allIdentical ? "All benchmarks matched their reference output." : "Some benchmarks did NOT match their reference output!");
+    return allIdentical;
+}
+
+// --- Server Mode ---
+
+/**
+ * @brief One queued protocol line for a session, in arrival order.
+ */
+typedef struct _server_request
+{
+    char* pszLine; // The raw JSON request (owned)
+    struct _server_request* pNext;
+} SERVER_REQUEST, * PSERVER_REQUEST;
+
+/**
+ * @brief Everything one game owns. The dictionary, pattern matrix, filter index and opening
+ * analysis are shared read-only; only these fields change while a session's requests run.
+ * At most one worker processes a session at a time, so the game fields need no locking;
+ * the scheduling fields at the end are guarded by the server lock.
+ */
+typedef struct _game_state
+{
+    long sessionId;
+    char mask[WORD_SIZE + 1];
+    char notMask[6][WORD_SIZE];
+    char good[WORD_SIZE + 1];
+    char bad[26];
+    int tryIdx;                    // Guesses applied so far (0..MAX_GUESSES)
+    bool solved;
+    WORD_ID* pCandidateIds;        // Remaining possible answers (owned, exactly numCandidates); NULL until the first guess, meaning the server's initial answers
+    long numCandidates;
+    RECOMMENDATION recommendation; // For the current candidates
+    long treeNode;                 // Decision tree node of the game, or -1 once it left the policy (or no tree is loaded)
+
+    PSERVER_REQUEST pPendingHead;  // Requests not processed yet
+    PSERVER_REQUEST pPendingTail;
+    bool isScheduled;              // On the ready list or being processed by a worker
+    bool isEnded;                  // An "end" request was processed (set under the server lock)
+    struct _game_state* pNextReady;
+} GAME_STATE, * PGAME_STATE;
+
+/**
+ * @brief Server-wide state: the shared game inputs, the session table and the ready list
+ * the workers take sessions from.
+ */
+typedef struct _solver_server
+{
+    PWORD_ENTRY pDictionary;
+    const char** pInitialAnswers;
+    long numInitialAnswers;
+    const RECOMMENDATION* pOpening;
+    const OPENING_CACHE* pOpeningCache; // Turn-2 replies to the opener, or NULL
+    FILE* fpOut;                        // Protocol responses
+
+    std::mutex lock;                    // Guards the session table, ready list and session queues
+    std::condition_variable wake;
+    std::mutex outputLock;              // Keeps response lines whole
+
+    PGAME_STATE* ppSessions;            // Open-addressing table keyed by session ID (linear probing, NULL = empty)
+    long numSessionSlots;               // A power of two, at least twice the open sessions
+    long nextSessionId;
+    long numActiveSessions;
+    PGAME_STATE pReadyHead;
+    PGAME_STATE pReadyTail;
+    bool shuttingDown;
+} SOLVER_SERVER, * PSOLVER_SERVER;
+
+/**
+ * @brief Moves protocol output off the informational messages: the returned stream writes to the
+ * original stdout and stdout itself is redirected to stderr, so startup and cache messages never
+ * end up between JSON responses.
+ * @return FILE* The protocol stream, or stdout if the descriptors could not be duplicated.
+ */
+FILE* open_protocol_stream()
+{
+    fflush(stdout);
+#ifdef _WIN32
+    int fd = _dup(_fileno(stdout));
+    FILE* fp = (fd >= 0) ? _fdopen(fd, "w") : NULL;
+    if (fp != NULL) _dup2(_fileno(stderr), _fileno(stdout));
+#else
+    int fd = dup(fileno(stdout));
+    FILE* fp = (fd >= 0) ? fdopen(fd, "w") : NULL;
+    if (fp != NULL) dup2(fileno(stderr), fileno(stdout));
+#endif
+    return (fp != NULL) ? fp : stdout;
+}
+
+/**
+ * @brief Finds the value of "key" in a flat JSON object (the protocol never nests).
+ * @return const char* The first character of the value, or NULL if the key is absent.
+ */
+static const char* json_find_value(const char* pszLine, const char* pszKey)
+{
+    size_t keyLen = strlen(pszKey);
+
+    for (const char* p = strchr(pszLine, '"'); p != NULL; p = strchr(p + 1, '"'))
+    {
+        if (strncmp(p + 1, pszKey, keyLen) != 0 || p[keyLen + 1] != '"') continue;
+
+        const char* pValue = p + keyLen + 2;
+        while (isspace((unsigned char)*pValue)) pValue++;
+        if (*pValue != ':') continue;
+        pValue++;
+        while (isspace((unsigned char)*pValue)) pValue++;
+        return pValue;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Reads a string member without escapes (all protocol strings are words, patterns or op names).
+ * @return bool True if the key holds a string that fits in valueSize.
+ */
+static bool json_get_string(const char* pszLine, const char* pszKey, char* pValue, size_t valueSize)
+{
+    const char* p = json_find_value(pszLine, pszKey);
+    if (p == NULL || *p != '"') return false;
+    p++;
+
+    size_t length = 0;
+    while (p[length] != '"')
+    {
+        if (p[length] == '\0' || p[length] == '\\' || length + 1 >= valueSize) return false;
+        length++;
+    }
+    memcpy(pValue, p, length);
+    pValue[length] = '\0';
+    return true;
+}
+
+/**
+ * @brief Reads an integer member.
+ * @return bool True if the key holds an integer.
+ */
+static bool json_get_long(const char* pszLine, const char* pszKey, long* pValue)
+{
+    const char* p = json_find_value(pszLine, pszKey);
+    if (p == NULL) return false;
+
+    char* pEnd = NULL;
+    long value = strtol(p, &pEnd, 10);
+    if (pEnd == p) return false;
+    *pValue = value;
+    return true;
+}
 
-        // Skip potential HTML tags within list items
-        if (*pTmp == '<')
-        {
-            char* pContentStart = strchr(pTmp, '>');
-            if (pContentStart != NULL && pContentStart < pWordEndTag) { pTmp = pContentStart + 1; }
-        }
+/**
+ * @brief Appends printf-style text to a response buffer, keeping it terminated when it is full.
+ * @return int The new length.
+ */
+static int append_response(char* pBuffer, int bufferSize, int length, const char* format, ...)
+{
+    if (length >= bufferSize - 1) return length;
 
-        pTmp += strspn(pTmp, nonWordChars);
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(pBuffer + length, bufferSize - length, format, args);
+    va_end(args);
 
-        // Check if the content is a 5-letter word
-        size_t wordLen = 0;
-        while (wordLen < WORD_SIZE && isalpha((unsigned char)*(pTmp + wordLen))) { wordLen++; }
+    if (written < 0) return length;
+    return (length + written < bufferSize) ? length + written : bufferSize - 1;
+}
 
-        if (wordLen == WORD_SIZE)
-        {
-            bool skip_word = false;
+/**
+ * @brief Writes one response line.
+ */
+static void write_server_response(PSOLVER_SERVER pServer, const char* pszResponse)
+{
+    std::lock_guard<std::mutex> guard(pServer->outputLock);
+    fputs(pszResponse, pServer->fpOut);
+    fputc('\n', pServer->fpOut);
+    fflush(pServer->fpOut);
+}
 
-#ifdef NUM_REPLAY_WORDS
-            // Check against the replay list
-            for (int i = 0; i < NUM_REPLAY_WORDS && skip_word == false; i++)
-            {
-                if (strncmp(pTmp, g_wordle_replay_words[i], WORD_SIZE) == 0)
-                {
-                    skip_word = true;
-                }
-            }
-#endif
+/**
+ * @brief Starts a response with the request's "id" (if it had one) and the session ID (if known).
+ * @return int The length written.
+ */
+static int begin_server_response(char* pBuffer, int bufferSize, const char* pszRequest, long sessionId)
+{
+    long requestId = 0;
+    int length = append_response(pBuffer, bufferSize, 0, "{");
+    if (pszRequest != NULL && json_get_long(pszRequest, "id", &requestId)) length = append_response(pBuffer, bufferSize, length, "\"id\":%ld,", requestId);
+    if (sessionId > 0) length = append_response(pBuffer, bufferSize, length, "\"session\":%ld,", sessionId);
+    return length;
+}
 
-            // If the word is NOT in the replay list, add it to the exclusion list (pTop)
-            if (!skip_word)
-            {
-                pNew = (PWORD_NODE)malloc(sizeof(WORD_NODE));
-                if (pNew == NULL) { fprintf(stderr, "Out of memory!\n"); return NULL; }
-                memset(pNew, 0, sizeof(WORD_NODE));
+/**
+ * @brief Writes {"ok":false,"error":...} for a request.
+ */
+static void write_server_error(PSOLVER_SERVER pServer, const char* pszRequest, long sessionId, const char* pszError)
+{
+    char response[256];
+    int length = begin_server_response(response, sizeof(response), pszRequest, sessionId);
+    append_response(response, sizeof(response), length, "\"ok\":false,\"error\":\"%s\"}", pszError);
+    write_server_response(pServer, response);
+}
 
-                // Copy and uppercase the word
-                memcpy(pNew->word, pTmp, WORD_SIZE);
-                for (int i = 0; i < WORD_SIZE; i++)
-                {
-                    pNew->word[i] = toupper((unsigned char)pNew->word[i]);
-                }
-                pNew->word[WORD_SIZE] = '\0';
+/**
+ * @brief Returns the text of a session's i-th remaining possible answer.
+ */
+static const char* get_session_candidate(const SOLVER_SERVER* pServer, const GAME_STATE* pState, long i)
+{
+    return (pState->pCandidateIds != NULL) ? get_word_text(pState->pCandidateIds[i]) : pServer->pInitialAnswers[i];
+}
 
-                numUsedWords++;
-                *ppNextNew = pNew;
-                ppNextNew = &(pNew->pNxt);
-            }
-        }
+/**
+ * @brief Writes a session's current recommendation (and, for small sets, its remaining answers).
+ */
+static void write_session_recommendation(PSOLVER_SERVER pServer, const char* pszRequest, const GAME_STATE* pState)
+{
+    char response[1024];
+    const RECOMMENDATION* pRec = &pState->recommendation;
 
-        // Move pointer to the start of the next list item
-        char* pNextListItem = strstr(pTmp + 1, wordStartTag);
-        char* pEndList = strstr(pTmp + 1, listEndTag);
+    int length = begin_server_response(response, sizeof(response), pszRequest, pState->sessionId);
+    length = append_response(response, sizeof(response), length,
+        "\"ok\":true,\"turn\":%d,\"remaining\":%ld,\"solved\":false,\"pick\":\"%s\",\"rank\":%d,\"entropy\":%.4f,\"rank_pick\":\"%s\",\"entropy_pick\":\"%s\"",
+        pState->tryIdx + 1, pState->numCandidates, pRec->finalPick.word, pRec->finalPick.rank, pRec->finalPick.entropy,
+        pRec->rankPick.word, pRec->entropyPick.word);
 
-        if (pNextListItem != NULL && (pEndList == NULL || pNextListItem < pEndList))
-        {
-            pTmp = pNextListItem;
-        }
-        else if (pEndList != NULL)
-        {
-            pTmp = pEndList;
-        }
-        else
+    if (pState->numCandidates <= LOW_POSSIBLE_ANSWER_COUNT)
+    {
+        length = append_response(response, sizeof(response), length, ",\"candidates\":[");
+        for (long i = 0; i < pState->numCandidates; i++)
         {
-            pTmp = NULL;
+            length = append_response(response, sizeof(response), length, "%s\"%s\"", i ? "," : "", get_session_candidate(pServer, pState, i));
         }
+        length = append_response(response, sizeof(response), length, "]");
     }
+    append_response(response, sizeof(response), length, "}");
+    write_server_response(pServer, response);
+}
 
-    printf("Found %ld total used words (excluding replay words).\n", numUsedWords);
-    return(pTop);
+/**
+ * @brief Creates a session at the start-of-game state; its turn-1 recommendation is the shared opening.
+ * The session shares the server's initial answers until its first guess narrows them.
+ * @return PGAME_STATE The session, or NULL on memory allocation failure.
+ */
+static PGAME_STATE create_game_state(PSOLVER_SERVER pServer)
+{
+    PGAME_STATE pState = (PGAME_STATE)calloc(1, sizeof(GAME_STATE));
+    if (pState == NULL) return NULL;
+
+    init_game_constraints(pState->mask, pState->notMask, pState->good, pState->bad);
+    pState->pCandidateIds = NULL;
+    pState->numCandidates = pServer->numInitialAnswers;
+    pState->recommendation = *pServer->pOpening;
+    pState->treeNode = (g_decisionTree.pNodes != NULL) ? 0 : -1;
+    return pState;
 }
 
+/**
+ * @brief Frees a session and any requests still queued for it.
+ */
+static void free_game_state(PGAME_STATE pState)
+{
+    while (pState->pPendingHead != NULL)
+    {
+        PSERVER_REQUEST pRequest = pState->pPendingHead;
+        pState->pPendingHead = pRequest->pNext;
+        free(pRequest->pszLine);
+        free(pRequest);
+    }
+    free(pState->pCandidateIds);
+    free(pState);
+}
 
 /**
- * @brief Fetches and loads the local dictionary file into memory.
- * The dictionary is loaded into a contiguous array of WORD_ENTRY structures and sorted.
- * @return PWORD_ENTRY Pointer to the allocated dictionary array, or NULL on failure.
+ * @brief Takes the turn-2 recommendation from the opening cache when the first guess was the
+ * cached opener.
+ * @param pOpeningCache The turn-2 replies to the opener, or NULL.
+ * @param guess The first guess (any case).
+ * @param pattern Its B/G/Y result.
+ * @param numCandidates The answers left after it (a cross-check against the cached reply).
+ * @param pRec Output: the cached recommendation.
+ * @return bool True if the reply was in the cache.
  */
-PWORD_ENTRY get_dictionary_table()
+bool get_opener_reply(const OPENING_CACHE* pOpeningCache, PWORD_ENTRY pDictionary, const char* guess, const char* pattern, long numCandidates, PRECOMMENDATION pRec)
 {
-    FILE* fpIn;
-    errno_t errval;
-    char buffer[100];
-    numWordsInDictionary = 0;
+    if (pOpeningCache == NULL || pOpeningCache->header.openerIndex < 0 || !is_same_word(guess, pDictionary[pOpeningCache->header.openerIndex].word)) return false;
 
-    PWORD_ENTRY pDictionary = (PWORD_ENTRY)malloc(sizeof(WORD_ENTRY) * maxDictionary);
-    if (pDictionary == NULL)
+    const CACHED_RECOMMENDATION* pReply = pOpeningCache->replies + encode_feedback_pattern(pattern);
+    return pReply->numPossibleAnswers == numCandidates && unpack_cached_recommendation(pReply, pDictionary, numWordsInDictionary, pRec);
+}
+
+/**
+ * @brief Applies a "guess" request to a session and answers with the next recommendation.
+ * @param pMetricsTable The calling worker's metric work buffer (numWordsInDictionary entries).
+ */
+static void process_guess_request(PSOLVER_SERVER pServer, PGAME_STATE pState, const char* pszRequest, PGUESS_METRICS pMetricsTable)
+{
+    char guess[WORD_SIZE + 2];
+    char pattern[WORD_SIZE + 2];
+    RECOMMENDATION rec;
+
+    if (pState->solved || pState->tryIdx >= MAX_GUESSES || pState->numCandidates == 0)
     {
-        fprintf(stderr, "Out of memory allocating dictionary!\n");
-        return NULL;
+        write_server_error(pServer, pszRequest, pState->sessionId, "game is over");
+        return;
     }
-
-    // Hardcoded path to the dictionary file
-    errval = fopen_s(&fpIn, "C:\\VS2022.Projects\\StuffForWordle\\WordleWordsCSVs\\AllWords.txt", "r");
-    if (fpIn == NULL || errval != 0)
+    if (!json_get_string(pszRequest, "word", guess, sizeof(guess)) || strlen(guess) != WORD_SIZE ||
+        !json_get_string(pszRequest, "result", pattern, sizeof(pattern)) || strlen(pattern) != WORD_SIZE)
     {
-        fprintf(stderr, "Could not open consolidated dictionary file (AllWords.txt)! Check the hardcoded path.\n");
-        free(pDictionary);
-        return NULL;
+        write_server_error(pServer, pszRequest, pState->sessionId, "guess needs a 5-letter word and a 5-character result");
+        return;
+    }
+    for (int i = 0; i < WORD_SIZE; i++)
+    {
+        guess[i] = toupper((unsigned char)guess[i]);
+        pattern[i] = toupper((unsigned char)pattern[i]);
+        if (guess[i] < 'A' || guess[i] > 'Z' || (pattern[i] != 'B' && pattern[i] != 'G' && pattern[i] != 'Y'))
+        {
+            write_server_error(pServer, pszRequest, pState->sessionId, "word must be letters and result only B, G or Y");
+            return;
+        }
     }
 
-    // Read the file line by line, parsing the word, rank, and linguistic types
-    while (fgets(buffer, 100, fpIn) != NULL && numWordsInDictionary < maxDictionary)
+    // The solver filters and scores word pointers; the session keeps only the IDs it has left
+    PSCRATCH_ARENA pArena = get_scratch_arena();
+    size_t mark = scratch_mark(pArena);
+    const char** pCandidates = (const char**)scratch_alloc(pArena, pState->numCandidates * sizeof(char*));
+    if (pCandidates == NULL)
     {
-        trim(buffer);
+        write_server_error(pServer, pszRequest, pState->sessionId, "out of memory");
+        scratch_release(pArena, mark);
+        return;
+    }
+    for (long i = 0; i < pState->numCandidates; i++) pCandidates[i] = get_session_candidate(pServer, pState, i);
 
-        // Line format: [5-Letter Word][3-Digit Rank][Noun Type][Verb Type] (min 10 chars)
-        if (strlen(buffer) >= 10)
-        {
-            PWORD_ENTRY pEntry = pDictionary + numWordsInDictionary;
+    pState->tryIdx++;
+    update_game_constraints(guess, pattern, pState->mask, pState->notMask, pState->good, pState->bad, pState->tryIdx);
 
-            // 1. Extract and format the word (first 5 characters)
-            memcpy(pEntry->word, buffer, WORD_SIZE);
-            for (int i = 0; i < WORD_SIZE; i++)
-            {
-                pEntry->word[i] = toupper((unsigned char)pEntry->word[i]);
-            }
-            pEntry->word[WORD_SIZE] = '\0';
+    if (strchr(pState->mask, '*') == NULL)
+    {
+        char response[256];
+        pState->solved = true;
+        int length = begin_server_response(response, sizeof(response), pszRequest, pState->sessionId);
+        append_response(response, sizeof(response), length, "\"ok\":true,\"turn\":%d,\"solved\":true,\"answer\":\"%s\"}", pState->tryIdx, pState->mask);
+        write_server_response(pServer, response);
+        scratch_release(pArena, mark);
+        return;
+    }
 
-            // 2. Extract and parse the rank (next 3 characters: 000-100)
-            char rankStr[4];
-            memcpy(rankStr, buffer + 5, 3);
-            rankStr[3] = '\0';
-            pEntry->rank = atoi(rankStr);
+    long numCandidates = filter_possible_answers_after_guess(guess, pattern, pCandidates, pState->numCandidates,
+        pState->mask, pState->notMask, pState->good, pState->bad, pState->tryIdx);
 
-            // 3. Extract linguistic types (next 2 characters)
-            pEntry->nounType = buffer[8];
-            pEntry->verbType = buffer[9];
+    // Shrink the session to the answers left (a failed allocation ends the game rather than keep stale IDs)
+    WORD_ID* pCandidateIds = (WORD_ID*)malloc((numCandidates > 0 ? numCandidates : 1) * sizeof(WORD_ID));
+    free(pState->pCandidateIds);
+    pState->pCandidateIds = pCandidateIds;
+    pState->numCandidates = (pCandidateIds != NULL) ? numCandidates : 0;
+    for (long i = 0; i < pState->numCandidates; i++) pCandidateIds[i] = get_word_id(pCandidates[i]);
 
-            numWordsInDictionary++;
-        }
+    if (pCandidateIds == NULL)
+    {
+        write_server_error(pServer, pszRequest, pState->sessionId, "out of memory");
+        scratch_release(pArena, mark);
+        return;
+    }
+    if (pState->numCandidates == 0)
+    {
+        write_server_error(pServer, pszRequest, pState->sessionId, "no possible answers remain");
+        scratch_release(pArena, mark);
+        return;
     }
 
-    fclose(fpIn);
-    printf("Loaded %ld words from the new consolidated dictionary.\n", numWordsInDictionary);
-    // Sort the dictionary for efficient O(log N) binary search access
-    qsort(pDictionary, numWordsInDictionary, sizeof(WORD_ENTRY), compare);
+    // Games that follow the precomputed policy walk the decision tree; the reply to the cached opener
+    // was precomputed with the opening analysis
+    pState->treeNode = find_decision_tree_child(&g_decisionTree, pState->treeNode, guess, encode_feedback_pattern(pattern), pState->numCandidates);
+    bool haveReply = pState->treeNode >= 0;
+    if (haveReply)
+    {
+        get_decision_tree_recommendation(g_decisionTree.pNodes + pState->treeNode, &rec);
+        stats_count(STAT_DECISION_TREE_HITS, 1);
+    }
+    else
+    {
+        haveReply = pState->tryIdx == 1 && get_opener_reply(pServer->pOpeningCache, pServer->pDictionary, guess, pattern, pState->numCandidates, &rec);
+    }
+    if (!haveReply && !get_shared_recommendation(pCandidates, pState->numCandidates, pState->good, pMetricsTable, NULL, &rec))
+    {
+        write_server_error(pServer, pszRequest, pState->sessionId, "out of memory");
+        scratch_release(pArena, mark);
+        return;
+    }
 
-    return pDictionary;
+    pState->recommendation = rec;
+    write_session_recommendation(pServer, pszRequest, pState);
+    scratch_release(pArena, mark);
 }
 
 /**
- * @brief Fetches the list of previously used Wordle answers, processes the linked list,
- * and stores them in a sorted contiguous array for fast lookup.
- * @return char* Pointer to the allocated, sorted array of used words (packed 5-char strings).
+ * @brief Runs one request against the session it was queued on (the worker owns the session meanwhile).
+ * @return bool True if the request was "end"; the caller marks the session ended under the server lock.
  */
-char* get_used_words_table()
+static bool process_server_request(PSOLVER_SERVER pServer, PGAME_STATE pState, const char* pszRequest, PGUESS_METRICS pMetricsTable)
 {
-    char* pUsedWords_webpage = NULL;
-    PWORD_LIST pUsedWords = NULL;
-    PWORD_NODE pWord = NULL;
-    char* pTable = NULL;
-    long cnt = 0;
+    char op[16];
+    json_get_string(pszRequest, "op", op, sizeof(op)); // Validated by the reader
 
-    pUsedWords_webpage = get_used_words_webpage();
-
-    if (pUsedWords_webpage != NULL)
+    if (strcmp(op, "guess") == 0)
     {
-        // Parse the HTML content into a linked list of words
-        pUsedWords = get_used_words_from_webpage_string(pUsedWords_webpage);
-        free(pUsedWords_webpage);
-
-        if (pUsedWords != NULL)
-        {
-            // Allocate space for a contiguous array of 5-char words
-            pTable = (char*)malloc(WORD_SIZE * numUsedWords);
-            if (pTable == NULL)
-            {
-                fprintf(stderr, "Out of memory allocating used word table\n");
-                return NULL;
-            }
-
-            // Copy words from linked list to the contiguous array and free list nodes
-            pWord = pUsedWords;
-            while (pWord != NULL)
-            {
-                PWORD_NODE pTemp = pWord->pNxt;
-
-                memcpy(pTable + (cnt * WORD_SIZE), pWord->word, WORD_SIZE);
-                free(pWord);
-                pWord = pTemp;
-                cnt++;
-            }
-        }
+        process_guess_request(pServer, pState, pszRequest, pMetricsTable);
     }
-
-    if (pTable != NULL)
+    else if (strcmp(op, "end") == 0)
     {
-        // Sort the list of used words for efficient O(log N) exclusion check
-        qsort(pTable, numUsedWords, WORD_SIZE, compare);
+        char response[128];
+        int length = begin_server_response(response, sizeof(response), pszRequest, pState->sessionId);
+        append_response(response, sizeof(response), length, "\"ok\":true,\"ended\":true}");
+        write_server_response(pServer, response);
+        return true;
     }
-    else // Ensure pTable is not NULL if no words were found
+    else if (pState->solved)
     {
-        pTable = (char*)malloc(1);
-        numUsedWords = 0;
+        write_server_error(pServer, pszRequest, pState->sessionId, "game is over");
+    }
+    else // "new" or "recommend"
+    {
+        write_session_recommendation(pServer, pszRequest, pState);
     }
+    return false;
+}
 
-    return pTable;
+/**
+ * @brief Finds a session ID's slot in the session table: the slot holding it, or the empty slot
+ * that ends its probe sequence. IDs are handed out in order, so the ID itself spreads them.
+ * Caller holds the server lock.
+ */
+static long find_session_slot(const PGAME_STATE* ppSessions, long numSlots, long sessionId)
+{
+    long slot = sessionId & (numSlots - 1);
+    while (ppSessions[slot] != NULL && ppSessions[slot]->sessionId != sessionId) slot = (slot + 1) & (numSlots - 1);
+    return slot;
 }
 
 /**
- * @brief Checks if a given word is a valid remaining answer based on current game constraints.
- * @param pMask Mask of known green letters (e.g., "*A*S*").
- * @param notMask Array of letters that cannot be in specific positions (from yellow and black results).
- * @param pGood String of required letters (min count constraint, from yellow and green results).
- * @param pBad String of letters that must be completely absent (from black results).
- * @param pWord The word being checked against the constraints.
- * @return 1 if the word is a good fit, 0 otherwise.
+ * @brief Returns the open session with an ID. Caller holds the server lock.
+ * @return PGAME_STATE The session, or NULL if the ID is not open.
  */
-int is_good_fit(char* pMask, char notMask[6][5], char* pGood, char* pBad, char* pWord)
+static PGAME_STATE find_game_state(const SOLVER_SERVER* pServer, long sessionId)
 {
-    // 1. CHECK REQUIRED LETTER COUNTS (YELLOW AND GREEN)
-    int required_counts[26] = { 0 };
-    for (char* p = pGood; *p != '\0'; p++)
+    if (pServer->ppSessions == NULL || sessionId <= 0) return NULL;
+    return pServer->ppSessions[find_session_slot(pServer->ppSessions, pServer->numSessionSlots, sessionId)];
+}
+
+/**
+ * @brief Registers a new session under the next session ID, doubling the session table when it
+ * would become more than half full. IDs are never reused. Caller holds the server lock.
+ * @return bool False if the maximum number of sessions is open or the table could not grow.
+ */
+static bool register_game_state(PSOLVER_SERVER pServer, PGAME_STATE pState)
+{
+    if (pServer->numActiveSessions >= SERVER_MAX_SESSIONS) return false;
+
+    if ((pServer->numActiveSessions + 1) * 2 > pServer->numSessionSlots)
     {
-        required_counts[*p - 'A']++;
+        long numSlots = (pServer->numSessionSlots > 0) ? pServer->numSessionSlots * 2 : SERVER_INITIAL_SESSION_SLOTS;
+        PGAME_STATE* ppSessions = (PGAME_STATE*)calloc(numSlots, sizeof(PGAME_STATE));
+        if (ppSessions == NULL) return false;
+
+        for (long i = 0; i < pServer->numSessionSlots; i++)
+        {
+            PGAME_STATE pOpen = pServer->ppSessions[i];
+            if (pOpen != NULL) ppSessions[find_session_slot(ppSessions, numSlots, pOpen->sessionId)] = pOpen;
+        }
+        free(pServer->ppSessions);
+        pServer->ppSessions = ppSessions;
+        pServer->numSessionSlots = numSlots;
     }
 
-    for (int i = 0; i < 26; i++)
+    pState->sessionId = pServer->nextSessionId++;
+    pServer->ppSessions[find_session_slot(pServer->ppSessions, pServer->numSessionSlots, pState->sessionId)] = pState;
+    pServer->numActiveSessions++;
+    return true;
+}
+
+/**
+ * @brief Removes a session from the session table, moving later entries of its probe run back into
+ * the hole so every open session stays reachable. Caller holds the server lock.
+ */
+static void unregister_game_state(PSOLVER_SERVER pServer, const GAME_STATE* pState)
+{
+    long mask = pServer->numSessionSlots - 1;
+    long hole = find_session_slot(pServer->ppSessions, pServer->numSessionSlots, pState->sessionId);
+
+    for (long slot = (hole + 1) & mask; pServer->ppSessions[slot] != NULL; slot = (slot + 1) & mask)
     {
-        if (required_counts[i] > 0)
+        // An entry may fill the hole if the hole lies between its home slot and where it sits now
+        long home = pServer->ppSessions[slot]->sessionId & mask;
+        if (((slot - home) & mask) >= ((slot - hole) & mask))
         {
-            char required_char = 'A' + i;
-            int word_count = 0;
+            pServer->ppSessions[hole] = pServer->ppSessions[slot];
+            hole = slot;
+        }
+    }
+    pServer->ppSessions[hole] = NULL;
+    pServer->numActiveSessions--;
+}
 
-            for (int wordIdx = 0; wordIdx < WORD_SIZE; wordIdx++)
-            {
-                if (*(pWord + wordIdx) == required_char)
-                {
-                    word_count++;
-                }
-            }
+/**
+ * @brief Server worker: takes a ready session, runs its oldest request, then requeues the session
+ * if more requests arrived. Sessions run in parallel; one session's requests run in order.
+ * Scoring runs inline on the worker (parallelism comes from serving many sessions at once).
+ */
+static void run_server_worker(PSOLVER_SERVER pServer)
+{
+    t_isParallelWorker = true;
+    PGUESS_METRICS pMetricsTable = (PGUESS_METRICS)malloc(numWordsInDictionary * sizeof(GUESS_METRICS));
 
-            // Word must contain at least the minimum required count of the letter
-            if (word_count < required_counts[i])
+    std::unique_lock<std::mutex> guard(pServer->lock);
+    while (true)
+    {
+        while (pServer->pReadyHead == NULL && !pServer->shuttingDown) pServer->wake.wait(guard);
+        if (pServer->pReadyHead == NULL) break;
+
+        PGAME_STATE pState = pServer->pReadyHead;
+        pServer->pReadyHead = pState->pNextReady;
+        if (pServer->pReadyHead == NULL) pServer->pReadyTail = NULL;
+        pState->pNextReady = NULL;
+
+        PSERVER_REQUEST pRequest = pState->pPendingHead;
+        pState->pPendingHead = pRequest->pNext;
+        if (pState->pPendingHead == NULL) pState->pPendingTail = NULL;
+
+        guard.unlock();
+        bool isEnded = false;
+        if (pMetricsTable != NULL) isEnded = process_server_request(pServer, pState, pRequest->pszLine, pMetricsTable);
+        else write_server_error(pServer, pRequest->pszLine, pState->sessionId, "out of memory");
+        free(pRequest->pszLine);
+        free(pRequest);
+        guard.lock();
+
+        // The reader checks isEnded under the lock, so it is only set here
+        if (isEnded) pState->isEnded = true;
+
+        if (pState->isEnded)
+        {
+            // Requests that arrived after "end" are answered, not run
+            for (PSERVER_REQUEST p = pState->pPendingHead; p != NULL; p = p->pNext)
             {
-                return 0;
+                write_server_error(pServer, p->pszLine, pState->sessionId, "unknown session");
             }
+            unregister_game_state(pServer, pState);
+            free_game_state(pState);
+        }
+        else if (pState->pPendingHead != NULL)
+        {
+            if (pServer->pReadyTail) pServer->pReadyTail->pNextReady = pState;
+            else pServer->pReadyHead = pState;
+            pServer->pReadyTail = pState;
+        }
+        else
+        {
+            pState->isScheduled = false;
         }
     }
 
-    // 2. CHECK POSITIONAL CONSTRAINTS
-    for (int idx = 0; (idx < WORD_SIZE); idx++)
+    free(pMetricsTable);
+    release_thread_scratch_arena();
+}
+
+/**
+ * @brief Adds a request to a session's queue and schedules the session. Caller holds the server lock.
+ * @return bool False on memory allocation failure.
+ */
+static bool queue_session_request(PSOLVER_SERVER pServer, PGAME_STATE pState, const char* pszLine)
+{
+    PSERVER_REQUEST pRequest = (PSERVER_REQUEST)malloc(sizeof(SERVER_REQUEST));
+    char* pszCopy = (pRequest != NULL) ? (char*)malloc(strlen(pszLine) + 1) : NULL;
+    if (pszCopy == NULL)
     {
-        char theChar = *(pWord + idx);
+        free(pRequest);
+        return false;
+    }
+    strcpy(pszCopy, pszLine);
+    pRequest->pszLine = pszCopy;
+    pRequest->pNext = NULL;
 
-        // Must not contain any "black-listed" letters (pBad)
-        if (strchr(pBad, theChar) != NULL) return 0;
+    if (pState->pPendingTail) pState->pPendingTail->pNext = pRequest;
+    else pState->pPendingHead = pRequest;
+    pState->pPendingTail = pRequest;
+
+    if (!pState->isScheduled)
+    {
+        pState->isScheduled = true;
+        if (pServer->pReadyTail) pServer->pReadyTail->pNextReady = pState;
+        else pServer->pReadyHead = pState;
+        pServer->pReadyTail = pState;
+        pServer->wake.notify_one();
+    }
+    return true;
+}
+
+/**
+ * @brief Reads one request, validates the envelope and queues it on its session.
+ * @return bool False if the request was "quit".
+ */
+static bool dispatch_server_request(PSOLVER_SERVER pServer, const char* pszLine)
+{
+    char op[16];
+    long sessionId = 0;
 
-        // Must match green letter mask (pMask)
-        if (*(pMask + idx) != '*' && *(pMask + idx) != theChar) return 0;
+    if (!json_get_string(pszLine, "op", op, sizeof(op)))
+    {
+        write_server_error(pServer, pszLine, 0, "missing op");
+        return true;
+    }
+    if (strcmp(op, "quit") == 0) return false;
 
-        // Must not have a yellow letter in the known incorrect position (notMask)
-        for (int notIdx = 0; notIdx < 6; notIdx++)
+    if (strcmp(op, "new") == 0)
+    {
+        PGAME_STATE pState = create_game_state(pServer);
+        std::lock_guard<std::mutex> guard(pServer->lock);
+        if (pState == NULL || !register_game_state(pServer, pState))
         {
-            if (notMask[notIdx][idx] == theChar) return 0;
+            if (pState) free_game_state(pState);
+            write_server_error(pServer, pszLine, 0, "cannot create session");
+        }
+        else if (!queue_session_request(pServer, pState, pszLine))
+        {
+            write_server_error(pServer, pszLine, pState->sessionId, "out of memory");
         }
+        return true;
     }
 
-    return 1;
-}
+    if (strcmp(op, "guess") != 0 && strcmp(op, "recommend") != 0 && strcmp(op, "end") != 0)
+    {
+        write_server_error(pServer, pszLine, 0, "unknown op");
+        return true;
+    }
+    if (!json_get_long(pszLine, "session", &sessionId))
+    {
+        write_server_error(pServer, pszLine, 0, "missing session");
+        return true;
+    }
 
-/**
- * @brief Looks up and returns the linguistic types and rank for a word from the dictionary.
- * @param word The word to look up.
- * @param pDictionary The dictionary array.
- * @param numDictionary The size of the dictionary.
- * @param nounType Output pointer for noun type ('P', 'S', 'N').
- * @param verbType Output pointer for verb type ('T', 'S', 'P', 'N').
- * @param rank Output pointer for the word rank (0-100).
- */
-void get_linguistic_types(const char* word, PWORD_ENTRY pDictionary, long numDictionary, char* nounType, char* verbType, int* rank)
-{
-    PWORD_ENTRY pFound = get_word_entry_from_word(word, pDictionary, numDictionary);
-    if (pFound)
+    std::lock_guard<std::mutex> guard(pServer->lock);
+    PGAME_STATE pState = find_game_state(pServer, sessionId);
+    if (pState == NULL || pState->isEnded)
     {
-        *nounType = pFound->nounType;
-        *verbType = pFound->verbType;
-        *rank = pFound->rank;
+        write_server_error(pServer, pszLine, sessionId, "unknown session");
     }
-    else
+    else if (!queue_session_request(pServer, pState, pszLine))
     {
-        // Default values for words not found in the linguistic dictionary
-        *nounType = 'N';
-        *verbType = 'N';
-        *rank = 0;
+        write_server_error(pServer, pszLine, sessionId, "out of memory");
     }
+    return true;
 }
 
 /**
- * @brief Calculates the Wordle feedback pattern (G, Y, B) for a hypothetical guess/answer pair.
- * This simulates the core Wordle logic needed for entropy calculation.
- * @param guess The word being guessed.
- * @param answer The actual solution word.
- * @param result_pattern Output buffer for the 5-character result pattern (e.g., "BGYBB").
+ * @brief Serves games over a line protocol: one JSON object per line on stdin, one per line back.
+ * Requests: {"op":"new"}, {"op":"guess","session":N,"word":"CRANE","result":"BGYBB"},
+ * {"op":"recommend","session":N}, {"op":"end","session":N} and {"op":"quit"}; any request may
+ * carry a numeric "id" that is echoed in its response. Responses of different sessions can
+ * interleave; each session's responses come in request order.
+ * @param pDictionary The entire word dictionary.
+ * @param pPossibleAnswers The turn-1 possible answers every new session starts from.
+ * @param numPossibleAnswers The number of possible answers.
+ * @param pOpening The shared turn-1 recommendation.
+ * @param pOpeningCache The turn-2 replies to the opener, or NULL.
+ * @param fpOut The protocol output stream (see open_protocol_stream).
+ * @return bool True on a clean shutdown (EOF or "quit").
  */
-void get_feedback_pattern(const char* guess, const char* answer, char* result_pattern)
+bool run_server(PWORD_ENTRY pDictionary, const char** pPossibleAnswers, long numPossibleAnswers, const RECOMMENDATION* pOpening, const OPENING_CACHE* pOpeningCache, FILE* fpOut)
 {
-    memset(result_pattern, 'B', WORD_SIZE);
-    result_pattern[WORD_SIZE] = '\0';
-
-    int answer_char_counts[26] = { 0 };
-    bool guess_used[WORD_SIZE] = { false };
-
-    // 1. Determine Green ('G') matches and tally remaining answer letters
-    for (int i = 0; i < WORD_SIZE; i++)
+    char line[SERVER_MAX_LINE];
+    char response[256];
+    SOLVER_SERVER* pServer = new SOLVER_SERVER();
+
+    pServer->pDictionary = pDictionary;
+    pServer->pInitialAnswers = pPossibleAnswers;
+    pServer->numInitialAnswers = numPossibleAnswers;
+    pServer->pOpening = pOpening;
+    pServer->pOpeningCache = pOpeningCache;
+    pServer->fpOut = fpOut;
+    pServer->ppSessions = NULL;
+    pServer->numSessionSlots = 0;
+    pServer->nextSessionId = 1; // 0 means "no session" in responses
+    pServer->numActiveSessions = 0;
+    pServer->pReadyHead = NULL;
+    pServer->pReadyTail = NULL;
+    pServer->shuttingDown = false;
+
+    int numWorkers = get_worker_thread_count();
+    std::thread* pWorkers = new std::thread[numWorkers];
+    int numStarted = 0;
+    for (int w = 0; w < numWorkers; w++)
     {
-        if (guess[i] == answer[i])
+        try
         {
-            result_pattern[i] = 'G';
-            guess_used[i] = true;
+            pWorkers[numStarted] = std::thread(run_server_worker, pServer);
+            numStarted++;
         }
-        else
+        catch (...)
         {
-            answer_char_counts[answer[i] - 'A']++;
+            break;
         }
     }
 
-    // 2. Determine Yellow ('Y') matches
-    for (int i = 0; i < WORD_SIZE; i++)
+    bool ok = (numStarted > 0);
+    if (ok)
     {
-        if (result_pattern[i] != 'G')
+        snprintf(response, sizeof(response), "{\"ok\":true,\"ready\":true,\"words\":%ld,\"answers\":%ld,\"workers\":%d,\"opener\":\"%s\"}",
+            numWordsInDictionary, numPossibleAnswers, numStarted, pOpening->finalPick.word);
+        write_server_response(pServer, response);
+
+        while (fgets(line, sizeof(line), stdin) != NULL)
         {
-            int letter_index = guess[i] - 'A';
-            if (answer_char_counts[letter_index] > 0)
+            if (strchr(line, '\n') == NULL && !feof(stdin))
             {
-                result_pattern[i] = 'Y';
-                // Decrement count to handle duplicates correctly
-                answer_char_counts[letter_index]--;
+                int ch;
+                while ((ch = getchar()) != '\n' && ch != EOF) {}
+                write_server_error(pServer, NULL, 0, "request too long");
+                continue;
             }
+            trim(line);
+            if (line[0] == '\0') continue;
+            if (!dispatch_server_request(pServer, line)) break;
         }
     }
+    else
+    {
+        fprintf(stderr, "Could not start any server worker threads!\n");
+    }
+
+    // Let the workers drain every queued request, then release the sessions still open
+    {
+        std::lock_guard<std::mutex> guard(pServer->lock);
+        pServer->shuttingDown = true;
+    }
+    pServer->wake.notify_all();
+    for (int w = 0; w < numStarted; w++) pWorkers[w].join();
+    delete[] pWorkers;
+
+    for (long i = 0; i < pServer->numSessionSlots; i++)
+    {
+        if (pServer->ppSessions[i] != NULL) free_game_state(pServer->ppSessions[i]);
+    }
+    free(pServer->ppSessions);
+    delete pServer;
+    return ok;
 }
 
+// --- Batch Queries ---
+
 /**
- * @brief Calculates the Shannon Entropy score for a word against the possible answers.
- * @param guess The word to calculate entropy for.
- * @param possibleAnswers Array of remaining possible answer words.
- * @param numPossibleAnswers The number of words in the array.
- * @return double The calculated entropy score (H).
+ * @brief One step of the batch history trie. Lines sharing a prefix share its nodes, so each
+ * distinct prefix is filtered once.
  */
-double calculate_entropy_score(const char* guess, const char** possibleAnswers, long numPossibleAnswers)
+typedef struct _batch_node
 {
-    double entropy = 0.0;
+    char guess[WORD_SIZE + 1];
     char pattern[WORD_SIZE + 1];
+    long firstChild;  // First child node, or -1
+    long nextSibling; // Next child of the same parent, or -1
+    long resultIdx;   // Result of the lines ending here, or -1 if no line ends here
+} BATCH_NODE, * PBATCH_NODE;
 
-    PWORD_LIST pPatternCounts = NULL;
-    PWORD_NODE pNew = NULL;
-    PWORD_NODE pCurrent;
-    PWORD_NODE* ppNextNew;
+/**
+ * @brief The answer to every line ending at one node.
+ */
+typedef struct _batch_result
+{
+    const char* pszError; // NULL on success
+    int turn;             // Turn the recommendation is for (guesses applied + 1)
+    bool solved;
+    char answer[WORD_SIZE + 1]; // When solved
+    long numCandidates;
+    const char* candidates[LOW_POSSIBLE_ANSWER_COUNT]; // When numCandidates <= LOW_POSSIBLE_ANSWER_COUNT
+    RECOMMENDATION recommendation;
+} BATCH_RESULT, * PBATCH_RESULT;
 
-    if (numPossibleAnswers <= 1) return 0.0;
+/**
+ * @brief One input line: its number in the file and the node its history ends at, or a parse error.
+ */
+typedef struct _batch_line
+{
+    long lineNumber;
+    long nodeIdx;         // -1 on a parse error
+    const char* pszError; // Parse error, or NULL
+} BATCH_LINE, * PBATCH_LINE;
 
-    // 1. Tally the frequency of each possible result pattern
-    for (long i = 0; i < numPossibleAnswers; i++)
+/**
+ * @brief A whole batch: the history trie (node 0 is the empty history), the results of its
+ * queried nodes and the input lines in order.
+ */
+typedef struct _batch
+{
+    PBATCH_NODE pNodes;
+    long numNodes;
+    long nodeCapacity;
+    PBATCH_RESULT pResults;
+    long numResults;
+    PBATCH_LINE pLines;
+    long numLines;
+    long lineCapacity;
+} BATCH, * PBATCH;
+
+/**
+ * @brief Game constraints after a node's history; children start from a copy.
+ */
+typedef struct _batch_state
+{
+    char mask[WORD_SIZE + 1];
+    char notMask[6][WORD_SIZE];
+    char good[WORD_SIZE + 1];
+    char bad[26];
+    int tryIdx;
+    const char** pCandidates;
+    long numCandidates;
+} BATCH_STATE, * PBATCH_STATE;
+
+/**
+ * @brief Shared inputs of one batch run, handed to each worker.
+ */
+typedef struct _batch_job
+{
+    PBATCH pBatch;
+    PWORD_ENTRY pDictionary;
+    const char** pInitialAnswers;
+    long numInitialAnswers;
+    const OPENING_CACHE* pOpeningCache; // Turn-2 replies to the opener, or NULL
+    const long* pSubtrees;              // The children of the empty history, one work item each
+} BATCH_JOB, * PBATCH_JOB;
+
+/**
+ * @brief Releases a batch.
+ */
+static void free_batch(PBATCH pBatch)
+{
+    free(pBatch->pNodes);
+    free(pBatch->pResults);
+    free(pBatch->pLines);
+    memset(pBatch, 0, sizeof(BATCH));
+}
+
+/**
+ * @brief Returns the child of a node for one (guess, pattern) step, adding it if it is new.
+ * @return long The child's node index, or -1 on memory allocation failure.
+ */
+static long add_batch_child(PBATCH pBatch, long parentIdx, const char* guess, const char* pattern)
+{
+    for (long c = pBatch->pNodes[parentIdx].firstChild; c >= 0; c = pBatch->pNodes[c].nextSibling)
     {
-        const char* answer = possibleAnswers[i];
-        get_feedback_pattern(guess, answer, pattern);
+        if (memcmp(pBatch->pNodes[c].guess, guess, WORD_SIZE) == 0 && memcmp(pBatch->pNodes[c].pattern, pattern, WORD_SIZE) == 0) return c;
+    }
 
-        // Search for the existing pattern in the linked list
-        pCurrent = pPatternCounts;
-        ppNextNew = &pPatternCounts;
-        bool found = false;
+    if (pBatch->numNodes == pBatch->nodeCapacity)
+    {
+        long capacity = pBatch->nodeCapacity * 2;
+        PBATCH_NODE pNodes = (PBATCH_NODE)realloc(pBatch->pNodes, capacity * sizeof(BATCH_NODE));
+        if (pNodes == NULL) return -1;
+        pBatch->pNodes = pNodes;
+        pBatch->nodeCapacity = capacity;
+    }
 
-        while (pCurrent != NULL)
-        {
-            if (strcmp(pCurrent->word, pattern) == 0)
-            {
-                pCurrent->rank++; // Increment count
-                found = true;
-                break;
-            }
-            ppNextNew = &(pCurrent->pNxt);
-            pCurrent = pCurrent->pNxt;
-        }
+    long idx = pBatch->numNodes++;
+    PBATCH_NODE pNode = pBatch->pNodes + idx;
+    memcpy(pNode->guess, guess, WORD_SIZE + 1);
+    memcpy(pNode->pattern, pattern, WORD_SIZE + 1);
+    pNode->firstChild = -1;
+    pNode->resultIdx = -1;
+    pNode->nextSibling = pBatch->pNodes[parentIdx].firstChild;
+    pBatch->pNodes[parentIdx].firstChild = idx;
+    return idx;
+}
 
-        // If pattern not found, create a new node
-        if (!found)
-        {
-            pNew = (PWORD_NODE)malloc(sizeof(WORD_NODE));
-            if (pNew == NULL) { fprintf(stderr, "Out of memory in entropy calculation!\n"); return 0.0; }
-            memset(pNew, 0, sizeof(WORD_NODE));
+/**
+ * @brief Splits the next token off a history line at any BATCH_SEPARATORS character.
+ * @return char* The token (terminated in place), or NULL at the end of the line.
+ */
+static char* next_batch_token(char** ppCursor)
+{
+    char* p = *ppCursor;
+    while (*p != '\0' && strchr(BATCH_SEPARATORS, *p) != NULL) p++;
+    if (*p == '\0') return NULL;
+
+    char* pToken = p;
+    while (*p != '\0' && strchr(BATCH_SEPARATORS, *p) == NULL) p++;
+    if (*p != '\0') *p++ = '\0';
+    *ppCursor = p;
+    return pToken;
+}
+
+/**
+ * @brief Parses one history line ("CRANE BGYBB SLOTH BBGYB", pairs separated by spaces, tabs,
+ * commas, colons or semicolons) into the trie.
+ * @param pszLine The trimmed line (modified by tokenizing).
+ * @param pNodeIdx Output: the node the history ends at.
+ * @return const char* NULL on success, otherwise the reason the line was rejected.
+ */
+static const char* parse_batch_history(PBATCH pBatch, char* pszLine, long* pNodeIdx)
+{
+    long nodeIdx = 0;
+    int numSteps = 0;
+    char* pCursor = pszLine;
 
-            memcpy(pNew->word, pattern, WORD_SIZE + 1);
-            pNew->rank = 1;
+    for (char* pszWord = next_batch_token(&pCursor); pszWord != NULL; pszWord = next_batch_token(&pCursor))
+    {
+        char* pszPattern = next_batch_token(&pCursor);
+        if (pszPattern == NULL || strlen(pszWord) != WORD_SIZE || strlen(pszPattern) != WORD_SIZE) return "each guess needs a 5-letter word and a 5-character result";
+        if (++numSteps > MAX_GUESSES) return "more than 6 guesses";
 
-            *ppNextNew = pNew;
+        for (int i = 0; i < WORD_SIZE; i++)
+        {
+            pszWord[i] = toupper((unsigned char)pszWord[i]);
+            pszPattern[i] = toupper((unsigned char)pszPattern[i]);
+            if (pszWord[i] < 'A' || pszWord[i] > 'Z' || (pszPattern[i] != 'B' && pszPattern[i] != 'G' && pszPattern[i] != 'Y')) return "word must be letters and result only B, G or Y";
         }
+
+        nodeIdx = add_batch_child(pBatch, nodeIdx, pszWord, pszPattern);
+        if (nodeIdx < 0) return "out of memory";
     }
 
-    // 2. Calculate Shannon Entropy H
-    const double LOG2_E = log(2.0); // Used to convert natural log to log base 2
-    pCurrent = pPatternCounts;
+    if (numSteps == 0) return "empty history";
+    *pNodeIdx = nodeIdx;
+    return NULL;
+}
 
-    while (pCurrent != NULL)
+/**
+ * @brief Reads every history line of the batch input into the trie. Blank lines and lines
+ * starting with '#' are skipped; a bad line gets an error result instead of stopping the batch.
+ * @return bool True on success, false on memory allocation failure.
+ */
+static bool read_batch(FILE* fpIn, PBATCH pBatch)
+{
+    char line[BATCH_MAX_LINE];
+    long lineNumber = 0;
+
+    pBatch->nodeCapacity = BATCH_INITIAL_CAPACITY;
+    pBatch->lineCapacity = BATCH_INITIAL_CAPACITY;
+    pBatch->pNodes = (PBATCH_NODE)malloc(pBatch->nodeCapacity * sizeof(BATCH_NODE));
+    pBatch->pLines = (PBATCH_LINE)malloc(pBatch->lineCapacity * sizeof(BATCH_LINE));
+    if (pBatch->pNodes == NULL || pBatch->pLines == NULL) return false;
+
+    // Node 0: the empty history
+    memset(pBatch->pNodes, 0, sizeof(BATCH_NODE));
+    pBatch->pNodes[0].firstChild = -1;
+    pBatch->pNodes[0].nextSibling = -1;
+    pBatch->pNodes[0].resultIdx = -1;
+    pBatch->numNodes = 1;
+
+    while (fgets(line, sizeof(line), fpIn) != NULL)
     {
-        long count_k = pCurrent->rank;
-        double P_k = (double)count_k / numPossibleAnswers; // Probability of pattern k
+        lineNumber++;
+        bool tooLong = strchr(line, '\n') == NULL && !feof(fpIn);
+        if (tooLong)
+        {
+            int ch;
+            while ((ch = fgetc(fpIn)) != '\n' && ch != EOF) {}
+        }
+        trim(line);
+        if (!tooLong && (line[0] == '\0' || line[0] == '#')) continue;
 
-        // H = sum(P_k * log2(1/P_k))
-        // log2(1/P_k) is equivalent to log(N/count_k) / log(2)
-        entropy += P_k * (log((double)numPossibleAnswers / count_k) / LOG2_E);
+        if (pBatch->numLines == pBatch->lineCapacity)
+        {
+            long capacity = pBatch->lineCapacity * 2;
+            PBATCH_LINE pLines = (PBATCH_LINE)realloc(pBatch->pLines, capacity * sizeof(BATCH_LINE));
+            if (pLines == NULL) return false;
+            pBatch->pLines = pLines;
+            pBatch->lineCapacity = capacity;
+        }
 
-        // Free linked list node and move to next
-        PWORD_NODE pTemp = pCurrent->pNxt;
-        free(pCurrent);
-        pCurrent = pTemp;
+        PBATCH_LINE pLine = pBatch->pLines + pBatch->numLines++;
+        pLine->lineNumber = lineNumber;
+        pLine->nodeIdx = -1;
+        pLine->pszError = tooLong ? "line too long" : parse_batch_history(pBatch, line, &pLine->nodeIdx);
+        if (pLine->pszError == NULL && pBatch->pNodes[pLine->nodeIdx].resultIdx < 0) pBatch->pNodes[pLine->nodeIdx].resultIdx = pBatch->numResults++;
     }
 
-    return entropy;
+    pBatch->pResults = (PBATCH_RESULT)malloc((pBatch->numResults ? pBatch->numResults : 1) * sizeof(BATCH_RESULT));
+    return pBatch->pResults != NULL;
 }
 
 /**
- * @brief Checks if a guess word contains a repeated letter that is NOT guaranteed by current constraints.
- * This guards against "risky" guesses (e.g., guessing 'DADDY' when D isn't confirmed as a double).
- * @param guess The word to check.
- * @param pGood The string of required letters (yellow or green).
- * @return true if the word has unconfirmed repeat letters, false otherwise.
+ * @brief Marks every result at or below a node with the same error (for histories that continue
+ * past a solved game or an empty answer set).
  */
-bool is_guess_word_risky(const char* guess, char* pGood)
+static void fail_batch_subtree(PBATCH pBatch, long nodeIdx, const char* pszError, int turn)
 {
-    int guess_counts[26] = { 0 };
-    int required_counts[26] = { 0 };
+    PBATCH_NODE pNode = pBatch->pNodes + nodeIdx;
+    if (pNode->resultIdx >= 0)
+    {
+        pBatch->pResults[pNode->resultIdx].pszError = pszError;
+        pBatch->pResults[pNode->resultIdx].turn = turn;
+    }
+    for (long c = pNode->firstChild; c >= 0; c = pBatch->pNodes[c].nextSibling) fail_batch_subtree(pBatch, c, pszError, turn + 1);
+}
 
-    // Tally letter counts in the guess word
-    for (int i = 0; i < WORD_SIZE; i++)
+/**
+ * @brief Applies a node's step to its parent's state, answers the node if a line ends there and
+ * recurses into its children. The node's candidates live in the worker's scratch arena until
+ * its subtree is done.
+ * @param pMetricsTable The worker's metric work buffer.
+ * @param pHistograms The worker's histograms (synced incrementally down each path).
+ */
+static void run_batch_node(PBATCH_JOB pJob, long nodeIdx, const BATCH_STATE* pParent, PGUESS_METRICS pMetricsTable, PPATTERN_HISTOGRAMS pHistograms)
+{
+    PBATCH pBatch = pJob->pBatch;
+    PBATCH_NODE pNode = pBatch->pNodes + nodeIdx;
+    PBATCH_RESULT pResult = (pNode->resultIdx >= 0) ? pBatch->pResults + pNode->resultIdx : NULL;
+    BATCH_STATE state = *pParent;
+
+    state.tryIdx++;
+    if (pResult != NULL)
     {
-        guess_counts[guess[i] - 'A']++;
+        pResult->pszError = NULL;
+        pResult->turn = state.tryIdx + 1;
+        pResult->solved = false;
+        pResult->numCandidates = 0;
     }
 
-    // Tally minimum required letter counts from game state (pGood)
-    for (char* p = pGood; *p != '\0'; p++)
+    update_game_constraints(pNode->guess, pNode->pattern, state.mask, state.notMask, state.good, state.bad, state.tryIdx);
+    if (strchr(state.mask, '*') == NULL)
     {
-        required_counts[*p - 'A']++;
+        if (pResult != NULL)
+        {
+            pResult->turn = state.tryIdx;
+            pResult->solved = true;
+            memcpy(pResult->answer, state.mask, WORD_SIZE + 1);
+        }
+        for (long c = pNode->firstChild; c >= 0; c = pBatch->pNodes[c].nextSibling) fail_batch_subtree(pBatch, c, "game is over", state.tryIdx + 1);
+        return;
     }
 
-    for (int i = 0; i < 26; i++)
+    PSCRATCH_ARENA pArena = get_scratch_arena();
+    size_t mark = scratch_mark(pArena);
+    state.pCandidates = (const char**)scratch_alloc(pArena, pParent->numCandidates * sizeof(char*));
+    if (state.pCandidates == NULL)
+    {
+        fail_batch_subtree(pBatch, nodeIdx, "out of memory", state.tryIdx + 1);
+        scratch_release(pArena, mark);
+        return;
+    }
+    memcpy((void*)state.pCandidates, pParent->pCandidates, pParent->numCandidates * sizeof(char*));
+    state.numCandidates = filter_possible_answers_after_guess(pNode->guess, pNode->pattern, state.pCandidates, pParent->numCandidates,
+        state.mask, state.notMask, state.good, state.bad, state.tryIdx);
+
+    const char* pszError = NULL;
+    if (state.numCandidates == 0) pszError = "no possible answers remain";
+    else if (state.tryIdx >= MAX_GUESSES) pszError = "game is over";
+
+    if (pszError != NULL)
+    {
+        fail_batch_subtree(pBatch, nodeIdx, pszError, state.tryIdx + 1);
+    }
+    else
     {
-        if (guess_counts[i] > 1) // Check only letters that appear multiple times in the guess
+        if (pResult != NULL)
         {
-            // If the number of times the letter appears in the guess is greater than
-            // the confirmed required count from the board state, it is risky.
-            if (guess_counts[i] > required_counts[i])
+            bool haveReply = state.tryIdx == 1 && get_opener_reply(pJob->pOpeningCache, pJob->pDictionary, pNode->guess, pNode->pattern, state.numCandidates, &pResult->recommendation);
+            if (!haveReply && !get_shared_recommendation(state.pCandidates, state.numCandidates, state.good, pMetricsTable, pHistograms, &pResult->recommendation))
             {
-                return true;
+                pResult->pszError = "out of memory";
             }
+            pResult->numCandidates = state.numCandidates;
+            for (long i = 0; i < state.numCandidates && i < LOW_POSSIBLE_ANSWER_COUNT; i++) pResult->candidates[i] = state.pCandidates[i];
         }
+        for (long c = pNode->firstChild; c >= 0; c = pBatch->pNodes[c].nextSibling) run_batch_node(pJob, c, &state, pMetricsTable, pHistograms);
     }
 
-    return false;
+    scratch_release(pArena, mark);
 }
 
 /**
- * @brief Searches an array of GUESS_METRICS structs to find the entry
- * corresponding to a specific word.
- * @param word The word to search for.
- * @param pArray The array of metrics.
- * @param num The number of elements in the array.
- * @return PGUESS_METRICS Pointer to the found metric, or NULL if not found.
+ * @brief parallel_for callback: answers the subtrees [begin, end) of the empty history.
+ * A single subtree runs on the calling thread, so its scoring still uses every core.
  */
-PGUESS_METRICS find_metric_by_word(const char* word, PGUESS_METRICS pArray, long num)
+static void run_batch_subtrees(long begin, long end, int, void* pContext)
 {
-    if (strcmp(word, "NONE") == 0) return NULL;
-    for (long i = 0; i < num; i++)
+    PBATCH_JOB pJob = (PBATCH_JOB)pContext;
+    BATCH_STATE root;
+
+    init_game_constraints(root.mask, root.notMask, root.good, root.bad);
+    root.tryIdx = 0;
+    root.pCandidates = pJob->pInitialAnswers;
+    root.numCandidates = pJob->numInitialAnswers;
+
+    PSCRATCH_ARENA pArena = get_scratch_arena();
+    size_t mark = scratch_mark(pArena);
+    PGUESS_METRICS pMetricsTable = (PGUESS_METRICS)scratch_alloc(pArena, numWordsInDictionary * sizeof(GUESS_METRICS));
+    PATTERN_HISTOGRAMS histograms;
+    init_pattern_histograms(&histograms);
+
+    for (long i = begin; i < end; i++)
     {
-        if (strcmp(pArray[i].word, word) == 0) return &pArray[i];
+        if (pMetricsTable != NULL) run_batch_node(pJob, pJob->pSubtrees[i], &root, pMetricsTable, &histograms);
+        else fail_batch_subtree(pJob->pBatch, pJob->pSubtrees[i], "out of memory", 2);
     }
-    return NULL;
-}
-
 
-// --- Refactored Functions Start Here ---
+    scratch_release(pArena, mark);
+    free_pattern_histograms(&histograms);
+}
 
 /**
- * @brief Performs the constraint update logic for a single guess.
- * Calculates confirmed counts and updates the mask, required letters (pGood),
- * excluded letters (pBad), and positional exclusions (notMask).
- * @param guess The 5-letter word guessed by the user.
- * @param result_pattern The 5-char feedback (B, G, Y) from Wordle.
- * @param pMask The green letter mask.
- * @param notMask Positional exclusions array.
- * @param pGood String of required letters (min count constraint).
- * @param pBad String of letters that must be absent.
- * @param tryIdx The current turn number.
+ * @brief Appends up to BATCH_TOP_ROWS table rows as [word, entropy, rank] triples (JSON) or
+ * space-separated words (CSV).
  */
-void update_game_constraints(const char* guess, const char* result_pattern, char* pMask, char notMask[6][5], char* pGood, char* pBad, int tryIdx)
+static int append_batch_rows(char* pBuffer, int bufferSize, int length, const GUESS_METRICS* pRows, long numRows, bool csv)
 {
-    // 1. Calculate confirmed minimum counts for required letters (Yellow/Green)
-    int confirmed_counts[26] = { 0 };
-    for (int idx = 0; idx < WORD_SIZE; idx++)
+    if (numRows > BATCH_TOP_ROWS) numRows = BATCH_TOP_ROWS;
+    for (long i = 0; i < numRows; i++)
     {
-        char current_char = toupper((unsigned char)guess[idx]);
-        if (result_pattern[idx] == 'G' || result_pattern[idx] == 'Y')
-        {
-            confirmed_counts[current_char - 'A']++;
-        }
+        if (csv) length = append_response(pBuffer, bufferSize, length, "%s%s", i ? " " : "", pRows[i].word);
+        else length = append_response(pBuffer, bufferSize, length, "%s[\"%s\",%.4f,%d]", i ? "," : "", pRows[i].word, pRows[i].entropy, pRows[i].rank);
     }
+    return length;
+}
 
-    // 2. Apply updates based on result pattern position by position
-    for (int idx = 0; idx < WORD_SIZE; idx++)
-    {
-        char current_char = toupper((unsigned char)guess[idx]);
+/**
+ * @brief Writes one line's answer as a JSON object or a CSV row (see run_batch).
+ */
+static void write_batch_line(FILE* fpOut, const BATCH_LINE* pLine, const BATCH_RESULT* pResult, bool csv)
+{
+    char output[2048];
+    const char* pszError = (pLine->pszError != NULL) ? pLine->pszError : pResult->pszError;
+    int length;
 
-        // Find how many of this char are already marked as required
-        int current_required_count = 0;
-        for (size_t k = 0; k < strlen(pGood); k++)
+    if (csv)
+    {
+        length = append_response(output, sizeof(output), 0, "%ld,", pLine->lineNumber);
+        if (pszError != NULL)
         {
-            if (pGood[k] == current_char) current_required_count++;
+            length = append_response(output, sizeof(output), length, "false,%d,,,,,,,,,,\"%s\"", pResult ? pResult->turn : 0, pszError);
         }
-
-        size_t len_good = strlen(pGood);
-        size_t len_bad = strlen(pBad);
-
-        if (result_pattern[idx] == 'G')
+        else if (pResult->solved)
         {
-            pMask[idx] = current_char;
-            // Update required letters (pGood) if we found a new, necessary instance
-            if (current_required_count < confirmed_counts[current_char - 'A'])
-            {
-                pGood[len_good] = current_char;
-                pGood[len_good + 1] = '\0';
-            }
+            length = append_response(output, sizeof(output), length, "true,%d,,true,%s,,,,,,,", pResult->turn, pResult->answer);
         }
-        else if (result_pattern[idx] == 'Y')
+        else
         {
-            notMask[tryIdx - 1][idx] = current_char;
-            // Update required letters (pGood)
-            if (current_required_count < confirmed_counts[current_char - 'A'])
-            {
-                pGood[len_good] = current_char;
-                pGood[len_good + 1] = '\0';
-            }
+            const RECOMMENDATION* pRec = &pResult->recommendation;
+            length = append_response(output, sizeof(output), length, "true,%d,%ld,false,%s,%d,%.4f,%s,%s,", pResult->turn, pResult->numCandidates,
+                pRec->finalPick.word, pRec->finalPick.rank, pRec->finalPick.entropy, pRec->rankPick.word, pRec->entropyPick.word);
+            length = append_batch_rows(output, sizeof(output), length, pRec->entropyRows, pRec->numEntropyRows, true);
+            length = append_response(output, sizeof(output), length, ",");
+            length = append_batch_rows(output, sizeof(output), length, pRec->rankRows, pRec->numRankRows, true);
+            length = append_response(output, sizeof(output), length, ",");
         }
-        else if (result_pattern[idx] == 'B')
+    }
+    else
+    {
+        length = append_response(output, sizeof(output), 0, "{\"line\":%ld,", pLine->lineNumber);
+        if (pszError != NULL)
         {
-            notMask[tryIdx - 1][idx] = current_char;
-
-            // Only blacklist the letter (pBad) if it is NOT a required letter (count is 0)
-            if (current_required_count == 0)
+            length = append_response(output, sizeof(output), length, "\"ok\":false,\"error\":\"%s\"}", pszError);
+        }
+        else if (pResult->solved)
+        {
+            length = append_response(output, sizeof(output), length, "\"ok\":true,\"turn\":%d,\"solved\":true,\"answer\":\"%s\"}", pResult->turn, pResult->answer);
+        }
+        else
+        {
+            const RECOMMENDATION* pRec = &pResult->recommendation;
+            length = append_response(output, sizeof(output), length,
+                "\"ok\":true,\"turn\":%d,\"remaining\":%ld,\"solved\":false,\"pick\":\"%s\",\"rank\":%d,\"entropy\":%.4f,\"rank_pick\":\"%s\",\"entropy_pick\":\"%s\",\"top_entropy\":[",
+                pResult->turn, pResult->numCandidates, pRec->finalPick.word, pRec->finalPick.rank, pRec->finalPick.entropy,
+                pRec->rankPick.word, pRec->entropyPick.word);
+            length = append_batch_rows(output, sizeof(output), length, pRec->entropyRows, pRec->numEntropyRows, false);
+            length = append_response(output, sizeof(output), length, "],\"top_rank\":[");
+            length = append_batch_rows(output, sizeof(output), length, pRec->rankRows, pRec->numRankRows, false);
+            length = append_response(output, sizeof(output), length, "]");
+
+            if (pResult->numCandidates <= LOW_POSSIBLE_ANSWER_COUNT)
             {
-                if (strchr(pBad, current_char) == NULL)
+                length = append_response(output, sizeof(output), length, ",\"candidates\":[");
+                for (long i = 0; i < pResult->numCandidates; i++)
                 {
-                    pBad[len_bad] = current_char;
-                    pBad[len_bad + 1] = '\0';
+                    length = append_response(output, sizeof(output), length, "%s\"%s\"", i ? "," : "", pResult->candidates[i]);
                 }
+                length = append_response(output, sizeof(output), length, "]");
             }
+            length = append_response(output, sizeof(output), length, "}");
         }
     }
+
+    fputs(output, fpOut);
+    fputc('\n', fpOut);
+}
+
+/**
+ * @brief Batch mode: answers a whole file of game histories, one per line, without the interactive
+ * loop. Each line holds the guesses so far as word/result pairs ("CRANE BGYBB SLOTH BBGYB") and is
+ * answered, in input order, with the recommendation for the next guess:
+ * {"line":N,"ok":true,"turn":T,"remaining":R,"solved":false,"pick":...,"top_entropy":[[word,H,R],...],
+ * "top_rank":[...]} (plus "candidates" for small sets), {"line":N,"ok":true,"solved":true,"answer":...}
+ * or {"line":N,"ok":false,"error":...}. With --csv the same fields are written as CSV rows under a
+ * header, the top rows as space-separated words and the error quoted.
+ * Histories are merged into a trie so shared prefixes are filtered once, the subtrees below the
+ * first guess are spread over the workers, and equal answer sets share the result cache.
+ * @param pDictionary The entire word dictionary.
+ * @param pPossibleAnswers The turn-1 possible answers every history starts from.
+ * @param numPossibleAnswers The number of possible answers.
+ * @param pOpeningCache The turn-2 replies to the opener, or NULL.
+ * @param pszPath The input file ("-" for stdin).
+ * @param fpOut The output stream (see open_protocol_stream).
+ * @return bool True if the input was read and answered, false on an I/O or memory failure.
+ */
+bool run_batch(PWORD_ENTRY pDictionary, const char** pPossibleAnswers, long numPossibleAnswers, const OPENING_CACHE* pOpeningCache, const char* pszPath, FILE* fpOut)
+{
+    BATCH batch;
+    memset(&batch, 0, sizeof(batch));
+
+    FILE* fpIn = stdin;
+    if (strcmp(pszPath, "-") != 0 && (fopen_s(&fpIn, pszPath, "r") != 0 || fpIn == NULL))
+    {
+        fprintf(stderr, "Could not open batch input %s!\n", pszPath);
+        return false;
+    }
+    bool ok = read_batch(fpIn, &batch);
+    if (fpIn != stdin) fclose(fpIn);
+    if (!ok)
+    {
+        fprintf(stderr, "Out of memory reading the batch input!\n");
+        free_batch(&batch);
+        return false;
+    }
+
+    long numSubtrees = 0;
+    for (long c = batch.pNodes[0].firstChild; c >= 0; c = batch.pNodes[c].nextSibling) numSubtrees++;
+    long* pSubtrees = (long*)malloc((numSubtrees ? numSubtrees : 1) * sizeof(long));
+    if (pSubtrees == NULL)
+    {
+        fprintf(stderr, "Out of memory for the batch subtrees!\n");
+        free_batch(&batch);
+        return false;
+    }
+    numSubtrees = 0;
+    for (long c = batch.pNodes[0].firstChild; c >= 0; c = batch.pNodes[c].nextSibling) pSubtrees[numSubtrees++] = c;
+
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    BATCH_JOB job = { &batch, pDictionary, pPossibleAnswers, numPossibleAnswers, pOpeningCache, pSubtrees };
+    parallel_for(numSubtrees, 1, run_batch_subtrees, &job);
+    double elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    if (g_options.csvOutput) fprintf(fpOut, "line,ok,turn,remaining,solved,pick,rank,entropy,rank_pick,entropy_pick,top_entropy,top_rank,error\n");
+    for (long i = 0; i < batch.numLines; i++)
+    {
+        const BATCH_LINE* pLine = batch.pLines + i;
+        const BATCH_RESULT* pResult = (pLine->nodeIdx >= 0) ? batch.pResults + batch.pNodes[pLine->nodeIdx].resultIdx : NULL;
+        write_batch_line(fpOut, pLine, pResult, g_options.csvOutput);
+    }
+    fflush(fpOut);
+
+    fprintf(stderr, "Answered %ld lines (%ld distinct histories, %ld trie nodes) in %.3f s.\n", batch.numLines, batch.numResults, batch.numNodes - 1, elapsedSeconds);
+    free(pSubtrees);
+    free_batch(&batch);
+    return true;
 }
 
+// --- Decision Tree ---
+
 /**
- * @brief Calculates all required metrics (H, R, Linguistic, Risk) for every possible answer.
- * @param pDictionary The entire word dictionary.
- * @param pPossibleAnswers Array of pointers to remaining possible answers.
- * @param numPossibleAnswers The number of words remaining.
- * @param pGood The string of required letters (for repeat risk check).
- * @param pMetricsTable The pre-allocated array to store the results.
- * @param numWordsInDictionary Total size of the dictionary (for lookup).
+ * @brief One game state while the policy tree is expanded, level by level.
  */
-void calculate_all_metrics(PWORD_ENTRY pDictionary, const char** pPossibleAnswers, long numPossibleAnswers, char* pGood, PGUESS_METRICS pMetricsTable, long numWordsInDictionary)
+typedef struct _tree_build_state
 {
-    for (long i = 0; i < numPossibleAnswers; i++)
-    {
-        const char* pWord = pPossibleAnswers[i];
-        PGUESS_METRICS pMetric = pMetricsTable + i;
-        char nounType, verbType;
-        int rank;
-
-        pMetric->word = pWord;
-
-        // Calculate the core information metric
-        pMetric->entropy = calculate_entropy_score(pWord, pPossibleAnswers, numPossibleAnswers);
+    BATCH_STATE game;       // Constraints and candidates (owned) after the history
+    const char** pReaching; // The answers whose feedback really gives this history (owned)
+    long numReaching;
+    const char* pick;       // The final pick played here, or NULL if the filter left no candidates
+    long nodeIdx;           // Output record
+    long parentIdx;         // Index of the parent in the previous level
+    PATTERN_CODE code;      // Feedback of the parent's pick that leads here
+} TREE_BUILD_STATE, * PTREE_BUILD_STATE;
 
-        // Look up static metrics
-        get_linguistic_types(pWord, pDictionary, numWordsInDictionary, &nounType, &verbType, &rank);
-        pMetric->rank = rank;
-        pMetric->nounType = nounType;
-        pMetric->verbType = verbType;
+/**
+ * @brief Shared inputs of one level expansion, handed to each worker.
+ */
+typedef struct _tree_build_job
+{
+    PWORD_ENTRY pDictionary;
+    const OPENING_CACHE* pOpeningCache; // Turn-2 replies to the opener, or NULL
+    const TREE_BUILD_STATE* pParents;
+    PTREE_BUILD_STATE pChildren;
+    PDECISION_TREE_NODE pNodes;
+    std::atomic<bool> failed;
+} TREE_BUILD_JOB, * PTREE_BUILD_JOB;
 
-        // Calculate dynamic risk based on current game state
-        pMetric->is_risky = is_guess_word_risky(pWord, pGood);
-    }
+/**
+ * @brief Counts the set bits of a child mask word.
+ */
+static inline int count_mask_bits(unsigned long long bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(bits);
+#else
+    int count = 0;
+    for (; bits != 0; bits &= bits - 1) count++;
+    return count;
+#endif
 }
 
 /**
- * @brief Allocates and sorts two metric buffers based on Rank and Entropy priorities.
- * The caller MUST free the memory pointed to by ppRankSorted and ppEntropySorted.
- * @param pMetricsTable The source metric table (unsorted).
- * @param numPossibleAnswers The number of elements.
- * @param ppRankSorted Output pointer for the Rank-sorted buffer.
- * @param ppEntropySorted Output pointer for the Entropy-sorted buffer.
- * @return bool True on success, false on memory allocation failure.
+ * @brief Releases one level of build states.
  */
-bool create_and_sort_metric_buffers(PGUESS_METRICS pMetricsTable, long numPossibleAnswers, PGUESS_METRICS* ppRankSorted, PGUESS_METRICS* ppEntropySorted)
+static void free_tree_level(PTREE_BUILD_STATE pLevel, long numStates)
 {
-    // Allocate memory for two temporary, sortable copies
-    *ppRankSorted = (PGUESS_METRICS)malloc(numPossibleAnswers * sizeof(GUESS_METRICS));
-    *ppEntropySorted = (PGUESS_METRICS)malloc(numPossibleAnswers * sizeof(GUESS_METRICS));
-
-    if (!*ppRankSorted || !*ppEntropySorted)
+    for (long i = 0; i < numStates; i++)
     {
-        fprintf(stderr, "Out of memory for sort buffers!\n");
-        if (*ppRankSorted) free(*ppRankSorted);
-        if (*ppEntropySorted) free(*ppEntropySorted);
-        return false;
+        free((void*)pLevel[i].game.pCandidates);
+        free((void*)pLevel[i].pReaching);
     }
-
-    // Copy the raw metric data
-    memcpy(*ppRankSorted, pMetricsTable, numPossibleAnswers * sizeof(GUESS_METRICS));
-    memcpy(*ppEntropySorted, pMetricsTable, numPossibleAnswers * sizeof(GUESS_METRICS));
-
-    // Sort 1: Priority on Rank (R), secondary on Entropy (H)
-    qsort(*ppRankSorted, numPossibleAnswers, sizeof(GUESS_METRICS), sortMetricsByRankDescending);
-
-    // Sort 2: Priority on Entropy (H), secondary on Rank (R)
-    qsort(*ppEntropySorted, numPossibleAnswers, sizeof(GUESS_METRICS), sortMetricsByEntropyDescending);
-
-    return true;
+    free(pLevel);
 }
 
 /**
- * @brief Finds the top pick and alternate based on strict linguistic/risk preferences.
- * This filters out undesirable word forms (plurals, past tense, etc.) from the top of the sorted list.
- * @param pSortedMetrics The array sorted by the primary metric (Rank or Entropy).
- * @param numMetrics Number of entries in the array.
- * @param pResult Output structure to store the top pick and alternate.
+ * @brief Stores a recommendation's picks in a tree node (the child links are left as they are).
  */
-void find_top_linguistic_picks(PGUESS_METRICS pSortedMetrics, long numMetrics, PICK_DATA* pResult)
+static void set_tree_node_picks(PDECISION_TREE_NODE pNode, const RECOMMENDATION* pRec)
 {
-    pResult->word = "NONE";
-    pResult->alternate_word = "NONE";
-    int found_count = 0;
+    pNode->numCandidates = (unsigned int)pRec->numPossibleAnswers;
+    pNode->finalId = get_word_id(pRec->finalPick.word);
+    pNode->finalEntropy = pRec->finalPick.entropy;
+    pNode->rankPickId = get_word_id(pRec->rankPick.word);
+    pNode->rankPickEntropy = pRec->rankPick.entropy;
+    pNode->entropyPickId = get_word_id(pRec->entropyPick.word);
+    pNode->entropyPickEntropy = pRec->entropyPick.entropy;
+}
 
-    // Search for the top two words that are linguistically sound and not risky
-    for (long i = 0; i < numMetrics; i++)
+/**
+ * @brief Splits each state's answers by the feedback of its pick and adds one child per pattern other
+ * than all green (none after the last guess). Children are numbered in level order and, within a
+ * parent, in pattern order, which is the layout find_decision_tree_child relies on. Also tallies the
+ * guess each answer is solved at.
+ * @param pParents The current level.
+ * @param numParents Its number of states.
+ * @param pNodes The output records (the parents' child links are set here).
+ * @param numNodes Records so far; the children get the indices that follow.
+ * @param ppChildren Output: the next level (owned by the caller, also on failure).
+ * @param pNumChildren Output: its number of states.
+ * @param pHistogram Games per number of guesses, [0] = failed (updated).
+ * @return bool True on success, false on memory allocation failure.
+ */
+static bool plan_tree_children(const TREE_BUILD_STATE* pParents, long numParents, PDECISION_TREE_NODE pNodes, long numNodes, PTREE_BUILD_STATE* ppChildren, long* pNumChildren, long* pHistogram)
+{
+    long counts[NUM_PATTERNS];
+    long childOfCode[NUM_PATTERNS];
+    long numChildren = 0;
+    long capacity = 0;
+
+    *ppChildren = NULL;
+    *pNumChildren = 0;
+    for (long p = 0; p < numParents; p++)
     {
-        PGUESS_METRICS pMetric = pSortedMetrics + i;
+        const TREE_BUILD_STATE* pParent = pParents + p;
+        int turn = pParent->game.tryIdx + 1;
+
+        if (pParent->pick == NULL)
+        {
+            pHistogram[0] += pParent->numReaching;
+            continue;
+        }
+
+        memset(counts, 0, sizeof(counts));
+        for (long i = 0; i < pParent->numReaching; i++) counts[lookup_feedback_pattern_code(pParent->pick, pParent->pReaching[i])]++;
+
+        pHistogram[turn] += counts[PATTERN_ALL_GREEN];
+        if (turn >= MAX_GUESSES)
+        {
+            pHistogram[0] += pParent->numReaching - counts[PATTERN_ALL_GREEN];
+            continue;
+        }
 
-        // CRITICAL FILTER: Exclude Plural Nouns ('P'), Past Tense Verbs ('T'),
-        // Third-Person Singular Verbs ('S'), and words with unconfirmed repeat letters.
-        if (pMetric->nounType != 'P' && pMetric->verbType != 'T' &&
-            pMetric->verbType != 'S' && pMetric->is_risky == false)
+        PDECISION_TREE_NODE pNode = pNodes + pParent->nodeIdx;
+        pNode->firstChild = (unsigned int)(numNodes + numChildren);
+        for (int code = 0; code < NUM_PATTERNS; code++)
         {
-            if (found_count == 0)
+            childOfCode[code] = -1;
+            if (counts[code] == 0 || code == PATTERN_ALL_GREEN) continue;
+
+            if (numChildren == capacity)
             {
-                pResult->word = pMetric->word;
-                found_count++;
+                long newCapacity = capacity ? capacity * 2 : BATCH_INITIAL_CAPACITY;
+                PTREE_BUILD_STATE pGrown = (PTREE_BUILD_STATE)realloc(*ppChildren, newCapacity * sizeof(TREE_BUILD_STATE));
+                if (pGrown == NULL) return false;
+                *ppChildren = pGrown;
+                capacity = newCapacity;
             }
-            else if (found_count == 1)
+
+            PTREE_BUILD_STATE pChild = *ppChildren + numChildren;
+            memset(pChild, 0, sizeof(TREE_BUILD_STATE));
+            pChild->pReaching = (const char**)malloc(counts[code] * sizeof(char*));
+            pChild->nodeIdx = numNodes + numChildren;
+            pChild->parentIdx = p;
+            pChild->code = (PATTERN_CODE)code;
+            childOfCode[code] = numChildren++;
+            *pNumChildren = numChildren;
+            if (pChild->pReaching == NULL) return false;
+
+            pNode->childMask[code / 64] |= 1ULL << (code % 64);
+        }
+
+        // Buckets keep the dictionary order of the parent's answers
+        for (long i = 0; i < pParent->numReaching; i++)
+        {
+            long c = childOfCode[lookup_feedback_pattern_code(pParent->pick, pParent->pReaching[i])];
+            if (c >= 0)
             {
-                pResult->alternate_word = pMetric->word;
-                found_count++;
-                break; // Found top pick and alternate
+                PTREE_BUILD_STATE pChild = *ppChildren + c;
+                pChild->pReaching[pChild->numReaching++] = pParent->pReaching[i];
             }
         }
     }
+    return true;
+}
 
-    // Fallback: If not enough linguistically clean words were found, use the absolute top words
-    if (found_count < 2 && numMetrics > 0)
+/**
+ * @brief parallel_for callback: plays each child's step [begin, end) exactly as a live game would
+ * (constraints, candidate filter, opener reply or shared recommendation) and records its picks.
+ * A child the filter leaves without candidates gets no pick; its answers are lost, as in a live game.
+ * Each worker scores inline; there are many children per level.
+ */
+static void expand_tree_children(long begin, long end, int, void* pContext)
+{
+    PTREE_BUILD_JOB pJob = (PTREE_BUILD_JOB)pContext;
+    char pattern[WORD_SIZE + 1];
+    RECOMMENDATION rec;
+
+    PSCRATCH_ARENA pArena = get_scratch_arena();
+    size_t mark = scratch_mark(pArena);
+    PGUESS_METRICS pMetricsTable = (PGUESS_METRICS)scratch_alloc(pArena, numWordsInDictionary * sizeof(GUESS_METRICS));
+
+    for (long i = begin; i < end && pMetricsTable != NULL; i++)
     {
-        // If 0 clean words found, use absolute top word as the Top Pick
-        if (found_count == 0)
+        PTREE_BUILD_STATE pChild = pJob->pChildren + i;
+        const TREE_BUILD_STATE* pParent = pJob->pParents + pChild->parentIdx;
+        BATCH_STATE* pGame = &pChild->game;
+
+        *pGame = pParent->game;
+        pGame->tryIdx++;
+        pGame->pCandidates = (const char**)malloc(pParent->game.numCandidates * sizeof(char*));
+        if (pGame->pCandidates == NULL)
         {
-            pResult->word = pSortedMetrics[0].word;
-            found_count = 1;
+            pJob->failed = true;
+            continue;
         }
 
-        // If less than 2 clean words found, use absolute second best as Alternate (if available)
-        if (found_count == 1 && numMetrics > 1)
+        decode_feedback_pattern(pChild->code, pattern);
+        update_game_constraints(pParent->pick, pattern, pGame->mask, pGame->notMask, pGame->good, pGame->bad, pGame->tryIdx);
+        memcpy((void*)pGame->pCandidates, pParent->game.pCandidates, pParent->game.numCandidates * sizeof(char*));
+        pGame->numCandidates = filter_possible_answers_after_guess(pParent->pick, pattern, pGame->pCandidates, pParent->game.numCandidates,
+            pGame->mask, pGame->notMask, pGame->good, pGame->bad, pGame->tryIdx);
+
+        if (pGame->numCandidates == 0)
         {
-            if (strcmp(pResult->alternate_word, "NONE") == 0)
-            {
-                if (strcmp(pSortedMetrics[1].word, pResult->word) != 0)
-                {
-                    pResult->alternate_word = pSortedMetrics[1].word;
-                }
-            }
+            pJob->pNodes[pChild->nodeIdx].finalId = INVALID_WORD_ID;
+            pJob->pNodes[pChild->nodeIdx].rankPickId = INVALID_WORD_ID;
+            pJob->pNodes[pChild->nodeIdx].entropyPickId = INVALID_WORD_ID;
+            continue;
         }
-        // If only one word total remains, alternate is NONE
-        else if (numMetrics == 1)
+
+        bool haveRec = (pGame->tryIdx == 1 && get_opener_reply(pJob->pOpeningCache, pJob->pDictionary, pParent->pick, pattern, pGame->numCandidates, &rec)) ||
+            get_shared_recommendation(pGame->pCandidates, pGame->numCandidates, pGame->good, pMetricsTable, NULL, &rec);
+        if (!haveRec || get_word_id(rec.finalPick.word) == INVALID_WORD_ID)
         {
-            pResult->alternate_word = "NONE";
+            pJob->failed = true;
+            continue;
         }
+
+        pChild->pick = rec.finalPick.word;
+        set_tree_node_picks(pJob->pNodes + pChild->nodeIdx, &rec);
     }
+
+    if (pMetricsTable == NULL) pJob->failed = true;
+    scratch_release(pArena, mark);
 }
 
 /**
- * @brief Prints the two-column table showing the top N choices for both Rank and Entropy.
- * @param pRankSorted The array sorted by Rank.
- * @param pEntropySorted The array sorted by Entropy.
- * @param numPossibleAnswers The total number of words.
- * @param pRankPicks The final top picks for the Rank path.
- * @param pE_Picks The final top picks for the Entropy path.
+ * @brief Offline mode: expands the solver's whole policy from an opener over every possible answer
+ * and writes it as a decision tree, so a server can answer games that follow the policy by walking
+ * the tree instead of scoring. Each level is expanded in parallel; every child state is played with
+ * the same constraint, filter and recommendation path as a live game, so the tree gives exactly the
+ * picks the solver would make. Prints the states per turn and the guess distribution of the policy.
+ * @param pDictionary The entire word dictionary.
+ * @param pPossibleAnswers The turn-1 possible answers.
+ * @param numPossibleAnswers The number of possible answers.
+ * @param pOpening The turn-1 recommendation (its final pick is the default opener).
+ * @param pOpeningCache The turn-2 replies to the opener, or NULL.
+ * @param pszOpener First guess of the tree, or NULL for the turn-1 final pick.
+ * @param pszPath The output file.
+ * @return bool True if the tree was built and written.
  */
-void print_recommendation_table(PGUESS_METRICS pRankSorted, PGUESS_METRICS pEntropySorted, long numPossibleAnswers, const PICK_DATA* pRankPicks, const PICK_DATA* pE_Picks)
+bool export_decision_tree(PWORD_ENTRY pDictionary, const char** pPossibleAnswers, long numPossibleAnswers, const RECOMMENDATION* pOpening, const OPENING_CACHE* pOpeningCache, const char* pszOpener, const char* pszPath)
 {
-    const int COL_WIDTH = 43;
-    const int MAX_ROWS = MAX_TOP_PICKS;
-
-    printf("\n%*s--- Top %d Choices (Possible Answers: %ld) ---\n", 22, "", MAX_ROWS, numPossibleAnswers);
-    printf("%*s(R=Rank, H=Entropy, N=Plurality, V=Preterite, R=Repeat Risk)\n", 16, "");
-    printf("-------------------------------------------+-------------------------------------------\n");
-    printf("     Rank-Optimized                        |     Entropy-Optimized                     \n");
-    printf("   (Higher Rank = More Common)             |   (Higher H = Reduces solution set)       \n");
-    printf("-------------------------------------------+-------------------------------------------\n");
+    long histogram[MAX_GUESSES + 1] = { 0 }; // [0] = failed
+    long statesPerTurn[MAX_GUESSES + 1] = { 0 };
 
-    // Print the top N rows side-by-side
-    for (int i = 0; i < MAX_ROWS && i < numPossibleAnswers; i++)
+    const char* opener = pOpening->finalPick.word;
+    if (pszOpener != NULL)
     {
-        PGUESS_METRICS pR = pRankSorted + i;
-        PGUESS_METRICS pE = pEntropySorted + i;
-
-        char rank_col_buffer[200];
-        char entropy_col_buffer[200];
-
-        // Format Left Column - Word (R, H) N=x V=x R=Y/N
-        sprintf_s(rank_col_buffer, sizeof(rank_col_buffer), "%3d. %-5s (R=%03d, H=%.4f) N=%c V=%c R=%c",
-            i + 1, pR->word, pR->rank, pR->entropy, pR->nounType, pR->verbType,
-            (pR->is_risky ? 'Y' : 'N'));
+        char word[WORD_SIZE + 1] = { 0 };
+        PWORD_ENTRY pEntry = NULL;
+        if (strlen(pszOpener) == WORD_SIZE)
+        {
+            for (int i = 0; i < WORD_SIZE; i++) word[i] = toupper((unsigned char)pszOpener[i]);
+            pEntry = get_word_entry_from_word(word, pDictionary, numWordsInDictionary);
+        }
+        if (pEntry == NULL)
+        {
+            fprintf(stderr, "Opener %s is not a dictionary word!\n", pszOpener);
+            return false;
+        }
+        opener = pEntry->word;
+    }
+    WORD_ID openerId = get_word_id(opener);
+    if (openerId == INVALID_WORD_ID || numPossibleAnswers == 0) return false;
 
-        // Format Right Column - Word (R, H) N=x V=x R=Y/N
-        sprintf_s(entropy_col_buffer, sizeof(entropy_col_buffer), "%3d. %-5s (R=%03d, H=%.4f) N=%c V=%c R=%c",
-            i + 1, pE->word, pE->rank, pE->entropy, pE->nounType, pE->verbType,
-            (pE->is_risky ? 'Y' : 'N'));
+    // Level 0: the start of the game, where the opener is played
+    PDECISION_TREE_NODE pNodes = (PDECISION_TREE_NODE)calloc(1, sizeof(DECISION_TREE_NODE));
+    PTREE_BUILD_STATE pLevel = (PTREE_BUILD_STATE)calloc(1, sizeof(TREE_BUILD_STATE));
+    long numNodes = 1;
+    long numLevel = 1;
+    bool ok = (pNodes != NULL && pLevel != NULL);
 
-        printf("%-*s|%-*s\n", COL_WIDTH, rank_col_buffer, COL_WIDTH, entropy_col_buffer);
+    if (ok)
+    {
+        init_game_constraints(pLevel->game.mask, pLevel->game.notMask, pLevel->game.good, pLevel->game.bad);
+        pLevel->game.pCandidates = (const char**)malloc(numPossibleAnswers * sizeof(char*));
+        pLevel->pReaching = (const char**)malloc(numPossibleAnswers * sizeof(char*));
+        ok = (pLevel->game.pCandidates != NULL && pLevel->pReaching != NULL);
+    }
+    if (ok)
+    {
+        memcpy((void*)pLevel->game.pCandidates, pPossibleAnswers, numPossibleAnswers * sizeof(char*));
+        memcpy((void*)pLevel->pReaching, pPossibleAnswers, numPossibleAnswers * sizeof(char*));
+        pLevel->game.numCandidates = numPossibleAnswers;
+        pLevel->numReaching = numPossibleAnswers;
+        pLevel->pick = opener;
+
+        set_tree_node_picks(pNodes, pOpening);
+        pNodes->finalId = openerId;
+        pNodes->finalEntropy = (opener == pOpening->finalPick.word) ? pOpening->finalPick.entropy : calculate_entropy_score(opener, pPossibleAnswers, numPossibleAnswers);
     }
 
-    printf("-------------------------------------------+-------------------------------------------\n");
+    printf("\n--- Building the decision tree from %s (%d threads) ---\n", opener, get_worker_thread_count());
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
 
-    // Lookup metrics for the final determined picks (after linguistic filtering)
-    PGUESS_METRICS pR_Pick = find_metric_by_word(pRankPicks->word, pRankSorted, numPossibleAnswers);
-    PGUESS_METRICS pE_Pick = find_metric_by_word(pE_Picks->word, pEntropySorted, numPossibleAnswers);
-    PGUESS_METRICS pR_Alt = find_metric_by_word(pRankPicks->alternate_word, pRankSorted, numPossibleAnswers);
-    PGUESS_METRICS pE_Alt = find_metric_by_word(pE_Picks->alternate_word, pEntropySorted, numPossibleAnswers);
+    for (int turn = 1; ok && numLevel > 0; turn++)
+    {
+        statesPerTurn[turn] = numLevel;
 
-    char rank_pick_buffer[100], rank_alt_buffer[100];
-    char entropy_pick_buffer[100], entropy_alt_buffer[100];
+        PTREE_BUILD_STATE pNext = NULL;
+        long numNext = 0;
+        if (!plan_tree_children(pLevel, numLevel, pNodes, numNodes, &pNext, &numNext, histogram))
+        {
+            free_tree_level(pNext, numNext);
+            ok = false;
+            break;
+        }
 
-    // Format Top Pick (Rank-Optimized)
-    sprintf_s(rank_pick_buffer, sizeof(rank_pick_buffer), "     Top Pick  : %-5s (R=%03d, H=%.4f)",
-        pRankPicks->word, pR_Pick ? pR_Pick->rank : 0, pR_Pick ? pR_Pick->entropy : 0.0);
+        if (numNext > 0)
+        {
+            PDECISION_TREE_NODE pGrown = (PDECISION_TREE_NODE)realloc(pNodes, (numNodes + numNext) * sizeof(DECISION_TREE_NODE));
+            if (pGrown == NULL)
+            {
+                free_tree_level(pNext, numNext);
+                ok = false;
+                break;
+            }
+            pNodes = pGrown;
+            memset(pNodes + numNodes, 0, numNext * sizeof(DECISION_TREE_NODE));
+
+            TREE_BUILD_JOB job;
+            job.pDictionary = pDictionary;
+            job.pOpeningCache = pOpeningCache;
+            job.pParents = pLevel;
+            job.pChildren = pNext;
+            job.pNodes = pNodes;
+            job.failed = false;
+            parallel_for(numNext, DECISION_TREE_CHUNK_SIZE, expand_tree_children, &job);
+
+            numNodes += numNext;
+            ok = !job.failed;
+        }
 
-    // Format Alternate (Rank-Optimized)
-    sprintf_s(rank_alt_buffer, sizeof(rank_alt_buffer), "     Alternate : %-5s (R=%03d, H=%.4f)",
-        pRankPicks->alternate_word, pR_Alt ? pR_Alt->rank : 0, pR_Alt ? pR_Alt->entropy : 0.0);
+        free_tree_level(pLevel, numLevel);
+        pLevel = pNext;
+        numLevel = numNext;
+    }
+    free_tree_level(pLevel, numLevel);
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
 
-    // Format Top Pick (Entropy-Optimized)
-    sprintf_s(entropy_pick_buffer, sizeof(entropy_pick_buffer), "     Top Pick  : %-5s (R=%03d, H=%.4f)",
-        pE_Picks->word, pE_Pick ? pE_Pick->rank : 0, pE_Pick ? pE_Pick->entropy : 0.0);
+    if (!ok)
+    {
+        fprintf(stderr, "Out of memory building the decision tree!\n");
+        free(pNodes);
+        return false;
+    }
 
-    // Format Alternate (Entropy-Optimized)
-    sprintf_s(entropy_alt_buffer, sizeof(entropy_alt_buffer), "     Alternate : %-5s (R=%03d, H=%.4f)",
-        pE_Picks->alternate_word, pE_Alt ? pE_Alt->rank : 0, pE_Alt ? pE_Alt->entropy : 0.0);
+    printf("States by turn  :");
+    for (int turn = 1; turn <= MAX_GUESSES; turn++) printf(" %ld", statesPerTurn[turn]);
+    printf(" (%ld nodes, %.1f KB)\n", numNodes, numNodes * sizeof(DECISION_TREE_NODE) / 1024.0);
+    print_guess_histogram(histogram, numPossibleAnswers);
+    printf("Wall time       : %.3f s\n", wallSeconds);
+
+    unsigned long long fingerprint = compute_opening_fingerprint(pDictionary, numWordsInDictionary, pPossibleAnswers, numPossibleAnswers);
+    ok = save_decision_tree(pszPath, fingerprint, openerId, pNodes, numNodes);
+    if (ok) printf("Saved decision tree to %s.\n", pszPath);
+    free(pNodes);
+    return ok;
+}
 
-    printf("%-*s|%-*s\n", COL_WIDTH, rank_pick_buffer, COL_WIDTH, entropy_pick_buffer);
-    printf("%-*s|%-*s\n", COL_WIDTH, rank_alt_buffer, COL_WIDTH, entropy_alt_buffer);
+/**
+ * @brief Writes a decision tree file: the header, then the nodes as they are laid out in memory.
+ * @return bool True on success.
+ */
+bool save_decision_tree(const char* pszPath, unsigned long long fingerprint, WORD_ID openerId, const DECISION_TREE_NODE* pNodes, long numNodes)
+{
+    DECISION_TREE_HEADER header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DECISION_TREE_MAGIC, 4);
+    header.version = DECISION_TREE_VERSION;
+    header.fingerprint = fingerprint;
+    header.openerId = openerId;
+    header.numNodes = (unsigned int)numNodes;
+
+    FILE* fpOut;
+    errno_t errval = fopen_s(&fpOut, pszPath, "wb");
+    if (fpOut == NULL || errval != 0)
+    {
+        fprintf(stderr, "Could not write decision tree (%s).\n", pszPath);
+        return false;
+    }
 
-    printf("-------------------------------------------+-------------------------------------------\n");
+    bool ok = (fwrite(&header, sizeof(header), 1, fpOut) == 1) &&
+        (fwrite(pNodes, sizeof(DECISION_TREE_NODE), numNodes, fpOut) == (size_t)numNodes);
+    ok = (fclose(fpOut) == 0) && ok;
+    if (!ok) fprintf(stderr, "Could not write decision tree (%s).\n", pszPath);
+    return ok;
 }
 
 /**
- * @brief Applies the dynamic H/R trade-off logic to select the single best final recommendation.
- * Prints the final top pick in a centered banner format.
- * @param pRankSorted The Rank-sorted array (for absolute top pick in small sets).
- * @param pEntropySorted The Entropy-sorted array (for metrics).
- * @param numPossibleAnswers The number of words remaining.
- * @param rankPicks The top picks from the Rank path.
- * @param entropyPicks The top picks from the Entropy path.
+ * @brief Maps a decision tree file and checks it was built for this game: same fingerprint (dictionary,
+ * answers and scoring settings), a consistent size, and child links and word IDs that stay in range.
+ * @param pszPath The file written by --export-tree.
+ * @param fingerprint compute_opening_fingerprint of the current game.
+ * @param pTree Output tree.
+ * @return bool True if the tree can be used.
  */
-void determine_final_pick(PGUESS_METRICS pRankSorted, PGUESS_METRICS pEntropySorted, long numPossibleAnswers, const PICK_DATA* rankPicks, const PICK_DATA* entropyPicks)
+bool load_decision_tree(const char* pszPath, unsigned long long fingerprint, PDECISION_TREE pTree)
 {
-    // Retrieve metrics for the linguistically filtered top picks
-    PGUESS_METRICS pR_Pick = find_metric_by_word(rankPicks->word, pRankSorted, numPossibleAnswers);
-    PGUESS_METRICS pE_Pick = find_metric_by_word(entropyPicks->word, pEntropySorted, numPossibleAnswers);
+    memset(pTree, 0, sizeof(DECISION_TREE));
+    if (!map_file_readonly(pszPath, &pTree->map))
+    {
+        fprintf(stderr, "Could not open decision tree %s.\n", pszPath);
+        return false;
+    }
 
-    // Default to the Rank pick (most common)
-    const char* final_word = rankPicks->word;
-    double final_rank = pR_Pick ? pR_Pick->rank : 0.0;
-    double final_entropy = pR_Pick ? pR_Pick->entropy : 0.0;
+    const DECISION_TREE_HEADER* pHeader = (const DECISION_TREE_HEADER*)pTree->map.pBase;
+    const DECISION_TREE_NODE* pNodes = (const DECISION_TREE_NODE*)(pHeader + 1);
+    const char* pszError = NULL;
 
-    if (pR_Pick && pE_Pick)
+    if (pTree->map.size < sizeof(DECISION_TREE_HEADER) || memcmp(pHeader->magic, DECISION_TREE_MAGIC, 4) != 0 || pHeader->version != DECISION_TREE_VERSION)
     {
-        double entropy_diff = fabs(pE_Pick->entropy - pR_Pick->entropy);
+        pszError = "not a decision tree of this version";
+    }
+    else if (pHeader->numNodes == 0 || pTree->map.size != sizeof(DECISION_TREE_HEADER) + (size_t)pHeader->numNodes * sizeof(DECISION_TREE_NODE))
+    {
+        pszError = "truncated file";
+    }
+    else if (pHeader->fingerprint != fingerprint)
+    {
+        pszError = "built for another dictionary, answer list or settings";
+    }
 
-        if (numPossibleAnswers > LOW_POSSIBLE_ANSWER_COUNT)
-        {
-            // Large set (N > 25): Prioritize H unless the difference is negligible.
-            if (entropy_diff > ENTROPY_RANK_THRESHOLD)
-            {
-                // Difference is significant: choose Entropy pick for max information gain
-                final_word = pE_Pick->word;
-                final_rank = pE_Pick->rank;
-                final_entropy = pE_Pick->entropy;
-            }
-            // Otherwise, Rank-Pick (default) is used for its higher probability.
-        }
-        else // Small set (N <= 25): Prioritize Rank.
+    for (unsigned int n = 0; pszError == NULL && n < pHeader->numNodes; n++)
+    {
+        const DECISION_TREE_NODE* pNode = pNodes + n;
+        long numChildren = 0;
+        for (int w = 0; w < DECISION_TREE_MASK_WORDS; w++) numChildren += count_mask_bits(pNode->childMask[w]);
+
+        bool idsValid = (pNode->finalId < (WORD_ID)numWordsInDictionary || (pNode->finalId == INVALID_WORD_ID && pNode->numCandidates == 0 && numChildren == 0)) &&
+            (pNode->rankPickId == INVALID_WORD_ID || pNode->rankPickId < (WORD_ID)numWordsInDictionary) &&
+            (pNode->entropyPickId == INVALID_WORD_ID || pNode->entropyPickId < (WORD_ID)numWordsInDictionary);
+        if (!idsValid || (numChildren > 0 && (pNode->firstChild <= n || (long long)pNode->firstChild + numChildren > pHeader->numNodes)))
         {
-            // Choose the absolute highest ranked word (first in the pRankSorted list)
-            final_word = pRankSorted[0].word;
-            final_rank = pRankSorted[0].rank;
-            final_entropy = pRankSorted[0].entropy;
+            pszError = "corrupt node";
         }
     }
-    else if (numPossibleAnswers > 0)
+
+    if (pszError != NULL)
     {
-        // Fallback: If filtering removed one of the key picks, use the absolute highest Rank word.
-        final_word = pRankSorted[0].word;
-        final_rank = pRankSorted[0].rank;
-        final_entropy = pRankSorted[0].entropy;
+        fprintf(stderr, "Ignoring decision tree %s: %s.\n", pszPath, pszError);
+        unmap_file(&pTree->map);
+        return false;
     }
 
-    // Format the final recommendation banner
-    char final_pick_buffer[100];
-    sprintf_s(final_pick_buffer, sizeof(final_pick_buffer), "Final Top Pick: %s (R=%03d, H=%.4f)",
-        final_word, (int)final_rank, final_entropy);
-
-    // Print centered final pick
-    int final_string_length = strlen(final_pick_buffer);
-    int total_width = 89;
-    int padding = (total_width - final_string_length) / 2;
-
-    printf("%*s%s%*s\n", padding, "", final_pick_buffer, padding, "");
-    printf("---------------------------------------------------------------------------------------\n");
+    pTree->pHeader = pHeader;
+    pTree->pNodes = pNodes;
+    pTree->numNodes = pHeader->numNodes;
+    printf("Mapped decision tree %s (%ld states, opener %s).\n", pszPath, pTree->numNodes, get_word_text(pNodes[0].finalId));
+    return true;
 }
 
-
 /**
- * @brief Coordinates the metric calculation, sorting, filtering, and printing for a single turn.
- * @param pDictionary The entire word dictionary.
- * @param pPossibleAnswers Array of pointers to remaining possible answers.
- * @param numPossibleAnswers The number of words remaining.
- * @param pGood The string of required letters (for repeat risk check).
- * @param pMetricsTable The pre-allocated array for metric storage.
+ * @brief Unmaps a decision tree (no-op if none is loaded).
  */
-void analyze_and_print_recommendations(PWORD_ENTRY pDictionary, const char** pPossibleAnswers, long numPossibleAnswers, char* pGood, PGUESS_METRICS pMetricsTable)
+void free_decision_tree(PDECISION_TREE pTree)
 {
-    PGUESS_METRICS pRankSorted = NULL;
-    PGUESS_METRICS pEntropySorted = NULL;
-    PICK_DATA rankPicks;
-    PICK_DATA entropyPicks;
-
-    if (numPossibleAnswers == 0) return;
-
-    // 1. Calculate all metrics (H, R, Linguistic, Risk) for the current possible answers
-    calculate_all_metrics(pDictionary, pPossibleAnswers, numPossibleAnswers, pGood, pMetricsTable, numWordsInDictionary);
+    unmap_file(&pTree->map);
+    memset(pTree, 0, sizeof(DECISION_TREE));
+}
 
-    // 2. Create and sort two separate metric buffers (must free these later)
-    if (!create_and_sort_metric_buffers(pMetricsTable, numPossibleAnswers, &pRankSorted, &pEntropySorted)) return;
+/**
+ * @brief Follows one guess through the tree in constant time.
+ * @param pTree The loaded tree.
+ * @param nodeIdx The game's current node.
+ * @param guess The guess played (any case); it must be the node's final pick.
+ * @param code Its feedback.
+ * @param numCandidates The answers the live game has left (must match the child's).
+ * @return long The child node, or -1 if the game has left the policy.
+ */
+long find_decision_tree_child(const DECISION_TREE* pTree, long nodeIdx, const char* guess, PATTERN_CODE code, long numCandidates)
+{
+    if (pTree->pNodes == NULL || nodeIdx < 0) return -1;
 
-    // 3. Find Top Pick and Alternate for each path, applying linguistic/risk filters
-    find_top_linguistic_picks(pRankSorted, numPossibleAnswers, &rankPicks);
-    find_top_linguistic_picks(pEntropySorted, numPossibleAnswers, &entropyPicks);
+    const DECISION_TREE_NODE* pNode = pTree->pNodes + nodeIdx;
+    if (pNode->finalId == INVALID_WORD_ID || !is_same_word(guess, get_word_text(pNode->finalId))) return -1;
 
-    // 4. Print the detailed two-column recommendation table
-    print_recommendation_table(pRankSorted, pEntropySorted, numPossibleAnswers, &rankPicks, &entropyPicks);
+    int word = code / 64;
+    unsigned long long bit = 1ULL << (code % 64);
+    if ((pNode->childMask[word] & bit) == 0) return -1;
 
-    // 5. Determine and print the final top pick based on the dynamic H/R trade-off
-    determine_final_pick(pRankSorted, pEntropySorted, numPossibleAnswers, &rankPicks, &entropyPicks);
+    long childIdx = pNode->firstChild + count_mask_bits(pNode->childMask[word] & (bit - 1));
+    for (int w = 0; w < word; w++) childIdx += count_mask_bits(pNode->childMask[w]);
 
-    // 6. Cleanup
-    free(pRankSorted);
-    free(pEntropySorted);
+    return (pTree->pNodes[childIdx].numCandidates == (unsigned int)numCandidates) ? childIdx : -1;
 }
 
-
 /**
- * @brief Filters the list of possible answers based on the latest game constraints.
- * This function updates the array of possible answers in place by moving valid pointers
- * to the beginning of the array.
- * @param pPossibleAnswers Array of pointers to remaining possible answers.
- * @param numCurrentAnswers The current count of answers.
- * @param pMask Green letters mask.
- * @param notMask Positional exclusions (Yellow/Black).
- * @param pGood Required letters (Min Count).
- * @param pBad Letters that must be absent.
- * @param numTries Current attempt number (unused but kept for context).
- * @return long The new count of possible answers.
+ * @brief Builds a tree pick metric from a word ID (R from the dictionary, H as stored).
  */
-long filter_possible_answers(const char** pPossibleAnswers, long numCurrentAnswers, char* pMask, char notMask[6][5], char* pGood, char* pBad, long numTries)
+static void make_tree_pick_metric(WORD_ID id, double entropy, PGUESS_METRICS pMetric)
 {
-    long numNewAnswers = 0;
-
-    for (long i = 0; i < numCurrentAnswers; i++)
-    {
-        char* pWord = (char*)pPossibleAnswers[i];
-        if (is_good_fit(pMask, notMask, pGood, pBad, pWord))
-        {
-            // Keep the pointer by moving it to the front of the array
-            pPossibleAnswers[numNewAnswers++] = pWord;
-        }
-    }
+    make_pick_metric("NONE", NULL, pMetric);
+    if (id == INVALID_WORD_ID) return;
+
+    const WORD_ENTRY* pEntry = g_dictionaryStore.pEntries + id;
+    pMetric->word = pEntry->word;
+    pMetric->rank = pEntry->rank;
+    pMetric->entropy = entropy;
+    pMetric->nounType = pEntry->nounType;
+    pMetric->verbType = pEntry->verbType;
+}
 
-    printf("\nFiltered. %ld possible answers remain.\n", numNewAnswers);
-    return numNewAnswers;
+/**
+ * @brief Turns a tree node into a recommendation holding its picks. The tree keeps no table rows,
+ * so those are empty and the alternates are "NONE".
+ */
+void get_decision_tree_recommendation(const DECISION_TREE_NODE* pNode, PRECOMMENDATION pRec)
+{
+    pRec->numPossibleAnswers = pNode->numCandidates;
+    pRec->numMetrics = 0;
+    pRec->numRankRows = 0;
+    pRec->numEntropyRows = 0;
+    make_tree_pick_metric(pNode->rankPickId, pNode->rankPickEntropy, &pRec->rankPick);
+    make_tree_pick_metric(INVALID_WORD_ID, 0.0, &pRec->rankAlternate);
+    make_tree_pick_metric(pNode->entropyPickId, pNode->entropyPickEntropy, &pRec->entropyPick);
+    make_tree_pick_metric(INVALID_WORD_ID, 0.0, &pRec->entropyAlternate);
+    make_tree_pick_metric(pNode->finalId, pNode->finalEntropy, &pRec->finalPick);
 }
 
 /**
@@ -1317,38 +10467,100 @@ int main(int argc, char* argv[])
 {
     int result = 0;
     char* pUsedWordsTable = NULL;
+    USED_WORDS_FETCH usedWordsFetch;
     PWORD_ENTRY pDictionaryTable = NULL;
 
     char** pPossibleAnswers = NULL;
     long numPossibleAnswers = 0;
     PGUESS_METRICS pMetricsTable = NULL;
 
+    // Opening cache (turn-1 analysis and turn-2 replies)
+    POPENING_CACHE pOpeningCache = NULL;
+    bool haveOpeningCache = false;
+    RECOMMENDATION recommendation;
+    FILE* fpProtocol = NULL;
+    PATTERN_HISTOGRAMS histograms; // Carried between turns of the interactive game
+
     // Game state constraint buffers
+    int wordLength = WORD_SIZE; // Or the variant dictionary's
     char mask[WORD_SIZE + 1];
-    char goodButDontKnowWhere[WORD_SIZE + 1];
+    char goodButDontKnowWhere[VARIANT_MAX_WORD_SIZE + 1];
     char cannotHave[26];
     char notMask[6][WORD_SIZE];
-    char result_input[WORD_SIZE + 1];
+    char result_input[VARIANT_MAX_WORD_SIZE + 1];
 
     // --- 1. Initialization ---
-    memset(mask, '*', WORD_SIZE);
-    mask[WORD_SIZE] = '\0'; // Green mask initialized to *****
-    memset(goodButDontKnowWhere, 0, sizeof(goodButDontKnowWhere)); // Required letters initialized empty
-    memset(cannotHave, 0, sizeof(cannotHave)); // Excluded letters initialized empty
-    for (int idx = 0; idx < 6; idx++)
+    init_game_constraints(mask, notMask, goodButDontKnowWhere, cannotHave);
+    init_pattern_histograms(&histograms);
+    result_input[WORD_SIZE] = '\0';
+
+    if (!parse_command_line(argc, argv, &g_options)) return 1;
+    if (!resolve_data_paths()) return 1;
+
+    // Server and batch modes keep stdout for their output; everything else printed goes to stderr.
+    // So do interactive games with --output compact or silent: stdout carries only their JSON lines
+    bool isInteractive = !g_options.server && g_options.pszBatchPath == NULL && !g_options.simulate && !g_options.bench &&
+        g_options.pszExportTreePath == NULL && !g_options.compileDictionary;
+    if (g_options.server || g_options.pszBatchPath != NULL || (isInteractive && g_options.outputMode != OUTPUT_HUMAN))
     {
-        memcpy(notMask[idx], mask, WORD_SIZE); // Positional exclusions initialized to *
+        fpProtocol = open_protocol_stream();
     }
-    result_input[WORD_SIZE] = '\0';
+    if (isInteractive) g_fpRecommendations = fpProtocol;
 
 
     // --- 2. Data Loading ---
-    pUsedWordsTable = get_used_words_table();
+    // The past-answer download runs in the background while every used-word-independent table is
+    // built; the used words are applied last, as a mask over the dictionary
+    start_used_words_fetch(&usedWordsFetch);
     pDictionaryTable = get_dictionary_table();
 
-    if (pDictionaryTable == NULL)
+    // A dictionary of another word length or alphabet is played by the word kernels its header selected,
+    // in the same game loop and simulation: every word is a possible answer
+    if (pDictionaryTable == NULL && g_variantDictionary.pKernels != NULL)
+    {
+        pUsedWordsTable = finish_used_words_fetch(&usedWordsFetch);
+        if (!apply_variant_options()) { result = 1; goto end_game_loop; }
+        if (g_options.compileDictionary)
+        {
+            if (!write_variant_binary_dictionary(g_szDictionaryBinaryPath)) result = 1;
+            goto end_game_loop;
+        }
+
+        wordLength = g_variantDictionary.wordLength;
+        pPossibleAnswers = (char**)malloc(numWordsInDictionary * sizeof(char*));
+        pMetricsTable = (PGUESS_METRICS)malloc(numWordsInDictionary * sizeof(GUESS_METRICS));
+        if (pPossibleAnswers == NULL || pMetricsTable == NULL) { fprintf(stderr, "Out of memory for answer list/metrics table!\n"); goto end_game_loop; }
+
+        numPossibleAnswers = numWordsInDictionary;
+        for (long i = 0; i < numPossibleAnswers; i++) pPossibleAnswers[i] = g_variantDictionary.pWords + (size_t)i * VARIANT_RECORD_SIZE(wordLength);
+        build_count_log2_table(numWordsInDictionary);
+
+        g_tryIdx = 1;
+        if (!compute_recommendation((const char**)pPossibleAnswers, numPossibleAnswers, goodButDontKnowWhere, pMetricsTable, NULL, &recommendation)) goto end_game_loop;
+        goto start_game;
+    }
+
+    if (pDictionaryTable == NULL || !build_dictionary_store(pDictionaryTable, numWordsInDictionary))
+    {
+        if (pDictionaryTable == NULL) fprintf(stderr, "Fatal Error: Dictionary could not be loaded. Exiting.\n");
+        pUsedWordsTable = finish_used_words_fetch(&usedWordsFetch);
+        goto end_game_loop;
+    }
+
+    if (g_options.useAccelerator) init_accelerator();
+    build_count_log2_table(numWordsInDictionary);
+    build_filter_index(pDictionaryTable, numWordsInDictionary);
+    if (g_options.lookaheadPlies > 0 && !init_lookahead_table()) g_options.lookaheadPlies = 0;
+
+    // Still waiting on the network: build the pattern matrix now instead of after the fetch
+    if (is_used_words_fetch_pending(&usedWordsFetch)) ensure_pattern_matrix(pDictionaryTable, numWordsInDictionary);
+    pUsedWordsTable = finish_used_words_fetch(&usedWordsFetch);
+
+    // Converter mode: write the compiled dictionary and stop
+    if (g_options.compileDictionary)
     {
-        fprintf(stderr, "Fatal Error: Dictionary could not be loaded. Exiting.\n");
+        ensure_pattern_matrix(pDictionaryTable, numWordsInDictionary);
+        if (!write_binary_dictionary(g_szDictionaryBinaryPath, pDictionaryTable, numWordsInDictionary)) result = 1;
         goto end_game_loop;
     }
 
@@ -1359,21 +10571,80 @@ int main(int argc, char* argv[])
     if (pPossibleAnswers == NULL || pMetricsTable == NULL) { fprintf(stderr, "Out of memory for answer list/metrics table!\n"); goto end_game_loop; }
 
     // Populate the initial list of possible answers (dictionary minus used words)
-    for (long i = 0; i < numWordsInDictionary; i++)
+    numPossibleAnswers = build_initial_answers(pDictionaryTable, numWordsInDictionary, pUsedWordsTable, numUsedWords, pPossibleAnswers);
+    if (numPossibleAnswers < 0) { fprintf(stderr, "Out of memory for the used-word mask!\n"); goto end_game_loop; }
+
+    g_tryIdx = 1;
+
+    if (g_options.useOpeningCache) pOpeningCache = (POPENING_CACHE)malloc(sizeof(OPENING_CACHE));
+    if (g_options.useOpeningCache && (g_options.simulate || g_options.server || g_options.pszBatchPath != NULL || g_options.pszExportTreePath != NULL)) init_result_cache();
+
+    if (!get_opening_recommendation(pDictionaryTable, (const char**)pPossibleAnswers, numPossibleAnswers, pMetricsTable, pOpeningCache, &recommendation, &haveOpeningCache))
+    {
+        fprintf(stderr, "Fatal Error: No possible answers to analyze. Exiting.\n");
+        goto end_game_loop;
+    }
+
+start_game:
+    // Batch mode: play every answer instead of the interactive loop
+    if (g_options.simulate)
+    {
+        if (pDictionaryTable != NULL) ensure_pattern_matrix(pDictionaryTable, numWordsInDictionary);
+        bool ok = g_options.sweep ?
+            run_parameter_sweep(pDictionaryTable, (const char**)pPossibleAnswers, numPossibleAnswers, &recommendation, haveOpeningCache ? pOpeningCache : NULL) :
+            run_simulation(pDictionaryTable, (const char**)pPossibleAnswers, numPossibleAnswers, &recommendation, haveOpeningCache ? pOpeningCache : NULL);
+        if (!ok) result = 1;
+        report_stats("simulation", 0, numPossibleAnswers);
+        goto end_game_loop;
+    }
+
+    // Benchmark mode: time the kernels against their references instead of playing
+    if (g_options.bench)
+    {
+        ensure_pattern_matrix(pDictionaryTable, numWordsInDictionary);
+        if (!run_benchmarks(pDictionaryTable, (const char**)pPossibleAnswers, numPossibleAnswers, &recommendation, haveOpeningCache ? pOpeningCache : NULL)) result = 1;
+        goto end_game_loop;
+    }
+
+    // Offline mode: precompute the whole policy from the opener and stop
+    if (g_options.pszExportTreePath != NULL)
     {
-        char* pWord = pDictionaryTable[i].word;
-        // Check if the word is NOT in the list of past used words
-        if (bsearch(pWord, pUsedWordsTable, numUsedWords, WORD_SIZE, compare) == NULL)
+        ensure_pattern_matrix(pDictionaryTable, numWordsInDictionary);
+        if (!export_decision_tree(pDictionaryTable, (const char**)pPossibleAnswers, numPossibleAnswers, &recommendation, haveOpeningCache ? pOpeningCache : NULL,
+            g_options.pszOpener, g_options.pszExportTreePath)) result = 1;
+        report_stats("tree", 0, numPossibleAnswers);
+        goto end_game_loop;
+    }
+
+    // Server mode: many concurrent games over the shared, read-only tables
+    if (g_options.server)
+    {
+        ensure_pattern_matrix(pDictionaryTable, numWordsInDictionary);
+
+        // A tree built for this game answers on-policy turns; its opener becomes the first recommendation
+        if (g_options.pszTreePath != NULL &&
+            load_decision_tree(g_options.pszTreePath, compute_opening_fingerprint(pDictionaryTable, numWordsInDictionary, (const char**)pPossibleAnswers, numPossibleAnswers), &g_decisionTree))
         {
-            pPossibleAnswers[numPossibleAnswers++] = pWord;
+            make_tree_pick_metric(g_decisionTree.pNodes[0].finalId, g_decisionTree.pNodes[0].finalEntropy, &recommendation.finalPick);
         }
+        if (!run_server(pDictionaryTable, (const char**)pPossibleAnswers, numPossibleAnswers, &recommendation, haveOpeningCache ? pOpeningCache : NULL, fpProtocol)) result = 1;
+        report_stats("server", 0, numPossibleAnswers);
+        goto end_game_loop;
     }
 
-    g_tryIdx = 1;
+    // Batch mode: answer every history in the input file instead of the interactive loop
+    if (g_options.pszBatchPath != NULL)
+    {
+        ensure_pattern_matrix(pDictionaryTable, numWordsInDictionary);
+        if (!run_batch(pDictionaryTable, (const char**)pPossibleAnswers, numPossibleAnswers, haveOpeningCache ? pOpeningCache : NULL, g_options.pszBatchPath, fpProtocol)) result = 1;
+        report_stats("batch", 0, numPossibleAnswers);
+        goto end_game_loop;
+    }
 
     // Print initial recommendations (Turn 1)
-    analyze_and_print_recommendations(pDictionaryTable, (const char**)pPossibleAnswers, numPossibleAnswers, goodButDontKnowWhere, pMetricsTable);
+    print_recommendation(&recommendation);
     printf("It is recommended you enter one of these words first.\n");
+    report_stats("startup", 0, numPossibleAnswers);
 
 
     // --- 3. Main Game Loop ---
@@ -1383,13 +10654,13 @@ int main(int argc, char* argv[])
         printf("\n--- Turn %d of 6 ---\n", g_tryIdx);
 
         // A. Get User Guess Input
-        printf("Enter your 5-letter word guess: ");
+        printf("Enter your %d-letter word guess: ", wordLength);
         if (fgets(buffer, 100, stdin) == NULL) break;
         trim(buffer);
         if (strcmp(buffer, "q") == 0) break;
-        if (strlen(buffer) != WORD_SIZE)
+        if ((int)strlen(buffer) != wordLength || (g_variantDictionary.pKernels != NULL && !parse_variant_guess(buffer)))
         {
-            printf("You must enter 5 letters. Try again!\n");
+            printf("You must enter %d letters. Try again!\n", wordLength);
             g_tryIdx--;
             continue;
         }
@@ -1397,13 +10668,13 @@ int main(int argc, char* argv[])
         // B. Get Result Pattern Input (Validation loop)
         while (1)
         {
-            printf("Enter the 5-character result (B=Black/Gray, G=Green, Y=Yellow) e.g. 'BGYBB': ");
-            if (fgets(result_input, sizeof(result_input), stdin) == NULL) goto end_game_loop;
+            printf("Enter the %d-character result (B=Black/Gray, G=Green, Y=Yellow) e.g. '%.*s': ", wordLength, wordLength, "BGYBBGY");
+            if (fgets(result_input, wordLength + 1, stdin) == NULL) goto end_game_loop;
             trim(result_input);
             clear_input_buffer();
 
             bool valid = true;
-            for (int i = 0; i < WORD_SIZE; i++)
+            for (int i = 0; i < wordLength; i++)
             {
                 result_input[i] = toupper((unsigned char)result_input[i]);
                 if (result_input[i] != 'B' && result_input[i] != 'G' && result_input[i] != 'Y')
@@ -1416,27 +10687,61 @@ int main(int argc, char* argv[])
             if (valid) break;
         }
 
-        // C. Update all game constraints based on guess and result
-        update_game_constraints(buffer, result_input, mask, notMask, goodButDontKnowWhere, cannotHave, g_tryIdx);
-
-        printf("\n--- Current Game State ---\n");
-        printf("Mask (Green) : %-5.5s\n", mask);
-        printf("Required Letters: %-5.5s (Min Count Constraint)\n", goodButDontKnowWhere);
-        printf("Excluded Letters: %s\n", cannotHave);
-
-        // D. Check for Solution
-        if (strchr(mask, '*') == NULL)
+        // C-E. A variant dictionary keeps exactly the answers giving the result (see apply_feedback_code)
+        if (g_variantDictionary.pKernels != NULL)
         {
-            printf("\n*** SOLVED! The word is %s ***\n", mask);
-            break;
+            int code = encode_variant_pattern(result_input, wordLength);
+            if (code == g_variantDictionary.pKernels->numPatterns - 1)
+            {
+                printf("\n*** SOLVED! The word is %s ***\n", buffer);
+                break;
+            }
+            numPossibleAnswers = apply_feedback_code(g_variantDictionary.pKernels, buffer, code, (const char**)pPossibleAnswers, numPossibleAnswers,
+                mask, notMask, goodButDontKnowWhere, cannotHave, g_tryIdx);
         }
+        else
+        {
+            // C. Update all game constraints based on guess and result
+            update_game_constraints(buffer, result_input, mask, notMask, goodButDontKnowWhere, cannotHave, g_tryIdx);
+
+            printf("\n--- Current Game State ---\n");
+            printf("Mask (Green) : %-5.5s\n", mask);
+            printf("Required Letters: %-5.5s (Min Count Constraint)\n", goodButDontKnowWhere);
+            printf("Excluded Letters: %s\n", cannotHave);
+
+            // D. Check for Solution
+            if (strchr(mask, '*') == NULL)
+            {
+                printf("\n*** SOLVED! The word is %s ***\n", mask);
+                break;
+            }
 
-        // E. Filter and Analyze
-        numPossibleAnswers = filter_possible_answers((const char**)pPossibleAnswers, numPossibleAnswers, mask, notMask, goodButDontKnowWhere, cannotHave, g_tryIdx);
+            // E. Filter and Analyze
+            numPossibleAnswers = filter_possible_answers_after_guess(buffer, result_input, (const char**)pPossibleAnswers, numPossibleAnswers, mask, notMask, goodButDontKnowWhere, cannotHave, g_tryIdx);
+        }
+        printf("\nFiltered. %ld possible answers remain.\n", numPossibleAnswers);
 
         if (numPossibleAnswers > 0)
         {
-            analyze_and_print_recommendations(pDictionaryTable, (const char**)pPossibleAnswers, numPossibleAnswers, goodButDontKnowWhere, pMetricsTable);
+            // The reply to the cached opener was precomputed with the opening analysis
+            bool printedCachedReply = false;
+            if (haveOpeningCache && g_tryIdx == 1 && pOpeningCache->header.openerIndex >= 0 &&
+                is_same_word(buffer, pDictionaryTable[pOpeningCache->header.openerIndex].word))
+            {
+                const CACHED_RECOMMENDATION* pReply = pOpeningCache->replies + encode_feedback_pattern(result_input);
+                if (pReply->numPossibleAnswers == numPossibleAnswers &&
+                    unpack_cached_recommendation(pReply, pDictionaryTable, numWordsInDictionary, &recommendation))
+                {
+                    print_recommendation(&recommendation);
+                    printedCachedReply = true;
+                }
+            }
+
+            if (!printedCachedReply)
+            {
+                analyze_and_print_recommendations((const char**)pPossibleAnswers, numPossibleAnswers, goodButDontKnowWhere, pMetricsTable, &histograms);
+            }
+            report_stats("turn", g_tryIdx, numPossibleAnswers);
 
             if (numPossibleAnswers == 1)
             {
@@ -1453,10 +10758,24 @@ int main(int argc, char* argv[])
 
 end_game_loop:
     // --- 4. Resource Cleanup ---
+    if (pOpeningCache) free(pOpeningCache);
     if (pMetricsTable) free(pMetricsTable);
     if (pPossibleAnswers) free(pPossibleAnswers);
-    if (pDictionaryTable) free(pDictionaryTable);
+    free_pattern_histograms(&histograms);
+    free_lookahead_table();
+    free_result_cache();
+    free_decision_tree(&g_decisionTree);
+    shutdown_parallel_pool();
+    free_scratch_arenas();
+    free_count_log2_table();
+    free_filter_index();
+    free_pattern_matrix();
+    free_accelerator();
+    free_dictionary_store();
+    release_dictionary_table(pDictionaryTable);
+    free_variant_dictionary();
     if (pUsedWordsTable) free(pUsedWordsTable);
+    if (fpProtocol && fpProtocol != stdout) fclose(fpProtocol);
 
     return(result);
 }